@@ -33,19 +33,57 @@ using TypePtr = std::unique_ptr<Type>;
 
 enum class TypeKind {
   Named, // i32, f64, bool, etc.
+  Array, // [N]T: fixed-size array of N elements of type T
 };
 
 struct Type {
   TypeKind kind;
-  std::string name; // for Named types
+  std::string name; // Type name; "[N]T" for arrays
+  TypePtr element;  // for Array types
+  size_t size = 0;  // for Array types
   SourceLocation loc;
 
   explicit Type(std::string name, SourceLocation loc = SourceLocation())
       : kind(TypeKind::Named), name(std::move(name)), loc(loc) {}
 
+  Type(TypePtr element, size_t size, SourceLocation loc = SourceLocation());
+
   void print(std::ostream &os) const;
 };
 
+// Element type name and length of an array type name such as "[8]f64".
+// Later phases only see type names, so the name is the canonical spelling.
+// Indices are i32, so arrays hold at most INT32_MAX elements
+constexpr size_t kMaxArrayLength = 2147483647;
+
+struct ArrayTypeName {
+  std::string element;
+  size_t size;
+};
+
+std::optional<ArrayTypeName> parse_array_type_name(const std::string &name);
+std::string array_type_name(const std::string &element, size_t size);
+
+// Width and signedness of an integer type name: i8, i16, i32, i64 and the
+// unsigned u8, u16, u32, u64 (bool is not an integer type)
+struct IntegerTypeName {
+  unsigned bits;
+  bool is_signed;
+};
+
+std::optional<IntegerTypeName>
+parse_integer_type_name(const std::string &name);
+
+// Lane type name and lane count of a SIMD vector type name such as "f64x4".
+// Vectors are values like scalars; lanes are i32, f64 or bool (comparison
+// masks), with a power-of-two count from 2 to 64
+struct VectorTypeName {
+  std::string element;
+  size_t lanes;
+};
+
+std::optional<VectorTypeName> parse_vector_type_name(const std::string &name);
+
 // ===== Expression =====
 
 enum class ExprKind {
@@ -58,6 +96,7 @@ enum class ExprKind {
   Unary,       // Unary operation (prefix/postfix)
   OperatorSeq, // Sequence of operands and operators (not yet resolved)
   Call,
+  Index, // Array element: base[index]
 };
 
 struct Expr {
@@ -76,21 +115,27 @@ protected:
 };
 
 struct IntLiteralExpr : public Expr {
-  std::string value; // store as string, parse later
+  std::string value; // store as string, parse later (digits only)
+  std::string type;  // From the suffix, e.g. "u8" for 255u8; "i32" without
 
   explicit IntLiteralExpr(std::string value,
-                          SourceLocation loc = SourceLocation())
-      : Expr(ExprKind::IntLiteral, loc), value(std::move(value)) {}
+                          SourceLocation loc = SourceLocation(),
+                          std::string type = "i32")
+      : Expr(ExprKind::IntLiteral, loc), value(std::move(value)),
+        type(std::move(type)) {}
 
   void print(std::ostream &os) const override;
 };
 
 struct FloatLiteralExpr : public Expr {
   std::string value;
+  std::string type; // "f32" for 1.5f32; "f64" without a suffix
 
   explicit FloatLiteralExpr(std::string value,
-                            SourceLocation loc = SourceLocation())
-      : Expr(ExprKind::FloatLiteral, loc), value(std::move(value)) {}
+                            SourceLocation loc = SourceLocation(),
+                            std::string type = "f64")
+      : Expr(ExprKind::FloatLiteral, loc), value(std::move(value)),
+        type(std::move(type)) {}
 
   void print(std::ostream &os) const override;
 };
@@ -219,6 +264,17 @@ struct CallExpr : public Expr {
   void print(std::ostream &os) const override;
 };
 
+struct IndexExpr : public Expr {
+  ExprPtr base; // An array variable, or an element of an array of arrays
+  ExprPtr index;
+
+  IndexExpr(ExprPtr base, ExprPtr index, SourceLocation loc = SourceLocation())
+      : Expr(ExprKind::Index, loc), base(std::move(base)),
+        index(std::move(index)) {}
+
+  void print(std::ostream &os) const override;
+};
+
 // ===== Statement =====
 
 enum class StmtKind {
@@ -363,4 +419,14 @@ struct BlockStmt : public Stmt {
   void print(std::ostream &os, int indent = 0) const override;
 };
 
+// ===== Copies =====
+
+// Deep copies, including locations and inferred types. Analysis rewrites
+// the AST it is given, so a caller that keeps an AST (such as the
+// IncrementalParser) hands out copies of it.
+TypePtr clone(const Type &type);
+ExprPtr clone(const Expr &expr);
+StmtPtr clone(const Stmt &stmt);
+std::vector<StmtPtr> clone(const std::vector<StmtPtr> &stmts);
+
 } // namespace pecco
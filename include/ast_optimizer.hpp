@@ -0,0 +1,144 @@
+#pragma once
+
+#include "ast.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace pecco {
+
+// Compile-time value of a scalar expression
+using ConstValue = std::variant<int32_t, double, bool>;
+
+// Value of an i32/f64/bool literal
+std::optional<ConstValue> literal_value(const Expr *expr);
+
+// Literal expression (with inferred_type set) for a value; returns nullptr
+// for non-finite f64 values, which have no literal spelling
+ExprPtr make_literal(const ConstValue &value, SourceLocation loc);
+
+// Whether codegen lowers the operator to a builtin instruction for these
+// operand types (user-defined overloads are never called in that case)
+bool is_builtin_binary(const std::string &op, const ConstValue &left,
+                       const ConstValue &right);
+bool is_builtin_unary(const std::string &op, OpPosition position,
+                      const ConstValue &operand);
+
+// Evaluate a builtin operator with codegen semantics (i32 wraparound,
+// ordered f64 comparisons). Returns nullopt for operations with undefined
+// behavior (division by zero, INT_MIN / -1, out-of-range shifts) or
+// unsupported operand types.
+std::optional<ConstValue> eval_builtin_binary(const std::string &op,
+                                              const ConstValue &left,
+                                              const ConstValue &right);
+std::optional<ConstValue> eval_builtin_unary(const std::string &op,
+                                             OpPosition position,
+                                             const ConstValue &operand);
+
+// A transformation over the resolved, type-checked AST.
+//
+// Passes must preserve the observable behavior of the program, including
+// i32 wraparound, codegen's choice between builtin instructions and
+// user-defined operator overloads, and the evaluation of operands with side
+// effects.
+class AstPass {
+public:
+  virtual ~AstPass() = default;
+
+  // Short identifier used in diagnostics
+  virtual const char *name() const = 0;
+
+  // Transform the program, returns true if anything changed
+  virtual bool run(std::vector<StmtPtr> &stmts) = 0;
+};
+
+// Base class for passes that rewrite expressions bottom-up
+class ExprRewritePass : public AstPass {
+public:
+  bool run(std::vector<StmtPtr> &stmts) override;
+
+protected:
+  // Rewrite one expression whose operands were already visited.
+  // Returns true if the expression was replaced or modified.
+  virtual bool rewrite(ExprPtr &expr) = 0;
+
+  bool visit_stmt(Stmt *stmt);
+  bool visit_expr(ExprPtr &expr);
+};
+
+// Fold builtin operators applied to literals: 2 + 3 -> 5, 2.0 ** 3.0 -> 8.0.
+// Operations with undefined behavior (division by zero, INT_MIN / -1,
+// out-of-range shifts) and non-finite f64 results are left untouched.
+class ConstantFoldingPass : public ExprRewritePass {
+public:
+  const char *name() const override { return "constant-folding"; }
+
+protected:
+  bool rewrite(ExprPtr &expr) override;
+};
+
+// Algebraic identities: x + 0 -> x, x * 1 -> x, b && true -> b, -(-x) -> x.
+// Identities that drop an operand (x * 0 -> 0) only apply when that operand
+// has no side effects.
+class AlgebraicSimplificationPass : public ExprRewritePass {
+public:
+  const char *name() const override { return "algebraic-simplification"; }
+
+protected:
+  bool rewrite(ExprPtr &expr) override;
+};
+
+// Replace `if` with a constant condition by the taken branch and remove
+// `while false` loops.
+class DeadBranchEliminationPass : public AstPass {
+public:
+  const char *name() const override { return "dead-branch-elimination"; }
+
+  bool run(std::vector<StmtPtr> &stmts) override;
+
+private:
+  bool visit_list(std::vector<StmtPtr> &stmts);
+  bool visit_stmt(StmtPtr &stmt);
+};
+
+// Remove statements following a statement that always returns.
+// Function and operator definitions are kept, they are not executable code.
+class UnreachableCodeEliminationPass : public AstPass {
+public:
+  const char *name() const override { return "unreachable-code-elimination"; }
+
+  bool run(std::vector<StmtPtr> &stmts) override;
+
+private:
+  bool visit_list(std::vector<StmtPtr> &stmts);
+  bool visit_stmt(Stmt *stmt);
+};
+
+// Runs a sequence of passes until the AST stops changing
+class AstPassManager {
+public:
+  AstPassManager() = default;
+
+  // Pipeline with all passes above
+  static AstPassManager create_default();
+
+  void add_pass(std::unique_ptr<AstPass> pass);
+
+  // Run the pipeline, returns true if anything changed
+  bool run(std::vector<StmtPtr> &stmts);
+
+  const std::vector<std::unique_ptr<AstPass>> &passes() const {
+    return passes_;
+  }
+
+private:
+  // Upper bound on pipeline iterations (each iteration may expose more work)
+  static constexpr int kMaxIterations = 8;
+
+  std::vector<std::unique_ptr<AstPass>> passes_;
+};
+
+} // namespace pecco
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "compilation_session.hpp"
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pecco {
+
+// Totals of the compiles done by a BatchCompiler
+struct BatchStats {
+  size_t files = 0;
+  size_t failed = 0;
+  double seconds = 0; // Time spent in compile()
+
+  double files_per_second() const { return seconds > 0 ? files / seconds : 0; }
+};
+
+// Compiles many programs to object files (like plc --compile), reusing the
+// expensive LLVM objects between them: one LLVMContext, the caller's
+// TargetMachine, the optimization pipeline with its four analysis managers,
+// and the code generation pass manager (which emits into a reused buffer).
+// Each module is emitted and released before compile() returns; cached
+// analyses are cleared with it.
+//
+// Not thread-safe: use one BatchCompiler per thread.
+class BatchCompiler {
+public:
+  // options.module_name is replaced by each compile's module name; with
+  // opt_level set, modules are optimized with that default pipeline
+  BatchCompiler(llvm::TargetMachine &target_machine, CompileOptions options,
+                std::optional<llvm::OptimizationLevel> opt_level,
+                std::shared_ptr<const SymbolTable> prelude =
+                    CompilationSession::default_prelude());
+  ~BatchCompiler();
+
+  BatchCompiler(const BatchCompiler &) = delete;
+  BatchCompiler &operator=(const BatchCompiler &) = delete;
+
+  // Compile source and write the object file to object_path. On failure
+  // the compile's diagnostics (an error phase "output" when the file
+  // cannot be written) are appended to diagnostics.
+  bool compile(std::string_view source, const std::string &module_name,
+               const std::string &object_path,
+               std::vector<Diagnostic> &diagnostics);
+
+  const BatchStats &stats() const { return stats_; }
+
+private:
+  llvm::TargetMachine &target_machine_;
+  CompileOptions options_;
+  std::shared_ptr<const SymbolTable> prelude_;
+  BatchStats stats_;
+
+  // Outlives every module compiled with it (declared before them)
+  llvm::LLVMContext context_;
+
+  bool optimize_;
+  llvm::LoopAnalysisManager loop_analyses_;
+  llvm::FunctionAnalysisManager function_analyses_;
+  llvm::CGSCCAnalysisManager cgscc_analyses_;
+  llvm::ModuleAnalysisManager module_analyses_;
+  llvm::PassBuilder pass_builder_;
+  llvm::ModulePassManager optimizer_;
+
+  // Code generation writes each object into object_ first
+  llvm::SmallVector<char, 0> object_;
+  llvm::raw_svector_ostream object_stream_{object_};
+  llvm::legacy::PassManager emitter_;
+  bool can_emit_;
+
+  bool emit(llvm::Module &module, const std::string &object_path,
+            std::string &error);
+};
+
+} // namespace pecco
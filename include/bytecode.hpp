@@ -0,0 +1,180 @@
+#pragma once
+
+#include "ast.hpp"
+#include "error.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// Register-based bytecode executed by the VM (--interp).
+//
+// Every function owns a window of registers; parameters occupy the first
+// registers, followed by locals and temporaries. Operands a/b/c are register
+// indices unless noted. 32-bit immediates (jump targets, i32 constants) are
+// split across b (low half) and c (high half).
+#define PECCO_OPCODES(X)                                                       \
+  /* a = b */                                                                  \
+  X(Mov)                                                                       \
+  /* a = imm32 (i32 or bool) */                                                \
+  X(LoadInt)                                                                   \
+  /* a = f64 constant pool[b] */                                               \
+  X(LoadF64)                                                                   \
+  /* a = string pool[b] */                                                     \
+  X(LoadStr)                                                                   \
+  /* i32 arithmetic with wraparound, a = b op c */                             \
+  X(AddI32) X(SubI32) X(MulI32) X(DivI32) X(RemI32)                            \
+  X(AndI32) X(OrI32) X(XorI32) X(ShlI32) X(ShrI32)                             \
+  /* a = -b, a = ~b, a = !b (bool) */                                          \
+  X(NegI32) X(NotI32) X(NotBool)                                               \
+  /* i32 comparisons, a = (b op c) */                                          \
+  X(EqI32) X(NeI32) X(LtI32) X(LeI32) X(GtI32) X(GeI32)                        \
+  /* f64 arithmetic */                                                         \
+  X(AddF64) X(SubF64) X(MulF64) X(DivF64) X(PowF64) X(NegF64)                  \
+  /* ordered f64 comparisons */                                                \
+  X(EqF64) X(NeF64) X(LtF64) X(LeF64) X(GtF64) X(GeF64)                        \
+  /* pc = imm32 */                                                             \
+  X(Jump)                                                                      \
+  /* loop back-edge: pc = imm32, counts towards the function's hotness */      \
+  X(Loop)                                                                      \
+  /* if !a: pc = imm32 */                                                      \
+  X(JumpIfFalse)                                                               \
+  /* a = functions[c](registers b...), callee window starts at b */            \
+  X(Call)                                                                      \
+  /* return a / return without value */                                        \
+  X(Return) X(ReturnVoid)                                                      \
+  /* native builtins: arguments start at b, result (write) in a */             \
+  X(Write) X(Print) X(PrintI32) X(PrintF64) X(Flush) X(Exit)
+
+enum class Opcode : uint16_t {
+#define PECCO_OPCODE_ENUM(name) name,
+  PECCO_OPCODES(PECCO_OPCODE_ENUM)
+#undef PECCO_OPCODE_ENUM
+};
+
+const char *to_string(Opcode op);
+
+struct Instr {
+  Opcode op;
+  uint16_t a = 0;
+  uint16_t b = 0;
+  uint16_t c = 0;
+
+  int32_t imm() const {
+    return static_cast<int32_t>(static_cast<uint32_t>(b) |
+                                (static_cast<uint32_t>(c) << 16));
+  }
+};
+
+// One register: i32 and bool values use i (bool is 0 or 1)
+union VMValue {
+  int32_t i;
+  double f;
+  const char *s;
+};
+
+struct BytecodeFunction {
+  std::string name;
+  uint16_t num_params = 0;
+  uint16_t num_regs = 0;
+  std::vector<Instr> code;
+};
+
+struct BytecodeModule {
+  std::vector<BytecodeFunction> functions;
+  // Index of the function running the top-level statements
+  size_t entry = 0;
+  std::vector<double> f64_constants;
+  // String literals; deque keeps c_str() pointers stable
+  std::deque<std::string> strings;
+
+  void disassemble(std::ostream &os) const;
+};
+
+// Compile the resolved, type-checked AST to bytecode. Operator dispatch
+// follows codegen: builtin instructions are chosen by operand type first,
+// user-defined operator overloads are called otherwise.
+class BytecodeCompiler {
+public:
+  bool compile(const std::vector<StmtPtr> &stmts, BytecodeModule &module);
+
+  bool has_errors() const { return !errors_.empty(); }
+  const std::vector<Error> &errors() const { return errors_; }
+
+private:
+  enum class ValueType { I32, F64, Bool, String, Void };
+
+  struct Local {
+    uint16_t reg;
+    ValueType type;
+  };
+
+  // Register holding an expression's value
+  struct Operand {
+    uint16_t reg;
+    ValueType type;
+  };
+
+  struct FunctionEntry {
+    uint16_t index;
+    std::vector<ValueType> params;
+    ValueType return_type;
+  };
+
+  BytecodeModule *module_ = nullptr;
+  std::map<std::string, FunctionEntry> functions_;
+  std::vector<Error> errors_;
+
+  // State of the function being compiled
+  BytecodeFunction *current_ = nullptr;
+  std::vector<std::map<std::string, Local>> scopes_;
+  uint16_t next_reg_ = 0;
+
+  static std::optional<ValueType> parse_type(const std::string &name);
+  static const char *type_name(ValueType type);
+
+  void compile_function(const std::string &name,
+                        const std::vector<Parameter> &params,
+                        const Stmt *body, ValueType return_type,
+                        BytecodeFunction &function);
+
+  uint16_t alloc_reg(const SourceLocation &loc);
+  const Local *lookup(const std::string &name) const;
+  void emit(Opcode op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0);
+  void emit_imm(Opcode op, uint16_t a, int32_t imm);
+  size_t emit_jump(Opcode op, uint16_t a = 0);
+  void patch_jump(size_t at);
+
+  void compile_stmt(const Stmt *stmt);
+  void compile_let(const LetStmt *let);
+  void compile_if(const IfStmt *if_stmt);
+  void compile_while(const WhileStmt *while_stmt);
+
+  // Evaluate into a fresh or existing register (identifiers are not copied)
+  std::optional<Operand> compile_operand(const Expr *expr);
+  // Evaluate into the given register
+  std::optional<ValueType> compile_into(const Expr *expr, uint16_t dest);
+
+  std::optional<ValueType> compile_binary(const BinaryExpr *binary,
+                                          uint16_t dest);
+  std::optional<ValueType> compile_assignment(const BinaryExpr *binary,
+                                              uint16_t dest);
+  std::optional<ValueType> compile_unary(const UnaryExpr *unary,
+                                         uint16_t dest);
+  std::optional<ValueType> compile_call(const CallExpr *call, uint16_t dest);
+  std::optional<ValueType> compile_user_call(const std::string &name,
+                                             const std::vector<uint16_t> &args,
+                                             uint16_t dest,
+                                             const SourceLocation &loc);
+
+  std::optional<ValueType> fail(const std::string &msg,
+                                const SourceLocation &loc);
+};
+
+} // namespace pecco
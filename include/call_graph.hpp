@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ast.hpp"
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// Mangled symbol name of an operator definition (see mangle_operator_name)
+std::string mangle_operator_declaration(const OperatorDeclStmt &op_decl);
+
+// Whole-program call graph over the top-level definitions of a module.
+//
+// Nodes are functions (keyed by name) and operator overloads (keyed by their
+// mangled name), plus the implicit entry function holding the top-level
+// statements. Operator uses are resolved to overloads through the operand
+// types inferred by the TypeChecker; when a type is unknown, every
+// user-defined overload of that operator is treated as a possible callee.
+class CallGraph {
+public:
+  // Name of the node representing top-level statements
+  static constexpr const char *kEntryName = "__pecco_entry";
+
+  CallGraph() = default;
+
+  // Build the graph from resolved (and ideally type-checked) statements
+  void build(const std::vector<StmtPtr> &stmts);
+
+  // Whether the definition can be reached from the top-level statements
+  bool is_reachable(const Stmt *definition) const;
+  bool is_reachable(const std::string &name) const;
+
+  // Callees of a node (functions and user-defined operators only)
+  const std::set<std::string> &callees(const std::string &name) const;
+
+  // Names of all defined nodes (entry first, then in source order)
+  const std::vector<std::string> &nodes() const { return nodes_; }
+
+  // Print "caller -> callee, ..." lines, marking unreachable definitions
+  void print(std::ostream &os) const;
+
+private:
+  // Defined nodes in source order
+  std::vector<std::string> nodes_;
+
+  // Names of nodes that have a definition with a body
+  std::set<std::string> defined_;
+
+  // Definition statement -> node name
+  std::map<const Stmt *, std::string> definition_names_;
+
+  // Operator symbol + position -> mangled names of user-defined overloads
+  std::map<std::pair<std::string, OpPosition>, std::vector<std::string>>
+      operator_overloads_;
+
+  // Caller -> callees
+  std::map<std::string, std::set<std::string>> edges_;
+
+  // Nodes reachable from the entry
+  std::set<std::string> reachable_;
+
+  void add_definition(const std::string &name, const Stmt *stmt);
+  void add_operator_use(const std::string &caller, const std::string &op,
+                        OpPosition position,
+                        const std::vector<const Expr *> &operands);
+
+  void collect_stmt(const std::string &caller, const Stmt *stmt);
+  void collect_expr(const std::string &caller, const Expr *expr);
+
+  void compute_reachability();
+};
+
+} // namespace pecco
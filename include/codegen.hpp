@@ -11,6 +11,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -19,16 +20,43 @@ namespace pecco {
 class CodeGen {
 public:
   explicit CodeGen(const std::string &module_name = "pecco_module");
+  // 在调用者持有的 context 中生成（批量编译复用同一个 context），
+  // 模块须在 context 之前释放，take_context() 返回空
+  CodeGen(const std::string &module_name, llvm::LLVMContext &context);
 
   // 生成整个模块的 LLVM IR
   bool generate(std::vector<StmtPtr> &stmts, const ScopedSymbolTable &symbols);
 
+  // 跳过顶层语句无法到达的函数/operator 定义（基于 CallGraph）
+  // 默认关闭：--compile 生成的目标文件可能被外部代码调用
+  void set_eliminate_dead_functions(bool enable) {
+    eliminate_dead_functions_ = enable;
+  }
+
+  // 浮点指令的 fast-math 标志（plc 的 --ffast-math、--fp-contract=fast、
+  // --fno-honor-nans），默认为空即严格 IEEE 语义
+  void set_fast_math_flags(llvm::FastMathFlags flags) {
+    fast_math_flags_ = flags;
+    builder_.setFastMathFlags(flags);
+  }
+
+  // 只生成 names 中列出的函数/operator 定义（operator 用 mangled name），
+  // 其余符号仅声明为外部函数，也不生成入口函数。用于分层执行时单独编译热点函数
+  bool generate_definitions(std::vector<StmtPtr> &stmts,
+                            const ScopedSymbolTable &symbols,
+                            const std::set<std::string> &names);
+
   // 获取生成的模块
   llvm::Module *get_module() { return module_.get(); }
 
   // 转移模块所有权（用于 JIT）
   std::unique_ptr<llvm::Module> take_module() { return std::move(module_); }
 
+  // 转移 context 所有权：与 take_module 一起交给 JIT 的 ThreadSafeModule
+  std::unique_ptr<llvm::LLVMContext> take_context() {
+    return std::move(owned_context_);
+  }
+
   // 错误处理
   bool has_errors() const { return !errors_.empty(); }
   const std::vector<Error> &errors() const { return errors_; }
@@ -38,7 +66,8 @@ public:
 
 private:
   // LLVM 核心组件
-  llvm::LLVMContext context_;
+  std::unique_ptr<llvm::LLVMContext> owned_context_;
+  llvm::LLVMContext &context_;
   std::unique_ptr<llvm::Module> module_;
   llvm::IRBuilder<> builder_;
 
@@ -48,29 +77,61 @@ private:
   // 变量作用域栈：每层是变量名到 LLVM Value* 的映射
   std::vector<std::map<std::string, llvm::Value *>> value_stack_;
 
+  // 数组变量的存储（局部 alloca、顶层数组的全局变量或按引用传入的参数指针）
+  // 到数组类型的映射
+  std::map<const llvm::Value *, llvm::ArrayType *> arrays_;
+
   // 函数表：函数名到 LLVM Function* 的映射
   std::map<std::string, llvm::Function *> functions_;
 
   // 当前正在生成的函数
   llvm::Function *current_function_;
 
+  // 是否跳过不可达的定义
+  bool eliminate_dead_functions_ = false;
+
+  // 浮点指令的 fast-math 标志
+  llvm::FastMathFlags fast_math_flags_;
+
   // 错误列表
   std::vector<Error> errors_;
 
-  // 类型映射：Pecco 类型名到 LLVM 类型
+  // 将符号表中的所有函数与 operator 声明为 LLVM 函数
+  bool declare_symbols(const ScopedSymbolTable &symbols);
+
+  // 类型映射：Pecco 类型名到 LLVM 类型（"[N]T" 映射为 [N x T]，
+  // 向量 "TxN" 映射为 <N x T>）
   llvm::Type *get_llvm_type(const std::string &type_name);
+  // 反向映射：LLVM 值类型到 Pecco 类型名（用于选择 operator 重载），未知时为空
+  std::string get_type_name(llvm::Type *type);
+  // 操作数的 Pecco 类型：类型检查得到的类型（区分有无符号），否则反向映射
+  std::string operand_type_name(const Expr *expr, llvm::Value *value);
+  // 参数类型：数组按引用传递，是指针；其余同 get_llvm_type
+  llvm::Type *get_param_type(const std::string &type_name);
+  // 数组参数指向整个数组且不会被保存，告诉 LLVM 以便向量化
+  void add_array_param_attributes(llvm::Function *func,
+                                  const std::vector<std::string> &param_types);
+  // 按 fast_math_flags_ 给所有定义加上对应的函数属性
+  void add_fast_math_attributes();
 
   // 作用域管理
   void push_scope();
   void pop_scope();
   void add_variable(const std::string &name, llvm::Value *value);
   llvm::Value *lookup_variable(const std::string &name);
+  // 在当前函数入口块创建 alloca：循环体中声明的变量也能被提升为寄存器
+  llvm::AllocaInst *create_entry_alloca(llvm::Type *type,
+                                        const std::string &name);
+  // 为参数建立变量：数组参数直接使用传入的指针，其余参数存入 alloca
+  void bind_params(llvm::Function *llvm_func,
+                   const std::vector<Parameter> &params);
 
   // 语句生成
   void gen_stmt(Stmt *stmt);
   void gen_func_stmt(FuncStmt *func);
   void gen_operator_stmt(OperatorDeclStmt *op_decl);
   void gen_let_stmt(LetStmt *let);
+  void gen_array_let_stmt(LetStmt *let);
   void gen_return_stmt(ReturnStmt *ret);
   void gen_expr_stmt(ExprStmt *expr_stmt);
   void gen_block_stmt(BlockStmt *block);
@@ -87,6 +148,18 @@ private:
   llvm::Value *gen_binary_expr(BinaryExpr *binary);
   llvm::Value *gen_unary_expr(UnaryExpr *unary);
   llvm::Value *gen_call_expr(CallExpr *call);
+  // 类型转换：整数之间 sext/zext/trunc，整数与浮点之间 [su]itofp/饱和转换
+  llvm::Value *gen_conversion(CallExpr *call, const std::string &name,
+                              const std::vector<llvm::Value *> &args);
+  // 位操作内置函数：popcount/clz/ctz、rotl/rotr、bswap、bitreverse
+  llvm::Value *gen_bit_builtin(CallExpr *call, const std::string &name,
+                               const std::vector<llvm::Value *> &args);
+  // SIMD 内置函数：向量构造、lane 访问、shuffle、select 与水平归约
+  llvm::Value *gen_simd_builtin(CallExpr *call, const std::string &name,
+                                const std::vector<llvm::Value *> &args);
+  llvm::Value *gen_index_expr(IndexExpr *index);
+  // 左值：变量或数组元素的地址，type 设为其中存放的值的类型
+  llvm::Value *gen_lvalue(Expr *expr, llvm::Type *&type);
 
   // 错误报告
   void error(const std::string &msg, size_t line, size_t column);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ast.hpp"
+#include "codegen.hpp"
+#include "scope.hpp"
+#include "symbol_table.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pecco {
+
+// Options of one compilation (the library equivalent of plc's flags)
+struct CompileOptions {
+  // Name of the generated LLVM module
+  std::string module_name = "main";
+  // Run the AST optimizer (compile-time evaluation, folding, DCE)
+  bool ast_opt = true;
+  // Only generate definitions reachable from the top-level statements
+  bool eliminate_dead_functions = true;
+  // Fast-math flags of every floating-point instruction (empty: strict IEEE)
+  llvm::FastMathFlags fast_math_flags;
+  // Threads parsing the top-level statements (see
+  // Parser::parse_program_parallel); 1 parses on the calling thread
+  unsigned parse_jobs = 1;
+  // Lex on a background thread while parsing (see TokenStream); only used
+  // when parse_jobs is 1, since parallel parsing needs all tokens up front
+  bool stream_tokens = false;
+};
+
+// A diagnostic from one front-end phase. phase is "lexer", "parse",
+// "semantic", "type" or "code generation"; end_column and caret_offset
+// refine the source highlight when known (0 otherwise).
+struct Diagnostic {
+  std::string phase;
+  std::string message;
+  size_t line = 0;
+  size_t column = 0;
+  size_t end_column = 0;
+  size_t caret_offset = 0;
+};
+
+// Diagnostic of an operator resolver error, formatted "at line:col: message"
+Diagnostic resolver_diagnostic(const std::string &error);
+
+// All state of compiling one source text: options, AST, symbol table,
+// diagnostics and generated LLVM module (with its own LLVMContext).
+//
+// Sessions share nothing mutable, so any number of them can run on
+// different threads at once. The prelude symbol table is loaded once and
+// shared read-only: each session's table is layered on top of it.
+class CompilationSession {
+public:
+  // Prelude from STDLIB_DIR, loaded on first use (thread-safe); null if it
+  // failed to load
+  static std::shared_ptr<const SymbolTable> default_prelude();
+
+  // Load a prelude file into a shareable table; null on failure
+  static std::shared_ptr<const SymbolTable>
+  load_prelude(const std::string &path, std::vector<Diagnostic> *diagnostics);
+
+  explicit CompilationSession(
+      CompileOptions options = {},
+      std::shared_ptr<const SymbolTable> prelude = default_prelude());
+
+  // Replace the prelude given to the constructor, e.g. with one loaded
+  // while parse() ran; call before declare() and analyze()
+  void set_prelude(std::shared_ptr<const SymbolTable> prelude);
+
+  // Phases, in order; each returns false and adds diagnostics on failure
+  bool parse(std::string_view source);
+  // Add an implicit function declaration (host functions etc.); call
+  // between parse() and analyze()
+  void declare(const FunctionSignature &signature);
+  // Same for an operator defined elsewhere
+  void declare(const OperatorInfo &info);
+  // Symbol table construction, operator resolution and type checking
+  bool analyze();
+  // AST optimization if enabled in the options
+  void optimize_ast();
+  bool generate();
+  // Generate into a caller-owned context (reused across sessions by
+  // BatchCompiler); the session must be destroyed before the context
+  bool generate(llvm::LLVMContext &context);
+
+  // parse + analyze + optimize_ast + generate
+  bool compile(std::string_view source);
+
+  const CompileOptions &options() const { return options_; }
+  std::vector<StmtPtr> &stmts() { return stmts_; }
+  ScopedSymbolTable &symbols() { return symbols_; }
+  // Valid after a successful generate()
+  CodeGen *codegen() { return codegen_.get(); }
+
+  bool has_errors() const { return !diagnostics_.empty(); }
+  const std::vector<Diagnostic> &diagnostics() const { return diagnostics_; }
+
+private:
+  CompileOptions options_;
+  bool has_prelude_;
+  std::vector<StmtPtr> stmts_;
+  ScopedSymbolTable symbols_;
+  std::unique_ptr<CodeGen> codegen_;
+  std::vector<Diagnostic> diagnostics_;
+
+  void report(std::string phase, std::string message, size_t line = 0,
+              size_t column = 0, size_t end_column = 0,
+              size_t caret_offset = 0);
+  // generate() on codegen_
+  bool run_codegen();
+  // parse() with options_.stream_tokens
+  bool parse_streaming(std::string_view source);
+};
+
+} // namespace pecco
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// Default socket of the compile server: $XDG_RUNTIME_DIR/plc.sock, or
+// /tmp/plc-<uid>/plc.sock when XDG_RUNTIME_DIR is not set. That directory
+// is created with mode 0700; nullopt (with error set) when it exists but
+// belongs to another user or is open to others.
+std::optional<std::string> default_server_socket(std::string &error);
+
+// Handles one request: args are the client's command line without the
+// program name. Runs in a child process whose stdin/stdout/stderr and
+// working directory are the client's; the result is the exit status.
+using ServerHandler = std::function<int(const std::vector<std::string> &)>;
+
+// Compile server on a Unix domain socket.
+//
+// Everything the process sets up before serve() (prelude, LLVM targets,
+// target machines) stays warm: each request is handled in a fork() of the
+// server, so requests share that state copy-on-write, run concurrently and
+// cannot corrupt each other or the server. The client passes its standard
+// file descriptors over the socket (SCM_RIGHTS), so the request's output
+// goes directly to the client's terminal or pipes. Both ends check with
+// SO_PEERCRED that the other runs as the same user.
+class CompileServer {
+public:
+  CompileServer(std::string socket_path, ServerHandler handler);
+  ~CompileServer();
+
+  CompileServer(const CompileServer &) = delete;
+  CompileServer &operator=(const CompileServer &) = delete;
+
+  // Bind and listen; fails if another server is already listening there.
+  // A stale socket file from a dead server is replaced.
+  bool listen(std::string &error);
+
+  // Accept requests until SIGINT or SIGTERM, then remove the socket
+  void serve();
+
+  const std::string &socket_path() const { return socket_path_; }
+
+private:
+  std::string socket_path_;
+  ServerHandler handler_;
+  int listen_fd_ = -1;
+  // Running requests: child pid -> connection to report the status on
+  std::map<int, int> running_;
+
+  void start_request(int connection);
+  void reap_finished();
+};
+
+// Run a request on the server at socket_path with this process's stdin,
+// stdout, stderr and working directory. Returns the request's exit status,
+// or nullopt (with error set) when no server of this user accepts the
+// request. Once the
+// request is sent it may be running, so losing the connection afterwards
+// sets error and returns status 1 instead.
+std::optional<int> run_on_server(const std::string &socket_path,
+                                 const std::vector<std::string> &args,
+                                 std::string &error);
+
+} // namespace pecco
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ast_optimizer.hpp"
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// Compile-time interpreter over the typed AST.
+//
+// Only side-effect-free definitions are evaluated: a function or operator is
+// pure when every call it makes (transitively) targets a user definition with
+// a body, so nothing reaches write/exit or other externs. Evaluation follows
+// codegen semantics and gives up (returns nullopt) on undefined behavior,
+// reads of unknown variables, string values, or when the step budget or the
+// call depth limit is exceeded.
+class ConstEvaluator {
+public:
+  static constexpr uint64_t kDefaultStepBudget = 1000000;
+  static constexpr int kMaxCallDepth = 256;
+
+  // Index the top-level definitions and compute which ones are pure
+  explicit ConstEvaluator(const std::vector<StmtPtr> &stmts,
+                          uint64_t step_budget = kDefaultStepBudget);
+
+  // Function name or mangled operator name
+  bool is_pure(const std::string &name) const;
+
+  // Evaluate a call with constant arguments, memoized by name and arguments
+  std::optional<ConstValue> call(const std::string &name,
+                                 const std::vector<ConstValue> &args);
+
+  // Evaluate a builtin or pure user-defined operator on constants
+  std::optional<ConstValue> apply_binary(const std::string &op,
+                                         const ConstValue &left,
+                                         const ConstValue &right);
+  std::optional<ConstValue> apply_unary(const std::string &op,
+                                        OpPosition position,
+                                        const ConstValue &operand);
+
+private:
+  // A definition that can be called: parameters plus body
+  struct Callable {
+    const std::vector<Parameter> *params;
+    const Stmt *body;
+    std::string return_type;
+  };
+
+  // Local variables of one call, innermost block scope last
+  using Frame = std::vector<std::map<std::string, ConstValue>>;
+
+  enum class Flow { Normal, Return, Abort };
+
+  std::map<std::string, Callable> callables_;
+  std::set<std::string> pure_;
+  std::map<std::string, std::optional<ConstValue>> cache_;
+
+  uint64_t step_budget_;
+  uint64_t steps_ = 0;
+  // Set when the step budget or call depth limit aborted the evaluation
+  bool limit_hit_ = false;
+  std::vector<Frame> frames_;
+  std::optional<ConstValue> return_value_;
+
+  bool step();
+  std::optional<ConstValue> invoke(const std::string &name,
+                                   const std::vector<ConstValue> &args);
+
+  Flow exec_stmt(const Stmt *stmt);
+  std::optional<ConstValue> eval_expr(const Expr *expr);
+  std::optional<ConstValue> eval_assignment(const BinaryExpr *binary);
+
+  ConstValue *lookup(const std::string &name);
+};
+
+// AST pass: replace calls to pure functions and operators whose arguments are
+// constants with the computed literal, and propagate top-level `let`
+// constants (never reassigned or shadowed) into later top-level statements.
+class CompileTimeEvaluationPass : public ExprRewritePass {
+public:
+  explicit CompileTimeEvaluationPass(
+      uint64_t step_budget = ConstEvaluator::kDefaultStepBudget)
+      : step_budget_(step_budget) {}
+
+  const char *name() const override { return "compile-time-evaluation"; }
+
+  bool run(std::vector<StmtPtr> &stmts) override;
+
+protected:
+  bool rewrite(ExprPtr &expr) override;
+
+private:
+  uint64_t step_budget_;
+  std::unique_ptr<ConstEvaluator> evaluator_;
+};
+
+} // namespace pecco
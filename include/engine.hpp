@@ -0,0 +1,142 @@
+#pragma once
+
+#include "error.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pecco {
+
+// C++ spellings of the Pecco types, for lookup<i32(i32, i32)>("add")
+using i8 = int8_t;
+using i16 = int16_t;
+using i32 = int32_t;
+using i64 = int64_t;
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+using f32 = float;
+using f64 = double;
+
+namespace detail {
+
+// Pecco type name of a C++ parameter or return type. Only types with a
+// matching native representation are allowed.
+template <typename T> struct PeccoType;
+template <> struct PeccoType<int8_t> {
+  static constexpr const char *name = "i8";
+};
+template <> struct PeccoType<int16_t> {
+  static constexpr const char *name = "i16";
+};
+template <> struct PeccoType<int32_t> {
+  static constexpr const char *name = "i32";
+};
+template <> struct PeccoType<int64_t> {
+  static constexpr const char *name = "i64";
+};
+template <> struct PeccoType<uint8_t> {
+  static constexpr const char *name = "u8";
+};
+template <> struct PeccoType<uint16_t> {
+  static constexpr const char *name = "u16";
+};
+template <> struct PeccoType<uint32_t> {
+  static constexpr const char *name = "u32";
+};
+template <> struct PeccoType<uint64_t> {
+  static constexpr const char *name = "u64";
+};
+template <> struct PeccoType<float> {
+  static constexpr const char *name = "f32";
+};
+template <> struct PeccoType<double> {
+  static constexpr const char *name = "f64";
+};
+template <> struct PeccoType<bool> {
+  static constexpr const char *name = "bool";
+};
+template <> struct PeccoType<const char *> {
+  static constexpr const char *name = "string";
+};
+template <> struct PeccoType<void> {
+  static constexpr const char *name = "void";
+};
+
+template <typename Signature> struct FunctionType;
+template <typename R, typename... Args> struct FunctionType<R(Args...)> {
+  static std::vector<std::string> params() {
+    return {PeccoType<Args>::name...};
+  }
+  static std::string result() { return PeccoType<R>::name; }
+};
+
+} // namespace detail
+
+// Compiles Pecco source in-process to native code and hands out typed
+// function pointers.
+//
+//   pecco::Engine engine;
+//   engine.define_extern("scale", +[](pecco::f64 x) { return x * 2.0; });
+//   engine.compile("func twice(x: f64) : f64 { return scale(x); }");
+//   auto twice = engine.lookup<pecco::f64(pecco::f64)>("twice");
+//   double y = twice(21.0);  // direct native call
+//
+// Each compile() call is a separate unit: its function definitions are
+// optimized, JIT-compiled and exported; top-level statements are ignored.
+// Functions and operators defined by earlier units and host functions
+// registered with define_extern() are visible to later units without a
+// declaration; redefining them is an error.
+// Returned pointers stay valid for the lifetime of the Engine.
+//
+// Output from print/print_i32/print_f64 goes through the runtime library's
+// buffer and is flushed by flush() in Pecco code or when the Engine is
+// destroyed.
+class Engine {
+public:
+  Engine();
+  ~Engine();
+
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+
+  // Make a host function callable from Pecco code compiled afterwards
+  template <typename R, typename... Args>
+  bool define_extern(const std::string &name, R (*function)(Args...)) {
+    return define_extern(name, reinterpret_cast<void *>(function),
+                         {detail::PeccoType<Args>::name...},
+                         detail::PeccoType<R>::name);
+  }
+
+  // Compile one unit of source; returns false and fills errors() on failure
+  bool compile(std::string_view source);
+
+  // Address of an exported function, or nullptr (with an error) when it
+  // does not exist or its Pecco signature differs from Signature
+  template <typename Signature> Signature *lookup(const std::string &name) {
+    using Type = detail::FunctionType<Signature>;
+    return reinterpret_cast<Signature *>(
+        lookup_address(name, Type::params(), Type::result()));
+  }
+
+  bool has_errors() const { return !errors_.empty(); }
+  const std::vector<Error> &errors() const { return errors_; }
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+  std::vector<Error> errors_;
+
+  bool define_extern(const std::string &name, void *address,
+                     std::vector<std::string> param_types,
+                     std::string return_type);
+  void *lookup_address(const std::string &name,
+                       const std::vector<std::string> &param_types,
+                       const std::string &return_type);
+};
+
+} // namespace pecco
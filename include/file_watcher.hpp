@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+namespace pecco {
+
+// Waits for a file to be saved, using inotify.
+//
+// The file's directory is watched rather than the file itself, so editors
+// that save by writing a new file and renaming it over the old one are
+// seen too. Events arriving within a short interval are merged into one
+// change.
+class FileWatcher {
+public:
+  explicit FileWatcher(std::string path);
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  bool start(std::string &error);
+
+  // Block until the file changes (true) or SIGINT/SIGTERM arrives (false)
+  bool wait();
+
+private:
+  std::string directory_;
+  std::string name_;
+  int inotify_fd_ = -1;
+
+  // Consume pending events; true if one of them is about the file
+  bool drain();
+};
+
+} // namespace pecco
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "ast.hpp"
+#include "compilation_session.hpp"
+#include "incremental_parser.hpp"
+#include "semantic_queries.hpp"
+#include "symbol_table.hpp"
+#include "token.hpp"
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pecco {
+
+// Semantic token kinds (in the order of the language server's legend)
+enum class SemanticTokenKind {
+  Keyword,
+  Function,
+  Parameter,
+  Variable,
+  Type,
+  Number,
+  String,
+  Comment,
+  Operator,
+};
+
+struct SemanticToken {
+  size_t line;
+  size_t column;
+  size_t length;
+  SemanticTokenKind kind;
+};
+
+// Hover result: the highlighted source range and its description
+struct HoverInfo {
+  SourceLocation range;
+  std::string text;
+};
+
+// Target of go-to-definition; path is empty for the document itself
+struct DefinitionLocation {
+  std::string path;
+  SourceLocation range;
+};
+
+// Work done since the last update()
+struct UpdateStats {
+  size_t statements = 0; // Top-level statements in the document
+  size_t parsed = 0;     // Statements whose text changed (lexed and parsed)
+  size_t checked = 0;    // Statements re-analyzed (resolved and type checked)
+};
+
+// Front-end analysis of one source text, updated incrementally.
+//
+// The text is parsed by an IncrementalParser, so after an edit only new or
+// changed top-level statements are parsed, and the results of each
+// statement are kept as long as the parser reuses it. Semantic analysis is demand-driven (see
+// SemanticQueries): hover analyzes the statement under the cursor only,
+// and diagnostics() checks every statement. A checked statement is
+// re-analyzed when its text changes or when something it uses changes:
+// the signature of a function it calls, the type of a global variable it
+// reads, or the operator declarations. Editing a function body therefore
+// re-checks only that function, and changing a signature only its callers.
+//
+// Lines and columns are 1-based, as in the rest of the front end.
+class IncrementalDocument {
+public:
+  explicit IncrementalDocument(std::shared_ptr<const SymbolTable> prelude =
+                                   CompilationSession::default_prelude());
+  ~IncrementalDocument();
+
+  // Replace the text; analysis happens when the results are queried
+  void update(const std::string &text);
+
+  // Syntax and semantic diagnostics of the whole document
+  const std::vector<Diagnostic> &diagnostics() const;
+  UpdateStats stats() const;
+
+  // Type of the expression, variable or function at a position
+  std::optional<HoverInfo> hover(size_t line, size_t column) const;
+
+  // Declaration of the variable or function named at a position
+  std::optional<DefinitionLocation> definition(size_t line,
+                                               size_t column) const;
+
+  // Classified tokens of the whole document, in source order
+  std::vector<SemanticToken> semantic_tokens() const;
+
+private:
+  struct Statement;
+
+  IncrementalParser parser_;
+  // Statements in source order, and the cache of the previous update keyed
+  // by the parsed statement (reused by the parser when its tokens are
+  // unchanged)
+  std::vector<std::shared_ptr<Statement>> statements_;
+  std::unordered_map<const ParsedStatement *, std::shared_ptr<Statement>>
+      cache_;
+
+  // Semantic analysis of the statements, memoized across updates
+  mutable SemanticQueries queries_;
+  // Computed on first use after an update
+  mutable std::optional<std::vector<Diagnostic>> diagnostics_;
+  UpdateStats stats_;
+
+  std::shared_ptr<Statement>
+  make_statement(std::shared_ptr<ParsedStatement> parsed);
+
+  // Index of the last statement starting at or before a position
+  std::optional<size_t> statement_at(size_t line, size_t column) const;
+  std::optional<DefinitionLocation>
+  function_definition(const std::string &name) const;
+};
+
+} // namespace pecco
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ast.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pecco {
+
+// One top-level statement (function, operator, global let, top-level
+// call...) with its tokens and AST. Token, AST and error lines are relative
+// to the statement (its first line is 1) so that it can be reused when
+// lines are inserted or deleted above it; columns are unchanged.
+struct ParsedStatement {
+  size_t first_line = 1;   // Absolute line of the first token
+  size_t first_column = 1; // Column of the first token
+  uint64_t hash = 0;       // Of the tokens, with their relative positions
+
+  std::vector<Token> tokens; // Ends with EndOfFile
+  bool lexer_ok = true;      // No Error tokens (not parsed otherwise)
+  std::vector<StmtPtr> stmts;
+  std::vector<Parser::ParseError> errors;
+
+  // A fresh AST from the tokens, for callers that rewrite the AST
+  std::vector<StmtPtr> reparse() const;
+};
+
+// Work done by the last IncrementalParser::update()
+struct ReparseStats {
+  size_t statements = 0; // Top-level statements in the program
+  size_t parsed = 0;     // Statements whose tokens changed
+  size_t reused = 0;     // Statements taken from the previous update
+  size_t lexed = 0;      // Bytes of text lexed
+};
+
+// Parser keeping the top-level statements of the previous update.
+//
+// The text is split at top-level statement boundaries (see
+// Parser::split_top_level) and each statement's token range is hashed; a
+// statement whose tokens match one of the previous update keeps its
+// ParsedStatement (tokens and AST), only the others are parsed. Statements
+// are matched by content, so inserting or deleting whole statements reuses
+// everything else.
+//
+// After the first update only the part of the text that changed is lexed
+// again: the statements around the edit, up to the first one starting on a
+// later line. The statements after it keep their tokens and are only moved.
+// When the edit changes how the rest of the text splits (an unclosed brace,
+// an unterminated string) the rest of the text is lexed again. An edit
+// therefore costs about the size of the statements it touches, plus a
+// comparison of the old and new text.
+class IncrementalParser {
+public:
+  // Bring the statements up to date with the text of the whole program
+  const std::vector<std::shared_ptr<ParsedStatement>> &
+  update(const std::string &text);
+
+  const std::vector<std::shared_ptr<ParsedStatement>> &statements() const {
+    return statements_;
+  }
+  const ReparseStats &stats() const { return stats_; }
+
+private:
+  // Previous statements by hash, for reuse
+  using Pool =
+      std::unordered_map<uint64_t,
+                         std::vector<std::shared_ptr<ParsedStatement>>>;
+
+  std::string text_;
+  std::vector<std::shared_ptr<ParsedStatement>> statements_;
+  // Byte offset of each statement's first token in text_
+  std::vector<size_t> offsets_;
+  ReparseStats stats_;
+
+  void update_all(const std::string &text);
+  bool update_range(const std::string &text);
+
+  // Statements of the token ranges, reused from the pool when possible.
+  // line_starts are the byte offsets of the token lines, indexed from
+  // first_line.
+  void collect(const std::vector<Token> &tokens,
+               const std::vector<std::pair<size_t, size_t>> &ranges,
+               Pool &pool, const std::vector<size_t> &line_starts,
+               size_t first_line,
+               std::vector<std::shared_ptr<ParsedStatement>> &statements,
+               std::vector<size_t> &offsets);
+
+  static std::shared_ptr<ParsedStatement>
+  parse(const std::vector<Token> &tokens, size_t begin, size_t end);
+};
+
+} // namespace pecco
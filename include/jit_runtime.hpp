@@ -0,0 +1,23 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/OptimizationLevel.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace pecco {
+
+// Create an in-process LLJIT for compiled Pecco code. The prelude builtins
+// (print, print_i32, print_f64, flush, write) bind to the runtime library's
+// __pecco_rt_ symbols in this process, so JIT code shares its output buffer
+// with the interpreter and the host; exit() calls exit_function. Any other
+// external symbol (pow from libm, ...) resolves against the process itself.
+llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>>
+create_runtime_jit(void (*exit_function)(int32_t));
+
+// Run the default new-PM pipeline for the given level over a JIT module
+void optimize_jit_module(llvm::Module &module, llvm::OptimizationLevel level);
+
+} // namespace pecco
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "incremental_document.hpp"
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace pecco {
+
+// Language Server Protocol server: JSON-RPC messages with Content-Length
+// headers on in/out (stdio for `plc --lsp`).
+//
+// Provides diagnostics, hover (inferred types), go-to-definition and
+// semantic tokens. Each open document is an IncrementalDocument, so an edit
+// re-parses and re-checks only the statements it touches. Text changes may
+// be incremental; positions are converted between LSP's UTF-16 offsets and
+// the front end's byte columns.
+class LanguageServer {
+public:
+  LanguageServer(std::istream &in, llvm::raw_ostream &out);
+  ~LanguageServer();
+
+  // Serve until the client sends 'exit'; returns the process exit status
+  int run();
+
+private:
+  struct Document;
+
+  std::istream &in_;
+  llvm::raw_ostream &out_;
+  std::map<std::string, std::unique_ptr<Document>> documents_; // By URI
+  bool shutdown_requested_ = false;
+
+  bool read_message(std::string &content);
+  void send(llvm::json::Value message);
+  void reply(const llvm::json::Value &id, llvm::json::Value result);
+  void reply_error(const llvm::json::Value &id, int code,
+                   const std::string &message);
+  void notify(const std::string &method, llvm::json::Value params);
+
+  // Returns false when the client asked to exit
+  bool handle(const llvm::json::Object &message);
+  llvm::json::Value initialize_result() const;
+  void did_open(const llvm::json::Object &params);
+  void did_change(const llvm::json::Object &params);
+  void did_close(const llvm::json::Object &params);
+  void publish_diagnostics(const std::string &uri, const Document &document);
+  llvm::json::Value hover(const llvm::json::Object &params) const;
+  llvm::json::Value definition(const llvm::json::Object &params) const;
+  llvm::json::Value semantic_tokens(const llvm::json::Object &params) const;
+
+  const Document *find_document(const llvm::json::Object &params) const;
+};
+
+} // namespace pecco
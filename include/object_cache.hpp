@@ -0,0 +1,58 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pecco {
+
+// Work done by the last ObjectCache::update()
+struct ObjectCacheStats {
+  size_t definitions = 0; // Functions defined by the module
+  size_t compiled = 0;    // Object files (re)built
+};
+
+// Object files of a program, one per function, reused across rebuilds.
+//
+// update() copies every function defined by the module into a module of
+// its own, holding the function, copies of the constants it uses and
+// declarations of everything else it references; mutable global variables
+// (top-level arrays) are defined together in one more module. The printed
+// IR of each module is the cache key: only functions whose IR changed (their
+// body, or the signature of a callee) are compiled to a new object file, the
+// others keep theirs. Linking the returned objects gives the same program as
+// compiling the whole module.
+//
+// Object files live in a directory owned by the caller; the cache removes
+// the ones it no longer needs, and all of them when it is destroyed.
+class ObjectCache {
+public:
+  ObjectCache(llvm::TargetMachine &target_machine, std::string directory);
+  ~ObjectCache();
+
+  ObjectCache(const ObjectCache &) = delete;
+  ObjectCache &operator=(const ObjectCache &) = delete;
+
+  // Split the module and bring the objects up to date (local functions of
+  // the module become external). On success objects lists them in the
+  // module's function order.
+  bool update(llvm::Module &module, std::vector<std::string> &objects,
+              std::string &error);
+
+  const ObjectCacheStats &stats() const { return stats_; }
+
+private:
+  llvm::TargetMachine &target_machine_;
+  std::string directory_;
+  // Printed per-function module -> its object file
+  std::unordered_map<std::string, std::string> objects_;
+  size_t next_object_ = 0;
+  ObjectCacheStats stats_;
+
+  bool emit(llvm::Module &module, const std::string &path, std::string &error);
+};
+
+} // namespace pecco
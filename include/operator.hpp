@@ -136,6 +136,11 @@ private:
       operators_;
 };
 
+// Mangled symbol name for an operator overload: op[$prefix|$postfix]$T1$T2...
+// The position suffix is only added for unary operators.
+std::string mangle_operator_name(const std::string &op, OpPosition position,
+                                 const std::vector<std::string> &param_types);
+
 // Default operator precedences (standard precedence levels)
 namespace precedence {
 constexpr int ASSIGNMENT = 10;     // = += -= etc (not yet implemented)
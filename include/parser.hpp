@@ -2,7 +2,9 @@
 
 #include "ast.hpp"
 #include "lexer.hpp"
+#include "token_stream.hpp"
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace pecco {
@@ -11,9 +13,32 @@ class Parser {
 public:
   explicit Parser(std::vector<Token> tokens);
 
+  // Parse tokens as the stream's lexer thread produces them. Batches are
+  // pulled on demand and the tokens of finished top-level statements are
+  // dropped, so only the statement being parsed is kept in memory.
+  // parse_program_parallel() parses sequentially on a stream. The stream's
+  // lexer errors are not reported by the parser (see
+  // TokenStream::lexer_errors).
+  explicit Parser(TokenStream &stream);
+
   // Parse a complete program (list of statements)
   std::vector<StmtPtr> parse_program();
 
+  // Same result and errors as parse_program(), parsing on up to `jobs`
+  // threads: the top-level statements are grouped into chunks of similar
+  // size, each parsed by its own Parser, and concatenated in source order.
+  // A chunk with errors makes it fall back to parse_program(), so errors
+  // and recovery are exactly those of the sequential parse.
+  std::vector<StmtPtr> parse_program_parallel(unsigned jobs);
+
+  // Token ranges [begin, end) of the top-level statements. A statement ends
+  // with ';' or with the '}' closing its outermost brace (unless an 'else'
+  // follows); comments before a statement belong to it, comments after the
+  // last one form a range of their own. open is set when the tokens end
+  // inside a statement (an unclosed bracket, or no ';' or '}' yet).
+  static std::vector<std::pair<size_t, size_t>>
+  split_top_level(const std::vector<Token> &tokens, bool *open = nullptr);
+
   // Check if there were any parse errors
   bool has_errors() const { return !errors_.empty(); }
 
@@ -42,6 +67,7 @@ private:
   ExprPtr parse_expr();
   ExprPtr parse_primary_expr();
   ExprPtr parse_call_expr(ExprPtr callee);
+  ExprPtr parse_index_expr(ExprPtr base);
 
   // Type parsing
   std::optional<TypePtr> parse_type_annotation();
@@ -64,13 +90,20 @@ private:
       const std::string &message); // Error after previous token
   void synchronize();
 
+  // Pull batches from stream_ until tokens_[idx] exists; false past the end
+  bool has_token(size_t idx) const;
+  // Drop the tokens of finished statements (streaming only)
+  void discard_consumed();
+
   // Convert token to source location
   SourceLocation token_loc(const Token &tok) const {
     return SourceLocation(tok.line, tok.column, tok.end_column);
   }
 
-  std::vector<Token> tokens_;
+  // Filled lazily from stream_ (hence mutable, for peek() and at_end())
+  mutable std::vector<Token> tokens_;
   std::size_t current_;
+  TokenStream *stream_ = nullptr;
   std::vector<ParseError> errors_;
 };
 
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+
+namespace pecco {
+
+// The runtime library (runtime/pecco_rt.h) implements the prelude's print
+// builtins and flush under __pecco_rt_-prefixed symbols, so a program that
+// embeds pecco_lib does not gain global names such as print or flush.
+// Generated code keeps calling the prelude names: create_runtime_jit binds
+// them for JIT code, bind_runtime_symbols for object files.
+
+// Redirect the module's declarations of those builtins to the runtime
+// library's symbols. Run before emitting an object file that is linked
+// against libpecco_rt; write and exit are left alone (the driver wraps them
+// at link time).
+void bind_runtime_symbols(llvm::Module &module);
+
+} // namespace pecco
@@ -87,6 +87,13 @@ public:
     current_scope_ = global_scope_.get();
   }
 
+  // Global symbols layered on a shared, read-only table (e.g. the prelude)
+  explicit ScopedSymbolTable(std::shared_ptr<const SymbolTable> base)
+      : global_symbols_(std::move(base)), current_scope_(nullptr) {
+    global_scope_ = std::make_unique<Scope>(ScopeKind::Global);
+    current_scope_ = global_scope_.get();
+  }
+
   // === Global symbols (functions, operators) ===
 
   void add_function(const FunctionSignature &sig) {
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ast.hpp"
+#include "compilation_session.hpp"
+#include "scope.hpp"
+#include "symbol_table.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pecco {
+
+// Work done by the queries since the last update()
+struct QueryStats {
+  size_t parsed = 0;       // Statements parsed
+  size_t declarations = 0; // Declaration tables built
+  size_t resolved = 0;     // Statements collected and operator-resolved
+  size_t checked = 0;      // Statements type checked
+};
+
+// Demand-driven semantic analysis of a program made of top-level statements.
+//
+// Nothing is computed up front: each query computes what it needs, pulling
+// other queries, and memoizes its result. A checked statement records what
+// it depended on (the signatures of the functions it calls, the global
+// variables it reads, the operator table) and is only checked again when
+// one of those changed, so editing a function body re-checks that function
+// and changing a signature re-checks its callers.
+//
+// Results survive update(): statements are identified by a key supplied by
+// the caller (typically their text), and a statement with the same key
+// keeps its memoized AST and results until a dependency changes.
+//
+// Locations are those of the ASTs the parse callbacks return.
+class SemanticQueries {
+public:
+  // Returns a fresh AST of one statement each time it is called (analysis
+  // rewrites the AST, so re-analysis starts from a new one)
+  using Parse = std::function<std::vector<StmtPtr>()>;
+
+  explicit SemanticQueries(std::shared_ptr<const SymbolTable> prelude =
+                               CompilationSession::default_prelude());
+  ~SemanticQueries();
+
+  // Replace the program: (key, parse) per statement, in source order. Keys
+  // must be unique.
+  void update(std::vector<std::pair<std::string, Parse>> statements);
+
+  size_t size() const { return statements_.size(); }
+
+  // === Queries ===
+
+  // Signatures of all top-level functions and operators, on the prelude
+  std::shared_ptr<const SymbolTable> declarations();
+
+  // Overloads of a function (prelude or program)
+  std::vector<FunctionSignature> function_signatures(const std::string &name);
+
+  // AST of a statement, analyzed as far as queried so far
+  const std::vector<StmtPtr> &syntax(size_t index);
+
+  // AST with scopes collected and operator sequences resolved into trees
+  const std::vector<StmtPtr> &resolved(size_t index);
+
+  // Global scope of a statement: its top-level variables, with the scopes
+  // of its functions and blocks as children (resolves the statement; valid
+  // until the statement is analyzed again)
+  const Scope &scopes(size_t index);
+
+  // Diagnostics of scope collection and operator resolution only (does not
+  // type check the statement)
+  const std::vector<Diagnostic> &resolution_diagnostics(size_t index);
+
+  // AST with expression types inferred
+  const std::vector<StmtPtr> &checked(size_t index);
+
+  // Type of the global variable `name` as seen by statement `index` (the
+  // last top-level let before it), empty if there is none
+  std::string global_type(const std::string &name, size_t index);
+
+  // Semantic diagnostics of a statement: scopes, operator resolution and
+  // type checking (checks the statement)
+  const std::vector<Diagnostic> &diagnostics(size_t index);
+
+  const QueryStats &stats() const { return stats_; }
+
+private:
+  struct Statement;
+
+  std::shared_ptr<const SymbolTable> prelude_;
+  std::vector<std::unique_ptr<Statement>> statements_;
+  // Incremented by update(); memoized results verified in the current
+  // revision are not validated again
+  size_t revision_ = 0;
+
+  std::string declarations_key_;
+  std::string operators_key_;
+  std::shared_ptr<const SymbolTable> declaration_table_;
+  size_t declarations_revision_ = 0;
+
+  QueryStats stats_;
+
+  // Current fingerprint of a dependency recorded by a checked statement
+  std::string dependency(const std::string &key, size_t index);
+  void parse(Statement &statement);
+};
+
+} // namespace pecco
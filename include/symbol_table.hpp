@@ -3,6 +3,7 @@
 #include "ast.hpp"
 #include "operator.hpp"
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -26,8 +27,17 @@ struct FunctionSignature {
 };
 
 // Symbol table for functions and operators
+//
+// A table can be layered on top of a shared, immutable base table (the
+// prelude): lookups see the base's symbols before the table's own, and
+// additions only go to the top layer, so many tables can share one base
+// from different threads.
 class SymbolTable {
 public:
+  SymbolTable() = default;
+  explicit SymbolTable(std::shared_ptr<const SymbolTable> base)
+      : base_(std::move(base)) {}
+
   // Add a function signature
   void add_function(const FunctionSignature &sig);
 
@@ -61,6 +71,9 @@ public:
   std::vector<OperatorInfo> get_all_operators() const;
 
 private:
+  // Read-only lower layer (may be null)
+  std::shared_ptr<const SymbolTable> base_;
+
   // Map: function_name -> list of overloads
   std::map<std::string, std::vector<FunctionSignature>> functions_;
 
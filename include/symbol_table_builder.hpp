@@ -42,7 +42,7 @@ private:
 
   std::vector<Error> errors_;
   bool collecting_prelude_ = false; // Track if we're loading prelude
-  int next_block_num_ = 0;          // For generating block descriptions
+  int next_block_num_ = 0; // Block descriptions, per top-level statement
 };
 
 } // namespace pecco
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// A small graph of tasks run on a pool of threads. A task starts once all
+// the tasks it depends on have succeeded; if one of them fails, it is
+// skipped (and so are the tasks depending on it).
+class TaskGraph {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Id = size_t;
+
+  // When and where a task ran; thread 0 is the thread calling run()
+  struct Timing {
+    std::string name;
+    Clock::time_point start;
+    Clock::time_point end;
+    unsigned thread = 0;
+    bool ran = false;
+    bool succeeded = false;
+  };
+
+  // Tasks can only depend on tasks added before them
+  Id add(std::string name, std::function<bool()> work,
+         std::vector<Id> dependencies = {});
+
+  // Run all tasks on up to `threads` threads (including the calling one);
+  // true if all of them succeeded. Must be called once.
+  bool run(unsigned threads);
+
+  bool succeeded(Id task) const { return tasks_[task].timing.succeeded; }
+  std::vector<Timing> timings() const;
+
+private:
+  struct Task {
+    std::function<bool()> work;
+    std::vector<Id> dependents;
+    size_t waiting_for = 0; // Dependencies not finished yet
+    bool skipped = false;   // A dependency failed
+    Timing timing;
+  };
+
+  std::vector<Task> tasks_;
+};
+
+} // namespace pecco
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "call_graph.hpp"
+#include "scope.hpp"
+#include "vm.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace llvm::orc {
+class LLJIT;
+} // namespace llvm::orc
+
+namespace pecco {
+
+// Second execution tier for the bytecode VM (--tiered).
+//
+// Hot functions reported by the VM are lowered through CodeGen, optimized
+// and compiled by an ORC LLJIT on a background thread while the interpreter
+// keeps running. Each compiled function gets a small adapter reading its
+// arguments from VM registers; once that is installed the VM calls into
+// native code instead of interpreting the function.
+//
+// A tier-up compiles the hot function together with the not yet compiled
+// functions and operators it transitively calls, so native code never calls
+// back into the interpreter. Frames already executing in the VM finish in
+// bytecode (there is no on-stack replacement).
+//
+// The statements and symbol table must stay alive and unmodified while the
+// TieredJit exists, and the TieredJit must outlive every VM::run() it serves.
+class TieredJit {
+public:
+  struct TierUp {
+    // Function that got hot
+    std::string function;
+    // Functions compiled by this tier-up (empty on failure)
+    std::vector<std::string> compiled;
+    double milliseconds = 0;
+    std::string error;
+  };
+
+  TieredJit(std::vector<StmtPtr> &stmts, const ScopedSymbolTable &symbols,
+            const BytecodeModule &module, VM &vm);
+  ~TieredJit();
+
+  TieredJit(const TieredJit &) = delete;
+  TieredJit &operator=(const TieredJit &) = delete;
+
+  // Queue a function for compilation; called from the VM's tier-up hook
+  void request(size_t function);
+
+  // Block until all queued requests are compiled and installed
+  void wait_idle();
+
+  // Finished tier-ups in completion order
+  std::vector<TierUp> tier_ups() const;
+
+private:
+  std::vector<StmtPtr> &stmts_;
+  const ScopedSymbolTable &symbols_;
+  const BytecodeModule &module_;
+  VM &vm_;
+  CallGraph call_graph_;
+  std::map<std::string, size_t> function_indices_;
+
+  // Only touched by the worker thread
+  std::unique_ptr<llvm::orc::LLJIT> jit_;
+  std::set<std::string> compiled_;
+  unsigned next_module_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::deque<size_t> queue_;
+  std::set<size_t> requested_;
+  std::vector<TierUp> tier_ups_;
+  bool busy_ = false;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  void run_worker();
+  TierUp compile(size_t function);
+};
+
+} // namespace pecco
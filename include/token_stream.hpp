@@ -0,0 +1,61 @@
+#pragma once
+
+#include "lexer.hpp"
+#include "token.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pecco {
+
+// Tokens of a source text, lexed on a background thread while they are
+// consumed (see Parser(TokenStream &)).
+//
+// The lexer thread hands the tokens over in batches through a fixed ring of
+// slots with one producer and one consumer: each side only advances its own
+// index, and blocks (std::atomic::wait) when the ring is full or empty. At
+// most kSlots batches are buffered, so memory does not grow with the input.
+class TokenStream {
+public:
+  static constexpr size_t kSlots = 8;
+  static constexpr size_t kDefaultBatchSize = 1024;
+
+  explicit TokenStream(std::string_view source,
+                       size_t batch_size = kDefaultBatchSize);
+  // Stops the lexer thread if the tokens were not all consumed
+  ~TokenStream();
+
+  TokenStream(const TokenStream &) = delete;
+  TokenStream &operator=(const TokenStream &) = delete;
+
+  // Append the next batch to tokens; false once the batch holding the
+  // EndOfFile token has been taken
+  bool next_batch(std::vector<Token> &tokens);
+
+  // Error tokens of the whole source, in order; the remaining tokens are
+  // consumed (and dropped) first
+  const std::vector<Token> &lexer_errors();
+
+private:
+  Lexer lexer_;
+  size_t batch_size_;
+  std::array<std::vector<Token>, kSlots> slots_;
+  // Batches taken by the consumer and produced by the lexer thread; slot i
+  // % kSlots is owned by the producer when i >= head_, by the consumer when
+  // i < tail_
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<bool> stop_{false};
+  bool finished_ = false; // EndOfFile consumed
+  // Written by the lexer thread, read after EndOfFile
+  std::vector<Token> errors_;
+  std::thread lexer_thread_;
+
+  void produce();
+};
+
+} // namespace pecco
@@ -3,6 +3,7 @@
 #include "ast.hpp"
 #include "error.hpp"
 #include "scope.hpp"
+#include <map>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,11 @@ public:
   // Check types for all statements and infer expression types
   bool check(std::vector<StmtPtr> &stmts, const ScopedSymbolTable &symbols);
 
+  // Same, with variables already defined in the global scope (name -> type),
+  // e.g. by earlier statements checked separately
+  bool check(std::vector<StmtPtr> &stmts, const ScopedSymbolTable &symbols,
+             const std::map<std::string, std::string> &globals);
+
   bool has_errors() const { return !errors_.empty(); }
   const std::vector<Error> &errors() const { return errors_; }
 
@@ -40,6 +46,18 @@ private:
   // Check and infer expression types, returns inferred type
   std::string check_expr(Expr *expr);
 
+  // Type of an integer literal from its suffix; reports values that do not
+  // fit. A negated literal may be one past the largest signed value
+  std::string check_int_literal(IntLiteralExpr *lit, bool negated);
+  // Two different integer types or two different float types, which need an
+  // explicit conversion
+  bool is_numeric_mix(const std::string &left, const std::string &right) const;
+
+  // Lane arguments of the SIMD builtins: shuffle lanes must be literals,
+  // and literal lanes must be in range
+  void check_lane_arguments(CallExpr *call, const std::string &func_name,
+                            const std::vector<std::string> &arg_types);
+
   // Helper: get type name from Type AST node
   std::string get_type_name(const Type *type) const;
 };
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bytecode.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pecco {
+
+// Executes a BytecodeModule in-process. Dispatch is direct-threaded (each
+// instruction carries the address of its handler, computed goto) when the
+// compiler supports labels as values, and a switch loop otherwise.
+//
+// Output goes through the runtime library's buffer, so it is formatted
+// exactly like a compiled program's output.
+//
+// For tiered execution the VM counts calls and loop back-edges per function.
+// Once a function gets hot, a native entry point can be installed for it
+// (from any thread); later calls to that function jump straight into native
+// code instead of interpreting it.
+class VM {
+public:
+  // Registers shared by all frames (8 MiB)
+  static constexpr size_t kStackSlots = size_t{1} << 20;
+  static constexpr size_t kMaxCallDepth = 100000;
+
+  // Native implementation of a bytecode function: reads the parameters from
+  // args[0..num_params) and stores the return value (if any) in *result
+  using NativeEntry = void (*)(VMValue *args, VMValue *result);
+
+  explicit VM(const BytecodeModule &module);
+
+  // Run the entry function, returns the program's exit status
+  int32_t run();
+
+  // Call on_hot(function index) once for each function whose calls plus
+  // loop back-edges reach threshold. The callback runs on the interpreter
+  // thread and should only hand the work off. A threshold of 0 disables
+  // counting.
+  void set_tier_up(uint32_t threshold, std::function<void(size_t)> on_hot);
+
+  // Route subsequent calls of a function to native code. Thread-safe.
+  void install_native(size_t function, NativeEntry entry);
+
+  bool has_error() const { return !error_.empty(); }
+  const std::string &error() const { return error_; }
+
+private:
+  struct ThreadedInstr {
+    const void *handler;
+    Opcode op;
+    uint16_t a, b, c;
+  };
+
+  struct Frame {
+    const ThreadedInstr *code;
+    const ThreadedInstr *return_pc;
+    VMValue *base;
+    uint32_t function;
+    uint16_t dest;
+  };
+
+  const BytecodeModule &module_;
+  std::vector<std::vector<ThreadedInstr>> code_;
+  std::unique_ptr<VMValue[]> stack_;
+  std::vector<Frame> frames_;
+  std::string error_;
+
+  // Tiering state
+  uint32_t tier_threshold_ = 0;
+  std::function<void(size_t)> on_hot_;
+  std::vector<uint32_t> hotness_;
+  std::unique_ptr<std::atomic<NativeEntry>[]> natives_;
+
+  void thread_code(const void *const *handlers);
+  void count_hotness(size_t function);
+  int32_t execute();
+  int32_t runtime_error(const std::string &msg);
+};
+
+} // namespace pecco
@@ -0,0 +1,328 @@
+#include "pecco_rt.h"
+
+#ifdef PECCO_RT_FREESTANDING
+
+// 独立模式：不依赖 libc，直接使用 Linux 系统调用
+#include <stddef.h>
+
+#if !defined(__x86_64__)
+#error "freestanding runtime only supports x86_64 Linux"
+#endif
+
+#define RT_SYS_WRITE 1
+#define RT_SYS_EXIT_GROUP 231
+#define RT_EINTR 4
+
+static long rt_sys_write(int32_t fd, const char *buf, long count) {
+  long ret;
+  __asm__ volatile("syscall"
+                   : "=a"(ret)
+                   : "a"((long)RT_SYS_WRITE), "D"((long)fd), "S"(buf),
+                     "d"(count)
+                   : "rcx", "r11", "memory");
+  return ret;
+}
+
+static void rt_sys_exit(int32_t code) {
+  for (;;) {
+    __asm__ volatile("syscall"
+                     :
+                     : "a"((long)RT_SYS_EXIT_GROUP), "D"((long)code)
+                     : "rcx", "r11", "memory");
+  }
+}
+
+// 出错时内核直接返回负的 errno
+#define RT_WRITE_INTERRUPTED(n) ((n) == -RT_EINTR)
+
+#else
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 直接走系统调用：被 --wrap 的 write 不能在运行时内部使用，否则会递归
+static long rt_sys_write(int32_t fd, const char *buf, long count) {
+  return syscall(SYS_write, fd, buf, count);
+}
+
+#define RT_WRITE_INTERRUPTED(n) (errno == EINTR)
+
+#endif
+
+// 输出缓冲区大小
+#define PECCO_RT_BUFFER_SIZE 65536
+
+static char out_buf[PECCO_RT_BUFFER_SIZE];
+static int32_t out_len = 0;
+
+// 写出全部数据，处理短写与 EINTR
+static void rt_write_all(int32_t fd, const char *buf, long count) {
+  while (count > 0) {
+    long n = rt_sys_write(fd, buf, count);
+    if (n < 0) {
+      if (RT_WRITE_INTERRUPTED(n)) {
+        continue;
+      }
+      return;
+    }
+    buf += n;
+    count -= n;
+  }
+}
+
+void __pecco_rt_flush(void) {
+  if (out_len > 0) {
+    rt_write_all(1, out_buf, out_len);
+    out_len = 0;
+  }
+}
+
+static void rt_append(const char *buf, int32_t count) {
+  if (count > PECCO_RT_BUFFER_SIZE - out_len) {
+    __pecco_rt_flush();
+    // 大块数据不经过缓冲区
+    if (count >= PECCO_RT_BUFFER_SIZE) {
+      rt_write_all(1, buf, count);
+      return;
+    }
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    out_buf[out_len + i] = buf[i];
+  }
+  out_len += count;
+}
+
+int32_t __pecco_rt_write(int32_t fd, const char *buf, int32_t count) {
+  if (count <= 0) {
+    return 0;
+  }
+  if (fd == 1) {
+    rt_append(buf, count);
+    return count;
+  }
+  // 其他 fd（如 stderr）保持无缓冲，先刷新 stdout 保证输出顺序
+  __pecco_rt_flush();
+  rt_write_all(fd, buf, count);
+  return count;
+}
+
+// ===== 数字格式化 =====
+
+static const char kDigitPairs[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+// 将无符号整数写入 buf 末尾（每次处理两位），返回起始位置
+static char *rt_format_u64(uint64_t value, char *end) {
+  char *p = end;
+  while (value >= 100) {
+    uint64_t pair = (value % 100) * 2;
+    value /= 100;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  }
+  if (value >= 10) {
+    uint64_t pair = value * 2;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  } else {
+    *--p = (char)('0' + value);
+  }
+  return p;
+}
+
+// 小数部分保留的位数
+#define PECCO_RT_FRAC_DIGITS 6
+#define PECCO_RT_FRAC_SCALE 1000000.0
+
+// 写出 [0, 1) 范围内小数的 6 位数字，去掉末尾的 0
+static void rt_append_fraction(uint64_t frac) {
+  char digits[PECCO_RT_FRAC_DIGITS];
+  for (int i = PECCO_RT_FRAC_DIGITS - 1; i >= 0; --i) {
+    digits[i] = (char)('0' + frac % 10);
+    frac /= 10;
+  }
+  int32_t len = PECCO_RT_FRAC_DIGITS;
+  while (len > 0 && digits[len - 1] == '0') {
+    --len;
+  }
+  if (len > 0) {
+    rt_append(".", 1);
+    rt_append(digits, len);
+  }
+}
+
+// 定点格式：整数部分 + 最多 6 位小数，要求 0 <= value < 1e16
+static void rt_append_fixed(double value) {
+  uint64_t int_part = (uint64_t)value;
+  uint64_t frac = (uint64_t)((value - (double)int_part) * PECCO_RT_FRAC_SCALE +
+                             0.5);
+  if (frac >= (uint64_t)PECCO_RT_FRAC_SCALE) {
+    int_part += 1;
+    frac = 0;
+  }
+  char buf[24];
+  char *end = buf + sizeof(buf);
+  char *start = rt_format_u64(int_part, end);
+  rt_append(start, (int32_t)(end - start));
+  rt_append_fraction(frac);
+}
+
+// 科学计数法：d.dddddde±XX
+static void rt_append_scientific(double value) {
+  int32_t exponent = 0;
+  while (value >= 10.0) {
+    value /= 10.0;
+    ++exponent;
+  }
+  while (value < 1.0) {
+    value *= 10.0;
+    --exponent;
+  }
+  uint64_t digit = (uint64_t)value;
+  uint64_t frac =
+      (uint64_t)((value - (double)digit) * PECCO_RT_FRAC_SCALE + 0.5);
+  if (frac >= (uint64_t)PECCO_RT_FRAC_SCALE) {
+    digit += 1;
+    frac = 0;
+    if (digit == 10) {
+      digit = 1;
+      ++exponent;
+    }
+  }
+  char lead = (char)('0' + digit);
+  rt_append(&lead, 1);
+  rt_append_fraction(frac);
+
+  rt_append(exponent < 0 ? "e-" : "e+", 2);
+  uint64_t abs_exp = exponent < 0 ? (uint64_t)-exponent : (uint64_t)exponent;
+  char buf[8];
+  char *end = buf + sizeof(buf);
+  char *start = rt_format_u64(abs_exp, end);
+  if (abs_exp < 10) {
+    *--start = '0';
+  }
+  rt_append(start, (int32_t)(end - start));
+}
+
+// ===== prelude 内置函数 =====
+
+void __pecco_rt_print(const char *str) {
+  int32_t len = 0;
+  while (str[len] != '\0') {
+    ++len;
+  }
+  rt_append(str, len);
+}
+
+void __pecco_rt_print_i32(int32_t value) {
+  char buf[16];
+  char *end = buf + sizeof(buf);
+  // 先转成 64 位再取绝对值，避免 INT32_MIN 溢出
+  int64_t wide = value;
+  char *start = rt_format_u64((uint64_t)(wide < 0 ? -wide : wide), end);
+  if (wide < 0) {
+    *--start = '-';
+  }
+  rt_append(start, (int32_t)(end - start));
+}
+
+void __pecco_rt_print_i64(int64_t value) {
+  char buf[24];
+  char *end = buf + sizeof(buf);
+  // 在无符号域取反，INT64_MIN 也不会溢出
+  uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+  char *start = rt_format_u64(magnitude, end);
+  if (value < 0) {
+    *--start = '-';
+  }
+  rt_append(start, (int32_t)(end - start));
+}
+
+void __pecco_rt_print_u64(uint64_t value) {
+  char buf[24];
+  char *end = buf + sizeof(buf);
+  char *start = rt_format_u64(value, end);
+  rt_append(start, (int32_t)(end - start));
+}
+
+void __pecco_rt_print_f64(double value) {
+  if (value != value) {
+    rt_append("nan", 3);
+    return;
+  }
+  // 处理符号（包括 -0.0）
+  union {
+    double d;
+    uint64_t u;
+  } bits = {value};
+  if (bits.u >> 63) {
+    rt_append("-", 1);
+    value = -value;
+  }
+  if (value > 1.7976931348623157e308) {
+    rt_append("inf", 3);
+    return;
+  }
+  if (value == 0.0 || (value >= 1e-5 && value < 1e16)) {
+    rt_append_fixed(value);
+  } else {
+    rt_append_scientific(value);
+  }
+}
+
+#ifdef PECCO_RT_FREESTANDING
+
+// ===== 独立模式下的 prelude 函数与编译器依赖 =====
+
+int32_t write(int32_t fd, const char *buf, int32_t count) {
+  return __pecco_rt_write(fd, buf, count);
+}
+
+void exit(int32_t code) {
+  __pecco_rt_flush();
+  rt_sys_exit(code);
+}
+
+// LLVM/GCC 即使在独立模式下也可能生成对这些函数的调用
+void *memcpy(void *dest, const void *src, size_t n) {
+  char *d = dest;
+  const char *s = src;
+  while (n--) {
+    *d++ = *s++;
+  }
+  return dest;
+}
+
+void *memmove(void *dest, const void *src, size_t n) {
+  char *d = dest;
+  const char *s = src;
+  if (d < s) {
+    while (n--) {
+      *d++ = *s++;
+    }
+  } else {
+    while (n--) {
+      d[n] = s[n];
+    }
+  }
+  return dest;
+}
+
+void *memset(void *dest, int c, size_t n) {
+  unsigned char *d = dest;
+  while (n--) {
+    *d++ = (unsigned char)c;
+  }
+  return dest;
+}
+
+#endif
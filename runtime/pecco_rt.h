@@ -0,0 +1,40 @@
+#ifndef PECCO_RT_H
+#define PECCO_RT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===== 运行时内部接口 =====
+
+// 带缓冲的 write：fd 1 写入输出缓冲区，其他 fd 先刷新缓冲区再直接写
+int32_t __pecco_rt_write(int32_t fd, const char *buf, int32_t count);
+
+// 将输出缓冲区写回 fd 1
+void __pecco_rt_flush(void);
+
+// ===== prelude 内置函数 =====
+// 符号带 __pecco_rt_ 前缀，嵌入 pecco_lib 的宿主程序中不会多出 print 之类的
+// 通用全局符号。生成的代码仍调用 prelude 的名字，由 create_runtime_jit 与
+// bind_runtime_symbols（输出目标文件前）绑定到这些符号；prelude 的 flush
+// 即 __pecco_rt_flush
+
+void __pecco_rt_print(const char *str);
+void __pecco_rt_print_i32(int32_t value);
+void __pecco_rt_print_i64(int64_t value);
+void __pecco_rt_print_u64(uint64_t value);
+void __pecco_rt_print_f64(double value);
+
+#ifdef PECCO_RT_FREESTANDING
+// 独立模式下 prelude 的 write/exit 直接由运行时实现
+int32_t write(int32_t fd, const char *buf, int32_t count);
+void exit(int32_t code);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PECCO_RT_H
@@ -0,0 +1,16 @@
+// 链接器包装：plc 以 -Wl,--wrap=write -Wl,--wrap=exit 链接生成的程序，
+// 使 prelude 的 write/exit 经过运行时的输出缓冲区。
+// 未使用 --wrap 时没有目标文件引用这些符号，本文件不会被链接进来。
+
+#include "pecco_rt.h"
+
+extern void __real_exit(int32_t code);
+
+int32_t __wrap_write(int32_t fd, const char *buf, int32_t count) {
+  return __pecco_rt_write(fd, buf, count);
+}
+
+void __wrap_exit(int32_t code) {
+  __pecco_rt_flush();
+  __real_exit(code);
+}
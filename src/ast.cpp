@@ -12,16 +12,78 @@ static void print_indent(std::ostream &os, int indent) {
 
 // Type print implementation
 
+Type::Type(TypePtr element, size_t size, SourceLocation loc)
+    : kind(TypeKind::Array), name(array_type_name(element->name, size)),
+      element(std::move(element)), size(size), loc(loc) {}
+
 void Type::print(std::ostream &os) const { os << name; }
 
+std::optional<ArrayTypeName> parse_array_type_name(const std::string &name) {
+  if (name.size() < 4 || name[0] != '[') {
+    return std::nullopt;
+  }
+  size_t close = name.find(']');
+  if (close == std::string::npos || close == 1 || close + 1 == name.size()) {
+    return std::nullopt;
+  }
+  size_t size = 0;
+  for (size_t i = 1; i < close; ++i) {
+    if (name[i] < '0' || name[i] > '9') {
+      return std::nullopt;
+    }
+    size = size * 10 + (name[i] - '0');
+  }
+  return ArrayTypeName{name.substr(close + 1), size};
+}
+
+std::string array_type_name(const std::string &element, size_t size) {
+  return "[" + std::to_string(size) + "]" + element;
+}
+
+std::optional<IntegerTypeName>
+parse_integer_type_name(const std::string &name) {
+  if (name.size() < 2 || (name[0] != 'i' && name[0] != 'u')) {
+    return std::nullopt;
+  }
+  std::string bits = name.substr(1);
+  if (bits != "8" && bits != "16" && bits != "32" && bits != "64") {
+    return std::nullopt;
+  }
+  return IntegerTypeName{static_cast<unsigned>(std::stoul(bits)),
+                         name[0] == 'i'};
+}
+
+std::optional<VectorTypeName> parse_vector_type_name(const std::string &name) {
+  size_t x = name.rfind('x');
+  if (x == std::string::npos || x + 1 == name.size() || x + 3 < name.size()) {
+    return std::nullopt;
+  }
+  std::string element = name.substr(0, x);
+  if (element != "i32" && element != "f64" && element != "bool") {
+    return std::nullopt;
+  }
+  size_t lanes = 0;
+  for (size_t i = x + 1; i < name.size(); ++i) {
+    if (name[i] < '0' || name[i] > '9') {
+      return std::nullopt;
+    }
+    lanes = lanes * 10 + (name[i] - '0');
+  }
+  // Powers of two only, which also rejects leading zeros
+  if (lanes < 2 || lanes > 64 || (lanes & (lanes - 1)) != 0) {
+    return std::nullopt;
+  }
+  return VectorTypeName{std::move(element), lanes};
+}
+
 // Expression print implementations
 
 void IntLiteralExpr::print(std::ostream &os) const {
-  os << "IntLiteral(" << value << ")";
+  os << "IntLiteral(" << value << (type == "i32" ? "" : type) << ")";
 }
 
 void FloatLiteralExpr::print(std::ostream &os) const {
-  os << "FloatLiteral(" << value << ")";
+  os << "FloatLiteral(" << value << (type == "f64" ? "" : type) << ")";
 }
 
 void StringLiteralExpr::print(std::ostream &os) const {
@@ -92,6 +154,14 @@ void CallExpr::print(std::ostream &os) const {
   os << "])";
 }
 
+void IndexExpr::print(std::ostream &os) const {
+  os << "Index(";
+  base->print(os);
+  os << ", ";
+  index->print(os);
+  os << ")";
+}
+
 // Statement print implementations
 
 void LetStmt::print(std::ostream &os, int indent) const {
@@ -101,8 +171,10 @@ void LetStmt::print(std::ostream &os, int indent) const {
     os << " : ";
     (*type)->print(os);
   }
-  os << " = ";
-  init->print(os);
+  if (init) {
+    os << " = ";
+    init->print(os);
+  }
   os << ")\n";
 }
 
@@ -231,4 +303,168 @@ void BlockStmt::print(std::ostream &os, int indent) const {
   }
 }
 
+// Copies
+
+namespace {
+
+template <typename T>
+std::unique_ptr<T> clone_ptr(const std::unique_ptr<T> &p) {
+  return p ? clone(*p) : nullptr;
+}
+
+template <typename T>
+std::optional<std::unique_ptr<T>>
+clone_optional(const std::optional<std::unique_ptr<T>> &p) {
+  if (!p) {
+    return std::nullopt;
+  }
+  return clone_ptr(*p);
+}
+
+std::vector<Parameter> clone_params(const std::vector<Parameter> &params) {
+  std::vector<Parameter> copies;
+  copies.reserve(params.size());
+  for (const auto &param : params) {
+    copies.emplace_back(param.name, clone_optional(param.type), param.loc);
+  }
+  return copies;
+}
+
+ExprPtr clone_expr(const Expr &expr) {
+  switch (expr.kind) {
+  case ExprKind::IntLiteral: {
+    auto &lit = static_cast<const IntLiteralExpr &>(expr);
+    return std::make_unique<IntLiteralExpr>(lit.value, lit.loc, lit.type);
+  }
+  case ExprKind::FloatLiteral: {
+    auto &lit = static_cast<const FloatLiteralExpr &>(expr);
+    return std::make_unique<FloatLiteralExpr>(lit.value, lit.loc, lit.type);
+  }
+  case ExprKind::StringLiteral:
+    return std::make_unique<StringLiteralExpr>(
+        static_cast<const StringLiteralExpr &>(expr).value, expr.loc);
+  case ExprKind::BoolLiteral:
+    return std::make_unique<BoolLiteralExpr>(
+        static_cast<const BoolLiteralExpr &>(expr).value, expr.loc);
+  case ExprKind::Identifier:
+    return std::make_unique<IdentifierExpr>(
+        static_cast<const IdentifierExpr &>(expr).name, expr.loc);
+  case ExprKind::Binary: {
+    auto &binary = static_cast<const BinaryExpr &>(expr);
+    auto copy = std::make_unique<BinaryExpr>(binary.op, clone_ptr(binary.left),
+                                             clone_ptr(binary.right),
+                                             binary.loc);
+    copy->position = binary.position;
+    return copy;
+  }
+  case ExprKind::Unary: {
+    auto &unary = static_cast<const UnaryExpr &>(expr);
+    return std::make_unique<UnaryExpr>(unary.op, clone_ptr(unary.operand),
+                                       unary.position, unary.loc);
+  }
+  case ExprKind::OperatorSeq: {
+    auto &seq = static_cast<const OperatorSeqExpr &>(expr);
+    std::vector<OpSeqItem> items;
+    items.reserve(seq.items.size());
+    for (const auto &item : seq.items) {
+      if (item.kind == OpSeqItem::Kind::Operator) {
+        items.emplace_back(item.op, item.loc);
+      } else {
+        items.emplace_back(clone_ptr(item.operand));
+        items.back().loc = item.loc;
+      }
+    }
+    return std::make_unique<OperatorSeqExpr>(std::move(items), seq.loc);
+  }
+  case ExprKind::Call: {
+    auto &call = static_cast<const CallExpr &>(expr);
+    std::vector<ExprPtr> args;
+    args.reserve(call.args.size());
+    for (const auto &arg : call.args) {
+      args.push_back(clone_ptr(arg));
+    }
+    return std::make_unique<CallExpr>(clone_ptr(call.callee), std::move(args),
+                                      call.loc);
+  }
+  case ExprKind::Index: {
+    auto &index = static_cast<const IndexExpr &>(expr);
+    return std::make_unique<IndexExpr>(clone_ptr(index.base),
+                                       clone_ptr(index.index), index.loc);
+  }
+  }
+  return nullptr;
+}
+
+StmtPtr clone_stmt(const Stmt &stmt) {
+  switch (stmt.kind) {
+  case StmtKind::Let: {
+    auto &let = static_cast<const LetStmt &>(stmt);
+    return std::make_unique<LetStmt>(let.name, clone_optional(let.type),
+                                     clone_ptr(let.init), let.loc);
+  }
+  case StmtKind::Func: {
+    auto &func = static_cast<const FuncStmt &>(stmt);
+    return std::make_unique<FuncStmt>(
+        func.name, clone_params(func.params), clone_optional(func.return_type),
+        clone_optional(func.body), func.loc);
+  }
+  case StmtKind::OperatorDecl: {
+    auto &op = static_cast<const OperatorDeclStmt &>(stmt);
+    return std::make_unique<OperatorDeclStmt>(
+        op.op, op.position, clone_params(op.params),
+        clone_optional(op.return_type), op.precedence, op.assoc,
+        clone_optional(op.body), op.loc);
+  }
+  case StmtKind::If: {
+    auto &if_stmt = static_cast<const IfStmt &>(stmt);
+    return std::make_unique<IfStmt>(
+        clone_ptr(if_stmt.condition), clone_ptr(if_stmt.then_branch),
+        clone_optional(if_stmt.else_branch), if_stmt.loc);
+  }
+  case StmtKind::Return: {
+    auto &ret = static_cast<const ReturnStmt &>(stmt);
+    return std::make_unique<ReturnStmt>(clone_optional(ret.value), ret.loc);
+  }
+  case StmtKind::While: {
+    auto &while_stmt = static_cast<const WhileStmt &>(stmt);
+    return std::make_unique<WhileStmt>(clone_ptr(while_stmt.condition),
+                                       clone_ptr(while_stmt.body),
+                                       while_stmt.loc);
+  }
+  case StmtKind::Expr:
+    return std::make_unique<ExprStmt>(
+        clone_ptr(static_cast<const ExprStmt &>(stmt).expr), stmt.loc);
+  case StmtKind::Block:
+    return std::make_unique<BlockStmt>(
+        clone(static_cast<const BlockStmt &>(stmt).stmts), stmt.loc);
+  }
+  return nullptr;
+}
+
+} // namespace
+
+TypePtr clone(const Type &type) {
+  if (type.kind == TypeKind::Array) {
+    return std::make_unique<Type>(clone_ptr(type.element), type.size, type.loc);
+  }
+  return std::make_unique<Type>(type.name, type.loc);
+}
+
+ExprPtr clone(const Expr &expr) {
+  ExprPtr copy = clone_expr(expr);
+  copy->inferred_type = expr.inferred_type;
+  return copy;
+}
+
+StmtPtr clone(const Stmt &stmt) { return clone_stmt(stmt); }
+
+std::vector<StmtPtr> clone(const std::vector<StmtPtr> &stmts) {
+  std::vector<StmtPtr> copies;
+  copies.reserve(stmts.size());
+  for (const auto &stmt : stmts) {
+    copies.push_back(clone_ptr(stmt));
+  }
+  return copies;
+}
+
 } // namespace pecco
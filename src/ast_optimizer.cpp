@@ -0,0 +1,721 @@
+#include "ast_optimizer.hpp"
+#include "ctfe.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+namespace pecco {
+
+// ===== Compile-time values =====
+
+std::optional<ConstValue> literal_value(const Expr *expr) {
+  if (!expr)
+    return std::nullopt;
+  try {
+    switch (expr->kind) {
+    case ExprKind::IntLiteral: {
+      // Only i32 is folded; other widths (255u8) are left to codegen
+      auto *lit = static_cast<const IntLiteralExpr *>(expr);
+      if (lit->type != "i32")
+        return std::nullopt;
+      // Same conversion as codegen: parse as i64, truncate to 32 bits
+      int64_t value = std::stoll(lit->value);
+      return static_cast<int32_t>(static_cast<uint32_t>(value));
+    }
+    case ExprKind::FloatLiteral: {
+      // Only f64 is folded; f32 rounding is left to codegen
+      auto *lit = static_cast<const FloatLiteralExpr *>(expr);
+      if (lit->type != "f64")
+        return std::nullopt;
+      return std::stod(lit->value);
+    }
+    case ExprKind::BoolLiteral:
+      return static_cast<const BoolLiteralExpr *>(expr)->value;
+    default:
+      return std::nullopt;
+    }
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+
+ExprPtr make_literal(const ConstValue &value, SourceLocation loc) {
+  ExprPtr lit;
+  if (auto *i = std::get_if<int32_t>(&value)) {
+    lit = std::make_unique<IntLiteralExpr>(std::to_string(*i), loc);
+    lit->inferred_type = "i32";
+  } else if (auto *f = std::get_if<double>(&value)) {
+    // Non-finite values have no literal spelling
+    if (!std::isfinite(*f))
+      return nullptr;
+    std::ostringstream os;
+    os << std::setprecision(std::numeric_limits<double>::max_digits10) << *f;
+    lit = std::make_unique<FloatLiteralExpr>(os.str(), loc);
+    lit->inferred_type = "f64";
+  } else {
+    lit = std::make_unique<BoolLiteralExpr>(std::get<bool>(value), loc);
+    lit->inferred_type = "bool";
+  }
+  return lit;
+}
+
+namespace {
+
+// Codegen selects builtin instructions by LLVM type: i32 and bool are both
+// integers there
+bool is_integer(const ConstValue &value) {
+  return !std::holds_alternative<double>(value);
+}
+
+bool is_double(const ConstValue &value) {
+  return std::holds_alternative<double>(value);
+}
+
+std::optional<ConstValue> eval_i32_binary(const std::string &op, int32_t a,
+                                          int32_t b) {
+  uint32_t ua = static_cast<uint32_t>(a);
+  uint32_t ub = static_cast<uint32_t>(b);
+  auto wrap = [](uint32_t value) { return static_cast<int32_t>(value); };
+
+  if (op == "+")
+    return wrap(ua + ub);
+  if (op == "-")
+    return wrap(ua - ub);
+  if (op == "*")
+    return wrap(ua * ub);
+  if (op == "/" || op == "%") {
+    // sdiv/srem are undefined for these operands, keep them for runtime
+    if (b == 0 || (a == std::numeric_limits<int32_t>::min() && b == -1))
+      return std::nullopt;
+    return op == "/" ? a / b : a % b;
+  }
+  if (op == "&")
+    return a & b;
+  if (op == "|")
+    return a | b;
+  if (op == "^")
+    return a ^ b;
+  if (op == "<<" || op == ">>") {
+    // Shift amounts outside [0, 31] produce poison in LLVM
+    if (b < 0 || b > 31)
+      return std::nullopt;
+    return op == "<<" ? wrap(ua << b) : a >> b;
+  }
+  if (op == "==")
+    return a == b;
+  if (op == "!=")
+    return a != b;
+  if (op == "<")
+    return a < b;
+  if (op == "<=")
+    return a <= b;
+  if (op == ">")
+    return a > b;
+  if (op == ">=")
+    return a >= b;
+  return std::nullopt;
+}
+
+std::optional<ConstValue> eval_f64_binary(const std::string &op, double a,
+                                          double b) {
+  if (op == "+")
+    return a + b;
+  if (op == "-")
+    return a - b;
+  if (op == "*")
+    return a * b;
+  if (op == "/")
+    return a / b;
+  if (op == "**")
+    return std::pow(a, b);
+  // Codegen uses ordered comparisons: false if either operand is NaN
+  if (op == "==")
+    return a == b;
+  if (op == "!=")
+    return a < b || a > b;
+  if (op == "<")
+    return a < b;
+  if (op == "<=")
+    return a <= b;
+  if (op == ">")
+    return a > b;
+  if (op == ">=")
+    return a >= b;
+  return std::nullopt;
+}
+
+std::optional<ConstValue> eval_bool_binary(const std::string &op, bool a,
+                                           bool b) {
+  if (op == "&&")
+    return a && b;
+  if (op == "||")
+    return a || b;
+  if (op == "==")
+    return a == b;
+  if (op == "!=")
+    return a != b;
+  return std::nullopt;
+}
+
+} // namespace
+
+bool is_builtin_binary(const std::string &op, const ConstValue &left,
+                       const ConstValue &right) {
+  if (op == "&&" || op == "||")
+    return true;
+  if (is_integer(left))
+    return op == "+" || op == "-" || op == "*" || op == "/" || op == "%" ||
+           op == "&" || op == "|" || op == "^" || op == "<<" || op == ">>" ||
+           op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" ||
+           op == ">=";
+  if (op == "**")
+    return is_double(right);
+  return op == "+" || op == "-" || op == "*" || op == "/" || op == "==" ||
+         op == "!=" || op == "<" || op == "<=" || op == ">" || op == ">=";
+}
+
+std::optional<ConstValue> eval_builtin_binary(const std::string &op,
+                                              const ConstValue &left,
+                                              const ConstValue &right) {
+  if (left.index() != right.index())
+    return std::nullopt;
+  if (auto *a = std::get_if<int32_t>(&left))
+    return eval_i32_binary(op, *a, std::get<int32_t>(right));
+  if (auto *a = std::get_if<double>(&left))
+    return eval_f64_binary(op, *a, std::get<double>(right));
+  return eval_bool_binary(op, std::get<bool>(left), std::get<bool>(right));
+}
+
+bool is_builtin_unary(const std::string &op, OpPosition position,
+                      const ConstValue &) {
+  return position == OpPosition::Prefix && (op == "-" || op == "!");
+}
+
+std::optional<ConstValue> eval_builtin_unary(const std::string &op,
+                                             OpPosition position,
+                                             const ConstValue &operand) {
+  if (position != OpPosition::Prefix)
+    return std::nullopt;
+  if (op == "-") {
+    if (auto *i = std::get_if<int32_t>(&operand))
+      return static_cast<int32_t>(0u - static_cast<uint32_t>(*i));
+    if (auto *f = std::get_if<double>(&operand))
+      return -*f;
+  } else if (op == "!") {
+    // Codegen lowers ! to a bitwise not
+    if (auto *i = std::get_if<int32_t>(&operand))
+      return ~*i;
+    if (auto *b = std::get_if<bool>(&operand))
+      return !*b;
+  }
+  return std::nullopt;
+}
+
+namespace {
+
+// Expressions that can be dropped without changing behavior
+bool is_pure(const Expr *expr) {
+  switch (expr->kind) {
+  case ExprKind::IntLiteral:
+  case ExprKind::FloatLiteral:
+  case ExprKind::StringLiteral:
+  case ExprKind::BoolLiteral:
+  case ExprKind::Identifier:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool operands_have_type(const BinaryExpr *binary, const char *type) {
+  return binary->left->inferred_type == type &&
+         binary->right->inferred_type == type;
+}
+
+ExprPtr make_i32(int32_t value, SourceLocation loc) {
+  return make_literal(value, loc);
+}
+
+ExprPtr make_bool(bool value, SourceLocation loc) {
+  return make_literal(value, loc);
+}
+
+std::optional<int32_t> as_i32(const Expr *expr) {
+  if (!expr || expr->kind != ExprKind::IntLiteral)
+    return std::nullopt;
+  auto value = literal_value(expr);
+  return value ? std::optional<int32_t>(std::get<int32_t>(*value))
+               : std::nullopt;
+}
+
+std::optional<double> as_f64(const Expr *expr) {
+  if (!expr || expr->kind != ExprKind::FloatLiteral)
+    return std::nullopt;
+  auto value = literal_value(expr);
+  return value ? std::optional<double>(std::get<double>(*value))
+               : std::nullopt;
+}
+
+std::optional<bool> as_bool(const Expr *expr) {
+  if (!expr || expr->kind != ExprKind::BoolLiteral)
+    return std::nullopt;
+  return static_cast<const BoolLiteralExpr *>(expr)->value;
+}
+
+// ===== Algebraic simplification =====
+
+bool is_i32_value(const Expr *expr, int32_t value) {
+  auto literal = as_i32(expr);
+  return literal && *literal == value;
+}
+
+bool is_f64_value(const Expr *expr, double value) {
+  auto literal = as_f64(expr);
+  return literal && *literal == value;
+}
+
+bool is_bool_value(const Expr *expr, bool value) {
+  auto literal = as_bool(expr);
+  return literal && *literal == value;
+}
+
+// Returns the replacement for `binary`, or nullptr if no identity applies.
+// `expr` owns `binary`; operands are moved out of it when kept.
+ExprPtr simplify_binary(BinaryExpr *binary) {
+  const std::string &op = binary->op;
+  ExprPtr &left = binary->left;
+  ExprPtr &right = binary->right;
+
+  if (operands_have_type(binary, "i32")) {
+    // x op 0 -> x
+    if ((op == "+" || op == "-" || op == "|" || op == "^" || op == "<<" ||
+         op == ">>") &&
+        is_i32_value(right.get(), 0))
+      return std::move(left);
+    // 0 op x -> x
+    if ((op == "+" || op == "|" || op == "^") && is_i32_value(left.get(), 0))
+      return std::move(right);
+    // x * 1, x / 1 -> x
+    if ((op == "*" || op == "/") && is_i32_value(right.get(), 1))
+      return std::move(left);
+    if (op == "*" && is_i32_value(left.get(), 1))
+      return std::move(right);
+    // x * 0, x & 0 -> 0 (x must be dropped safely)
+    if ((op == "*" || op == "&") &&
+        ((is_i32_value(right.get(), 0) && is_pure(left.get())) ||
+         (is_i32_value(left.get(), 0) && is_pure(right.get()))))
+      return make_i32(0, binary->loc);
+    // x - x -> 0
+    if (op == "-" && left->kind == ExprKind::Identifier &&
+        right->kind == ExprKind::Identifier &&
+        static_cast<IdentifierExpr *>(left.get())->name ==
+            static_cast<IdentifierExpr *>(right.get())->name)
+      return make_i32(0, binary->loc);
+  } else if (operands_have_type(binary, "f64")) {
+    // x + 0.0 is not an identity for x = -0.0, x - 0.0 is
+    if (op == "-" && is_f64_value(right.get(), 0.0) &&
+        !std::signbit(*as_f64(right.get())))
+      return std::move(left);
+    if ((op == "*" || op == "/") && is_f64_value(right.get(), 1.0))
+      return std::move(left);
+    if (op == "*" && is_f64_value(left.get(), 1.0))
+      return std::move(right);
+  } else if (operands_have_type(binary, "bool")) {
+    // b && true, b || false -> b
+    if ((op == "&&" && is_bool_value(right.get(), true)) ||
+        (op == "||" && is_bool_value(right.get(), false)))
+      return std::move(left);
+    if ((op == "&&" && is_bool_value(left.get(), true)) ||
+        (op == "||" && is_bool_value(left.get(), false)))
+      return std::move(right);
+    // b && false -> false, b || true -> true (operators do not
+    // short-circuit, so b is evaluated and must be pure)
+    bool absorbing = op == "||";
+    if ((op == "&&" || op == "||") &&
+        ((is_bool_value(right.get(), absorbing) && is_pure(left.get())) ||
+         (is_bool_value(left.get(), absorbing) && is_pure(right.get()))))
+      return make_bool(absorbing, binary->loc);
+  }
+  return nullptr;
+}
+
+ExprPtr simplify_unary(UnaryExpr *unary) {
+  if (unary->position != OpPosition::Prefix ||
+      unary->operand->kind != ExprKind::Unary)
+    return nullptr;
+  auto *inner = static_cast<UnaryExpr *>(unary->operand.get());
+  if (inner->position != OpPosition::Prefix || inner->op != unary->op)
+    return nullptr;
+
+  // -(-x) -> x (also for INT_MIN under wraparound), !!b -> b
+  const std::string &type = inner->operand->inferred_type;
+  if ((unary->op == "-" && (type == "i32" || type == "f64")) ||
+      (unary->op == "!" && type == "bool"))
+    return std::move(inner->operand);
+  return nullptr;
+}
+
+// ===== Statement helpers =====
+
+bool always_returns(const Stmt *stmt) {
+  switch (stmt->kind) {
+  case StmtKind::Return:
+    return true;
+  case StmtKind::Block: {
+    auto *block = static_cast<const BlockStmt *>(stmt);
+    for (const auto &inner : block->stmts) {
+      if (always_returns(inner.get()))
+        return true;
+    }
+    return false;
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<const IfStmt *>(stmt);
+    return if_stmt->else_branch && always_returns(if_stmt->then_branch.get()) &&
+           always_returns(if_stmt->else_branch.value().get());
+  }
+  default:
+    return false;
+  }
+}
+
+bool is_definition(const Stmt *stmt) {
+  return stmt->kind == StmtKind::Func || stmt->kind == StmtKind::OperatorDecl;
+}
+
+bool is_empty_block(const Stmt *stmt) {
+  return stmt->kind == StmtKind::Block &&
+         static_cast<const BlockStmt *>(stmt)->stmts.empty();
+}
+
+} // namespace
+
+// ===== ExprRewritePass =====
+
+bool ExprRewritePass::run(std::vector<StmtPtr> &stmts) {
+  bool changed = false;
+  for (auto &stmt : stmts) {
+    changed |= visit_stmt(stmt.get());
+  }
+  return changed;
+}
+
+bool ExprRewritePass::visit_stmt(Stmt *stmt) {
+  if (!stmt)
+    return false;
+
+  bool changed = false;
+  switch (stmt->kind) {
+  case StmtKind::Let: {
+    auto *let = static_cast<LetStmt *>(stmt);
+    if (let->init) {
+      changed |= visit_expr(let->init);
+    }
+    break;
+  }
+  case StmtKind::Func: {
+    auto *func = static_cast<FuncStmt *>(stmt);
+    if (func->body) {
+      changed |= visit_stmt(func->body.value().get());
+    }
+    break;
+  }
+  case StmtKind::OperatorDecl: {
+    auto *op_decl = static_cast<OperatorDeclStmt *>(stmt);
+    if (op_decl->body) {
+      changed |= visit_stmt(op_decl->body.value().get());
+    }
+    break;
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<IfStmt *>(stmt);
+    changed |= visit_expr(if_stmt->condition);
+    changed |= visit_stmt(if_stmt->then_branch.get());
+    if (if_stmt->else_branch) {
+      changed |= visit_stmt(if_stmt->else_branch.value().get());
+    }
+    break;
+  }
+  case StmtKind::Return: {
+    auto *ret = static_cast<ReturnStmt *>(stmt);
+    if (ret->value) {
+      changed |= visit_expr(ret->value.value());
+    }
+    break;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<WhileStmt *>(stmt);
+    changed |= visit_expr(while_stmt->condition);
+    changed |= visit_stmt(while_stmt->body.get());
+    break;
+  }
+  case StmtKind::Expr: {
+    auto *expr_stmt = static_cast<ExprStmt *>(stmt);
+    changed |= visit_expr(expr_stmt->expr);
+    break;
+  }
+  case StmtKind::Block: {
+    auto *block = static_cast<BlockStmt *>(stmt);
+    for (auto &inner : block->stmts) {
+      changed |= visit_stmt(inner.get());
+    }
+    break;
+  }
+  }
+  return changed;
+}
+
+bool ExprRewritePass::visit_expr(ExprPtr &expr) {
+  if (!expr)
+    return false;
+
+  bool changed = false;
+  switch (expr->kind) {
+  case ExprKind::Binary: {
+    auto *binary = static_cast<BinaryExpr *>(expr.get());
+    changed |= visit_expr(binary->left);
+    changed |= visit_expr(binary->right);
+    break;
+  }
+  case ExprKind::Unary: {
+    auto *unary = static_cast<UnaryExpr *>(expr.get());
+    changed |= visit_expr(unary->operand);
+    break;
+  }
+  case ExprKind::Call: {
+    auto *call = static_cast<CallExpr *>(expr.get());
+    for (auto &arg : call->args) {
+      changed |= visit_expr(arg);
+    }
+    break;
+  }
+  case ExprKind::Index: {
+    auto *index = static_cast<IndexExpr *>(expr.get());
+    changed |= visit_expr(index->base);
+    changed |= visit_expr(index->index);
+    break;
+  }
+  case ExprKind::OperatorSeq: {
+    auto *seq = static_cast<OperatorSeqExpr *>(expr.get());
+    for (auto &item : seq->items) {
+      if (item.kind == OpSeqItem::Kind::Operand) {
+        changed |= visit_expr(item.operand);
+      }
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  changed |= rewrite(expr);
+  return changed;
+}
+
+// ===== ConstantFoldingPass =====
+
+bool ConstantFoldingPass::rewrite(ExprPtr &expr) {
+  ExprPtr folded;
+  if (expr->kind == ExprKind::Binary) {
+    auto *binary = static_cast<BinaryExpr *>(expr.get());
+    auto left = literal_value(binary->left.get());
+    auto right = literal_value(binary->right.get());
+    if (left && right && is_builtin_binary(binary->op, *left, *right)) {
+      if (auto value = eval_builtin_binary(binary->op, *left, *right)) {
+        folded = make_literal(*value, binary->loc);
+      }
+    }
+  } else if (expr->kind == ExprKind::Unary) {
+    auto *unary = static_cast<UnaryExpr *>(expr.get());
+    auto operand = literal_value(unary->operand.get());
+    if (operand && is_builtin_unary(unary->op, unary->position, *operand)) {
+      if (auto value =
+              eval_builtin_unary(unary->op, unary->position, *operand)) {
+        folded = make_literal(*value, unary->loc);
+      }
+    }
+  }
+  if (!folded)
+    return false;
+  expr = std::move(folded);
+  return true;
+}
+
+// ===== AlgebraicSimplificationPass =====
+
+bool AlgebraicSimplificationPass::rewrite(ExprPtr &expr) {
+  ExprPtr simplified;
+  if (expr->kind == ExprKind::Binary) {
+    simplified = simplify_binary(static_cast<BinaryExpr *>(expr.get()));
+  } else if (expr->kind == ExprKind::Unary) {
+    simplified = simplify_unary(static_cast<UnaryExpr *>(expr.get()));
+  }
+  if (!simplified)
+    return false;
+  expr = std::move(simplified);
+  return true;
+}
+
+// ===== DeadBranchEliminationPass =====
+
+bool DeadBranchEliminationPass::run(std::vector<StmtPtr> &stmts) {
+  return visit_list(stmts);
+}
+
+bool DeadBranchEliminationPass::visit_list(std::vector<StmtPtr> &stmts) {
+  bool changed = false;
+  std::vector<StmtPtr> kept;
+  kept.reserve(stmts.size());
+  for (auto &stmt : stmts) {
+    changed |= visit_stmt(stmt);
+    // Folded-away branches leave empty blocks behind
+    if (stmt && is_empty_block(stmt.get())) {
+      changed = true;
+      continue;
+    }
+    kept.push_back(std::move(stmt));
+  }
+  stmts = std::move(kept);
+  return changed;
+}
+
+bool DeadBranchEliminationPass::visit_stmt(StmtPtr &stmt) {
+  if (!stmt)
+    return false;
+
+  switch (stmt->kind) {
+  case StmtKind::Func: {
+    auto *func = static_cast<FuncStmt *>(stmt.get());
+    return func->body && visit_stmt(func->body.value());
+  }
+  case StmtKind::OperatorDecl: {
+    auto *op_decl = static_cast<OperatorDeclStmt *>(stmt.get());
+    return op_decl->body && visit_stmt(op_decl->body.value());
+  }
+  case StmtKind::Block: {
+    auto *block = static_cast<BlockStmt *>(stmt.get());
+    return visit_list(block->stmts);
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<IfStmt *>(stmt.get());
+    if (auto cond = as_bool(if_stmt->condition.get())) {
+      // The taken branch keeps its own block scope
+      if (*cond) {
+        stmt = std::move(if_stmt->then_branch);
+      } else if (if_stmt->else_branch) {
+        stmt = std::move(if_stmt->else_branch.value());
+      } else {
+        stmt = std::make_unique<BlockStmt>(std::vector<StmtPtr>{},
+                                           if_stmt->loc);
+      }
+      visit_stmt(stmt);
+      return true;
+    }
+    bool changed = visit_stmt(if_stmt->then_branch);
+    if (if_stmt->else_branch) {
+      changed |= visit_stmt(if_stmt->else_branch.value());
+    }
+    return changed;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<WhileStmt *>(stmt.get());
+    if (is_bool_value(while_stmt->condition.get(), false)) {
+      stmt = std::make_unique<BlockStmt>(std::vector<StmtPtr>{},
+                                         while_stmt->loc);
+      return true;
+    }
+    return visit_stmt(while_stmt->body);
+  }
+  default:
+    return false;
+  }
+}
+
+// ===== UnreachableCodeEliminationPass =====
+
+bool UnreachableCodeEliminationPass::run(std::vector<StmtPtr> &stmts) {
+  return visit_list(stmts);
+}
+
+bool UnreachableCodeEliminationPass::visit_list(std::vector<StmtPtr> &stmts) {
+  bool changed = false;
+  bool returned = false;
+  std::vector<StmtPtr> kept;
+  kept.reserve(stmts.size());
+  for (auto &stmt : stmts) {
+    if (returned && !is_definition(stmt.get())) {
+      changed = true;
+      continue;
+    }
+    changed |= visit_stmt(stmt.get());
+    if (!returned && always_returns(stmt.get())) {
+      returned = true;
+    }
+    kept.push_back(std::move(stmt));
+  }
+  stmts = std::move(kept);
+  return changed;
+}
+
+bool UnreachableCodeEliminationPass::visit_stmt(Stmt *stmt) {
+  switch (stmt->kind) {
+  case StmtKind::Func: {
+    auto *func = static_cast<FuncStmt *>(stmt);
+    return func->body && visit_stmt(func->body.value().get());
+  }
+  case StmtKind::OperatorDecl: {
+    auto *op_decl = static_cast<OperatorDeclStmt *>(stmt);
+    return op_decl->body && visit_stmt(op_decl->body.value().get());
+  }
+  case StmtKind::Block:
+    return visit_list(static_cast<BlockStmt *>(stmt)->stmts);
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<IfStmt *>(stmt);
+    bool changed = visit_stmt(if_stmt->then_branch.get());
+    if (if_stmt->else_branch) {
+      changed |= visit_stmt(if_stmt->else_branch.value().get());
+    }
+    return changed;
+  }
+  case StmtKind::While:
+    return visit_stmt(static_cast<WhileStmt *>(stmt)->body.get());
+  default:
+    return false;
+  }
+}
+
+// ===== AstPassManager =====
+
+AstPassManager AstPassManager::create_default() {
+  AstPassManager manager;
+  manager.add_pass(std::make_unique<CompileTimeEvaluationPass>());
+  manager.add_pass(std::make_unique<ConstantFoldingPass>());
+  manager.add_pass(std::make_unique<AlgebraicSimplificationPass>());
+  manager.add_pass(std::make_unique<DeadBranchEliminationPass>());
+  manager.add_pass(std::make_unique<UnreachableCodeEliminationPass>());
+  return manager;
+}
+
+void AstPassManager::add_pass(std::unique_ptr<AstPass> pass) {
+  passes_.push_back(std::move(pass));
+}
+
+bool AstPassManager::run(std::vector<StmtPtr> &stmts) {
+  bool changed_any = false;
+  for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+    bool changed = false;
+    for (auto &pass : passes_) {
+      changed |= pass->run(stmts);
+    }
+    if (!changed)
+      break;
+    changed_any = true;
+  }
+  return changed_any;
+}
+
+} // namespace pecco
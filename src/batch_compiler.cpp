@@ -0,0 +1,105 @@
+#include "batch_compiler.hpp"
+
+#include "runtime_symbols.hpp"
+
+#include <llvm/Support/FileSystem.h>
+
+#include <chrono>
+
+namespace pecco {
+
+BatchCompiler::BatchCompiler(llvm::TargetMachine &target_machine,
+                             CompileOptions options,
+                             std::optional<llvm::OptimizationLevel> opt_level,
+                             std::shared_ptr<const SymbolTable> prelude)
+    : target_machine_(target_machine), options_(std::move(options)),
+      prelude_(std::move(prelude)), optimize_(opt_level.has_value()),
+      pass_builder_(&target_machine) {
+  pass_builder_.registerModuleAnalyses(module_analyses_);
+  pass_builder_.registerCGSCCAnalyses(cgscc_analyses_);
+  pass_builder_.registerFunctionAnalyses(function_analyses_);
+  pass_builder_.registerLoopAnalyses(loop_analyses_);
+  pass_builder_.crossRegisterProxies(loop_analyses_, function_analyses_,
+                                     cgscc_analyses_, module_analyses_);
+  if (optimize_) {
+    optimizer_ = pass_builder_.buildPerModuleDefaultPipeline(*opt_level);
+  }
+
+  // The code generation passes are bound to object_stream_ once; running
+  // them again on the next module starts a new object file
+  can_emit_ = !target_machine_.addPassesToEmitFile(
+      emitter_, object_stream_, nullptr, llvm::CodeGenFileType::ObjectFile);
+}
+
+BatchCompiler::~BatchCompiler() = default;
+
+bool BatchCompiler::compile(std::string_view source,
+                            const std::string &module_name,
+                            const std::string &object_path,
+                            std::vector<Diagnostic> &diagnostics) {
+  auto start = std::chrono::steady_clock::now();
+  auto finish = [&](bool ok) {
+    ++stats_.files;
+    stats_.failed += !ok;
+    stats_.seconds += std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    return ok;
+  };
+
+  CompileOptions options = options_;
+  options.module_name = module_name;
+  CompilationSession session(options, prelude_);
+  if (!session.parse(source) || !session.analyze()) {
+    diagnostics.insert(diagnostics.end(), session.diagnostics().begin(),
+                       session.diagnostics().end());
+    return finish(false);
+  }
+  session.optimize_ast();
+  if (!session.generate(context_)) {
+    diagnostics.insert(diagnostics.end(), session.diagnostics().begin(),
+                       session.diagnostics().end());
+    return finish(false);
+  }
+
+  llvm::Module &module = *session.codegen()->get_module();
+  module.setTargetTriple(target_machine_.getTargetTriple().str());
+  module.setDataLayout(target_machine_.createDataLayout());
+  if (optimize_) {
+    optimizer_.run(module, module_analyses_);
+    // Cached results point into the module, which is about to go away
+    loop_analyses_.clear();
+    function_analyses_.clear();
+    cgscc_analyses_.clear();
+    module_analyses_.clear();
+  }
+
+  std::string error;
+  if (!emit(module, object_path, error)) {
+    diagnostics.push_back({"output", error});
+    return finish(false);
+  }
+  return finish(true);
+}
+
+bool BatchCompiler::emit(llvm::Module &module, const std::string &object_path,
+                         std::string &error) {
+  if (!can_emit_) {
+    error = "target machine cannot emit object files";
+    return false;
+  }
+  bind_runtime_symbols(module);
+  object_.clear();
+  emitter_.run(module);
+
+  std::error_code ec;
+  llvm::raw_fd_ostream dest(object_path, ec, llvm::sys::fs::OF_None);
+  if (ec) {
+    error = "cannot write '" + object_path + "': " + ec.message();
+    return false;
+  }
+  dest.write(object_.data(), object_.size());
+  return true;
+}
+
+} // namespace pecco
@@ -0,0 +1,834 @@
+#include "bytecode.hpp"
+#include "call_graph.hpp"
+
+#include <iomanip>
+#include <limits>
+
+namespace pecco {
+
+const char *to_string(Opcode op) {
+  switch (op) {
+#define PECCO_OPCODE_NAME(name)                                                \
+  case Opcode::name:                                                           \
+    return #name;
+    PECCO_OPCODES(PECCO_OPCODE_NAME)
+#undef PECCO_OPCODE_NAME
+  }
+  return "?";
+}
+
+void BytecodeModule::disassemble(std::ostream &os) const {
+  for (size_t index = 0; index < functions.size(); ++index) {
+    const BytecodeFunction &func = functions[index];
+    os << "function " << index << " " << func.name << " (params "
+       << func.num_params << ", registers " << func.num_regs << ")"
+       << (index == entry ? " [entry]" : "") << "\n";
+    for (size_t pc = 0; pc < func.code.size(); ++pc) {
+      const Instr &ins = func.code[pc];
+      os << "  " << std::setw(4) << pc << "  " << std::left << std::setw(12)
+         << to_string(ins.op) << std::right;
+      switch (ins.op) {
+      case Opcode::LoadInt:
+        os << "r" << ins.a << ", " << ins.imm();
+        break;
+      case Opcode::LoadF64:
+        os << "r" << ins.a << ", " << f64_constants[ins.b];
+        break;
+      case Opcode::LoadStr:
+        os << "r" << ins.a << ", s" << ins.b;
+        break;
+      case Opcode::Jump:
+      case Opcode::Loop:
+        os << "@" << ins.imm();
+        break;
+      case Opcode::JumpIfFalse:
+        os << "r" << ins.a << ", @" << ins.imm();
+        break;
+      case Opcode::Call:
+        os << "r" << ins.a << ", " << functions[ins.c].name << "(r" << ins.b
+           << "..)";
+        break;
+      case Opcode::Mov:
+      case Opcode::NegI32:
+      case Opcode::NotI32:
+      case Opcode::NotBool:
+      case Opcode::NegF64:
+        os << "r" << ins.a << ", r" << ins.b;
+        break;
+      case Opcode::Return:
+        os << "r" << ins.a;
+        break;
+      case Opcode::ReturnVoid:
+      case Opcode::Flush:
+        break;
+      case Opcode::Write:
+        os << "r" << ins.a << ", r" << ins.b << "..";
+        break;
+      case Opcode::Print:
+      case Opcode::PrintI32:
+      case Opcode::PrintF64:
+      case Opcode::Exit:
+        os << "r" << ins.b;
+        break;
+      default:
+        os << "r" << ins.a << ", r" << ins.b << ", r" << ins.c;
+        break;
+      }
+      os << "\n";
+    }
+  }
+}
+
+// ===== BytecodeCompiler =====
+
+namespace {
+
+bool is_assignment(const std::string &op) {
+  return op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "/=" ||
+         op == "%=";
+}
+
+// Whether evaluating the expression may store to a variable
+bool contains_assignment(const Expr *expr) {
+  if (!expr)
+    return false;
+  switch (expr->kind) {
+  case ExprKind::Binary: {
+    auto *binary = static_cast<const BinaryExpr *>(expr);
+    return is_assignment(binary->op) ||
+           contains_assignment(binary->left.get()) ||
+           contains_assignment(binary->right.get());
+  }
+  case ExprKind::Unary:
+    return contains_assignment(
+        static_cast<const UnaryExpr *>(expr)->operand.get());
+  case ExprKind::Call:
+    for (const auto &arg : static_cast<const CallExpr *>(expr)->args) {
+      if (contains_assignment(arg.get()))
+        return true;
+    }
+    return false;
+  default:
+    return false;
+  }
+}
+
+// Native builtins from the prelude, implemented directly by the VM
+struct NativeBuiltin {
+  const char *name;
+  Opcode op;
+  size_t arity;
+};
+
+constexpr NativeBuiltin kNativeBuiltins[] = {
+    {"write", Opcode::Write, 3},         {"print", Opcode::Print, 1},
+    {"print_i32", Opcode::PrintI32, 1}, {"print_f64", Opcode::PrintF64, 1},
+    {"flush", Opcode::Flush, 0},         {"exit", Opcode::Exit, 1},
+};
+
+const NativeBuiltin *find_native(const std::string &name) {
+  for (const auto &native : kNativeBuiltins) {
+    if (name == native.name)
+      return &native;
+  }
+  return nullptr;
+}
+
+} // namespace
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::parse_type(const std::string &name) {
+  if (name == "i32")
+    return ValueType::I32;
+  if (name == "f64")
+    return ValueType::F64;
+  if (name == "bool")
+    return ValueType::Bool;
+  if (name == "string")
+    return ValueType::String;
+  if (name == "void")
+    return ValueType::Void;
+  return std::nullopt;
+}
+
+const char *BytecodeCompiler::type_name(ValueType type) {
+  switch (type) {
+  case ValueType::I32:
+    return "i32";
+  case ValueType::F64:
+    return "f64";
+  case ValueType::Bool:
+    return "bool";
+  case ValueType::String:
+    return "string";
+  case ValueType::Void:
+    return "void";
+  }
+  return "?";
+}
+
+bool BytecodeCompiler::compile(const std::vector<StmtPtr> &stmts,
+                               BytecodeModule &module) {
+  module_ = &module;
+  functions_.clear();
+  errors_.clear();
+
+  // Assign an index to every definition first so calls may refer forward
+  struct Definition {
+    std::string name;
+    const std::vector<Parameter> *params;
+    const Stmt *body;
+    ValueType return_type;
+  };
+  std::vector<Definition> definitions;
+  for (const auto &stmt : stmts) {
+    std::string name;
+    const std::vector<Parameter> *params = nullptr;
+    const Stmt *body = nullptr;
+    const std::optional<TypePtr> *return_type = nullptr;
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      if (!func->body)
+        continue;
+      name = func->name;
+      params = &func->params;
+      body = func->body.value().get();
+      return_type = &func->return_type;
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op_decl = static_cast<const OperatorDeclStmt *>(stmt.get());
+      if (!op_decl->body)
+        continue;
+      name = mangle_operator_declaration(*op_decl);
+      params = &op_decl->params;
+      body = op_decl->body.value().get();
+      return_type = &op_decl->return_type;
+    } else {
+      continue;
+    }
+
+    FunctionEntry entry;
+    entry.index = static_cast<uint16_t>(definitions.size());
+    auto ret = *return_type ? parse_type(return_type->value()->name)
+                            : std::optional<ValueType>(ValueType::Void);
+    if (!ret) {
+      fail("Unknown return type in definition of " + name, stmt->loc);
+      continue;
+    }
+    entry.return_type = *ret;
+    for (const auto &param : *params) {
+      if (param.type && param.type.value()->kind == TypeKind::Array) {
+        fail("Arrays are not supported by the interpreter", param.loc);
+        break;
+      }
+      auto type = param.type ? parse_type(param.type.value()->name)
+                             : std::nullopt;
+      if (!type || *type == ValueType::Void) {
+        fail("Unknown type of parameter " + param.name, param.loc);
+        break;
+      }
+      entry.params.push_back(*type);
+    }
+    if (!functions_.emplace(name, entry).second) {
+      fail("Duplicate definition of " + name, stmt->loc);
+      continue;
+    }
+    definitions.push_back({name, params, body, *ret});
+  }
+  if (has_errors())
+    return false;
+
+  module.functions.clear();
+  module.functions.resize(definitions.size() + 1);
+  module.entry = definitions.size();
+
+  for (size_t i = 0; i < definitions.size(); ++i) {
+    const Definition &def = definitions[i];
+    compile_function(def.name, *def.params, def.body, def.return_type,
+                     module.functions[i]);
+  }
+
+  // Top-level statements run in the entry function, which returns 0 unless
+  // a top-level return says otherwise
+  BytecodeFunction &entry = module.functions[module.entry];
+  entry.name = "__pecco_entry";
+  current_ = &entry;
+  scopes_.assign(1, {});
+  next_reg_ = 0;
+  for (const auto &stmt : stmts) {
+    compile_stmt(stmt.get());
+  }
+  uint16_t result = alloc_reg(SourceLocation());
+  emit_imm(Opcode::LoadInt, result, 0);
+  emit(Opcode::Return, result);
+  scopes_.clear();
+
+  return !has_errors();
+}
+
+void BytecodeCompiler::compile_function(const std::string &name,
+                                        const std::vector<Parameter> &params,
+                                        const Stmt *body,
+                                        ValueType return_type,
+                                        BytecodeFunction &function) {
+  function.name = name;
+  function.num_params = static_cast<uint16_t>(params.size());
+  current_ = &function;
+  next_reg_ = 0;
+
+  // Parameters occupy the first registers of the window
+  const FunctionEntry &entry = functions_.at(name);
+  scopes_.assign(1, {});
+  for (size_t i = 0; i < params.size(); ++i) {
+    scopes_.back()[params[i].name] = {alloc_reg(params[i].loc),
+                                      entry.params[i]};
+  }
+
+  compile_stmt(body);
+
+  // Falling off the end returns a zero value like codegen does
+  if (return_type == ValueType::Void) {
+    emit(Opcode::ReturnVoid);
+  } else {
+    uint16_t result = alloc_reg(body->loc);
+    if (return_type == ValueType::F64) {
+      module_->f64_constants.push_back(0.0);
+      emit(Opcode::LoadF64, result,
+           static_cast<uint16_t>(module_->f64_constants.size() - 1));
+    } else {
+      emit_imm(Opcode::LoadInt, result, 0);
+    }
+    emit(Opcode::Return, result);
+  }
+  scopes_.clear();
+}
+
+uint16_t BytecodeCompiler::alloc_reg(const SourceLocation &loc) {
+  if (next_reg_ == std::numeric_limits<uint16_t>::max()) {
+    fail("Too many registers in function " + current_->name, loc);
+    return 0;
+  }
+  uint16_t reg = next_reg_++;
+  if (next_reg_ > current_->num_regs) {
+    current_->num_regs = next_reg_;
+  }
+  return reg;
+}
+
+const BytecodeCompiler::Local *
+BytecodeCompiler::lookup(const std::string &name) const {
+  for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end()) {
+      return &found->second;
+    }
+  }
+  return nullptr;
+}
+
+void BytecodeCompiler::emit(Opcode op, uint16_t a, uint16_t b, uint16_t c) {
+  current_->code.push_back({op, a, b, c});
+}
+
+void BytecodeCompiler::emit_imm(Opcode op, uint16_t a, int32_t imm) {
+  auto bits = static_cast<uint32_t>(imm);
+  emit(op, a, static_cast<uint16_t>(bits & 0xffff),
+       static_cast<uint16_t>(bits >> 16));
+}
+
+size_t BytecodeCompiler::emit_jump(Opcode op, uint16_t a) {
+  emit(op, a);
+  return current_->code.size() - 1;
+}
+
+void BytecodeCompiler::patch_jump(size_t at) {
+  auto target = static_cast<uint32_t>(current_->code.size());
+  current_->code[at].b = static_cast<uint16_t>(target & 0xffff);
+  current_->code[at].c = static_cast<uint16_t>(target >> 16);
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::fail(const std::string &msg, const SourceLocation &loc) {
+  errors_.emplace_back(msg, loc.line, loc.column);
+  return std::nullopt;
+}
+
+// ===== Statements =====
+
+void BytecodeCompiler::compile_stmt(const Stmt *stmt) {
+  if (!stmt)
+    return;
+
+  // Temporaries die at the end of the statement
+  uint16_t mark = next_reg_;
+  switch (stmt->kind) {
+  case StmtKind::Let:
+    compile_let(static_cast<const LetStmt *>(stmt));
+    return;
+  case StmtKind::Return: {
+    auto *ret = static_cast<const ReturnStmt *>(stmt);
+    if (ret->value) {
+      if (auto value = compile_operand(ret->value.value().get())) {
+        emit(Opcode::Return, value->reg);
+      }
+    } else {
+      emit(Opcode::ReturnVoid);
+    }
+    break;
+  }
+  case StmtKind::Expr: {
+    const Expr *expr = static_cast<const ExprStmt *>(stmt)->expr.get();
+    // A discarded assignment needs no copy of the stored value
+    if (expr && expr->kind == ExprKind::Binary) {
+      auto *binary = static_cast<const BinaryExpr *>(expr);
+      if (is_assignment(binary->op) &&
+          binary->left->kind == ExprKind::Identifier) {
+        auto *var = static_cast<const IdentifierExpr *>(binary->left.get());
+        if (const Local *local = lookup(var->name)) {
+          compile_into(expr, local->reg);
+          break;
+        }
+      }
+    }
+    compile_operand(expr);
+    break;
+  }
+  case StmtKind::Block:
+    scopes_.emplace_back();
+    for (const auto &inner : static_cast<const BlockStmt *>(stmt)->stmts) {
+      compile_stmt(inner.get());
+    }
+    scopes_.pop_back();
+    break;
+  case StmtKind::If:
+    compile_if(static_cast<const IfStmt *>(stmt));
+    break;
+  case StmtKind::While:
+    compile_while(static_cast<const WhileStmt *>(stmt));
+    break;
+  case StmtKind::Func:
+  case StmtKind::OperatorDecl:
+    // Only top-level definitions are compiled, like codegen
+    break;
+  }
+  next_reg_ = mark;
+}
+
+void BytecodeCompiler::compile_let(const LetStmt *let) {
+  uint16_t reg = alloc_reg(let->loc);
+  std::optional<ValueType> type;
+  if (let->init) {
+    type = compile_into(let->init.get(), reg);
+    if (!type)
+      return;
+  } else if (let->type) {
+    if (let->type.value()->kind == TypeKind::Array) {
+      fail("Arrays are not supported by the interpreter", let->loc);
+      return;
+    }
+    type = parse_type(let->type.value()->name);
+    if (!type || *type == ValueType::Void) {
+      fail("Cannot determine type for variable: " + let->name, let->loc);
+      return;
+    }
+    // Uninitialized variables read as zero
+    emit_imm(Opcode::LoadInt, reg, 0);
+  }
+  if (!type || *type == ValueType::Void) {
+    fail("Cannot determine type for variable: " + let->name, let->loc);
+    return;
+  }
+  // The initializer temporaries are freed, the variable stays
+  next_reg_ = reg + 1;
+  scopes_.back()[let->name] = {reg, *type};
+}
+
+void BytecodeCompiler::compile_if(const IfStmt *if_stmt) {
+  auto cond = compile_operand(if_stmt->condition.get());
+  if (!cond)
+    return;
+  size_t to_else = emit_jump(Opcode::JumpIfFalse, cond->reg);
+
+  compile_stmt(if_stmt->then_branch.get());
+  if (if_stmt->else_branch) {
+    size_t to_end = emit_jump(Opcode::Jump);
+    patch_jump(to_else);
+    compile_stmt(if_stmt->else_branch.value().get());
+    patch_jump(to_end);
+  } else {
+    patch_jump(to_else);
+  }
+}
+
+void BytecodeCompiler::compile_while(const WhileStmt *while_stmt) {
+  auto loop_start = static_cast<int32_t>(current_->code.size());
+  uint16_t mark = next_reg_;
+  auto cond = compile_operand(while_stmt->condition.get());
+  if (!cond)
+    return;
+  size_t to_end = emit_jump(Opcode::JumpIfFalse, cond->reg);
+  next_reg_ = mark;
+
+  compile_stmt(while_stmt->body.get());
+  emit_imm(Opcode::Loop, 0, loop_start);
+  patch_jump(to_end);
+}
+
+// ===== Expressions =====
+
+std::optional<BytecodeCompiler::Operand>
+BytecodeCompiler::compile_operand(const Expr *expr) {
+  if (expr && expr->kind == ExprKind::Identifier) {
+    auto *ident = static_cast<const IdentifierExpr *>(expr);
+    if (const Local *local = lookup(ident->name)) {
+      return Operand{local->reg, local->type};
+    }
+  }
+  uint16_t reg = alloc_reg(expr ? expr->loc : SourceLocation());
+  auto type = compile_into(expr, reg);
+  if (!type)
+    return std::nullopt;
+  return Operand{reg, *type};
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::compile_into(const Expr *expr, uint16_t dest) {
+  if (!expr)
+    return std::nullopt;
+
+  switch (expr->kind) {
+  case ExprKind::IntLiteral: {
+    auto *lit = static_cast<const IntLiteralExpr *>(expr);
+    if (lit->type != "i32")
+      return fail("Only i32 integers are supported by the interpreter",
+                  expr->loc);
+    int64_t value = std::stoll(lit->value);
+    emit_imm(Opcode::LoadInt, dest, static_cast<int32_t>(value));
+    return ValueType::I32;
+  }
+  case ExprKind::FloatLiteral: {
+    auto *lit = static_cast<const FloatLiteralExpr *>(expr);
+    if (lit->type != "f64")
+      return fail("Only f64 floats are supported by the interpreter",
+                  expr->loc);
+    module_->f64_constants.push_back(std::stod(lit->value));
+    if (module_->f64_constants.size() > std::numeric_limits<uint16_t>::max())
+      return fail("Too many f64 constants", expr->loc);
+    emit(Opcode::LoadF64, dest,
+         static_cast<uint16_t>(module_->f64_constants.size() - 1));
+    return ValueType::F64;
+  }
+  case ExprKind::StringLiteral: {
+    module_->strings.push_back(
+        static_cast<const StringLiteralExpr *>(expr)->value);
+    if (module_->strings.size() > std::numeric_limits<uint16_t>::max())
+      return fail("Too many string literals", expr->loc);
+    emit(Opcode::LoadStr, dest,
+         static_cast<uint16_t>(module_->strings.size() - 1));
+    return ValueType::String;
+  }
+  case ExprKind::BoolLiteral:
+    emit_imm(Opcode::LoadInt, dest,
+             static_cast<const BoolLiteralExpr *>(expr)->value ? 1 : 0);
+    return ValueType::Bool;
+  case ExprKind::Identifier: {
+    auto *ident = static_cast<const IdentifierExpr *>(expr);
+    const Local *local = lookup(ident->name);
+    if (!local)
+      return fail("Undefined variable: " + ident->name, expr->loc);
+    if (local->reg != dest) {
+      emit(Opcode::Mov, dest, local->reg);
+    }
+    return local->type;
+  }
+  case ExprKind::Binary:
+    return compile_binary(static_cast<const BinaryExpr *>(expr), dest);
+  case ExprKind::Unary:
+    return compile_unary(static_cast<const UnaryExpr *>(expr), dest);
+  case ExprKind::Call:
+    return compile_call(static_cast<const CallExpr *>(expr), dest);
+  case ExprKind::Index:
+    return fail("Arrays are not supported by the interpreter", expr->loc);
+  case ExprKind::OperatorSeq:
+    return fail("OperatorSeq should have been resolved before codegen",
+                expr->loc);
+  }
+  return std::nullopt;
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::compile_binary(const BinaryExpr *binary, uint16_t dest) {
+  const std::string &op = binary->op;
+  if (is_assignment(op)) {
+    return compile_assignment(binary, dest);
+  }
+
+  uint16_t mark = next_reg_;
+  auto left = compile_operand(binary->left.get());
+  if (!left)
+    return std::nullopt;
+  // Codegen loads the left variable before evaluating the right operand
+  if (binary->left->kind == ExprKind::Identifier &&
+      contains_assignment(binary->right.get())) {
+    uint16_t copy = alloc_reg(binary->loc);
+    emit(Opcode::Mov, copy, left->reg);
+    left->reg = copy;
+  }
+  auto right = compile_operand(binary->right.get());
+  if (!right)
+    return std::nullopt;
+
+  ValueType lt = left->type;
+  ValueType rt = right->type;
+  bool is_int = lt == ValueType::I32 || lt == ValueType::Bool;
+  bool is_f64 = lt == ValueType::F64;
+
+  // Builtin instruction chosen by the left operand type, as in codegen
+  std::optional<Opcode> builtin;
+  ValueType result = lt;
+  bool swap = false;
+  if (op == "&&" || op == "||") {
+    if (lt != ValueType::Bool || rt != ValueType::Bool)
+      return fail("Operator " + op + " requires bool operands", binary->loc);
+    builtin = op == "&&" ? Opcode::AndI32 : Opcode::OrI32;
+  } else if (is_int) {
+    static const std::map<std::string, Opcode> kIntOps = {
+        {"+", Opcode::AddI32}, {"-", Opcode::SubI32}, {"*", Opcode::MulI32},
+        {"/", Opcode::DivI32}, {"%", Opcode::RemI32}, {"&", Opcode::AndI32},
+        {"|", Opcode::OrI32},  {"^", Opcode::XorI32}, {"<<", Opcode::ShlI32},
+        {">>", Opcode::ShrI32}, {"==", Opcode::EqI32}, {"!=", Opcode::NeI32},
+        {"<", Opcode::LtI32},  {"<=", Opcode::LeI32}, {">", Opcode::GtI32},
+        {">=", Opcode::GeI32}};
+    auto it = kIntOps.find(op);
+    if (it != kIntOps.end()) {
+      if (lt != rt)
+        return fail("Operand type mismatch for operator " + op, binary->loc);
+      builtin = it->second;
+      if (op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" ||
+          op == ">=") {
+        result = ValueType::Bool;
+        // Codegen compares i1 as signed, where true is -1
+        swap = lt == ValueType::Bool && op != "==" && op != "!=";
+      } else if (lt == ValueType::Bool && op != "&" && op != "|" &&
+                 op != "^") {
+        return fail("Unsupported bool operator " + op, binary->loc);
+      }
+    }
+  } else if (is_f64) {
+    static const std::map<std::string, Opcode> kF64Ops = {
+        {"+", Opcode::AddF64},  {"-", Opcode::SubF64}, {"*", Opcode::MulF64},
+        {"/", Opcode::DivF64},  {"==", Opcode::EqF64}, {"!=", Opcode::NeF64},
+        {"<", Opcode::LtF64},   {"<=", Opcode::LeF64}, {">", Opcode::GtF64},
+        {">=", Opcode::GeF64}};
+    auto it = kF64Ops.find(op);
+    if (op == "**" && rt == ValueType::F64) {
+      builtin = Opcode::PowF64;
+    } else if (it != kF64Ops.end()) {
+      if (rt != ValueType::F64)
+        return fail("Operand type mismatch for operator " + op, binary->loc);
+      builtin = it->second;
+      if (op != "+" && op != "-" && op != "*" && op != "/")
+        result = ValueType::Bool;
+    }
+  }
+
+  if (builtin) {
+    if (swap) {
+      emit(*builtin, dest, right->reg, left->reg);
+    } else {
+      emit(*builtin, dest, left->reg, right->reg);
+    }
+    next_reg_ = mark;
+    return result;
+  }
+
+  // User-defined operator overload: arguments must be consecutive
+  std::string mangled = mangle_operator_name(op, OpPosition::Infix,
+                                             {type_name(lt), type_name(rt)});
+  std::vector<uint16_t> args = {left->reg, right->reg};
+  auto type = compile_user_call(mangled, args, dest, binary->loc);
+  if (!type)
+    return fail("Unknown binary operator: " + op + " (" + type_name(lt) +
+                    ", " + type_name(rt) + ")",
+                binary->loc);
+  next_reg_ = mark;
+  return type;
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::compile_assignment(const BinaryExpr *binary, uint16_t dest) {
+  if (binary->left->kind != ExprKind::Identifier)
+    return fail("Left side of assignment must be a variable", binary->loc);
+  auto *var_expr = static_cast<const IdentifierExpr *>(binary->left.get());
+  const Local *var = lookup(var_expr->name);
+  if (!var)
+    return fail("Undefined variable: " + var_expr->name, binary->loc);
+  uint16_t var_reg = var->reg;
+  ValueType var_type = var->type;
+
+  uint16_t mark = next_reg_;
+  if (binary->op == "=") {
+    auto type = compile_into(binary->right.get(), var_reg);
+    if (!type)
+      return std::nullopt;
+    if (*type != var_type)
+      return fail("Cannot assign " + std::string(type_name(*type)) + " to " +
+                      type_name(var_type) + " variable " + var_expr->name,
+                  binary->loc);
+  } else {
+    // The right-hand side is evaluated before the variable is loaded
+    auto right = compile_operand(binary->right.get());
+    if (!right)
+      return std::nullopt;
+    if (right->type != var_type)
+      return fail("Operand type mismatch for operator " + binary->op,
+                  binary->loc);
+
+    std::string op = binary->op.substr(0, binary->op.size() - 1);
+    std::optional<Opcode> builtin;
+    if (var_type == ValueType::I32) {
+      static const std::map<std::string, Opcode> kIntOps = {
+          {"+", Opcode::AddI32}, {"-", Opcode::SubI32}, {"*", Opcode::MulI32},
+          {"/", Opcode::DivI32}, {"%", Opcode::RemI32}};
+      builtin = kIntOps.at(op);
+    } else if (var_type == ValueType::F64 && op != "%") {
+      static const std::map<std::string, Opcode> kF64Ops = {
+          {"+", Opcode::AddF64},
+          {"-", Opcode::SubF64},
+          {"*", Opcode::MulF64},
+          {"/", Opcode::DivF64}};
+      builtin = kF64Ops.at(op);
+    }
+    if (!builtin)
+      return fail("Unsupported compound assignment " + binary->op + " on " +
+                      type_name(var_type),
+                  binary->loc);
+    emit(*builtin, var_reg, var_reg, right->reg);
+  }
+
+  // The assignment expression yields the stored value
+  if (dest != var_reg) {
+    emit(Opcode::Mov, dest, var_reg);
+  }
+  next_reg_ = mark;
+  return var_type;
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::compile_unary(const UnaryExpr *unary, uint16_t dest) {
+  uint16_t mark = next_reg_;
+  auto operand = compile_operand(unary->operand.get());
+  if (!operand)
+    return std::nullopt;
+
+  if (unary->position == OpPosition::Prefix) {
+    if (unary->op == "-" && operand->type == ValueType::I32) {
+      emit(Opcode::NegI32, dest, operand->reg);
+      next_reg_ = mark;
+      return ValueType::I32;
+    }
+    if (unary->op == "-" && operand->type == ValueType::F64) {
+      emit(Opcode::NegF64, dest, operand->reg);
+      next_reg_ = mark;
+      return ValueType::F64;
+    }
+    if (unary->op == "!" && operand->type == ValueType::Bool) {
+      emit(Opcode::NotBool, dest, operand->reg);
+      next_reg_ = mark;
+      return ValueType::Bool;
+    }
+    if (unary->op == "!" && operand->type == ValueType::I32) {
+      emit(Opcode::NotI32, dest, operand->reg);
+      next_reg_ = mark;
+      return ValueType::I32;
+    }
+  }
+
+  std::string mangled = mangle_operator_name(unary->op, unary->position,
+                                             {type_name(operand->type)});
+  auto type = compile_user_call(mangled, {operand->reg}, dest, unary->loc);
+  if (!type)
+    return fail("Unknown unary operator: " + unary->op + " (" +
+                    type_name(operand->type) + ")",
+                unary->loc);
+  next_reg_ = mark;
+  return type;
+}
+
+std::optional<BytecodeCompiler::ValueType>
+BytecodeCompiler::compile_call(const CallExpr *call, uint16_t dest) {
+  if (call->callee->kind != ExprKind::Identifier)
+    return fail("Function call callee must be an identifier", call->loc);
+  const std::string &name =
+      static_cast<const IdentifierExpr *>(call->callee.get())->name;
+
+  uint16_t mark = next_reg_;
+  auto user = functions_.find(name);
+  const NativeBuiltin *native =
+      user == functions_.end() ? find_native(name) : nullptr;
+  if (user == functions_.end() && !native)
+    return fail("Unknown function: " + name +
+                    " (only defined functions and prelude builtins can be "
+                    "interpreted)",
+                call->loc);
+
+  size_t arity = native ? native->arity : user->second.params.size();
+  if (call->args.size() != arity)
+    return fail("Incorrect number of arguments for function " + name,
+                call->loc);
+
+  // Single-argument builtins read their operand in place
+  if (native && arity == 1) {
+    auto arg = compile_operand(call->args[0].get());
+    if (!arg)
+      return std::nullopt;
+    emit(native->op, dest, arg->reg);
+    next_reg_ = mark;
+    return ValueType::Void;
+  }
+
+  // Arguments are evaluated left to right into consecutive registers
+  std::vector<uint16_t> args;
+  for (const auto &arg : call->args) {
+    uint16_t reg = alloc_reg(arg->loc);
+    auto type = compile_into(arg.get(), reg);
+    if (!type)
+      return std::nullopt;
+    args.push_back(reg);
+  }
+
+  std::optional<ValueType> result;
+  if (native) {
+    uint16_t first = args.empty() ? 0 : args[0];
+    emit(native->op, dest, first);
+    result = native->op == Opcode::Write ? ValueType::I32 : ValueType::Void;
+  } else {
+    result = compile_user_call(name, args, dest, call->loc);
+  }
+  next_reg_ = mark;
+  return result;
+}
+
+std::optional<BytecodeCompiler::ValueType> BytecodeCompiler::compile_user_call(
+    const std::string &name, const std::vector<uint16_t> &args, uint16_t dest,
+    const SourceLocation &loc) {
+  auto it = functions_.find(name);
+  if (it == functions_.end() || it->second.params.size() != args.size())
+    return std::nullopt;
+
+  // The callee window starts at the first argument and overwrites every
+  // register above it, so the arguments must be the topmost registers
+  bool in_place = !args.empty() && args[0] + args.size() == next_reg_;
+  for (size_t i = 1; in_place && i < args.size(); ++i) {
+    in_place = args[i] == args[0] + i;
+  }
+  uint16_t base = in_place ? args[0] : next_reg_;
+  if (!in_place) {
+    for (uint16_t arg : args) {
+      emit(Opcode::Mov, alloc_reg(loc), arg);
+    }
+  }
+  emit(Opcode::Call, dest, base, it->second.index);
+  return it->second.return_type;
+}
+
+} // namespace pecco
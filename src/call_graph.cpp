@@ -0,0 +1,265 @@
+#include "call_graph.hpp"
+
+namespace pecco {
+
+std::string mangle_operator_declaration(const OperatorDeclStmt &op_decl) {
+  std::vector<std::string> param_types;
+  for (const auto &param : op_decl.params) {
+    if (param.type) {
+      param_types.push_back(param.type.value()->name);
+    }
+  }
+  return mangle_operator_name(op_decl.op, op_decl.position, param_types);
+}
+
+void CallGraph::build(const std::vector<StmtPtr> &stmts) {
+  nodes_.clear();
+  defined_.clear();
+  definition_names_.clear();
+  operator_overloads_.clear();
+  edges_.clear();
+  reachable_.clear();
+
+  nodes_.push_back(kEntryName);
+  edges_[kEntryName];
+
+  // First pass: register every top-level definition with a body, so that
+  // forward references and recursion resolve to known nodes
+  for (const auto &stmt : stmts) {
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      if (func->body) {
+        add_definition(func->name, func);
+      }
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op_decl = static_cast<const OperatorDeclStmt *>(stmt.get());
+      if (op_decl->body) {
+        std::string mangled = mangle_operator_declaration(*op_decl);
+        add_definition(mangled, op_decl);
+        operator_overloads_[{op_decl->op, op_decl->position}].push_back(
+            mangled);
+      }
+    }
+  }
+
+  // Second pass: collect edges from definition bodies and top-level code
+  for (const auto &stmt : stmts) {
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      if (func->body) {
+        collect_stmt(func->name, func->body.value().get());
+      }
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op_decl = static_cast<const OperatorDeclStmt *>(stmt.get());
+      if (op_decl->body) {
+        collect_stmt(mangle_operator_declaration(*op_decl),
+                     op_decl->body.value().get());
+      }
+    } else {
+      collect_stmt(kEntryName, stmt.get());
+    }
+  }
+
+  compute_reachability();
+}
+
+void CallGraph::add_definition(const std::string &name, const Stmt *stmt) {
+  if (defined_.insert(name).second) {
+    nodes_.push_back(name);
+    edges_[name];
+  }
+  definition_names_[stmt] = name;
+}
+
+void CallGraph::add_operator_use(const std::string &caller,
+                                 const std::string &op, OpPosition position,
+                                 const std::vector<const Expr *> &operands) {
+  auto it = operator_overloads_.find({op, position});
+  if (it == operator_overloads_.end()) {
+    return;
+  }
+
+  std::vector<std::string> operand_types;
+  for (const Expr *operand : operands) {
+    if (!operand || operand->inferred_type.empty()) {
+      // Unknown operand type: any overload may be selected
+      edges_[caller].insert(it->second.begin(), it->second.end());
+      return;
+    }
+    operand_types.push_back(operand->inferred_type);
+  }
+
+  std::string mangled = mangle_operator_name(op, position, operand_types);
+  if (defined_.count(mangled)) {
+    edges_[caller].insert(mangled);
+  }
+}
+
+void CallGraph::collect_stmt(const std::string &caller, const Stmt *stmt) {
+  if (!stmt)
+    return;
+
+  switch (stmt->kind) {
+  case StmtKind::Let: {
+    auto *let = static_cast<const LetStmt *>(stmt);
+    collect_expr(caller, let->init.get());
+    break;
+  }
+  case StmtKind::Return: {
+    auto *ret = static_cast<const ReturnStmt *>(stmt);
+    if (ret->value) {
+      collect_expr(caller, ret->value.value().get());
+    }
+    break;
+  }
+  case StmtKind::Expr: {
+    auto *expr_stmt = static_cast<const ExprStmt *>(stmt);
+    collect_expr(caller, expr_stmt->expr.get());
+    break;
+  }
+  case StmtKind::Block: {
+    auto *block = static_cast<const BlockStmt *>(stmt);
+    for (const auto &inner : block->stmts) {
+      collect_stmt(caller, inner.get());
+    }
+    break;
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<const IfStmt *>(stmt);
+    collect_expr(caller, if_stmt->condition.get());
+    collect_stmt(caller, if_stmt->then_branch.get());
+    if (if_stmt->else_branch) {
+      collect_stmt(caller, if_stmt->else_branch.value().get());
+    }
+    break;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+    collect_expr(caller, while_stmt->condition.get());
+    collect_stmt(caller, while_stmt->body.get());
+    break;
+  }
+  case StmtKind::Func:
+  case StmtKind::OperatorDecl:
+    // Nested definitions are not lowered by codegen
+    break;
+  }
+}
+
+void CallGraph::collect_expr(const std::string &caller, const Expr *expr) {
+  if (!expr)
+    return;
+
+  switch (expr->kind) {
+  case ExprKind::IntLiteral:
+  case ExprKind::FloatLiteral:
+  case ExprKind::StringLiteral:
+  case ExprKind::BoolLiteral:
+  case ExprKind::Identifier:
+    break;
+  case ExprKind::Binary: {
+    auto *binary = static_cast<const BinaryExpr *>(expr);
+    collect_expr(caller, binary->left.get());
+    collect_expr(caller, binary->right.get());
+    add_operator_use(caller, binary->op, OpPosition::Infix,
+                     {binary->left.get(), binary->right.get()});
+    break;
+  }
+  case ExprKind::Unary: {
+    auto *unary = static_cast<const UnaryExpr *>(expr);
+    collect_expr(caller, unary->operand.get());
+    add_operator_use(caller, unary->op, unary->position,
+                     {unary->operand.get()});
+    break;
+  }
+  case ExprKind::Index: {
+    auto *index = static_cast<const IndexExpr *>(expr);
+    collect_expr(caller, index->base.get());
+    collect_expr(caller, index->index.get());
+    break;
+  }
+  case ExprKind::OperatorSeq: {
+    // Unresolved sequence: operand types are unknown, keep every overload
+    auto *seq = static_cast<const OperatorSeqExpr *>(expr);
+    for (const auto &item : seq->items) {
+      if (item.kind == OpSeqItem::Kind::Operand) {
+        collect_expr(caller, item.operand.get());
+        continue;
+      }
+      for (OpPosition position :
+           {OpPosition::Prefix, OpPosition::Infix, OpPosition::Postfix}) {
+        add_operator_use(caller, item.op, position, {nullptr});
+      }
+    }
+    break;
+  }
+  case ExprKind::Call: {
+    auto *call = static_cast<const CallExpr *>(expr);
+    if (call->callee->kind == ExprKind::Identifier) {
+      auto *ident = static_cast<const IdentifierExpr *>(call->callee.get());
+      edges_[caller].insert(ident->name);
+    } else {
+      collect_expr(caller, call->callee.get());
+    }
+    for (const auto &arg : call->args) {
+      collect_expr(caller, arg.get());
+    }
+    break;
+  }
+  }
+}
+
+void CallGraph::compute_reachability() {
+  std::vector<std::string> worklist = {kEntryName};
+  reachable_.insert(kEntryName);
+  while (!worklist.empty()) {
+    std::string name = worklist.back();
+    worklist.pop_back();
+    for (const auto &callee : callees(name)) {
+      if (defined_.count(callee) && reachable_.insert(callee).second) {
+        worklist.push_back(callee);
+      }
+    }
+  }
+}
+
+bool CallGraph::is_reachable(const Stmt *definition) const {
+  auto it = definition_names_.find(definition);
+  return it != definition_names_.end() && reachable_.count(it->second) > 0;
+}
+
+bool CallGraph::is_reachable(const std::string &name) const {
+  return reachable_.count(name) > 0;
+}
+
+const std::set<std::string> &
+CallGraph::callees(const std::string &name) const {
+  static const std::set<std::string> empty;
+  auto it = edges_.find(name);
+  return it != edges_.end() ? it->second : empty;
+}
+
+void CallGraph::print(std::ostream &os) const {
+  for (const auto &name : nodes_) {
+    os << "  " << name;
+    if (!is_reachable(name)) {
+      os << " [unreachable]";
+    }
+    os << " ->";
+    const auto &targets = callees(name);
+    if (targets.empty()) {
+      os << " (none)";
+    }
+    bool first = true;
+    for (const auto &callee : targets) {
+      os << (first ? " " : ", ") << callee;
+      if (!defined_.count(callee)) {
+        os << " [extern]";
+      }
+      first = false;
+    }
+    os << "\n";
+  }
+}
+
+} // namespace pecco
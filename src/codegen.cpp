@@ -1,4 +1,5 @@
 #include "codegen.hpp"
+#include "call_graph.hpp"
 
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_ostream.h>
@@ -7,14 +8,60 @@
 
 namespace pecco {
 
+namespace {
+
+// SIMD 内置函数：prelude 中以向量为第一个参数的这些函数和以向量类型命名的
+// 构造函数不生成 LLVM 函数，调用时直接生成向量指令
+bool is_simd_builtin(const std::string &name, bool vector_first_arg) {
+  if (parse_vector_type_name(name)) {
+    return true;
+  }
+  static const std::set<std::string> names = {
+      "extract",    "insert",     "shuffle",    "select", "reduce_add",
+      "reduce_mul", "reduce_min", "reduce_max", "any",    "all"};
+  return vector_first_arg && names.count(name);
+}
+
+// 类型转换：prelude 中以目标类型命名的函数（i64(x)、f32(x) 等）
+bool is_conversion_builtin(const std::string &name) {
+  return parse_integer_type_name(name) || name == "f32" || name == "f64";
+}
+
+// 位操作内置函数：prelude 中以整数为第一个参数的这些函数直接映射到
+// LLVM intrinsic（ctpop、ctlz、cttz、fshl/fshr、bswap、bitreverse）
+bool is_bit_builtin(const std::string &name, bool integer_first_arg) {
+  static const std::set<std::string> names = {
+      "popcount", "clz", "ctz", "rotl", "rotr", "bswap", "bitreverse"};
+  return integer_first_arg && names.count(name);
+}
+
+// 无符号整数选择 udiv/urem/lshr 与无符号比较；
+// 没有类型信息（未经类型检查）时按有符号处理
+bool is_unsigned(const Expr *expr) {
+  auto integer = parse_integer_type_name(expr->inferred_type);
+  return integer && !integer->is_signed;
+}
+
+} // namespace
+
 CodeGen::CodeGen(const std::string &module_name)
-    : builder_(context_), current_function_(nullptr) {
+    : owned_context_(std::make_unique<llvm::LLVMContext>()),
+      context_(*owned_context_), builder_(context_),
+      current_function_(nullptr) {
+  module_ = std::make_unique<llvm::Module>(module_name, context_);
+}
+
+CodeGen::CodeGen(const std::string &module_name, llvm::LLVMContext &context)
+    : context_(context), builder_(context_), current_function_(nullptr) {
   module_ = std::make_unique<llvm::Module>(module_name, context_);
 }
 
 llvm::Type *CodeGen::get_llvm_type(const std::string &type_name) {
-  if (type_name == "i32") {
-    return llvm::Type::getInt32Ty(context_);
+  if (auto integer = parse_integer_type_name(type_name)) {
+    // 有符号与无符号整数是同一个 LLVM 类型，由指令区分
+    return llvm::Type::getIntNTy(context_, integer->bits);
+  } else if (type_name == "f32") {
+    return llvm::Type::getFloatTy(context_);
   } else if (type_name == "f64") {
     return llvm::Type::getDoubleTy(context_);
   } else if (type_name == "bool") {
@@ -23,10 +70,92 @@ llvm::Type *CodeGen::get_llvm_type(const std::string &type_name) {
     return llvm::Type::getInt8PtrTy(context_);
   } else if (type_name == "void") {
     return llvm::Type::getVoidTy(context_);
+  } else if (auto array = parse_array_type_name(type_name)) {
+    llvm::Type *element = get_llvm_type(array->element);
+    if (!element || element->isVoidTy()) {
+      return nullptr;
+    }
+    return llvm::ArrayType::get(element, array->size);
+  } else if (auto vector = parse_vector_type_name(type_name)) {
+    return llvm::FixedVectorType::get(get_llvm_type(vector->element),
+                                      vector->lanes);
   }
   return nullptr;
 }
 
+std::string CodeGen::get_type_name(llvm::Type *type) {
+  if (type->isIntegerTy(1)) {
+    return "bool";
+  } else if (type->isIntegerTy()) {
+    // 无法区分无符号类型，调用方优先使用表达式的 inferred_type
+    return "i" + std::to_string(type->getIntegerBitWidth());
+  } else if (type->isFloatTy()) {
+    return "f32";
+  } else if (type->isDoubleTy()) {
+    return "f64";
+  } else if (auto *vector = llvm::dyn_cast<llvm::FixedVectorType>(type)) {
+    std::string element = get_type_name(vector->getElementType());
+    if (!element.empty()) {
+      return element + "x" + std::to_string(vector->getNumElements());
+    }
+  }
+  return "";
+}
+
+std::string CodeGen::operand_type_name(const Expr *expr, llvm::Value *value) {
+  return expr->inferred_type.empty() ? get_type_name(value->getType())
+                                     : expr->inferred_type;
+}
+
+llvm::Type *CodeGen::get_param_type(const std::string &type_name) {
+  llvm::Type *type = get_llvm_type(type_name);
+  if (type && type->isArrayTy()) {
+    return llvm::PointerType::getUnqual(context_);
+  }
+  return type;
+}
+
+void CodeGen::add_array_param_attributes(
+    llvm::Function *func, const std::vector<std::string> &param_types) {
+  const llvm::DataLayout &layout = module_->getDataLayout();
+  for (size_t i = 0; i < param_types.size(); ++i) {
+    llvm::Type *type = get_llvm_type(param_types[i]);
+    if (!type || !type->isArrayTy()) {
+      continue;
+    }
+    llvm::Argument *arg = func->getArg(i);
+    arg->addAttr(llvm::Attribute::NonNull);
+    arg->addAttr(llvm::Attribute::NoCapture);
+    arg->addAttr(llvm::Attribute::getWithDereferenceableBytes(
+        context_, layout.getTypeAllocSize(type).getFixedValue()));
+    arg->addAttr(llvm::Attribute::getWithAlignment(
+        context_, layout.getABITypeAlign(type)));
+  }
+}
+
+void CodeGen::add_fast_math_attributes() {
+  // 与 clang 的 -ffast-math 相同的函数属性：指令上的标志之外，
+  // 部分优化（如浮点 min/max 归约的向量化）只看函数属性
+  const llvm::FastMathFlags &flags = fast_math_flags_;
+  std::pair<const char *, bool> attributes[] = {
+      {"no-nans-fp-math", flags.noNaNs()},
+      {"no-infs-fp-math", flags.noInfs()},
+      {"no-signed-zeros-fp-math", flags.noSignedZeros()},
+      {"approx-func-fp-math", flags.approxFunc()},
+      {"unsafe-fp-math", flags.isFast()},
+  };
+  for (llvm::Function &func : *module_) {
+    if (func.isDeclaration()) {
+      continue;
+    }
+    for (const auto &[name, enabled] : attributes) {
+      if (enabled) {
+        func.addFnAttr(name, "true");
+      }
+    }
+  }
+}
+
 void CodeGen::push_scope() { value_stack_.emplace_back(); }
 
 void CodeGen::pop_scope() {
@@ -52,27 +181,58 @@ llvm::Value *CodeGen::lookup_variable(const std::string &name) {
   return nullptr;
 }
 
+llvm::AllocaInst *CodeGen::create_entry_alloca(llvm::Type *type,
+                                               const std::string &name) {
+  llvm::BasicBlock &entry = current_function_->getEntryBlock();
+  llvm::IRBuilder<> entry_builder(&entry, entry.begin());
+  return entry_builder.CreateAlloca(type, nullptr, name);
+}
+
+void CodeGen::bind_params(llvm::Function *llvm_func,
+                          const std::vector<Parameter> &params) {
+  size_t idx = 0;
+  for (auto &arg : llvm_func->args()) {
+    const Parameter &param = params[idx++];
+    if (arg.getType()->isPointerTy() && param.type &&
+        param.type.value()->kind == TypeKind::Array) {
+      arrays_[&arg] = llvm::cast<llvm::ArrayType>(
+          get_llvm_type(param.type.value()->name));
+      add_variable(param.name, &arg);
+      continue;
+    }
+    llvm::AllocaInst *alloca =
+        builder_.CreateAlloca(arg.getType(), nullptr, arg.getName());
+    builder_.CreateStore(&arg, alloca);
+    add_variable(param.name, alloca);
+  }
+}
+
 void CodeGen::error(const std::string &msg, size_t line, size_t column) {
   errors_.emplace_back(msg, line, column);
 }
 
-bool CodeGen::generate(std::vector<StmtPtr> &stmts,
-                       const ScopedSymbolTable &symbols) {
-  symbols_ = &symbols;
-  errors_.clear();
-  value_stack_.clear();
-  functions_.clear();
-  current_function_ = nullptr;
-
+bool CodeGen::declare_symbols(const ScopedSymbolTable &symbols) {
   // 首先从 symbol table 中声明所有函数（包括 prelude 和用户定义的）
   auto func_names = symbols.symbol_table().get_all_function_names();
   for (const auto &func_name : func_names) {
     auto funcs = symbols.symbol_table().find_functions(func_name);
     for (const auto &func_info : funcs) {
+      bool integer_first_arg =
+          !func_info.param_types.empty() &&
+          parse_integer_type_name(func_info.param_types[0]);
+      if (is_conversion_builtin(func_name) ||
+          is_bit_builtin(func_name, integer_first_arg) ||
+          is_simd_builtin(func_name,
+                          !func_info.param_types.empty() &&
+                              parse_vector_type_name(
+                                  func_info.param_types[0]))) {
+        continue;
+      }
+
       // 构建参数类型列表
       std::vector<llvm::Type *> param_types;
       for (const auto &param_type : func_info.param_types) {
-        llvm::Type *ty = get_llvm_type(param_type);
+        llvm::Type *ty = get_param_type(param_type);
         if (!ty) {
           error("Unknown type: " + param_type, 0, 0);
           return false;
@@ -92,6 +252,7 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
           llvm::FunctionType::get(return_type, param_types, false);
       llvm::Function *llvm_func = llvm::Function::Create(
           func_type, llvm::Function::ExternalLinkage, func_name, module_.get());
+      add_array_param_attributes(llvm_func, func_info.param_types);
 
       functions_[func_name] = llvm_func;
     }
@@ -103,7 +264,7 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
     // 构建参数类型列表
     std::vector<llvm::Type *> param_types;
     for (const auto &param_type : op_info.signature.param_types) {
-      llvm::Type *ty = get_llvm_type(param_type);
+      llvm::Type *ty = get_param_type(param_type);
       if (!ty) {
         error("Unknown type: " + param_type, 0, 0);
         return false;
@@ -120,18 +281,8 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
 
     // 生成 mangled name 用于区分重载：op_symbol$position$type1$type2...
     // 对于一元 operator，需要加上 position 以区分 prefix 和 postfix
-    std::string mangled_name = op_info.op;
-    if (op_info.signature.param_types.size() == 1) {
-      // 一元 operator：添加位置信息
-      if (op_info.position == OpPosition::Prefix) {
-        mangled_name += "$prefix";
-      } else if (op_info.position == OpPosition::Postfix) {
-        mangled_name += "$postfix";
-      }
-    }
-    for (const auto &param_type : op_info.signature.param_types) {
-      mangled_name += "$" + param_type;
-    }
+    std::string mangled_name = mangle_operator_name(
+        op_info.op, op_info.position, op_info.signature.param_types);
 
     // 创建函数声明（使用 mangled name）
     llvm::FunctionType *func_type =
@@ -139,10 +290,27 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
     llvm::Function *llvm_func =
         llvm::Function::Create(func_type, llvm::Function::ExternalLinkage,
                                mangled_name, module_.get());
+    add_array_param_attributes(llvm_func, op_info.signature.param_types);
 
     functions_[mangled_name] = llvm_func;
   }
 
+  return true;
+}
+
+bool CodeGen::generate(std::vector<StmtPtr> &stmts,
+                       const ScopedSymbolTable &symbols) {
+  symbols_ = &symbols;
+  errors_.clear();
+  value_stack_.clear();
+  arrays_.clear();
+  functions_.clear();
+  current_function_ = nullptr;
+
+  if (!declare_symbols(symbols)) {
+    return false;
+  }
+
   // 创建隐式入口函数 __pecco_entry
   llvm::FunctionType *entry_type =
       llvm::FunctionType::get(llvm::Type::getInt32Ty(context_), false);
@@ -159,18 +327,27 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
   // 创建全局作用域
   push_scope();
 
+  // 构建调用图，找出从顶层语句可达的定义
+  CallGraph call_graph;
+  if (eliminate_dead_functions_) {
+    call_graph.build(stmts);
+  }
+  auto is_live = [&](const Stmt *definition) {
+    return !eliminate_dead_functions_ || call_graph.is_reachable(definition);
+  };
+
   // 生成所有顶层语句
   for (auto &stmt : stmts) {
     if (stmt->kind == StmtKind::Func) {
       // 函数定义单独处理
       auto *func = static_cast<FuncStmt *>(stmt.get());
-      if (func->body) {
+      if (func->body && is_live(func)) {
         gen_func_stmt(func);
       }
     } else if (stmt->kind == StmtKind::OperatorDecl) {
       // 操作符定义单独处理
       auto *op_decl = static_cast<OperatorDeclStmt *>(stmt.get());
-      if (op_decl->body) {
+      if (op_decl->body && is_live(op_decl)) {
         gen_operator_stmt(op_decl);
       }
     } else {
@@ -186,6 +363,7 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
   }
 
   pop_scope();
+  add_fast_math_attributes();
 
   // 验证模块
   std::string error_str;
@@ -198,6 +376,48 @@ bool CodeGen::generate(std::vector<StmtPtr> &stmts,
   return !has_errors();
 }
 
+bool CodeGen::generate_definitions(std::vector<StmtPtr> &stmts,
+                                   const ScopedSymbolTable &symbols,
+                                   const std::set<std::string> &names) {
+  symbols_ = &symbols;
+  errors_.clear();
+  value_stack_.clear();
+  arrays_.clear();
+  functions_.clear();
+  current_function_ = nullptr;
+
+  if (!declare_symbols(symbols)) {
+    return false;
+  }
+
+  // 函数体看不到顶层变量，这里的全局作用域为空
+  push_scope();
+  for (auto &stmt : stmts) {
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<FuncStmt *>(stmt.get());
+      if (func->body && names.count(func->name)) {
+        gen_func_stmt(func);
+      }
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op_decl = static_cast<OperatorDeclStmt *>(stmt.get());
+      if (op_decl->body && names.count(mangle_operator_declaration(*op_decl))) {
+        gen_operator_stmt(op_decl);
+      }
+    }
+  }
+  pop_scope();
+  add_fast_math_attributes();
+
+  std::string error_str;
+  llvm::raw_string_ostream error_stream(error_str);
+  if (llvm::verifyModule(*module_, &error_stream)) {
+    error("LLVM module verification failed: " + error_str, 0, 0);
+    return false;
+  }
+
+  return !has_errors();
+}
+
 std::string CodeGen::get_ir() const {
   std::string ir_str;
   llvm::raw_string_ostream stream(ir_str);
@@ -258,15 +478,7 @@ void CodeGen::gen_func_stmt(FuncStmt *func) {
   // 创建新作用域
   push_scope();
 
-  // 为每个参数创建 alloca 并存储参数值
-  size_t idx = 0;
-  for (auto &arg : llvm_func->args()) {
-    llvm::AllocaInst *alloca =
-        builder_.CreateAlloca(arg.getType(), nullptr, arg.getName());
-    builder_.CreateStore(&arg, alloca);
-    add_variable(func->params[idx].name, alloca);
-    idx++;
-  }
+  bind_params(llvm_func, func->params);
 
   // 生成函数体
   if (func->body) {
@@ -282,11 +494,7 @@ void CodeGen::gen_func_stmt(FuncStmt *func) {
       // 如果函数应该返回值但没有 return，这是个错误
       // 但为了生成有效的 IR，我们返回一个默认值
       llvm::Type *ret_type = get_llvm_type(func->return_type.value()->name);
-      if (ret_type->isIntegerTy()) {
-        builder_.CreateRet(llvm::ConstantInt::get(ret_type, 0));
-      } else if (ret_type->isDoubleTy()) {
-        builder_.CreateRet(llvm::ConstantFP::get(ret_type, 0.0));
-      }
+      builder_.CreateRet(llvm::Constant::getNullValue(ret_type));
     }
   }
 
@@ -301,20 +509,7 @@ void CodeGen::gen_func_stmt(FuncStmt *func) {
 
 void CodeGen::gen_operator_stmt(OperatorDeclStmt *op_decl) {
   // 生成 mangled name（与声明时相同）
-  std::string mangled_name = op_decl->op;
-  if (op_decl->params.size() == 1) {
-    // 一元 operator：添加位置信息
-    if (op_decl->position == OpPosition::Prefix) {
-      mangled_name += "$prefix";
-    } else if (op_decl->position == OpPosition::Postfix) {
-      mangled_name += "$postfix";
-    }
-  }
-  for (const auto &param : op_decl->params) {
-    if (param.type) {
-      mangled_name += "$" + param.type.value()->name;
-    }
-  }
+  std::string mangled_name = mangle_operator_declaration(*op_decl);
 
   // Operator 已经在 generate 中声明，这里生成函数体
   llvm::Function *llvm_func = functions_[mangled_name];
@@ -336,15 +531,7 @@ void CodeGen::gen_operator_stmt(OperatorDeclStmt *op_decl) {
   // 创建新作用域
   push_scope();
 
-  // 为每个参数创建 alloca 并存储参数值
-  size_t idx = 0;
-  for (auto &arg : llvm_func->args()) {
-    llvm::AllocaInst *alloca =
-        builder_.CreateAlloca(arg.getType(), nullptr, arg.getName());
-    builder_.CreateStore(&arg, alloca);
-    add_variable(op_decl->params[idx].name, alloca);
-    idx++;
-  }
+  bind_params(llvm_func, op_decl->params);
 
   // 生成函数体
   if (op_decl->body) {
@@ -360,11 +547,7 @@ void CodeGen::gen_operator_stmt(OperatorDeclStmt *op_decl) {
       // 如果函数应该返回值但没有 return，这是个错误
       // 但为了生成有效的 IR，我们返回一个默认值
       llvm::Type *ret_type = get_llvm_type(op_decl->return_type.value()->name);
-      if (ret_type->isIntegerTy()) {
-        builder_.CreateRet(llvm::ConstantInt::get(ret_type, 0));
-      } else if (ret_type->isDoubleTy()) {
-        builder_.CreateRet(llvm::ConstantFP::get(ret_type, 0.0));
-      }
+      builder_.CreateRet(llvm::Constant::getNullValue(ret_type));
     }
   }
 
@@ -378,6 +561,11 @@ void CodeGen::gen_operator_stmt(OperatorDeclStmt *op_decl) {
 }
 
 void CodeGen::gen_let_stmt(LetStmt *let) {
+  if (let->type && let->type.value()->kind == TypeKind::Array) {
+    gen_array_let_stmt(let);
+    return;
+  }
+
   // 生成初始化表达式
   llvm::Value *init_val = nullptr;
   if (let->init) {
@@ -399,8 +587,7 @@ void CodeGen::gen_let_stmt(LetStmt *let) {
     return;
   }
 
-  llvm::AllocaInst *alloca =
-      builder_.CreateAlloca(var_type, nullptr, let->name);
+  llvm::AllocaInst *alloca = create_entry_alloca(var_type, let->name);
 
   // 如果有初始值，存储它
   if (init_val) {
@@ -411,6 +598,34 @@ void CodeGen::gen_let_stmt(LetStmt *let) {
   add_variable(let->name, alloca);
 }
 
+void CodeGen::gen_array_let_stmt(LetStmt *let) {
+  auto *type = llvm::dyn_cast_or_null<llvm::ArrayType>(
+      get_llvm_type(let->type.value()->name));
+  if (!type) {
+    error("Unknown type: " + let->type.value()->name, let->loc.line,
+          let->loc.column);
+    return;
+  }
+
+  llvm::Value *storage;
+  if (value_stack_.size() == 1) {
+    // 顶层数组是模块的全局变量，之后定义的函数也能访问
+    storage = new llvm::GlobalVariable(
+        *module_, type, false, llvm::GlobalValue::InternalLinkage,
+        llvm::ConstantAggregateZero::get(type), let->name);
+  } else {
+    // 局部数组：每次执行到声明时清零
+    llvm::AllocaInst *alloca = create_entry_alloca(type, let->name);
+    builder_.CreateMemSet(
+        alloca, builder_.getInt8(0),
+        module_->getDataLayout().getTypeAllocSize(type).getFixedValue(),
+        alloca->getAlign());
+    storage = alloca;
+  }
+  arrays_[storage] = type;
+  add_variable(let->name, storage);
+}
+
 void CodeGen::gen_return_stmt(ReturnStmt *ret) {
   if (ret->value) {
     llvm::Value *val = gen_expr(ret->value.value().get());
@@ -533,6 +748,8 @@ llvm::Value *CodeGen::gen_expr(Expr *expr) {
     return gen_unary_expr(static_cast<UnaryExpr *>(expr));
   case ExprKind::Call:
     return gen_call_expr(static_cast<CallExpr *>(expr));
+  case ExprKind::Index:
+    return gen_index_expr(static_cast<IndexExpr *>(expr));
   case ExprKind::OperatorSeq:
     error("OperatorSeq should have been resolved before codegen",
           expr->loc.line, expr->loc.column);
@@ -542,13 +759,20 @@ llvm::Value *CodeGen::gen_expr(Expr *expr) {
 }
 
 llvm::Value *CodeGen::gen_int_literal(IntLiteralExpr *lit) {
-  int64_t val = std::stoll(lit->value);
-  return llvm::ConstantInt::get(context_, llvm::APInt(32, val, true));
+  auto integer = parse_integer_type_name(lit->type);
+  unsigned bits = integer ? integer->bits : 32;
+  // 常量折叠的结果可能是负数；u64 的值可能超出 int64_t
+  if (!lit->value.empty() && lit->value[0] == '-') {
+    int64_t val = std::stoll(lit->value);
+    return llvm::ConstantInt::get(context_, llvm::APInt(bits, val, true));
+  }
+  uint64_t val = std::stoull(lit->value);
+  return llvm::ConstantInt::get(context_, llvm::APInt(bits, val));
 }
 
 llvm::Value *CodeGen::gen_float_literal(FloatLiteralExpr *lit) {
-  double val = std::stod(lit->value);
-  return llvm::ConstantFP::get(llvm::Type::getDoubleTy(context_), val);
+  // 按目标类型直接解析十进制文本，f32 不会经过 double 二次舍入
+  return llvm::ConstantFP::get(get_llvm_type(lit->type), lit->value);
 }
 
 llvm::Value *CodeGen::gen_string_literal(StringLiteralExpr *lit) {
@@ -567,6 +791,10 @@ llvm::Value *CodeGen::gen_identifier(IdentifierExpr *ident) {
           ident->loc.column);
     return nullptr;
   }
+  // 数组按引用使用（只能作为实参），值就是它的地址
+  if (arrays_.count(var)) {
+    return var;
+  }
   // Load 值从 alloca 指针
   llvm::Type *elem_type = llvm::cast<llvm::AllocaInst>(var)->getAllocatedType();
   return builder_.CreateLoad(elem_type, var, ident->name);
@@ -578,19 +806,10 @@ llvm::Value *CodeGen::gen_binary_expr(BinaryExpr *binary) {
   // 赋值操作符需要特殊处理（左值语义）
   if (op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "/=" ||
       op == "%=") {
-    // 左操作数必须是变量（左值）
-    if (binary->left->kind != ExprKind::Identifier) {
-      error("Left side of assignment must be a variable", binary->loc.line,
-            binary->loc.column);
-      return nullptr;
-    }
-
-    IdentifierExpr *var_expr =
-        static_cast<IdentifierExpr *>(binary->left.get());
-    llvm::Value *var = lookup_variable(var_expr->name);
+    // 左操作数必须是变量或数组元素（左值）
+    llvm::Type *elem_type = nullptr;
+    llvm::Value *var = gen_lvalue(binary->left.get(), elem_type);
     if (!var) {
-      error("Undefined variable: " + var_expr->name, binary->loc.line,
-            binary->loc.column);
       return nullptr;
     }
 
@@ -601,39 +820,40 @@ llvm::Value *CodeGen::gen_binary_expr(BinaryExpr *binary) {
     // 处理复合赋值操作符 (+=, -=, 等)
     if (op != "=") {
       // 先加载当前值
-      llvm::Type *elem_type =
-          llvm::cast<llvm::AllocaInst>(var)->getAllocatedType();
-      llvm::Value *left_val =
-          builder_.CreateLoad(elem_type, var, var_expr->name);
+      llvm::Value *left_val = builder_.CreateLoad(elem_type, var, "lhs");
 
       // 执行相应的操作
       if (op == "+=") {
-        if (left_val->getType()->isIntegerTy()) {
+        if (left_val->getType()->isIntOrIntVectorTy()) {
           right_val = builder_.CreateAdd(left_val, right_val, "addtmp");
-        } else if (left_val->getType()->isDoubleTy()) {
+        } else if (left_val->getType()->isFPOrFPVectorTy()) {
           right_val = builder_.CreateFAdd(left_val, right_val, "addtmp");
         }
       } else if (op == "-=") {
-        if (left_val->getType()->isIntegerTy()) {
+        if (left_val->getType()->isIntOrIntVectorTy()) {
           right_val = builder_.CreateSub(left_val, right_val, "subtmp");
-        } else if (left_val->getType()->isDoubleTy()) {
+        } else if (left_val->getType()->isFPOrFPVectorTy()) {
           right_val = builder_.CreateFSub(left_val, right_val, "subtmp");
         }
       } else if (op == "*=") {
-        if (left_val->getType()->isIntegerTy()) {
+        if (left_val->getType()->isIntOrIntVectorTy()) {
           right_val = builder_.CreateMul(left_val, right_val, "multmp");
-        } else if (left_val->getType()->isDoubleTy()) {
+        } else if (left_val->getType()->isFPOrFPVectorTy()) {
           right_val = builder_.CreateFMul(left_val, right_val, "multmp");
         }
       } else if (op == "/=") {
-        if (left_val->getType()->isIntegerTy()) {
-          right_val = builder_.CreateSDiv(left_val, right_val, "divtmp");
-        } else if (left_val->getType()->isDoubleTy()) {
+        if (left_val->getType()->isIntOrIntVectorTy()) {
+          right_val = is_unsigned(binary->left.get())
+                          ? builder_.CreateUDiv(left_val, right_val, "divtmp")
+                          : builder_.CreateSDiv(left_val, right_val, "divtmp");
+        } else if (left_val->getType()->isFPOrFPVectorTy()) {
           right_val = builder_.CreateFDiv(left_val, right_val, "divtmp");
         }
       } else if (op == "%=") {
-        if (left_val->getType()->isIntegerTy()) {
-          right_val = builder_.CreateSRem(left_val, right_val, "modtmp");
+        if (left_val->getType()->isIntOrIntVectorTy()) {
+          right_val = is_unsigned(binary->left.get())
+                          ? builder_.CreateURem(left_val, right_val, "modtmp")
+                          : builder_.CreateSRem(left_val, right_val, "modtmp");
         }
       }
     }
@@ -651,102 +871,115 @@ llvm::Value *CodeGen::gen_binary_expr(BinaryExpr *binary) {
   if (!left || !right)
     return nullptr;
 
+  // 无符号整数使用 udiv/urem/lshr 与无符号比较
+  bool is_unsigned_op = is_unsigned(binary->left.get());
+
   // 算术操作符
   if (op == "+") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateAdd(left, right, "addtmp");
-    } else if (left->getType()->isDoubleTy()) {
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFAdd(left, right, "addtmp");
     }
   } else if (op == "-") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateSub(left, right, "subtmp");
-    } else if (left->getType()->isDoubleTy()) {
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFSub(left, right, "subtmp");
     }
   } else if (op == "*") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateMul(left, right, "multmp");
-    } else if (left->getType()->isDoubleTy()) {
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFMul(left, right, "multmp");
     }
   } else if (op == "/") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateSDiv(left, right, "divtmp");
-    } else if (left->getType()->isDoubleTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateUDiv(left, right, "divtmp")
+                            : builder_.CreateSDiv(left, right, "divtmp");
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFDiv(left, right, "divtmp");
     }
   } else if (op == "%") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateSRem(left, right, "modtmp");
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateURem(left, right, "modtmp")
+                            : builder_.CreateSRem(left, right, "modtmp");
     }
   }
   // 幂运算
   else if (op == "**") {
-    if (left->getType()->isDoubleTy() && right->getType()->isDoubleTy()) {
-      llvm::Function *pow_func =
-          llvm::Intrinsic::getDeclaration(module_.get(), llvm::Intrinsic::pow,
-                                          {llvm::Type::getDoubleTy(context_)});
+    if (left->getType()->isFloatingPointTy() &&
+        left->getType() == right->getType()) {
+      llvm::Function *pow_func = llvm::Intrinsic::getDeclaration(
+          module_.get(), llvm::Intrinsic::pow, {left->getType()});
       return builder_.CreateCall(pow_func, {left, right}, "powtmp");
     }
   }
   // 位运算操作符
   else if (op == "&") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateAnd(left, right, "andtmp");
     }
   } else if (op == "|") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateOr(left, right, "ortmp");
     }
   } else if (op == "^") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateXor(left, right, "xortmp");
     }
-  } else if (op == "<<") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateShl(left, right, "shltmp");
-    }
-  } else if (op == ">>") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateAShr(left, right, "ashrtmp");
+  } else if (op == "<<" || op == ">>") {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      // 标量的移位量是 i32，转换为左操作数的宽度
+      if (right->getType() != left->getType()) {
+        right = builder_.CreateZExtOrTrunc(right, left->getType(), "shamt");
+      }
+      if (op == "<<") {
+        return builder_.CreateShl(left, right, "shltmp");
+      }
+      return is_unsigned_op ? builder_.CreateLShr(left, right, "lshrtmp")
+                            : builder_.CreateAShr(left, right, "ashrtmp");
     }
   }
   // 比较操作符
   else if (op == "==") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateICmpEQ(left, right, "eqtmp");
-    } else if (left->getType()->isDoubleTy()) {
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpOEQ(left, right, "eqtmp");
     }
   } else if (op == "!=") {
-    if (left->getType()->isIntegerTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
       return builder_.CreateICmpNE(left, right, "netmp");
-    } else if (left->getType()->isDoubleTy()) {
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpONE(left, right, "netmp");
     }
   } else if (op == "<") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateICmpSLT(left, right, "lttmp");
-    } else if (left->getType()->isDoubleTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateICmpULT(left, right, "lttmp")
+                            : builder_.CreateICmpSLT(left, right, "lttmp");
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpOLT(left, right, "lttmp");
     }
   } else if (op == "<=") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateICmpSLE(left, right, "letmp");
-    } else if (left->getType()->isDoubleTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateICmpULE(left, right, "letmp")
+                            : builder_.CreateICmpSLE(left, right, "letmp");
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpOLE(left, right, "letmp");
     }
   } else if (op == ">") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateICmpSGT(left, right, "gttmp");
-    } else if (left->getType()->isDoubleTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateICmpUGT(left, right, "gttmp")
+                            : builder_.CreateICmpSGT(left, right, "gttmp");
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpOGT(left, right, "gttmp");
     }
   } else if (op == ">=") {
-    if (left->getType()->isIntegerTy()) {
-      return builder_.CreateICmpSGE(left, right, "getmp");
-    } else if (left->getType()->isDoubleTy()) {
+    if (left->getType()->isIntOrIntVectorTy()) {
+      return is_unsigned_op ? builder_.CreateICmpUGE(left, right, "getmp")
+                            : builder_.CreateICmpSGE(left, right, "getmp");
+    } else if (left->getType()->isFPOrFPVectorTy()) {
       return builder_.CreateFCmpOGE(left, right, "getmp");
     }
   }
@@ -762,22 +995,8 @@ llvm::Value *CodeGen::gen_binary_expr(BinaryExpr *binary) {
   if (!ops.empty()) {
     // 需要找到匹配类型的 operator
     // 根据操作数的 LLVM 类型推断 Pecco 类型
-    std::string left_type, right_type;
-    if (left->getType()->isIntegerTy(32)) {
-      left_type = "i32";
-    } else if (left->getType()->isDoubleTy()) {
-      left_type = "f64";
-    } else if (left->getType()->isIntegerTy(1)) {
-      left_type = "bool";
-    }
-
-    if (right->getType()->isIntegerTy(32)) {
-      right_type = "i32";
-    } else if (right->getType()->isDoubleTy()) {
-      right_type = "f64";
-    } else if (right->getType()->isIntegerTy(1)) {
-      right_type = "bool";
-    }
+    std::string left_type = operand_type_name(binary->left.get(), left);
+    std::string right_type = operand_type_name(binary->right.get(), right);
 
     // 查找匹配的 operator 重载
     for (const auto &op_info : ops) {
@@ -785,7 +1004,8 @@ llvm::Value *CodeGen::gen_binary_expr(BinaryExpr *binary) {
           op_info.signature.param_types[0] == left_type &&
           op_info.signature.param_types[1] == right_type) {
         // 构造 mangled name
-        std::string mangled_name = op + "$" + left_type + "$" + right_type;
+        std::string mangled_name = mangle_operator_name(
+            op, OpPosition::Infix, {left_type, right_type});
         llvm::Function *op_func = module_->getFunction(mangled_name);
         if (op_func) {
           // 找到了 operator 函数
@@ -811,9 +1031,9 @@ llvm::Value *CodeGen::gen_unary_expr(UnaryExpr *unary) {
   if (unary->position == OpPosition::Prefix) {
     if (op == "-") {
       // 负号
-      if (operand->getType()->isIntegerTy()) {
+      if (operand->getType()->isIntOrIntVectorTy()) {
         return builder_.CreateNeg(operand, "negtmp");
-      } else if (operand->getType()->isDoubleTy()) {
+      } else if (operand->getType()->isFPOrFPVectorTy()) {
         return builder_.CreateFNeg(operand, "negtmp");
       }
     } else if (op == "!") {
@@ -830,27 +1050,16 @@ llvm::Value *CodeGen::gen_unary_expr(UnaryExpr *unary) {
   auto ops = symbols_->find_operators(op, unary->position);
   if (!ops.empty()) {
     // 根据操作数的 LLVM 类型推断 Pecco 类型
-    std::string operand_type;
-    if (operand->getType()->isIntegerTy(32)) {
-      operand_type = "i32";
-    } else if (operand->getType()->isDoubleTy()) {
-      operand_type = "f64";
-    } else if (operand->getType()->isIntegerTy(1)) {
-      operand_type = "bool";
-    }
+    std::string operand_type =
+        operand_type_name(unary->operand.get(), operand);
 
     // 查找匹配的 operator 重载
     for (const auto &op_info : ops) {
       if (op_info.signature.param_types.size() == 1 &&
           op_info.signature.param_types[0] == operand_type) {
         // 构造 mangled name（需要包含位置信息）
-        std::string mangled_name = op;
-        if (unary->position == OpPosition::Prefix) {
-          mangled_name += "$prefix";
-        } else if (unary->position == OpPosition::Postfix) {
-          mangled_name += "$postfix";
-        }
-        mangled_name += "$" + operand_type;
+        std::string mangled_name =
+            mangle_operator_name(op, unary->position, {operand_type});
         llvm::Function *op_func = module_->getFunction(mangled_name);
         if (op_func) {
           // 找到了 operator 函数
@@ -876,6 +1085,27 @@ llvm::Value *CodeGen::gen_call_expr(CallExpr *call) {
   auto *ident = static_cast<IdentifierExpr *>(call->callee.get());
   std::string func_name = ident->name;
 
+  // 生成参数值（SIMD 内置函数按参数类型识别）
+  std::vector<llvm::Value *> args;
+  for (auto &arg : call->args) {
+    llvm::Value *arg_val = gen_expr(arg.get());
+    if (!arg_val)
+      return nullptr;
+    args.push_back(arg_val);
+  }
+  if (is_conversion_builtin(func_name)) {
+    return gen_conversion(call, func_name, args);
+  }
+  if (is_bit_builtin(func_name, !args.empty() &&
+                                    args[0]->getType()->isIntegerTy() &&
+                                    !args[0]->getType()->isIntegerTy(1))) {
+    return gen_bit_builtin(call, func_name, args);
+  }
+  if (is_simd_builtin(func_name,
+                      !args.empty() && args[0]->getType()->isVectorTy())) {
+    return gen_simd_builtin(call, func_name, args);
+  }
+
   // 查找函数
   llvm::Function *callee = functions_[func_name];
   if (!callee) {
@@ -895,15 +1125,6 @@ llvm::Value *CodeGen::gen_call_expr(CallExpr *call) {
     return nullptr;
   }
 
-  // 生成参数值
-  std::vector<llvm::Value *> args;
-  for (auto &arg : call->args) {
-    llvm::Value *arg_val = gen_expr(arg.get());
-    if (!arg_val)
-      return nullptr;
-    args.push_back(arg_val);
-  }
-
   // 生成函数调用
   // void 函数的调用不应该有名字
   if (callee->getReturnType()->isVoidTy()) {
@@ -913,4 +1134,220 @@ llvm::Value *CodeGen::gen_call_expr(CallExpr *call) {
   }
 }
 
+llvm::Value *CodeGen::gen_conversion(CallExpr *call, const std::string &name,
+                                     const std::vector<llvm::Value *> &args) {
+  if (args.size() != 1) {
+    error("Incorrect number of arguments for function " + name, call->loc.line,
+          call->loc.column);
+    return nullptr;
+  }
+  llvm::Value *value = args[0];
+  llvm::Type *from = value->getType();
+  llvm::Type *to = get_llvm_type(name);
+  auto target = parse_integer_type_name(name);
+
+  if (from->isIntegerTy()) {
+    // 按源类型的符号扩展或零扩展（bool 为零扩展），或截断
+    bool from_signed =
+        !from->isIntegerTy(1) && !is_unsigned(call->args[0].get());
+    if (target) {
+      return builder_.CreateIntCast(value, to, from_signed, "conv");
+    }
+    return from_signed ? builder_.CreateSIToFP(value, to, "conv")
+                       : builder_.CreateUIToFP(value, to, "conv");
+  }
+  if (from->isFloatingPointTy()) {
+    if (target) {
+      // 饱和转换：超出范围取边界值，NaN 为 0（fptosi 在此时是 poison）
+      return builder_.CreateIntrinsic(target->is_signed
+                                          ? llvm::Intrinsic::fptosi_sat
+                                          : llvm::Intrinsic::fptoui_sat,
+                                      {to, from}, {value}, nullptr, "conv");
+    }
+    return builder_.CreateFPCast(value, to, "conv");
+  }
+  error("Cannot convert to " + name, call->loc.line, call->loc.column);
+  return nullptr;
+}
+
+llvm::Value *CodeGen::gen_bit_builtin(CallExpr *call, const std::string &name,
+                                      const std::vector<llvm::Value *> &args) {
+  bool rotate = name == "rotl" || name == "rotr";
+  if (args.size() != (rotate ? 2u : 1u)) {
+    error("Incorrect number of arguments for function " + name, call->loc.line,
+          call->loc.column);
+    return nullptr;
+  }
+  llvm::Value *value = args[0];
+  llvm::Type *type = value->getType();
+
+  if (rotate) {
+    // 两个输入相同的漏斗移位即循环移位，移位量按位宽取模
+    llvm::Value *amount = builder_.CreateZExtOrTrunc(args[1], type, "rotamt");
+    return builder_.CreateIntrinsic(name == "rotl" ? llvm::Intrinsic::fshl
+                                                   : llvm::Intrinsic::fshr,
+                                    {type}, {value, value, amount}, nullptr,
+                                    name);
+  }
+  if (name == "bswap") {
+    // 单字节的字节序翻转不改变值（llvm.bswap 要求位宽是 16 的倍数）
+    if (type->getIntegerBitWidth() == 8) {
+      return value;
+    }
+    return builder_.CreateUnaryIntrinsic(llvm::Intrinsic::bswap, value,
+                                         nullptr, name);
+  }
+  if (name == "bitreverse") {
+    return builder_.CreateUnaryIntrinsic(llvm::Intrinsic::bitreverse, value,
+                                         nullptr, name);
+  }
+
+  // 计数结果统一为 i32；参数 0 时 clz/ctz 为位宽（is_zero_poison 为 false）
+  llvm::Value *count;
+  if (name == "popcount") {
+    count = builder_.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, value);
+  } else {
+    count = builder_.CreateIntrinsic(name == "clz" ? llvm::Intrinsic::ctlz
+                                                   : llvm::Intrinsic::cttz,
+                                     {type}, {value, builder_.getFalse()});
+  }
+  return builder_.CreateZExtOrTrunc(count, builder_.getInt32Ty(), name);
+}
+
+llvm::Value *CodeGen::gen_simd_builtin(CallExpr *call, const std::string &name,
+                                       const std::vector<llvm::Value *> &args) {
+  auto arity_error = [&]() -> llvm::Value * {
+    error("Incorrect number of arguments for function " + name, call->loc.line,
+          call->loc.column);
+    return nullptr;
+  };
+
+  // 构造：一个参数时广播到所有 lane，否则逐个 lane 给出
+  if (auto vector = parse_vector_type_name(name)) {
+    if (args.size() == 1) {
+      return builder_.CreateVectorSplat(vector->lanes, args[0], "splat");
+    }
+    if (args.size() != vector->lanes) {
+      return arity_error();
+    }
+    llvm::Value *result = llvm::PoisonValue::get(get_llvm_type(name));
+    for (size_t i = 0; i < args.size(); ++i) {
+      result = builder_.CreateInsertElement(result, args[i], i, "vec");
+    }
+    return result;
+  }
+
+  auto *type = llvm::cast<llvm::FixedVectorType>(args[0]->getType());
+  bool is_float = type->isFPOrFPVectorTy();
+  llvm::Type *element = type->getElementType();
+
+  if (name == "shuffle") {
+    if (args.size() != 2 + type->getNumElements()) {
+      return arity_error();
+    }
+    // shufflevector 的 mask 必须是常量（类型检查要求 lane 为整数字面量）
+    llvm::SmallVector<int, 16> mask;
+    for (size_t i = 2; i < args.size(); ++i) {
+      auto *lane = llvm::dyn_cast<llvm::ConstantInt>(args[i]);
+      if (!lane) {
+        error("Shuffle lanes must be integer constants", call->loc.line,
+              call->loc.column);
+        return nullptr;
+      }
+      mask.push_back(static_cast<int>(lane->getSExtValue()));
+    }
+    return builder_.CreateShuffleVector(args[0], args[1], mask, "shuffle");
+  }
+
+  size_t arity = name == "extract"                       ? 2
+                 : name == "insert" || name == "select" ? 3
+                                                         : 1;
+  if (args.size() != arity) {
+    return arity_error();
+  }
+  if (name == "extract") {
+    return builder_.CreateExtractElement(args[0], args[1], "lane");
+  } else if (name == "insert") {
+    return builder_.CreateInsertElement(args[0], args[2], args[1], "vec");
+  } else if (name == "select") {
+    return builder_.CreateSelect(args[0], args[1], args[2], "select");
+  } else if (name == "reduce_add") {
+    // 不带 reassoc 标志的浮点归约按 lane 顺序求和
+    return is_float ? builder_.CreateFAddReduce(
+                          llvm::ConstantFP::get(element, -0.0), args[0])
+                    : builder_.CreateAddReduce(args[0]);
+  } else if (name == "reduce_mul") {
+    return is_float ? builder_.CreateFMulReduce(
+                          llvm::ConstantFP::get(element, 1.0), args[0])
+                    : builder_.CreateMulReduce(args[0]);
+  } else if (name == "reduce_min") {
+    return is_float ? builder_.CreateFPMinReduce(args[0])
+                    : builder_.CreateIntMinReduce(args[0], true);
+  } else if (name == "reduce_max") {
+    return is_float ? builder_.CreateFPMaxReduce(args[0])
+                    : builder_.CreateIntMaxReduce(args[0], true);
+  } else if (name == "any") {
+    return builder_.CreateOrReduce(args[0]);
+  } else if (name == "all") {
+    return builder_.CreateAndReduce(args[0]);
+  }
+  error("Unknown function: " + name, call->loc.line, call->loc.column);
+  return nullptr;
+}
+
+llvm::Value *CodeGen::gen_index_expr(IndexExpr *index) {
+  llvm::Type *elem_type = nullptr;
+  llvm::Value *elem_ptr = gen_lvalue(index, elem_type);
+  if (!elem_ptr)
+    return nullptr;
+  // 数组的数组：元素本身是数组，同样按引用使用
+  if (elem_type->isArrayTy()) {
+    return elem_ptr;
+  }
+  return builder_.CreateLoad(elem_type, elem_ptr, "elem");
+}
+
+llvm::Value *CodeGen::gen_lvalue(Expr *expr, llvm::Type *&type) {
+  if (expr->kind == ExprKind::Identifier) {
+    auto *ident = static_cast<IdentifierExpr *>(expr);
+    llvm::Value *var = lookup_variable(ident->name);
+    if (!var) {
+      error("Undefined variable: " + ident->name, expr->loc.line,
+            expr->loc.column);
+      return nullptr;
+    }
+    auto array = arrays_.find(var);
+    type = array != arrays_.end()
+               ? array->second
+               : llvm::cast<llvm::AllocaInst>(var)->getAllocatedType();
+    return var;
+  }
+
+  if (expr->kind == ExprKind::Index) {
+    auto *index = static_cast<IndexExpr *>(expr);
+    llvm::Type *base_type = nullptr;
+    llvm::Value *base = gen_lvalue(index->base.get(), base_type);
+    if (!base)
+      return nullptr;
+    auto *array_type = llvm::dyn_cast<llvm::ArrayType>(base_type);
+    if (!array_type) {
+      error("Cannot index a value that is not an array", expr->loc.line,
+            expr->loc.column);
+      return nullptr;
+    }
+    llvm::Value *idx = gen_expr(index->index.get());
+    if (!idx)
+      return nullptr;
+    // 下标是 i32，GEP 使用 64 位下标；不做运行时越界检查
+    idx = builder_.CreateSExt(idx, builder_.getInt64Ty(), "idxext");
+    type = array_type->getElementType();
+    return builder_.CreateInBoundsGEP(array_type, base,
+                                      {builder_.getInt64(0), idx}, "elemptr");
+  }
+
+  error("Left side of assignment must be a variable or an array element",
+        expr->loc.line, expr->loc.column);
+  return nullptr;
+}
+
 } // namespace pecco
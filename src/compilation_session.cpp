@@ -0,0 +1,208 @@
+#include "compilation_session.hpp"
+
+#include "ast_optimizer.hpp"
+#include "lexer.hpp"
+#include "operator_resolver.hpp"
+#include "parser.hpp"
+#include "symbol_table_builder.hpp"
+#include "token_stream.hpp"
+#include "type_checker.hpp"
+
+namespace pecco {
+
+Diagnostic resolver_diagnostic(const std::string &error) {
+  // Format: "at line:col: message"
+  size_t colon = error.find(':');
+  size_t end = error.find(": ");
+  if (error.rfind("at ", 0) == 0 && end != std::string::npos && colon < end) {
+    try {
+      return {"semantic", error.substr(end + 2),
+              std::stoul(error.substr(3, colon - 3)),
+              std::stoul(error.substr(colon + 1, end - colon - 1))};
+    } catch (const std::exception &) {
+    }
+  }
+  return {"semantic", error};
+}
+
+std::shared_ptr<const SymbolTable> CompilationSession::default_prelude() {
+  // Magic static: initialized exactly once even with concurrent callers
+  static const std::shared_ptr<const SymbolTable> prelude =
+      load_prelude(STDLIB_DIR "/prelude.pec", nullptr);
+  return prelude;
+}
+
+std::shared_ptr<const SymbolTable>
+CompilationSession::load_prelude(const std::string &path,
+                                 std::vector<Diagnostic> *diagnostics) {
+  ScopedSymbolTable symbols;
+  SymbolTableBuilder builder;
+  if (!builder.load_prelude(path, symbols)) {
+    if (diagnostics) {
+      for (const auto &err : builder.errors()) {
+        diagnostics->push_back(
+            {"semantic", err.message, err.line, err.column, 0, 0});
+      }
+    }
+    return nullptr;
+  }
+  return std::make_shared<const SymbolTable>(symbols.symbol_table());
+}
+
+CompilationSession::CompilationSession(
+    CompileOptions options, std::shared_ptr<const SymbolTable> prelude)
+    : options_(std::move(options)), has_prelude_(prelude != nullptr),
+      symbols_(std::move(prelude)) {}
+
+void CompilationSession::set_prelude(
+    std::shared_ptr<const SymbolTable> prelude) {
+  has_prelude_ = prelude != nullptr;
+  symbols_ = ScopedSymbolTable(std::move(prelude));
+}
+
+void CompilationSession::report(std::string phase, std::string message,
+                                size_t line, size_t column, size_t end_column,
+                                size_t caret_offset) {
+  diagnostics_.push_back({std::move(phase), std::move(message), line, column,
+                          end_column, caret_offset});
+}
+
+bool CompilationSession::parse(std::string_view source) {
+  if (options_.stream_tokens && options_.parse_jobs <= 1) {
+    return parse_streaming(source);
+  }
+
+  Lexer lexer(source);
+  auto tokens = lexer.tokenize_all();
+  bool lexer_failed = false;
+  for (const auto &tok : tokens) {
+    if (tok.kind == TokenKind::Error) {
+      report("lexer", tok.lexeme, tok.line, tok.column, tok.end_column,
+             tok.error_offset);
+      lexer_failed = true;
+    }
+  }
+  if (lexer_failed) {
+    return false;
+  }
+
+  Parser parser(std::move(tokens));
+  stmts_ = parser.parse_program_parallel(options_.parse_jobs);
+  if (parser.has_errors()) {
+    for (const auto &err : parser.errors()) {
+      report("parse", err.message, err.line, err.column, err.end_column);
+    }
+    return false;
+  }
+  return true;
+}
+
+bool CompilationSession::parse_streaming(std::string_view source) {
+  TokenStream stream(source);
+  Parser parser(stream);
+  stmts_ = parser.parse_program();
+
+  // Lexer errors take precedence, as in parse(): the parse errors they
+  // cause are not reported
+  const auto &lexer_errors = stream.lexer_errors();
+  if (!lexer_errors.empty()) {
+    for (const auto &tok : lexer_errors) {
+      report("lexer", tok.lexeme, tok.line, tok.column, tok.end_column,
+             tok.error_offset);
+    }
+    stmts_.clear();
+    return false;
+  }
+  if (parser.has_errors()) {
+    for (const auto &err : parser.errors()) {
+      report("parse", err.message, err.line, err.column, err.end_column);
+    }
+    return false;
+  }
+  return true;
+}
+
+void CompilationSession::declare(const FunctionSignature &signature) {
+  symbols_.add_function(signature);
+}
+
+void CompilationSession::declare(const OperatorInfo &info) {
+  symbols_.add_operator(info);
+}
+
+bool CompilationSession::analyze() {
+  if (!has_prelude_) {
+    report("semantic", "failed to load prelude");
+    return false;
+  }
+
+  // Phase 1: hierarchical symbol table (all declarations, all scopes)
+  SymbolTableBuilder builder;
+  if (!builder.collect(stmts_, symbols_)) {
+    for (const auto &err : builder.errors()) {
+      report("semantic", err.message, err.line, err.column);
+    }
+    return false;
+  }
+
+  // Phase 2: operator sequences to precedence trees
+  std::vector<std::string> resolve_errors;
+  for (auto &stmt : stmts_) {
+    OperatorResolver::resolve_stmt(stmt.get(), symbols_.symbol_table(),
+                                   resolve_errors);
+  }
+  for (const auto &err : resolve_errors) {
+    diagnostics_.push_back(resolver_diagnostic(err));
+  }
+  if (!resolve_errors.empty()) {
+    return false;
+  }
+
+  // Phase 3: type checking and inference
+  TypeChecker checker;
+  if (!checker.check(stmts_, symbols_)) {
+    for (const auto &err : checker.errors()) {
+      report("type", err.message, err.line, err.column);
+    }
+    return false;
+  }
+  return true;
+}
+
+void CompilationSession::optimize_ast() {
+  if (options_.ast_opt) {
+    AstPassManager::create_default().run(stmts_);
+  }
+}
+
+bool CompilationSession::generate() {
+  codegen_ = std::make_unique<CodeGen>(options_.module_name);
+  return run_codegen();
+}
+
+bool CompilationSession::generate(llvm::LLVMContext &context) {
+  codegen_ = std::make_unique<CodeGen>(options_.module_name, context);
+  return run_codegen();
+}
+
+bool CompilationSession::run_codegen() {
+  codegen_->set_eliminate_dead_functions(options_.eliminate_dead_functions);
+  codegen_->set_fast_math_flags(options_.fast_math_flags);
+  if (!codegen_->generate(stmts_, symbols_)) {
+    for (const auto &err : codegen_->errors()) {
+      report("code generation", err.message, err.line, err.column);
+    }
+    return false;
+  }
+  return true;
+}
+
+bool CompilationSession::compile(std::string_view source) {
+  if (!parse(source) || !analyze()) {
+    return false;
+  }
+  optimize_ast();
+  return generate();
+}
+
+} // namespace pecco
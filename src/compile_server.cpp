@@ -0,0 +1,456 @@
+#include "compile_server.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace pecco {
+
+namespace {
+
+// Wire format, client to server: a uint32_t payload length carrying the
+// client's stdin/stdout/stderr as SCM_RIGHTS, then the payload: working
+// directory and arguments, each NUL-terminated. Server to client: the
+// request's int32_t exit status.
+constexpr uint32_t max_payload = 1 << 20;
+constexpr int forwarded_fds = 3;
+
+// Self-pipe: signal handlers wake up the accept loop through it
+int signal_pipe[2] = {-1, -1};
+volatile sig_atomic_t stop_requested = 0;
+
+void on_child_exit(int) {
+  int saved = errno;
+  char byte = 'c';
+  (void)!write(signal_pipe[1], &byte, 1);
+  errno = saved;
+}
+
+void on_stop(int) {
+  stop_requested = 1;
+  on_child_exit(0);
+}
+
+bool make_address(const std::string &path, sockaddr_un &address,
+                  std::string &error) {
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    error = "socket path too long: " + path;
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+std::string system_error(const std::string &what) {
+  return what + ": " + std::strerror(errno);
+}
+
+// The other end of a connected socket must run as this user: requests
+// carry the client's terminal, working directory and arguments
+bool same_user_peer(int fd, std::string &error) {
+  ucred peer;
+  socklen_t size = sizeof(peer);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) < 0) {
+    error = system_error("cannot read peer credentials");
+    return false;
+  }
+  if (peer.uid != getuid()) {
+    error = "peer runs as uid " + std::to_string(peer.uid);
+    return false;
+  }
+  return true;
+}
+
+bool write_all(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool read_all(int fd, void *data, size_t size) {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t n = read(fd, bytes, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Receive the header and forwarded descriptors of a request
+bool receive_header(int connection, uint32_t &payload_size,
+                    int (&fds)[forwarded_fds]) {
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * forwarded_fds)];
+  iovec io = {&payload_size, sizeof(payload_size)};
+  msghdr message = {};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t n;
+  do {
+    n = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && errno == EINTR);
+
+  cmsghdr *header = CMSG_FIRSTHDR(&message);
+  bool has_fds = header && header->cmsg_level == SOL_SOCKET &&
+                 header->cmsg_type == SCM_RIGHTS &&
+                 header->cmsg_len == CMSG_LEN(sizeof(int) * forwarded_fds);
+  if (has_fds) {
+    std::memcpy(fds, CMSG_DATA(header), sizeof(int) * forwarded_fds);
+  }
+  if (n != sizeof(payload_size) || !has_fds) {
+    if (has_fds) {
+      for (int fd : fds) {
+        close(fd);
+      }
+    }
+    return false;
+  }
+  return payload_size <= max_payload;
+}
+
+// Split "cwd\0arg\0arg\0" into its parts
+std::vector<std::string> split_payload(const std::string &payload) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start < payload.size()) {
+    size_t end = payload.find('\0', start);
+    if (end == std::string::npos) {
+      end = payload.size();
+    }
+    parts.push_back(payload.substr(start, end - start));
+    start = end + 1;
+  }
+  return parts;
+}
+
+int exit_code(int wait_status) {
+  if (WIFEXITED(wait_status)) {
+    return WEXITSTATUS(wait_status);
+  }
+  if (WIFSIGNALED(wait_status)) {
+    return 128 + WTERMSIG(wait_status);
+  }
+  return 1;
+}
+
+} // namespace
+
+std::optional<std::string> default_server_socket(std::string &error) {
+  if (const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR")) {
+    if (*runtime_dir) {
+      return std::string(runtime_dir) + "/plc.sock";
+    }
+  }
+
+  // /tmp is shared with other users: keep the socket in a directory that
+  // only this user can enter, and refuse one that someone else prepared
+  std::string directory = "/tmp/plc-" + std::to_string(getuid());
+  if (mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+    error = system_error("cannot create " + directory);
+    return std::nullopt;
+  }
+  struct stat info;
+  if (lstat(directory.c_str(), &info) < 0) {
+    error = system_error("cannot access " + directory);
+    return std::nullopt;
+  }
+  if (!S_ISDIR(info.st_mode) || info.st_uid != getuid() ||
+      (info.st_mode & 077) != 0) {
+    error = directory + " is not a private directory of the current user";
+    return std::nullopt;
+  }
+  return directory + "/plc.sock";
+}
+
+CompileServer::CompileServer(std::string socket_path, ServerHandler handler)
+    : socket_path_(std::move(socket_path)), handler_(std::move(handler)) {}
+
+CompileServer::~CompileServer() {
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+  }
+}
+
+bool CompileServer::listen(std::string &error) {
+  sockaddr_un address;
+  if (!make_address(socket_path_, address, error)) {
+    return false;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    error = system_error("socket");
+    return false;
+  }
+
+  int bound =
+      bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  if (bound < 0 && errno == EADDRINUSE) {
+    // A live server accepts connections; a stale socket file refuses them
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool alive = connect(probe, reinterpret_cast<sockaddr *>(&address),
+                         sizeof(address)) == 0;
+    close(probe);
+    if (alive) {
+      error = "a compile server is already listening on " + socket_path_;
+      close(fd);
+      return false;
+    }
+    unlink(socket_path_.c_str());
+    bound = bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  }
+  if (bound < 0) {
+    error = system_error("cannot bind " + socket_path_);
+    close(fd);
+    return false;
+  }
+  if (::listen(fd, SOMAXCONN) < 0) {
+    error = system_error("cannot listen on " + socket_path_);
+    close(fd);
+    return false;
+  }
+  listen_fd_ = fd;
+  return true;
+}
+
+void CompileServer::start_request(int connection) {
+  std::string error;
+  if (!same_user_peer(connection, error)) {
+    close(connection);
+    return;
+  }
+
+  // The request is read in the child, so a slow or idle client holds up
+  // only its own request and never the accept loop
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Child: read the request, become the client's process and run it
+    signal(SIGCHLD, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    close(listen_fd_);
+    close(signal_pipe[0]);
+    close(signal_pipe[1]);
+    for (const auto &[other_pid, other_connection] : running_) {
+      close(other_connection);
+    }
+
+    // Requests are sent right after connecting
+    timeval timeout = {5, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+               sizeof(timeout));
+    uint32_t payload_size = 0;
+    int fds[forwarded_fds];
+    if (!receive_header(connection, payload_size, fds)) {
+      _exit(1);
+    }
+    std::string payload(payload_size, '\0');
+    std::vector<std::string> parts;
+    if (read_all(connection, payload.data(), payload.size())) {
+      parts = split_payload(payload);
+    }
+    if (parts.empty()) {
+      _exit(1);
+    }
+    close(connection);
+
+    for (int &fd : fds) {
+      // Move descriptors out of 0-2 first so dup2 cannot clobber them
+      if (fd < forwarded_fds) {
+        fd = fcntl(fd, F_DUPFD_CLOEXEC, forwarded_fds);
+      }
+    }
+    for (int i = 0; i < forwarded_fds; ++i) {
+      dup2(fds[i], i);
+      close(fds[i]);
+    }
+    if (chdir(parts[0].c_str()) < 0) {
+      std::string message =
+          system_error("plc server: cannot enter " + parts[0]) + "\n";
+      (void)!write(2, message.data(), message.size());
+      _exit(1);
+    }
+    parts.erase(parts.begin());
+    std::exit(handler_(parts));
+  }
+
+  if (pid < 0) {
+    int status = 1;
+    write_all(connection, &status, sizeof(status));
+    close(connection);
+    return;
+  }
+  running_[pid] = connection;
+}
+
+void CompileServer::reap_finished() {
+  int wait_status;
+  pid_t pid;
+  while ((pid = waitpid(-1, &wait_status, WNOHANG)) > 0) {
+    auto it = running_.find(pid);
+    if (it == running_.end()) {
+      continue;
+    }
+    int32_t status = exit_code(wait_status);
+    write_all(it->second, &status, sizeof(status));
+    close(it->second);
+    running_.erase(it);
+  }
+}
+
+void CompileServer::serve() {
+  if (pipe2(signal_pipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+    return;
+  }
+  struct sigaction action = {};
+  sigemptyset(&action.sa_mask);
+  action.sa_handler = on_child_exit;
+  sigaction(SIGCHLD, &action, nullptr);
+  action.sa_handler = on_stop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  while (!stop_requested) {
+    pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {signal_pipe[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      char buffer[64];
+      while (read(signal_pipe[0], buffer, sizeof(buffer)) > 0) {
+      }
+      reap_finished();
+    }
+    if (fds[0].revents & POLLIN) {
+      int connection = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+      if (connection >= 0) {
+        start_request(connection);
+      }
+    }
+  }
+
+  // Stop accepting, then let running requests finish
+  close(listen_fd_);
+  listen_fd_ = -1;
+  unlink(socket_path_.c_str());
+  for (const auto &[pid, connection] : running_) {
+    int wait_status;
+    while (waitpid(pid, &wait_status, 0) < 0 && errno == EINTR) {
+    }
+    int32_t status = exit_code(wait_status);
+    write_all(connection, &status, sizeof(status));
+    close(connection);
+  }
+  running_.clear();
+  close(signal_pipe[0]);
+  close(signal_pipe[1]);
+}
+
+std::optional<int> run_on_server(const std::string &socket_path,
+                                 const std::vector<std::string> &args,
+                                 std::string &error) {
+  sockaddr_un address;
+  if (!make_address(socket_path, address, error)) {
+    return std::nullopt;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    error = system_error("socket");
+    return std::nullopt;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) <
+      0) {
+    error = system_error("cannot connect to " + socket_path);
+    close(fd);
+    return std::nullopt;
+  }
+  std::string peer_error;
+  if (!same_user_peer(fd, peer_error)) {
+    error = "refusing compile server at " + socket_path + ": " + peer_error;
+    close(fd);
+    return std::nullopt;
+  }
+
+  char cwd[4096];
+  if (!getcwd(cwd, sizeof(cwd))) {
+    error = system_error("getcwd");
+    close(fd);
+    return std::nullopt;
+  }
+  std::string payload = std::string(cwd) + '\0';
+  for (const auto &arg : args) {
+    payload += arg + '\0';
+  }
+  uint32_t payload_size = static_cast<uint32_t>(payload.size());
+
+  // Header with our stdin/stdout/stderr attached
+  int fds[forwarded_fds] = {0, 1, 2};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+  iovec io = {&payload_size, sizeof(payload_size)};
+  msghdr message = {};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr *header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+  ssize_t sent;
+  do {
+    sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  if (sent != sizeof(payload_size) ||
+      !write_all(fd, payload.data(), payload.size())) {
+    error = system_error("cannot send request to " + socket_path);
+    close(fd);
+    return std::nullopt;
+  }
+
+  // The request may already be running: from here on, report failures as
+  // an error status rather than asking the caller to retry
+  int32_t status;
+  if (!read_all(fd, &status, sizeof(status))) {
+    error = "lost connection to compile server at " + socket_path;
+    status = 1;
+  }
+  close(fd);
+  return status;
+}
+
+} // namespace pecco
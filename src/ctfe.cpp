@@ -0,0 +1,618 @@
+#include "ctfe.hpp"
+#include "call_graph.hpp"
+
+#include <sstream>
+
+namespace pecco {
+
+namespace {
+
+const char *type_name(const ConstValue &value) {
+  if (std::holds_alternative<int32_t>(value))
+    return "i32";
+  if (std::holds_alternative<double>(value))
+    return "f64";
+  return "bool";
+}
+
+// Value returned by codegen when a non-void function falls off its end
+std::optional<ConstValue> default_return_value(const std::string &type) {
+  if (type == "i32")
+    return ConstValue(int32_t{0});
+  if (type == "f64")
+    return ConstValue(0.0);
+  if (type == "bool")
+    return ConstValue(false);
+  return std::nullopt;
+}
+
+bool is_assignment(const std::string &op) {
+  return op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "/=" ||
+         op == "%=";
+}
+
+bool is_definition(const Stmt *stmt) {
+  return stmt->kind == StmtKind::Func || stmt->kind == StmtKind::OperatorDecl;
+}
+
+std::string cache_key(const std::string &name,
+                      const std::vector<ConstValue> &args) {
+  std::ostringstream key;
+  key << name;
+  for (const auto &arg : args) {
+    key << '|' << type_name(arg) << ':';
+    if (auto *i = std::get_if<int32_t>(&arg))
+      key << *i;
+    else if (auto *f = std::get_if<double>(&arg))
+      key << std::hexfloat << *f << std::defaultfloat;
+    else
+      key << std::get<bool>(arg);
+  }
+  return key.str();
+}
+
+// ===== Top-level constant propagation helpers =====
+
+// Record `let` declarations and assignment targets in non-definition code
+void collect_bindings(const Expr *expr, std::set<std::string> &assigned) {
+  if (!expr)
+    return;
+  switch (expr->kind) {
+  case ExprKind::Binary: {
+    auto *binary = static_cast<const BinaryExpr *>(expr);
+    if (is_assignment(binary->op) &&
+        binary->left->kind == ExprKind::Identifier) {
+      assigned.insert(
+          static_cast<const IdentifierExpr *>(binary->left.get())->name);
+    }
+    collect_bindings(binary->left.get(), assigned);
+    collect_bindings(binary->right.get(), assigned);
+    break;
+  }
+  case ExprKind::Unary:
+    collect_bindings(static_cast<const UnaryExpr *>(expr)->operand.get(),
+                     assigned);
+    break;
+  case ExprKind::Call:
+    for (const auto &arg : static_cast<const CallExpr *>(expr)->args) {
+      collect_bindings(arg.get(), assigned);
+    }
+    break;
+  case ExprKind::Index:
+    collect_bindings(static_cast<const IndexExpr *>(expr)->index.get(),
+                     assigned);
+    break;
+  default:
+    break;
+  }
+}
+
+void collect_bindings(const Stmt *stmt, std::map<std::string, int> &lets,
+                      std::set<std::string> &assigned) {
+  if (!stmt)
+    return;
+  switch (stmt->kind) {
+  case StmtKind::Let: {
+    auto *let = static_cast<const LetStmt *>(stmt);
+    lets[let->name]++;
+    collect_bindings(let->init.get(), assigned);
+    break;
+  }
+  case StmtKind::Return: {
+    auto *ret = static_cast<const ReturnStmt *>(stmt);
+    if (ret->value) {
+      collect_bindings(ret->value.value().get(), assigned);
+    }
+    break;
+  }
+  case StmtKind::Expr:
+    collect_bindings(static_cast<const ExprStmt *>(stmt)->expr.get(),
+                     assigned);
+    break;
+  case StmtKind::Block:
+    for (const auto &inner : static_cast<const BlockStmt *>(stmt)->stmts) {
+      collect_bindings(inner.get(), lets, assigned);
+    }
+    break;
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<const IfStmt *>(stmt);
+    collect_bindings(if_stmt->condition.get(), assigned);
+    collect_bindings(if_stmt->then_branch.get(), lets, assigned);
+    if (if_stmt->else_branch) {
+      collect_bindings(if_stmt->else_branch.value().get(), lets, assigned);
+    }
+    break;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+    collect_bindings(while_stmt->condition.get(), assigned);
+    collect_bindings(while_stmt->body.get(), lets, assigned);
+    break;
+  }
+  case StmtKind::Func:
+  case StmtKind::OperatorDecl:
+    // Definitions cannot see top-level variables
+    break;
+  }
+}
+
+// Replace uses of known constants with literals
+bool substitute(ExprPtr &expr,
+                const std::map<std::string, ConstValue> &constants) {
+  if (!expr)
+    return false;
+  switch (expr->kind) {
+  case ExprKind::Identifier: {
+    auto it = constants.find(static_cast<IdentifierExpr *>(expr.get())->name);
+    if (it == constants.end())
+      return false;
+    expr = make_literal(it->second, expr->loc);
+    return true;
+  }
+  case ExprKind::Binary: {
+    auto *binary = static_cast<BinaryExpr *>(expr.get());
+    bool changed = substitute(binary->left, constants);
+    return substitute(binary->right, constants) || changed;
+  }
+  case ExprKind::Unary:
+    return substitute(static_cast<UnaryExpr *>(expr.get())->operand,
+                      constants);
+  case ExprKind::Call: {
+    bool changed = false;
+    for (auto &arg : static_cast<CallExpr *>(expr.get())->args) {
+      changed |= substitute(arg, constants);
+    }
+    return changed;
+  }
+  case ExprKind::Index:
+    // The base names an array, which is never a constant
+    return substitute(static_cast<IndexExpr *>(expr.get())->index, constants);
+  default:
+    return false;
+  }
+}
+
+bool substitute(Stmt *stmt,
+                const std::map<std::string, ConstValue> &constants) {
+  if (!stmt)
+    return false;
+  switch (stmt->kind) {
+  case StmtKind::Let:
+    return substitute(static_cast<LetStmt *>(stmt)->init, constants);
+  case StmtKind::Return: {
+    auto *ret = static_cast<ReturnStmt *>(stmt);
+    return ret->value && substitute(ret->value.value(), constants);
+  }
+  case StmtKind::Expr:
+    return substitute(static_cast<ExprStmt *>(stmt)->expr, constants);
+  case StmtKind::Block: {
+    bool changed = false;
+    for (auto &inner : static_cast<BlockStmt *>(stmt)->stmts) {
+      changed |= substitute(inner.get(), constants);
+    }
+    return changed;
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<IfStmt *>(stmt);
+    bool changed = substitute(if_stmt->condition, constants);
+    changed |= substitute(if_stmt->then_branch.get(), constants);
+    if (if_stmt->else_branch) {
+      changed |= substitute(if_stmt->else_branch.value().get(), constants);
+    }
+    return changed;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<WhileStmt *>(stmt);
+    bool changed = substitute(while_stmt->condition, constants);
+    return substitute(while_stmt->body.get(), constants) || changed;
+  }
+  case StmtKind::Func:
+  case StmtKind::OperatorDecl:
+    return false;
+  }
+  return false;
+}
+
+} // namespace
+
+// ===== ConstEvaluator =====
+
+ConstEvaluator::ConstEvaluator(const std::vector<StmtPtr> &stmts,
+                               uint64_t step_budget)
+    : step_budget_(step_budget) {
+  // Index definitions; a function name defined more than once is ambiguous
+  std::set<std::string> ambiguous;
+  for (const auto &stmt : stmts) {
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      if (!func->body)
+        continue;
+      std::string return_type =
+          func->return_type ? func->return_type.value()->name : "void";
+      if (!callables_
+               .emplace(func->name, Callable{&func->params,
+                                             func->body.value().get(),
+                                             return_type})
+               .second) {
+        ambiguous.insert(func->name);
+      }
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op_decl = static_cast<const OperatorDeclStmt *>(stmt.get());
+      if (!op_decl->body)
+        continue;
+      std::string return_type =
+          op_decl->return_type ? op_decl->return_type.value()->name : "void";
+      callables_.emplace(mangle_operator_declaration(*op_decl),
+                         Callable{&op_decl->params,
+                                  op_decl->body.value().get(), return_type});
+    }
+  }
+  for (const auto &name : ambiguous) {
+    callables_.erase(name);
+  }
+
+  // Purity is the greatest fixpoint: drop definitions that call anything
+  // that is not itself a pure definition
+  CallGraph graph;
+  graph.build(stmts);
+  for (const auto &[name, callable] : callables_) {
+    pure_.insert(name);
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto it = pure_.begin(); it != pure_.end();) {
+      bool calls_impure = false;
+      for (const auto &callee : graph.callees(*it)) {
+        if (!pure_.count(callee)) {
+          calls_impure = true;
+          break;
+        }
+      }
+      if (calls_impure) {
+        it = pure_.erase(it);
+        changed = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+bool ConstEvaluator::is_pure(const std::string &name) const {
+  return pure_.count(name) > 0;
+}
+
+std::optional<ConstValue>
+ConstEvaluator::call(const std::string &name,
+                     const std::vector<ConstValue> &args) {
+  return invoke(name, args);
+}
+
+std::optional<ConstValue>
+ConstEvaluator::apply_binary(const std::string &op, const ConstValue &left,
+                             const ConstValue &right) {
+  if (is_builtin_binary(op, left, right)) {
+    return eval_builtin_binary(op, left, right);
+  }
+  return invoke(mangle_operator_name(op, OpPosition::Infix,
+                                     {type_name(left), type_name(right)}),
+                {left, right});
+}
+
+std::optional<ConstValue> ConstEvaluator::apply_unary(const std::string &op,
+                                                      OpPosition position,
+                                                      const ConstValue &operand) {
+  if (is_builtin_unary(op, position, operand)) {
+    return eval_builtin_unary(op, position, operand);
+  }
+  return invoke(mangle_operator_name(op, position, {type_name(operand)}),
+                {operand});
+}
+
+bool ConstEvaluator::step() {
+  if (++steps_ > step_budget_) {
+    limit_hit_ = true;
+  }
+  return !limit_hit_;
+}
+
+std::optional<ConstValue>
+ConstEvaluator::invoke(const std::string &name,
+                       const std::vector<ConstValue> &args) {
+  // Each evaluation started from the pass gets a fresh budget
+  if (frames_.empty()) {
+    steps_ = 0;
+    limit_hit_ = false;
+  }
+
+  std::string key = cache_key(name, args);
+  auto cached = cache_.find(key);
+  if (cached != cache_.end()) {
+    return cached->second;
+  }
+
+  auto it = callables_.find(name);
+  if (it == callables_.end() || !is_pure(name) ||
+      it->second.params->size() != args.size()) {
+    return std::nullopt;
+  }
+  if (frames_.size() >= static_cast<size_t>(kMaxCallDepth)) {
+    limit_hit_ = true;
+    return std::nullopt;
+  }
+  const Callable &callable = it->second;
+
+  Frame frame(1);
+  for (size_t i = 0; i < args.size(); ++i) {
+    frame.back()[(*callable.params)[i].name] = args[i];
+  }
+  frames_.push_back(std::move(frame));
+  return_value_.reset();
+  Flow flow = exec_stmt(callable.body);
+  frames_.pop_back();
+
+  std::optional<ConstValue> result;
+  if (flow == Flow::Return) {
+    result = return_value_;
+  } else if (flow == Flow::Normal) {
+    result = default_return_value(callable.return_type);
+  }
+  return_value_.reset();
+
+  // Failures caused by the budget or depth limit depend on the caller
+  if (!limit_hit_) {
+    cache_[key] = result;
+  }
+  return result;
+}
+
+ConstValue *ConstEvaluator::lookup(const std::string &name) {
+  Frame &frame = frames_.back();
+  for (auto it = frame.rbegin(); it != frame.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end()) {
+      return &found->second;
+    }
+  }
+  return nullptr;
+}
+
+ConstEvaluator::Flow ConstEvaluator::exec_stmt(const Stmt *stmt) {
+  if (!stmt || !step())
+    return Flow::Abort;
+
+  switch (stmt->kind) {
+  case StmtKind::Let: {
+    auto *let = static_cast<const LetStmt *>(stmt);
+    // Uninitialized variables have no compile-time value
+    auto value = eval_expr(let->init.get());
+    if (!value)
+      return Flow::Abort;
+    frames_.back().back()[let->name] = *value;
+    return Flow::Normal;
+  }
+  case StmtKind::Return: {
+    auto *ret = static_cast<const ReturnStmt *>(stmt);
+    return_value_.reset();
+    if (ret->value) {
+      return_value_ = eval_expr(ret->value.value().get());
+      if (!return_value_)
+        return Flow::Abort;
+    }
+    return Flow::Return;
+  }
+  case StmtKind::Expr:
+    return eval_expr(static_cast<const ExprStmt *>(stmt)->expr.get())
+               ? Flow::Normal
+               : Flow::Abort;
+  case StmtKind::Block: {
+    frames_.back().emplace_back();
+    Flow flow = Flow::Normal;
+    for (const auto &inner : static_cast<const BlockStmt *>(stmt)->stmts) {
+      flow = exec_stmt(inner.get());
+      if (flow != Flow::Normal)
+        break;
+    }
+    frames_.back().pop_back();
+    return flow;
+  }
+  case StmtKind::If: {
+    auto *if_stmt = static_cast<const IfStmt *>(stmt);
+    auto cond = eval_expr(if_stmt->condition.get());
+    if (!cond || !std::holds_alternative<bool>(*cond))
+      return Flow::Abort;
+    if (std::get<bool>(*cond))
+      return exec_stmt(if_stmt->then_branch.get());
+    if (if_stmt->else_branch)
+      return exec_stmt(if_stmt->else_branch.value().get());
+    return Flow::Normal;
+  }
+  case StmtKind::While: {
+    auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+    while (true) {
+      auto cond = eval_expr(while_stmt->condition.get());
+      if (!cond || !std::holds_alternative<bool>(*cond))
+        return Flow::Abort;
+      if (!std::get<bool>(*cond))
+        return Flow::Normal;
+      Flow flow = exec_stmt(while_stmt->body.get());
+      if (flow != Flow::Normal)
+        return flow;
+    }
+  }
+  case StmtKind::Func:
+  case StmtKind::OperatorDecl:
+    // Nested definitions are not lowered by codegen
+    return Flow::Normal;
+  }
+  return Flow::Abort;
+}
+
+std::optional<ConstValue> ConstEvaluator::eval_expr(const Expr *expr) {
+  if (!expr || !step())
+    return std::nullopt;
+
+  switch (expr->kind) {
+  case ExprKind::IntLiteral:
+  case ExprKind::FloatLiteral:
+  case ExprKind::BoolLiteral:
+    return literal_value(expr);
+  case ExprKind::StringLiteral:
+  case ExprKind::OperatorSeq:
+  case ExprKind::Index: // Arrays have no compile-time value
+    return std::nullopt;
+  case ExprKind::Identifier: {
+    ConstValue *value =
+        lookup(static_cast<const IdentifierExpr *>(expr)->name);
+    return value ? std::optional<ConstValue>(*value) : std::nullopt;
+  }
+  case ExprKind::Binary: {
+    auto *binary = static_cast<const BinaryExpr *>(expr);
+    if (is_assignment(binary->op)) {
+      return eval_assignment(binary);
+    }
+    auto left = eval_expr(binary->left.get());
+    if (!left)
+      return std::nullopt;
+    auto right = eval_expr(binary->right.get());
+    if (!right)
+      return std::nullopt;
+    return apply_binary(binary->op, *left, *right);
+  }
+  case ExprKind::Unary: {
+    auto *unary = static_cast<const UnaryExpr *>(expr);
+    auto operand = eval_expr(unary->operand.get());
+    if (!operand)
+      return std::nullopt;
+    return apply_unary(unary->op, unary->position, *operand);
+  }
+  case ExprKind::Call: {
+    auto *call = static_cast<const CallExpr *>(expr);
+    if (call->callee->kind != ExprKind::Identifier)
+      return std::nullopt;
+    std::vector<ConstValue> args;
+    for (const auto &arg : call->args) {
+      auto value = eval_expr(arg.get());
+      if (!value)
+        return std::nullopt;
+      args.push_back(*value);
+    }
+    return invoke(static_cast<const IdentifierExpr *>(call->callee.get())->name,
+                  args);
+  }
+  }
+  return std::nullopt;
+}
+
+std::optional<ConstValue>
+ConstEvaluator::eval_assignment(const BinaryExpr *binary) {
+  if (binary->left->kind != ExprKind::Identifier)
+    return std::nullopt;
+
+  // Codegen evaluates the right-hand side before loading the variable
+  auto value = eval_expr(binary->right.get());
+  if (!value)
+    return std::nullopt;
+  ConstValue *var =
+      lookup(static_cast<const IdentifierExpr *>(binary->left.get())->name);
+  if (!var)
+    return std::nullopt;
+
+  if (binary->op != "=") {
+    std::string op = binary->op.substr(0, binary->op.size() - 1);
+    if (!is_builtin_binary(op, *var, *value))
+      return std::nullopt;
+    value = eval_builtin_binary(op, *var, *value);
+    if (!value)
+      return std::nullopt;
+  }
+  *var = *value;
+  return value;
+}
+
+// ===== CompileTimeEvaluationPass =====
+
+bool CompileTimeEvaluationPass::run(std::vector<StmtPtr> &stmts) {
+  evaluator_ = std::make_unique<ConstEvaluator>(stmts, step_budget_);
+
+  // Top-level variables declared once and never reassigned are constants
+  std::map<std::string, int> lets;
+  std::set<std::string> assigned;
+  for (const auto &stmt : stmts) {
+    collect_bindings(stmt.get(), lets, assigned);
+  }
+
+  std::map<std::string, ConstValue> constants;
+  bool changed = false;
+  for (auto &stmt : stmts) {
+    if (!is_definition(stmt.get())) {
+      changed |= substitute(stmt.get(), constants);
+    }
+    changed |= visit_stmt(stmt.get());
+
+    if (stmt->kind == StmtKind::Let) {
+      auto *let = static_cast<LetStmt *>(stmt.get());
+      auto value = literal_value(let->init.get());
+      if (value && lets[let->name] == 1 && !assigned.count(let->name)) {
+        constants[let->name] = *value;
+      }
+    }
+  }
+
+  evaluator_.reset();
+  return changed;
+}
+
+bool CompileTimeEvaluationPass::rewrite(ExprPtr &expr) {
+  std::optional<ConstValue> value;
+  switch (expr->kind) {
+  case ExprKind::Call: {
+    auto *call = static_cast<CallExpr *>(expr.get());
+    if (call->callee->kind != ExprKind::Identifier)
+      return false;
+    const std::string &name =
+        static_cast<IdentifierExpr *>(call->callee.get())->name;
+    if (!evaluator_->is_pure(name))
+      return false;
+    std::vector<ConstValue> args;
+    for (const auto &arg : call->args) {
+      auto arg_value = literal_value(arg.get());
+      if (!arg_value)
+        return false;
+      args.push_back(*arg_value);
+    }
+    value = evaluator_->call(name, args);
+    break;
+  }
+  case ExprKind::Binary: {
+    auto *binary = static_cast<BinaryExpr *>(expr.get());
+    auto left = literal_value(binary->left.get());
+    auto right = literal_value(binary->right.get());
+    if (!left || !right || is_assignment(binary->op))
+      return false;
+    value = evaluator_->apply_binary(binary->op, *left, *right);
+    break;
+  }
+  case ExprKind::Unary: {
+    auto *unary = static_cast<UnaryExpr *>(expr.get());
+    auto operand = literal_value(unary->operand.get());
+    if (!operand)
+      return false;
+    value = evaluator_->apply_unary(unary->op, unary->position, *operand);
+    break;
+  }
+  default:
+    return false;
+  }
+
+  if (!value)
+    return false;
+  ExprPtr literal = make_literal(*value, expr->loc);
+  if (!literal)
+    return false;
+  expr = std::move(literal);
+  return true;
+}
+
+} // namespace pecco
@@ -1,19 +1,38 @@
+#include "ast_optimizer.hpp"
+#include "batch_compiler.hpp"
+#include "bytecode.hpp"
+#include "call_graph.hpp"
 #include "codegen.hpp"
+#include "compile_server.hpp"
+#include "compilation_session.hpp"
+#include "file_watcher.hpp"
+#include "language_server.hpp"
 #include "lexer.hpp"
+#include "object_cache.hpp"
 #include "operator_resolver.hpp"
 #include "parser.hpp"
+#include "pecco_rt.h"
+#include "runtime_symbols.hpp"
 #include "scope.hpp"
 #include "scope_checker.hpp"
+#include "semantic_queries.hpp"
 #include "symbol_table_builder.hpp"
+#include "task_graph.hpp"
+#include "tiered_jit.hpp"
 #include "type_checker.hpp"
+#include "vm.hpp"
 
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/ELFObjectFile.h>
+#include <llvm/Object/ObjectFile.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/Program.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/WithColor.h>
@@ -21,21 +40,27 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/IPO/Internalize.h>
 #include <llvm/Transforms/InstCombine/InstCombine.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Scalar/GVN.h>
 #include <llvm/Transforms/Utils.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <system_error>
+#include <thread>
 
 using namespace llvm;
 
 static cl::opt<std::string>
-    InputFilename(cl::Positional, cl::desc("<input file>"), cl::Required);
+    InputFilename(cl::Positional, cl::desc("<input file>"));
 
 static cl::opt<bool> LexMode("lex",
                              cl::desc("Run lexer only and output tokens"));
@@ -51,6 +76,11 @@ static cl::opt<bool>
     DumpSymbols("dump-symbols",
                 cl::desc("Dump symbol table after semantic analysis"));
 
+static cl::opt<bool> DumpCallGraph(
+    "dump-callgraph",
+    cl::desc("Dump the call graph of top-level definitions after semantic "
+             "analysis"));
+
 static cl::opt<bool>
     HidePrelude("hide-prelude",
                 cl::desc("Hide prelude symbols in symbol table output"));
@@ -65,11 +95,153 @@ static cl::opt<bool>
 static cl::opt<bool>
     RunAfterCompile("run", cl::desc("Compile, link, and run the program"));
 
+static cl::opt<bool> Interpret(
+    "interp",
+    cl::desc("Run the program in the bytecode interpreter instead of "
+             "compiling it with LLVM"));
+
+static cl::opt<bool>
+    DumpBytecode("dump-bytecode",
+                 cl::desc("Dump the interpreter bytecode of the program"));
+
+static cl::opt<bool> Tiered(
+    "tiered",
+    cl::desc("Interpret the program and JIT-compile hot functions in the "
+             "background (implies --interp)"));
+
+static cl::opt<unsigned> JitThreshold(
+    "jit-threshold",
+    cl::desc("Calls plus loop iterations before a function is JIT-compiled "
+             "(default: 1000)"),
+    cl::init(1000));
+
+static cl::opt<bool>
+    TierReport("tier-report",
+               cl::desc("Print the functions compiled by --tiered to stderr"));
+
 static cl::opt<bool> OptimizeCode("opt", cl::desc("Enable LLVM optimizations"));
 
+static cl::opt<bool> NoAstOpt(
+    "no-ast-opt",
+    cl::desc("Disable AST optimizations (constant folding, dead branch and "
+             "unreachable code elimination) before code generation"));
+
+static cl::opt<unsigned> ParseJobs(
+    "parse-jobs",
+    cl::desc("Threads parsing the top-level statements (0: one per CPU, "
+             "default: 1)"),
+    cl::init(1));
+
+static cl::opt<bool> StreamTokens(
+    "stream-tokens",
+    cl::desc("Lex on a background thread while parsing (ignored with "
+             "--parse-jobs other than 1)"));
+
+// --parse-jobs=0 表示每个 CPU 一个线程
+static unsigned parseJobs() {
+  if (ParseJobs == 0) {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+  return ParseJobs;
+}
+
+static cl::opt<bool> FastMath(
+    "ffast-math",
+    cl::desc("Let floating-point operations be reassociated and contracted "
+             "and assume no NaNs, infinities or signed zeros"));
+
+// 浮点乘加合并
+enum class FPContract { Off, Fast };
+
+static cl::opt<FPContract> FPContractMode(
+    "fp-contract", cl::desc("Fuse floating-point multiply and add:"),
+    cl::init(FPContract::Off),
+    cl::values(clEnumValN(FPContract::Off, "off",
+                          "Keep multiplies and adds separate (default "
+                          "without --ffast-math)"),
+               clEnumValN(FPContract::Fast, "fast",
+                          "Fuse into FMA whenever possible")));
+
+static cl::opt<bool> NoHonorNaNs(
+    "fno-honor-nans",
+    cl::desc("Assume floating-point values and results are never NaN"));
+
+// 浮点选项对应的 fast-math 标志；--fp-contract 可覆盖 --ffast-math 的合并设置
+static llvm::FastMathFlags fastMathFlags() {
+  llvm::FastMathFlags flags;
+  if (FastMath) {
+    flags.setFast();
+  }
+  if (FPContractMode.getNumOccurrences()) {
+    flags.setAllowContract(FPContractMode == FPContract::Fast);
+  }
+  if (NoHonorNaNs) {
+    flags.setNoNaNs();
+  }
+  return flags;
+}
+
+// 体积优化级别
+enum class SizeLevel { None, Os, Oz };
+
+static cl::opt<SizeLevel> SizeOpt(
+    cl::desc("Size optimization (per-function sections, internalized "
+             "symbols, --gc-sections, stripped output):"),
+    cl::init(SizeLevel::None),
+    cl::values(clEnumValN(SizeLevel::Os, "Os", "Optimize for size"),
+               clEnumValN(SizeLevel::Oz, "Oz",
+                          "Optimize for size aggressively")));
+
+static cl::opt<bool>
+    SizeReport("size-report",
+               cl::desc("Show each function's contribution to the final "
+                        ".text of the linked executable"));
+
+static cl::opt<bool> Freestanding(
+    "freestanding",
+    cl::desc("Link a static libc-free executable using raw Linux syscalls"));
+
+static cl::opt<bool> TimePhases(
+    "time-phases",
+    cl::desc("Print when each compile phase ran and on which thread"));
+
 static cl::opt<std::string> OutputFilename("o", cl::desc("Output filename"),
                                            cl::value_desc("filename"));
 
+static cl::opt<std::string> BatchList(
+    "batch",
+    cl::desc("Compile every .pec file listed in the file (one per line) to an "
+             "object file, reusing the LLVM state between files; -o names the "
+             "output directory"),
+    cl::value_desc("list"));
+
+static cl::opt<bool> WatchMode(
+    "watch",
+    cl::desc("Rebuild whenever the input file is saved (and rerun it with "
+             "--run), recompiling only the functions that changed"));
+
+static cl::opt<bool>
+    LspMode("lsp", cl::desc("Run a Language Server Protocol server on "
+                            "stdin/stdout (diagnostics, hover, "
+                            "go-to-definition, semantic tokens)"));
+
+static cl::opt<bool> ServerMode(
+    "server",
+    cl::desc("Run a compile server that keeps the prelude and LLVM targets "
+             "loaded between requests"));
+
+static cl::opt<bool> UseServer(
+    "use-server",
+    cl::desc("Run this invocation on the compile server (compiles locally "
+             "when no server is running)"));
+
+static cl::opt<std::string>
+    SocketPath("socket",
+               cl::desc("Compile server socket (default: "
+                        "$XDG_RUNTIME_DIR/plc.sock or "
+                        "/tmp/plc-<uid>/plc.sock)"),
+               cl::value_desc("path"));
+
 static void printToken(const pecco::Token &tok, raw_ostream &os) {
   os << "[" << pecco::to_string(tok.kind) << "] ";
   if (!tok.lexeme.empty() && tok.kind != pecco::TokenKind::EndOfFile) {
@@ -119,7 +291,18 @@ static void printSourceLine(StringRef source, size_t line, size_t column,
   os << "\n";
 }
 
-static void optimizeModule(llvm::Module *module) {
+static llvm::TargetMachine *getTargetMachine();
+
+static void optimizeModule(llvm::Module *module,
+                           llvm::OptimizationLevel level) {
+  // 优化需要目标信息：没有 TargetTransformInfo 时循环向量化器认为
+  // 目标没有向量寄存器，什么都不会向量化
+  llvm::TargetMachine *target_machine = getTargetMachine();
+  if (target_machine) {
+    module->setTargetTriple(target_machine->getTargetTriple().str());
+    module->setDataLayout(target_machine->createDataLayout());
+  }
+
   // 创建分析管理器
   llvm::LoopAnalysisManager LAM;
   llvm::FunctionAnalysisManager FAM;
@@ -127,47 +310,99 @@ static void optimizeModule(llvm::Module *module) {
   llvm::ModuleAnalysisManager MAM;
 
   // 创建 PassBuilder 并注册分析
-  llvm::PassBuilder PB;
+  llvm::PassBuilder PB(target_machine);
   PB.registerModuleAnalyses(MAM);
   PB.registerCGSCCAnalyses(CGAM);
   PB.registerFunctionAnalyses(FAM);
   PB.registerLoopAnalyses(LAM);
   PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
 
-  // 创建优化 pipeline (O2 级别)
-  llvm::ModulePassManager MPM =
-      PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+  // 创建优化 pipeline
+  llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(level);
 
   // 运行优化
   MPM.run(*module, MAM);
 }
 
-static int compileToObject(llvm::Module *module, StringRef output_file) {
-  // 初始化目标
-  llvm::InitializeAllTargetInfos();
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmParsers();
-  llvm::InitializeAllAsmPrinters();
+// 体积优化：除入口外全部内部化，使未被引用的函数能被 GlobalDCE 删除
+static void optimizeForSize(llvm::Module *module, StringRef entry_name,
+                            SizeLevel level) {
+  for (llvm::Function &func : *module) {
+    if (func.isDeclaration()) {
+      continue;
+    }
+    func.addFnAttr(llvm::Attribute::OptimizeForSize);
+    if (level == SizeLevel::Oz) {
+      func.addFnAttr(llvm::Attribute::MinSize);
+    }
+  }
+
+  llvm::internalizeModule(*module, [entry_name](const llvm::GlobalValue &gv) {
+    return gv.getName() == entry_name;
+  });
 
-  auto target_triple = llvm::sys::getDefaultTargetTriple();
-  module->setTargetTriple(target_triple);
+  optimizeModule(module, level == SizeLevel::Oz ? llvm::OptimizationLevel::Oz
+                                                : llvm::OptimizationLevel::Os);
+}
 
+// 创建本机的目标机器；separate_sections 时每个函数/数据放入独立 section，
+// 供链接器 --gc-sections 回收
+static std::unique_ptr<llvm::TargetMachine>
+createTargetMachine(bool separate_sections) {
+  // 只注册本机目标：生成的代码不含内联汇编，不需要汇编解析器。
+  // 注册会修改 LLVM 的全局表，只做一次
+  static std::once_flag targets_initialized;
+  std::call_once(targets_initialized, [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+
+  auto target_triple = llvm::sys::getProcessTriple();
   std::string error;
   auto target = llvm::TargetRegistry::lookupTarget(target_triple, error);
   if (!target) {
     WithColor::error(errs(), "plc") << error << "\n";
-    return 1;
+    return nullptr;
   }
 
   auto CPU = "generic";
   auto features = "";
   llvm::TargetOptions opt;
+  opt.FunctionSections = separate_sections;
+  opt.DataSections = separate_sections;
   auto RM = std::optional<llvm::Reloc::Model>();
-  auto target_machine =
-      target->createTargetMachine(target_triple, CPU, features, opt, RM);
+  return std::unique_ptr<llvm::TargetMachine>(
+      target->createTargetMachine(target_triple, CPU, features, opt, RM));
+}
+
+// 默认选项的目标机器只创建一次，之后的编译复用（编译服务器启动时预先创建）。
+// 局部静态变量的初始化是线程安全的；共享的目标机器创建后不再修改，
+// 需要其他选项的编译自己创建一个。
+// 只在需要生成目标文件或优化 IR 时调用，--lex/--parse/不带优化的
+// --emit-llvm 等模式不初始化任何 LLVM 目标
+static llvm::TargetMachine *getTargetMachine() {
+  static const std::unique_ptr<llvm::TargetMachine> target_machine =
+      createTargetMachine(false);
+  return target_machine.get();
+}
 
+static int compileToObject(llvm::Module *module, StringRef output_file,
+                           bool separate_sections = false) {
+  // 分 section 输出只用于这一次编译，不修改共享的目标机器
+  std::unique_ptr<llvm::TargetMachine> sectioned;
+  llvm::TargetMachine *target_machine;
+  if (separate_sections) {
+    sectioned = createTargetMachine(true);
+    target_machine = sectioned.get();
+  } else {
+    target_machine = getTargetMachine();
+  }
+  if (!target_machine) {
+    return 1;
+  }
+  module->setTargetTriple(target_machine->getTargetTriple().str());
   module->setDataLayout(target_machine->createDataLayout());
+  pecco::bind_runtime_symbols(*module);
 
   std::error_code EC;
   llvm::raw_fd_ostream dest(output_file, EC, llvm::sys::fs::OF_None);
@@ -208,13 +443,149 @@ static void addMainWrapper(llvm::Module *module) {
   llvm::Function *main_func = llvm::Function::Create(
       main_type, llvm::Function::ExternalLinkage, "main", module);
 
-  // main 调用 __pecco_entry 并返回结果
+  // 运行时库的输出缓冲区刷新函数
+  llvm::FunctionCallee flush_func = module->getOrInsertFunction(
+      "__pecco_rt_flush", llvm::Type::getVoidTy(context));
+
+  // main 调用 __pecco_entry，正常返回前刷新输出缓冲区并返回结果
   llvm::BasicBlock *bb = llvm::BasicBlock::Create(context, "entry", main_func);
   llvm::IRBuilder<> builder(bb);
   llvm::Value *result = builder.CreateCall(entry_func);
+  builder.CreateCall(flush_func);
   builder.CreateRet(result);
 }
 
+// 独立模式：添加 _start 入口，调用 __pecco_entry 后以其返回值 exit
+static void addStartWrapper(llvm::Module *module) {
+  llvm::LLVMContext &context = module->getContext();
+
+  llvm::Function *entry_func = module->getFunction("__pecco_entry");
+  if (!entry_func) {
+    return;
+  }
+
+  // exit 由独立运行时以 exit_group 系统调用实现
+  llvm::FunctionCallee exit_func = module->getOrInsertFunction(
+      "exit", llvm::Type::getVoidTy(context), llvm::Type::getInt32Ty(context));
+
+  llvm::FunctionType *start_type =
+      llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+  llvm::Function *start_func = llvm::Function::Create(
+      start_type, llvm::Function::ExternalLinkage, "_start", module);
+  start_func->setDoesNotReturn();
+  // 内核进入 _start 时栈按 16 字节对齐（没有返回地址），需要重新对齐
+  start_func->addFnAttr("stackrealign");
+
+  llvm::BasicBlock *bb = llvm::BasicBlock::Create(context, "entry", start_func);
+  llvm::IRBuilder<> builder(bb);
+  llvm::Value *result = builder.CreateCall(entry_func);
+  builder.CreateCall(exit_func, {result});
+  builder.CreateUnreachable();
+}
+
+// 按函数列出可执行文件 .text 的组成（需要未 strip 的符号表）
+static int printSizeReport(StringRef exe_file, raw_ostream &os) {
+  auto binary_or_err = llvm::object::ObjectFile::createObjectFile(exe_file);
+  if (!binary_or_err) {
+    WithColor::error(errs(), "plc")
+        << "cannot read '" << exe_file
+        << "': " << toString(binary_or_err.takeError()) << "\n";
+    return 1;
+  }
+  const llvm::object::ObjectFile *obj = binary_or_err->getBinary();
+  const auto *elf = llvm::dyn_cast<llvm::object::ELFObjectFileBase>(obj);
+  if (!elf) {
+    WithColor::error(errs(), "plc")
+        << "size report requires an ELF executable\n";
+    return 1;
+  }
+
+  uint64_t text_size = 0;
+  std::optional<llvm::object::SectionRef> text_section;
+  for (const llvm::object::SectionRef &section : obj->sections()) {
+    auto name = section.getName();
+    if (name && *name == ".text") {
+      text_size = section.getSize();
+      text_section = section;
+    }
+  }
+
+  std::vector<std::pair<uint64_t, std::string>> entries;
+  uint64_t function_total = 0;
+  for (const llvm::object::ELFSymbolRef &sym : elf->symbols()) {
+    auto type = sym.getType();
+    auto section = sym.getSection();
+    auto name = sym.getName();
+    if (!type || *type != llvm::object::SymbolRef::ST_Function || !section ||
+        !name || !text_section || *section != *text_section) {
+      llvm::consumeError(type.takeError());
+      llvm::consumeError(section.takeError());
+      llvm::consumeError(name.takeError());
+      continue;
+    }
+    entries.emplace_back(sym.getSize(), name->str());
+    function_total += sym.getSize();
+  }
+
+  std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    if (a.first != b.first)
+      return a.first > b.first;
+    return a.second < b.second;
+  });
+
+  WithColor(os, raw_ostream::CYAN, true) << "Size report (.text):\n";
+  for (const auto &[size, name] : entries) {
+    os << "  " << llvm::format("%8llu", static_cast<unsigned long long>(size))
+       << "  " << name << "\n";
+  }
+  os << "  " << llvm::format("%8llu", static_cast<unsigned long long>(
+                                          text_size - function_total))
+     << "  (other)\n";
+  os << "  " << llvm::format("%8llu", static_cast<unsigned long long>(text_size))
+     << "  total\n";
+  return 0;
+}
+
+// 用 cc 把目标文件与运行时库链接为可执行文件，strip 时去掉符号表（-s）
+static int linkExecutable(const std::vector<std::string> &obj_files,
+                          StringRef exe_file, bool size_mode, bool strip) {
+  auto cc = llvm::sys::findProgramByName("cc");
+  if (!cc) {
+    WithColor::error(errs(), "plc")
+        << "cc not found (need system C compiler for linking)\n";
+    return 1;
+  }
+
+  std::vector<llvm::StringRef> args = {*cc};
+  if (Freestanding) {
+    // 不链接 libc 和 crt 启动文件，生成没有动态加载器的静态程序
+    args.insert(args.end(), {"-static", "-nostdlib", "-no-pie"});
+    args.insert(args.end(), obj_files.begin(), obj_files.end());
+    args.push_back(PECCO_RT_FREESTANDING_LIB);
+  } else {
+    // 链接运行时库，并将 prelude 的 write/exit 包装为带缓冲的版本
+    args.push_back("-no-pie");
+    args.insert(args.end(), obj_files.begin(), obj_files.end());
+    args.insert(args.end(),
+                {PECCO_RT_LIB, "-Wl,--wrap=write", "-Wl,--wrap=exit"});
+  }
+  args.insert(args.end(), {"-o", exe_file});
+  if (size_mode) {
+    // 回收未引用的 section
+    args.push_back("-Wl,--gc-sections");
+  }
+  if (strip) {
+    args.push_back("-s");
+  }
+  std::string err_msg;
+  if (llvm::sys::ExecuteAndWait(*cc, args, std::nullopt, {}, 0, 0,
+                                &err_msg)) {
+    WithColor::error(errs(), "plc") << "Linking failed: " << err_msg << "\n";
+    return 1;
+  }
+  return 0;
+}
+
 static int runLexer(StringRef filename) {
   auto bufferOrErr = MemoryBuffer::getFile(filename);
   if (std::error_code ec = bufferOrErr.getError()) {
@@ -305,7 +676,7 @@ static int runParser(StringRef filename) {
   }
 
   pecco::Parser parser(std::move(tokens));
-  auto stmts = parser.parse_program();
+  auto stmts = parser.parse_program_parallel(parseJobs());
 
   if (parser.has_errors()) {
     for (const auto &err : parser.errors()) {
@@ -443,17 +814,15 @@ static void printScope(const pecco::Scope *scope, raw_ostream &os, int indent,
   }
 }
 
-// Print hierarchical symbol table with all scopes
-static void printHierarchicalSymbols(const pecco::ScopedSymbolTable &symbols,
-                                     raw_ostream &os, bool hide_prelude) {
-  WithColor(os, raw_ostream::CYAN, true) << "\nHierarchical Symbol Table:\n";
-
+// Print global functions and operators
+static void printGlobalSymbols(const pecco::SymbolTable &symbols,
+                               raw_ostream &os, bool hide_prelude) {
   // Print global functions
   WithColor(os, raw_ostream::GREEN, true) << "\nGlobal Functions:\n";
-  auto func_names = symbols.symbol_table().get_all_function_names();
+  auto func_names = symbols.get_all_function_names();
   bool printed_any = false;
   for (const auto &name : func_names) {
-    auto funcs = symbols.symbol_table().find_functions(name);
+    auto funcs = symbols.find_functions(name);
     for (const auto &func : funcs) {
       // Skip prelude functions if hide_prelude is true
       if (hide_prelude && func.origin == pecco::SymbolOrigin::Prelude) {
@@ -486,7 +855,7 @@ static void printHierarchicalSymbols(const pecco::ScopedSymbolTable &symbols,
 
   // Print operators
   WithColor(os, raw_ostream::GREEN, true) << "\nOperators:\n";
-  auto all_ops = symbols.symbol_table().get_all_operators();
+  auto all_ops = symbols.get_all_operators();
   std::sort(all_ops.begin(), all_ops.end(),
             [](const pecco::OperatorInfo &a, const pecco::OperatorInfo &b) {
               if (a.op != b.op)
@@ -535,134 +904,215 @@ static void printHierarchicalSymbols(const pecco::ScopedSymbolTable &symbols,
   if (!printed_any) {
     os << "  (none)\n";
   }
+}
+
+// Print hierarchical symbol table with all scopes
+static void printHierarchicalSymbols(const pecco::ScopedSymbolTable &symbols,
+                                     raw_ostream &os, bool hide_prelude) {
+  WithColor(os, raw_ostream::CYAN, true) << "\nHierarchical Symbol Table:\n";
+  printGlobalSymbols(symbols.symbol_table(), os, hide_prelude);
 
   // Print scopes hierarchy
   WithColor(os, raw_ostream::GREEN, true) << "\nScope Hierarchy:\n";
   printScope(symbols.root_scope(), os, 0, hide_prelude);
 }
 
-static int runCompile(StringRef filename) {
-  auto bufferOrErr = MemoryBuffer::getFile(filename);
-  if (std::error_code ec = bufferOrErr.getError()) {
-    WithColor::error(errs(), "plc")
-        << "cannot open file '" << filename << "': " << ec.message() << "\n";
-    return 1;
-  }
-
-  std::unique_ptr<MemoryBuffer> buffer = std::move(*bufferOrErr);
-  StringRef sourceContent = buffer->getBuffer();
-
-  // Lex
-  pecco::Lexer lexer(sourceContent);
-  auto tokens = lexer.tokenize_all();
+// 同上，符号来自 SemanticQueries：全局作用域合并各顶层语句的变量（与
+// SymbolTableBuilder 一样保留先定义的），其后是各语句的函数和块作用域
+static void printHierarchicalSymbols(pecco::SemanticQueries &queries,
+                                     raw_ostream &os, bool hide_prelude) {
+  WithColor(os, raw_ostream::CYAN, true) << "\nHierarchical Symbol Table:\n";
+  printGlobalSymbols(*queries.declarations(), os, hide_prelude);
 
-  // Check for lexer errors
-  bool hasLexerError = false;
-  for (const auto &tok : tokens) {
-    if (tok.kind == pecco::TokenKind::Error) {
-      hasLexerError = true;
-      WithColor::error(errs(), "plc")
-          << "lexer error at " << filename << ":" << tok.line << ":"
-          << tok.column << ": " << tok.lexeme << "\n";
-      printSourceLine(sourceContent, tok.line, tok.column, tok.end_column,
-                      tok.error_offset, errs());
+  WithColor(os, raw_ostream::GREEN, true) << "\nScope Hierarchy:\n";
+  pecco::Scope global(pecco::ScopeKind::Global);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    for (const auto &var : queries.scopes(i).get_local_variables()) {
+      if (!global.has_variable_local(var.name)) {
+        global.add_variable(var);
+      }
     }
   }
-
-  if (hasLexerError) {
-    return 1;
+  printScope(&global, os, 0, hide_prelude);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    for (const auto *child : queries.scopes(i).children()) {
+      printScope(child, os, 1, hide_prelude);
+    }
   }
+}
 
-  // Parse
-  pecco::Parser parser(std::move(tokens));
-  auto stmts = parser.parse_program();
-
-  if (parser.has_errors()) {
-    for (const auto &err : parser.errors()) {
+static void printDiagnostics(const std::vector<pecco::Diagnostic> &diagnostics,
+                             StringRef filename, StringRef source) {
+  for (const auto &diag : diagnostics) {
+    if (diag.line == 0) {
       WithColor::error(errs(), "plc")
-          << "parse error at " << filename << ":" << err.line << ":"
-          << err.column << ": " << err.message << "\n";
-      printSourceLine(sourceContent, err.line, err.column, err.end_column, 0,
-                      errs());
+          << diag.phase << " error: " << diag.message << "\n";
+      continue;
     }
-    return 1;
+    WithColor::error(errs(), "plc")
+        << diag.phase << " error at " << filename << ":" << diag.line << ":"
+        << diag.column << ": " << diag.message << "\n";
+    printSourceLine(source, diag.line, diag.column, diag.end_column,
+                    diag.caret_offset, errs());
   }
+}
 
-  // Semantic analysis
-  // Phase 1: Build hierarchical symbol table (collect ALL declarations)
-  pecco::ScopedSymbolTable scoped_symbols;
-  pecco::SymbolTableBuilder builder;
+static void printDiagnostics(const pecco::CompilationSession &session,
+                             StringRef filename, StringRef source) {
+  printDiagnostics(session.diagnostics(), filename, source);
+}
 
-  // Load prelude
-  if (!builder.load_prelude(STDLIB_DIR "/prelude.pec", scoped_symbols)) {
-    WithColor::error(errs(), "plc") << "failed to load prelude\n";
-    if (builder.has_errors()) {
-      for (const auto &err : builder.errors()) {
+// prelude 只加载一次，之后的编译共享（编译服务器启动时预先加载）。
+// 局部静态变量的初始化是线程安全的，可以在任务图的线程中调用
+static std::shared_ptr<const pecco::SymbolTable> loadPrelude() {
+  static const std::shared_ptr<const pecco::SymbolTable> prelude = [] {
+    std::vector<pecco::Diagnostic> prelude_errors;
+    auto symbols = pecco::CompilationSession::load_prelude(
+        STDLIB_DIR "/prelude.pec", &prelude_errors);
+    if (!symbols) {
+      WithColor::error(errs(), "plc") << "failed to load prelude\n";
+      for (const auto &err : prelude_errors) {
         errs() << "  " << err.message << "\n";
       }
     }
-    return 1;
+    return symbols;
+  }();
+  return prelude;
+}
+
+// 从文件名提取模块名（去掉路径和扩展名）
+static std::string moduleName(StringRef filename) {
+  std::string module_name = filename.str();
+  size_t last_slash = module_name.find_last_of("/\\");
+  if (last_slash != std::string::npos) {
+    module_name = module_name.substr(last_slash + 1);
   }
+  size_t last_dot = module_name.find_last_of('.');
+  if (last_dot != std::string::npos) {
+    module_name = module_name.substr(0, last_dot);
+  }
+  return module_name;
+}
 
-  // Collect user declarations (recursively collects all scopes)
-  if (!builder.collect(stmts, scoped_symbols)) {
-    for (const auto &err : builder.errors()) {
-      WithColor::error(errs(), "plc")
-          << "semantic error at " << filename << ":" << err.line << ":"
-          << err.column << ": " << err.message << "\n";
-      printSourceLine(sourceContent, err.line, err.column, 0, 0, errs());
+// --time-phases：runCompile 结束时输出每个阶段的起止时间（相对于开始编译）
+// 和执行线程，任务图中并行的阶段时间区间会重叠
+class PhaseReport {
+public:
+  using Clock = pecco::TaskGraph::Clock;
+
+  ~PhaseReport() {
+    if (!TimePhases) {
+      return;
     }
-    return 1;
+    Clock::time_point end = Clock::now();
+    WithColor(errs(), raw_ostream::CYAN, true) << "Phases (ms):\n";
+    errs() << "  phase      thread    start      end     time\n";
+    for (const auto &phase : phases_) {
+      if (!phase.ran) {
+        continue;
+      }
+      errs() << llvm::format("  %-10s %6u %8.2f %8.2f %8.2f\n",
+                             phase.name.c_str(), phase.thread,
+                             ms(phase.start), ms(phase.end),
+                             ms(phase.end) - ms(phase.start));
+    }
+    errs() << llvm::format("  total      %24.2f\n", ms(end));
   }
 
-  // Phase 2: Resolve operator sequences
-  std::vector<std::string> resolve_errors;
-  for (auto &stmt : stmts) {
-    pecco::OperatorResolver::resolve_stmt(
-        stmt.get(), scoped_symbols.symbol_table(), resolve_errors);
-  }
-
-  // Check for errors after resolution
-  if (!resolve_errors.empty()) {
-    for (const auto &err : resolve_errors) {
-      // Parse error format: "at line:col: message"
-      if (err.find("at ") == 0) {
-        size_t pos = err.find(": ");
-        if (pos != std::string::npos) {
-          std::string location = err.substr(3, pos - 3);
-          std::string message = err.substr(pos + 2);
-
-          // Parse line:col
-          size_t colon = location.find(':');
-          if (colon != std::string::npos) {
-            size_t line = std::stoul(location.substr(0, colon));
-            size_t column = std::stoul(location.substr(colon + 1));
-
-            WithColor::error(errs(), "plc")
-                << "semantic error at " << filename << ":" << line << ":"
-                << column << ": " << message << "\n";
-            printSourceLine(sourceContent, line, column, 0, 0, errs());
-            continue;
-          }
-        }
-      }
-      // Fallback: print error as is
-      WithColor::error(errs(), "plc") << "semantic error: " << err << "\n";
+  void add(const pecco::TaskGraph &graph) {
+    auto timings = graph.timings();
+    phases_.insert(phases_.end(), timings.begin(), timings.end());
+  }
+
+  // 在调用线程上执行的阶段
+  void add(std::string name, Clock::time_point from) {
+    pecco::TaskGraph::Timing phase;
+    phase.name = std::move(name);
+    phase.start = from;
+    phase.end = Clock::now();
+    phase.ran = true;
+    phases_.push_back(std::move(phase));
+  }
+
+private:
+  Clock::time_point start_ = Clock::now();
+  std::vector<pecco::TaskGraph::Timing> phases_;
+
+  double ms(Clock::time_point at) const {
+    return std::chrono::duration<double, std::milli>(at - start_).count();
+  }
+};
+
+static int runCompile(StringRef filename) {
+  PhaseReport report;
+  std::string module_name = moduleName(filename);
+
+  pecco::CompileOptions options;
+  options.module_name = module_name;
+  options.ast_opt = !NoAstOpt;
+  options.parse_jobs = parseJobs();
+  options.stream_tokens = StreamTokens;
+  options.fast_math_flags = fastMathFlags();
+  // 只有 --compile 的目标文件可能被外部调用，其余模式只保留可达定义
+  options.eliminate_dead_functions = !CompileOnly;
+  // prelude 与源文件的解析并行加载，分析前再交给 session
+  pecco::CompilationSession session(options, nullptr);
+
+  // 互不依赖的阶段在线程池上重叠执行：读取并解析源文件、加载 prelude、
+  // 初始化 LLVM 目标（只有生成目标文件时需要）
+  std::unique_ptr<MemoryBuffer> buffer;
+  std::shared_ptr<const pecco::SymbolTable> prelude;
+  pecco::TaskGraph graph;
+  auto read = graph.add("read", [&] {
+    auto bufferOrErr = MemoryBuffer::getFile(filename);
+    if (std::error_code ec = bufferOrErr.getError()) {
+      WithColor::error(errs(), "plc") << "cannot open file '" << filename
+                                      << "': " << ec.message() << "\n";
+      return false;
     }
-    return 1;
+    buffer = std::move(*bufferOrErr);
+    return true;
+  });
+  auto parse = graph.add(
+      "parse", [&] { return session.parse(buffer->getBuffer()); }, {read});
+  auto load = graph.add("prelude", [&] {
+    prelude = loadPrelude();
+    return prelude != nullptr;
+  });
+  bool interpret = Interpret || Tiered || DumpBytecode;
+  bool emit_object = CompileOnly || (!interpret && !EmitLLVM && !DumpAST &&
+                                     !DumpSymbols && !DumpCallGraph);
+  if (emit_object) {
+    graph.add("target", [] { return getTargetMachine() != nullptr; });
+  }
+  // 单独的 --dump-symbols 只需要声明和作用域，由 SemanticQueries 按需计算，
+  // 不做类型检查
+  bool analyze = !DumpSymbols || DumpAST || DumpCallGraph || interpret ||
+                 EmitLLVM || CompileOnly;
+  // 词法、语法分析之后：符号表构建、操作符解析与类型检查
+  if (analyze) {
+    graph.add(
+        "analyze",
+        [&] {
+          session.set_prelude(prelude);
+          return session.analyze();
+        },
+        {parse, load});
   }
 
-  // Phase 3: Type checking and inference
-  pecco::TypeChecker type_checker;
-  if (!type_checker.check(stmts, scoped_symbols)) {
-    for (const auto &err : type_checker.errors()) {
-      WithColor::error(errs(), "plc")
-          << "type error at " << filename << ":" << err.line << ":"
-          << err.column << ": " << err.message << "\n";
-      printSourceLine(sourceContent, err.line, err.column, 0, 0, errs());
+  // 图中最多三个阶段同时就绪
+  bool ok = graph.run(3);
+  report.add(graph);
+  if (!ok) {
+    if (graph.succeeded(read)) {
+      printDiagnostics(session, filename, buffer->getBuffer());
     }
     return 1;
   }
+  StringRef sourceContent = buffer->getBuffer();
+
+  auto &stmts = session.stmts();
+  auto &scoped_symbols = session.symbols();
 
   // Output based on flags
   if (DumpAST) {
@@ -672,39 +1122,146 @@ static int runCompile(StringRef filename) {
     }
   }
 
+  if (DumpSymbols && !analyze) {
+    auto symbols_start = PhaseReport::Clock::now();
+    // 每次查询取顶层语句的一份副本，session 的 AST 保持不变
+    pecco::SemanticQueries queries(prelude);
+    std::vector<std::pair<std::string, pecco::SemanticQueries::Parse>>
+        statements;
+    for (const auto &stmt : stmts) {
+      statements.emplace_back(std::to_string(statements.size()), [&stmt] {
+        std::vector<pecco::StmtPtr> copy;
+        copy.push_back(pecco::clone(*stmt));
+        return copy;
+      });
+    }
+    queries.update(std::move(statements));
+
+    std::vector<pecco::Diagnostic> diagnostics;
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const auto &errors = queries.resolution_diagnostics(i);
+      diagnostics.insert(diagnostics.end(), errors.begin(), errors.end());
+    }
+    if (!diagnostics.empty()) {
+      printDiagnostics(diagnostics, filename, sourceContent);
+      return 1;
+    }
+    report.add("symbols", symbols_start);
+    printHierarchicalSymbols(queries, outs(), HidePrelude);
+    return 0;
+  }
+
   if (DumpSymbols) {
     printHierarchicalSymbols(scoped_symbols, outs(), HidePrelude);
   }
 
-  // 从文件名提取模块名（去掉路径和扩展名）
-  std::string module_name = filename.str();
-  size_t last_slash = module_name.find_last_of("/\\");
-  if (last_slash != std::string::npos) {
-    module_name = module_name.substr(last_slash + 1);
-  }
-  size_t last_dot = module_name.find_last_of('.');
-  if (last_dot != std::string::npos) {
-    module_name = module_name.substr(0, last_dot);
+  if (DumpCallGraph) {
+    pecco::CallGraph call_graph;
+    call_graph.build(stmts);
+    std::ostringstream graph_text;
+    call_graph.print(graph_text);
+    WithColor(outs(), raw_ostream::GREEN, true) << "Call Graph:\n";
+    outs() << graph_text.str();
   }
 
-  // Code generation
-  if (EmitLLVM || CompileOnly || (!DumpAST && !DumpSymbols)) {
-    pecco::CodeGen codegen(module_name);
-    if (!codegen.generate(stmts, scoped_symbols)) {
-      for (const auto &err : codegen.errors()) {
+  // --interp：编译为寄存器字节码并在进程内执行，完全不经过 LLVM 后端
+  if (interpret) {
+    session.optimize_ast();
+
+    pecco::BytecodeModule bytecode;
+    pecco::BytecodeCompiler compiler;
+    if (!compiler.compile(stmts, bytecode)) {
+      for (const auto &err : compiler.errors()) {
         WithColor::error(errs(), "plc")
-            << "code generation error at " << filename << ":" << err.line << ":"
+            << "interpreter error at " << filename << ":" << err.line << ":"
             << err.column << ": " << err.message << "\n";
         printSourceLine(sourceContent, err.line, err.column, 0, 0, errs());
       }
       return 1;
     }
 
-    // 优化 IR（如果启用了 --opt）
-    if (OptimizeCode) {
-      optimizeModule(codegen.get_module());
+    if (DumpBytecode) {
+      std::ostringstream text;
+      bytecode.disassemble(text);
+      WithColor(outs(), raw_ostream::GREEN, true) << "Bytecode:\n";
+      outs() << text.str();
+      if (!Interpret && !Tiered) {
+        return 0;
+      }
+      // 程序输出直接写 fd 1，先刷新 outs() 保证顺序
+      outs().flush();
+    }
+
+    pecco::VM vm(bytecode);
+    // --tiered：解释执行的同时在后台把热点函数编译为机器码
+    std::optional<pecco::TieredJit> tiered_jit;
+    if (Tiered && JitThreshold > 0) {
+      tiered_jit.emplace(stmts, scoped_symbols, bytecode, vm);
+      vm.set_tier_up(JitThreshold,
+                     [&](size_t function) { tiered_jit->request(function); });
+    }
+
+    int32_t status = vm.run();
+    if (vm.has_error()) {
+      WithColor::error(errs(), "plc") << "runtime error: " << vm.error() << "\n";
+    }
+
+    if (tiered_jit && TierReport) {
+      // 报告包含所有已触发的编译：等待后台线程处理完队列
+      tiered_jit->wait_idle();
+      WithColor(errs(), raw_ostream::CYAN, true) << "Tier-ups:\n";
+      for (const auto &tier_up : tiered_jit->tier_ups()) {
+        errs() << "  " << tier_up.function << " ("
+               << llvm::format("%.1f", tier_up.milliseconds) << " ms): ";
+        if (!tier_up.error.empty()) {
+          errs() << "failed: " << tier_up.error << "\n";
+          continue;
+        }
+        for (size_t i = 0; i < tier_up.compiled.size(); ++i) {
+          errs() << (i ? ", " : "") << tier_up.compiled[i];
+        }
+        errs() << "\n";
+      }
+    }
+    return status;
+  }
+
+  // Code generation
+  if (EmitLLVM || CompileOnly ||
+      (!DumpAST && !DumpSymbols && !DumpCallGraph)) {
+    auto codegen_start = PhaseReport::Clock::now();
+    // AST 级优化：在交给 LLVM 之前折叠常量、删除死分支和不可达代码
+    session.optimize_ast();
+    if (!session.generate()) {
+      printDiagnostics(session, filename, sourceContent);
+      return 1;
+    }
+    pecco::CodeGen &codegen = *session.codegen();
+
+    // 默认行为（非 --emit-llvm/--compile）：编译 + 链接生成可执行文件
+    bool link_executable = !EmitLLVM && !CompileOnly;
+
+    // 添加程序入口：独立模式用 _start，否则用 main wrapper
+    std::string entry_name = "__pecco_entry";
+    if (link_executable) {
+      if (Freestanding) {
+        addStartWrapper(codegen.get_module());
+        entry_name = "_start";
+      } else {
+        addMainWrapper(codegen.get_module());
+        entry_name = "main";
+      }
     }
 
+    // 优化 IR：-Os/-Oz 优先于 --opt
+    bool size_mode = SizeOpt != SizeLevel::None;
+    if (size_mode) {
+      optimizeForSize(codegen.get_module(), entry_name, SizeOpt);
+    } else if (OptimizeCode) {
+      optimizeModule(codegen.get_module(), llvm::OptimizationLevel::O2);
+    }
+    report.add("codegen", codegen_start);
+
     // 只输出 LLVM IR
     if (EmitLLVM) {
       outs() << codegen.get_ir();
@@ -720,9 +1277,11 @@ static int runCompile(StringRef filename) {
         obj_file = module_name + ".o";
       }
 
-      if (compileToObject(codegen.get_module(), obj_file)) {
+      auto emit_start = PhaseReport::Clock::now();
+      if (compileToObject(codegen.get_module(), obj_file, size_mode)) {
         return 1;
       }
+      report.add("emit", emit_start);
 
       WithColor(outs(), raw_ostream::GREEN, true)
           << "Object file generated: " << obj_file << "\n";
@@ -730,15 +1289,14 @@ static int runCompile(StringRef filename) {
     }
 
     // 默认行为：编译 + 链接，生成可执行文件
-    if (!DumpAST && !DumpSymbols) {
-      // 添加 main wrapper
-      addMainWrapper(codegen.get_module());
-
+    if (link_executable) {
       // 生成目标文件
       std::string obj_file = module_name + ".o";
-      if (compileToObject(codegen.get_module(), obj_file)) {
+      auto emit_start = PhaseReport::Clock::now();
+      if (compileToObject(codegen.get_module(), obj_file, size_mode)) {
         return 1;
       }
+      report.add("emit", emit_start);
 
       // 确定输出文件名
       std::string exe_file;
@@ -748,28 +1306,25 @@ static int runCompile(StringRef filename) {
         exe_file = module_name;
       }
 
-      // 使用 cc 链接
-      auto cc = llvm::sys::findProgramByName("cc");
-      if (!cc) {
-        WithColor::error(errs(), "plc")
-            << "cc not found (need system C compiler for linking)\n";
-        llvm::sys::fs::remove(obj_file);
-        return 1;
-      }
-
-      std::vector<llvm::StringRef> args = {*cc, "-no-pie", obj_file, "-o",
-                                           exe_file};
-      std::string err_msg;
-      if (llvm::sys::ExecuteAndWait(*cc, args, std::nullopt, {}, 0, 0,
-                                    &err_msg)) {
-        WithColor::error(errs(), "plc")
-            << "Linking failed: " << err_msg << "\n";
-        llvm::sys::fs::remove(obj_file);
-        return 1;
+      // --size-report 需要未 strip 的符号表：先链接一次输出报告，体积模式
+      // 下再带 -s 重新链接，不依赖外部的 strip 工具
+      auto link_start = PhaseReport::Clock::now();
+      int link_result = linkExecutable({obj_file}, exe_file, size_mode,
+                                       size_mode && !SizeReport);
+      if (!link_result && SizeReport) {
+        link_result = printSizeReport(exe_file, outs());
+        if (!link_result && size_mode) {
+          link_result = linkExecutable({obj_file}, exe_file, size_mode, true);
+        }
       }
+      report.add("link", link_start);
 
       // 清理目标文件
       llvm::sys::fs::remove(obj_file);
+      if (link_result) {
+        return 1;
+      }
+      std::string err_msg;
 
       // --run 模式：运行可执行文件
       if (RunAfterCompile) {
@@ -794,8 +1349,11 @@ static int runCompile(StringRef filename) {
   return 0;
 }
 
-int main(int argc, char **argv) {
-  cl::ParseCommandLineOptions(argc, argv, "pecco-lang compiler\n");
+static int runInput() {
+  if (InputFilename.empty()) {
+    WithColor::error(errs(), "plc") << "no input file\n";
+    return 1;
+  }
 
   if (LexMode) {
     return runLexer(InputFilename);
@@ -808,3 +1366,344 @@ int main(int argc, char **argv) {
   // Default: run full compilation
   return runCompile(InputFilename);
 }
+
+static double elapsedMs(std::chrono::steady_clock::time_point from,
+                        std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// --watch 的一次增量构建：前端与 IR 生成完整执行，后端只为 IR 有变化的
+// 函数重新生成目标文件，有新目标文件时才重新链接
+static void rebuildIncremental(StringRef filename,
+                               std::shared_ptr<const pecco::SymbolTable> prelude,
+                               pecco::ObjectCache &cache,
+                               const std::string &exe_file) {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+
+  auto bufferOrErr = MemoryBuffer::getFile(filename);
+  if (std::error_code ec = bufferOrErr.getError()) {
+    WithColor::error(errs(), "plc")
+        << "cannot open file '" << filename << "': " << ec.message() << "\n";
+    return;
+  }
+  StringRef sourceContent = (*bufferOrErr)->getBuffer();
+
+  pecco::CompileOptions options;
+  options.module_name = moduleName(filename);
+  options.ast_opt = !NoAstOpt;
+  options.parse_jobs = parseJobs();
+  options.stream_tokens = StreamTokens;
+  options.fast_math_flags = fastMathFlags();
+  options.eliminate_dead_functions = true;
+  pecco::CompilationSession session(options, std::move(prelude));
+  if (!session.parse(sourceContent) || !session.analyze()) {
+    printDiagnostics(session, filename, sourceContent);
+    return;
+  }
+  session.optimize_ast();
+  if (!session.generate()) {
+    printDiagnostics(session, filename, sourceContent);
+    return;
+  }
+  llvm::Module *module = session.codegen()->get_module();
+  if (Freestanding) {
+    addStartWrapper(module);
+  } else {
+    addMainWrapper(module);
+  }
+  if (OptimizeCode) {
+    optimizeModule(module, llvm::OptimizationLevel::O2);
+  }
+  auto front_end_done = Clock::now();
+
+  std::vector<std::string> objects;
+  std::string error;
+  if (!cache.update(*module, objects, error)) {
+    WithColor::error(errs(), "plc") << error << "\n";
+    return;
+  }
+  auto codegen_done = Clock::now();
+
+  // 没有函数改变时可执行文件仍是最新的
+  const pecco::ObjectCacheStats &stats = cache.stats();
+  bool relink = stats.compiled > 0 || !llvm::sys::fs::exists(exe_file);
+  if (relink && linkExecutable(objects, exe_file, false, false)) {
+    return;
+  }
+  auto link_done = Clock::now();
+
+  errs() << "plc: rebuilt in "
+         << llvm::format("%.1f", elapsedMs(start, link_done))
+         << " ms (front end "
+         << llvm::format("%.1f", elapsedMs(start, front_end_done))
+         << " ms, codegen "
+         << llvm::format("%.1f", elapsedMs(front_end_done, codegen_done))
+         << " ms for " << stats.compiled << "/" << stats.definitions
+         << " functions, ";
+  if (relink) {
+    errs() << "link "
+           << llvm::format("%.1f", elapsedMs(codegen_done, link_done))
+           << " ms)\n";
+  } else {
+    errs() << "link skipped)\n";
+  }
+
+  if (!RunAfterCompile) {
+    outs() << "Executable generated: " << exe_file << "\n";
+    outs().flush();
+    return;
+  }
+  std::string err_msg;
+  std::vector<StringRef> run_args = {exe_file};
+  int run_result = llvm::sys::ExecuteAndWait(exe_file, run_args, std::nullopt,
+                                             {}, 0, 0, &err_msg);
+  errs() << "plc: exited with status " << run_result << "\n";
+}
+
+// --watch：构建一次，之后每次保存文件都重新构建（--run 时重新运行），
+// 直到收到 SIGINT/SIGTERM
+static int runWatch(StringRef filename) {
+  pecco::FileWatcher watcher(filename.str());
+  std::string error;
+  if (!watcher.start(error)) {
+    WithColor::error(errs(), "plc") << error << "\n";
+    return 1;
+  }
+
+  // 链接出可执行文件的模式可以复用各函数的目标文件；其他模式每次完整执行
+  bool incremental = !LexMode && !ParseMode && !DumpAST && !DumpSymbols &&
+                     !DumpCallGraph && !DumpBytecode && !EmitLLVM &&
+                     !CompileOnly && !Interpret && !Tiered &&
+                     SizeOpt == SizeLevel::None && !SizeReport;
+  if (!incremental) {
+    do {
+      auto start = std::chrono::steady_clock::now();
+      int status = runInput();
+      outs().flush();
+      __pecco_rt_flush();
+      errs() << "plc: finished with status " << status << " in "
+             << llvm::format("%.1f", elapsedMs(start,
+                                               std::chrono::steady_clock::now()))
+             << " ms\n";
+    } while (watcher.wait());
+    return 0;
+  }
+
+  llvm::TargetMachine *target_machine = getTargetMachine();
+  auto prelude = loadPrelude();
+  if (!target_machine || !prelude) {
+    return 1;
+  }
+  SmallString<128> directory;
+  if (std::error_code ec =
+          llvm::sys::fs::createUniqueDirectory("plc-watch", directory)) {
+    WithColor::error(errs(), "plc")
+        << "cannot create a build directory: " << ec.message() << "\n";
+    return 1;
+  }
+
+  // --run 且未指定输出文件时，可执行文件放在构建目录中，退出时删除
+  std::string exe_file = OutputFilename;
+  if (exe_file.empty()) {
+    exe_file = RunAfterCompile
+                   ? (directory + "/" + moduleName(filename)).str()
+                   : moduleName(filename);
+  }
+  {
+    pecco::ObjectCache cache(*target_machine, directory.str().str());
+    do {
+      rebuildIncremental(filename, prelude, cache, exe_file);
+    } while (watcher.wait());
+  }
+  if (RunAfterCompile && OutputFilename.empty()) {
+    llvm::sys::fs::remove(exe_file);
+  }
+  llvm::sys::fs::remove(directory);
+  return 0;
+}
+
+// --batch：依次编译列表中的文件，共用一个 LLVMContext、目标机器与 pass
+// 管理器（BatchCompiler），结束时报告吞吐量
+static int runBatch(StringRef list_file) {
+  auto listOrErr = MemoryBuffer::getFile(list_file);
+  if (std::error_code ec = listOrErr.getError()) {
+    WithColor::error(errs(), "plc")
+        << "cannot open file '" << list_file << "': " << ec.message() << "\n";
+    return 1;
+  }
+  // 每行一个源文件，忽略空行与 # 开头的注释行
+  std::vector<std::string> files;
+  SmallVector<StringRef, 0> lines;
+  (*listOrErr)->getBuffer().split(lines, '\n');
+  for (StringRef line : lines) {
+    line = line.trim();
+    if (!line.empty() && line.front() != '#') {
+      files.push_back(line.str());
+    }
+  }
+
+  llvm::TargetMachine *target_machine = getTargetMachine();
+  auto prelude = loadPrelude();
+  if (!target_machine || !prelude) {
+    return 1;
+  }
+  // -o 指定输出目录，否则目标文件与源文件放在一起
+  if (!OutputFilename.empty()) {
+    if (std::error_code ec =
+            llvm::sys::fs::create_directories(OutputFilename)) {
+      WithColor::error(errs(), "plc") << "cannot create directory '"
+                                      << OutputFilename
+                                      << "': " << ec.message() << "\n";
+      return 1;
+    }
+  }
+
+  pecco::CompileOptions options;
+  options.ast_opt = !NoAstOpt;
+  options.parse_jobs = parseJobs();
+  options.stream_tokens = StreamTokens;
+  options.fast_math_flags = fastMathFlags();
+  // 与 --compile 相同：目标文件中的函数可能被外部调用
+  options.eliminate_dead_functions = false;
+  std::optional<llvm::OptimizationLevel> opt_level;
+  if (SizeOpt != SizeLevel::None) {
+    opt_level = SizeOpt == SizeLevel::Oz ? llvm::OptimizationLevel::Oz
+                                         : llvm::OptimizationLevel::Os;
+  } else if (OptimizeCode) {
+    opt_level = llvm::OptimizationLevel::O2;
+  }
+  pecco::BatchCompiler compiler(*target_machine, options, opt_level, prelude);
+
+  auto start = std::chrono::steady_clock::now();
+  size_t unreadable = 0;
+  for (const auto &file : files) {
+    auto bufferOrErr = MemoryBuffer::getFile(file);
+    if (std::error_code ec = bufferOrErr.getError()) {
+      WithColor::error(errs(), "plc")
+          << "cannot open file '" << file << "': " << ec.message() << "\n";
+      ++unreadable;
+      continue;
+    }
+    std::string module_name = moduleName(file);
+    SmallString<128> object_file;
+    if (OutputFilename.empty()) {
+      object_file = file;
+      llvm::sys::path::replace_extension(object_file, "o");
+    } else {
+      object_file = OutputFilename;
+      llvm::sys::path::append(object_file, module_name + ".o");
+    }
+
+    std::vector<pecco::Diagnostic> diagnostics;
+    StringRef source = (*bufferOrErr)->getBuffer();
+    if (!compiler.compile(source, module_name, object_file.str().str(),
+                          diagnostics)) {
+      printDiagnostics(diagnostics, file, source);
+    }
+  }
+
+  const pecco::BatchStats &stats = compiler.stats();
+  double total_ms = elapsedMs(start, std::chrono::steady_clock::now());
+  size_t failed = stats.failed + unreadable;
+  errs() << "plc: compiled " << stats.files - stats.failed << "/"
+         << files.size() << " files in "
+         << llvm::format("%.1f", total_ms) << " ms ("
+         << llvm::format("%.1f", files.size() / (total_ms / 1000.0))
+         << " files/s)\n";
+  return failed ? 1 : 0;
+}
+
+// 编译服务器的一个请求：在 fork 出的子进程中按客户端的参数重新解析选项，
+// 标准输入输出和工作目录已经换成客户端的
+static int runServerRequest(const std::vector<std::string> &args) {
+  cl::ResetAllOptionOccurrences();
+  std::vector<const char *> argv = {"plc"};
+  for (const auto &arg : args) {
+    argv.push_back(arg.c_str());
+  }
+  if (!cl::ParseCommandLineOptions(static_cast<int>(argv.size()), argv.data(),
+                                   "pecco-lang compiler\n", &errs())) {
+    return 1;
+  }
+  if (ServerMode) {
+    WithColor::error(errs(), "plc") << "--server is not a compile request\n";
+    return 1;
+  }
+
+  int status = runInput();
+  outs().flush();
+  __pecco_rt_flush();
+  return status;
+}
+
+static int runServer(const std::string &socket_path) {
+  // 预热：LLVM 目标、目标机器与 prelude 符号表由之后 fork 出的请求直接复用
+  if (!getTargetMachine() || !loadPrelude()) {
+    return 1;
+  }
+
+  pecco::CompileServer server(socket_path, runServerRequest);
+  std::string error;
+  if (!server.listen(error)) {
+    WithColor::error(errs(), "plc") << error << "\n";
+    return 1;
+  }
+  errs() << "plc: compile server listening on " << socket_path << "\n";
+  server.serve();
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "pecco-lang compiler\n");
+
+  // --lsp：语言服务器，通过 stdin/stdout 与编辑器通信
+  if (LspMode) {
+    return pecco::LanguageServer(std::cin, outs()).run();
+  }
+
+  std::string socket_path = SocketPath;
+  std::string socket_error;
+  if (socket_path.empty() && (ServerMode || UseServer)) {
+    socket_path =
+        pecco::default_server_socket(socket_error).value_or(std::string());
+  }
+  if (ServerMode) {
+    if (socket_path.empty()) {
+      WithColor::error(errs(), "plc") << socket_error << "\n";
+      return 1;
+    }
+    return runServer(socket_path);
+  }
+
+  if (!BatchList.empty()) {
+    return runBatch(BatchList);
+  }
+
+  // --watch 需要在本地监视文件，不交给编译服务器
+  if (WatchMode) {
+    if (InputFilename.empty()) {
+      WithColor::error(errs(), "plc") << "no input file\n";
+      return 1;
+    }
+    return runWatch(InputFilename);
+  }
+
+  // --use-server：把整个命令行交给编译服务器执行，没有服务器时在本地编译
+  if (UseServer) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    // 默认套接字目录不可信时 socket_path 为空，不连接服务器
+    std::string error = socket_error;
+    if (!socket_path.empty()) {
+      if (auto status = pecco::run_on_server(socket_path, args, error)) {
+        if (!error.empty()) {
+          WithColor::error(errs(), "plc") << error << "\n";
+        }
+        return *status;
+      }
+    }
+    WithColor::warning(errs(), "plc") << error << ", compiling locally\n";
+  }
+
+  return runInput();
+}
@@ -0,0 +1,296 @@
+#include "engine.hpp"
+
+#include "call_graph.hpp"
+#include "compilation_session.hpp"
+#include "jit_runtime.hpp"
+#include "pecco_rt.h"
+
+#include <cstdlib>
+#include <map>
+#include <set>
+
+namespace pecco {
+
+namespace {
+
+// exit() called from Pecco code terminates the host process, after
+// flushing output like a compiled program would
+void engine_exit(int32_t code) {
+  __pecco_rt_flush();
+  std::exit(code);
+}
+
+std::string describe(const std::vector<std::string> &param_types,
+                     const std::string &return_type) {
+  std::string text = "(";
+  for (size_t i = 0; i < param_types.size(); ++i) {
+    text += (i ? ", " : "") + param_types[i];
+  }
+  return text + ") : " + return_type;
+}
+
+// Symbol tables spell an omitted return type as ""
+std::string normalize_return_type(const std::string &type) {
+  return type.empty() ? "void" : type;
+}
+
+// How the C ABI widens an 8/16-bit integer of the given Pecco type
+llvm::Attribute::AttrKind narrow_int_extension(const std::string &type) {
+  if (type == "i8" || type == "i16") {
+    return llvm::Attribute::SExt;
+  }
+  if (type == "u8" || type == "u16") {
+    return llvm::Attribute::ZExt;
+  }
+  return llvm::Attribute::None;
+}
+
+// Host code calls compiled functions, and compiled code calls host
+// functions, with the C ABI, which extends bool and 8/16-bit integer
+// arguments and return values to 32 bits; tell LLVM so. LLVM integer types
+// carry no signedness, so narrow integers take it from the Pecco signature.
+void mark_c_abi_extensions(llvm::Module &module, const SymbolTable &symbols) {
+  for (llvm::Function &func : module) {
+    for (llvm::Argument &arg : func.args()) {
+      if (arg.getType()->isIntegerTy(1)) {
+        func.addParamAttr(arg.getArgNo(), llvm::Attribute::ZExt);
+      }
+    }
+    if (func.getReturnType()->isIntegerTy(1)) {
+      func.addRetAttr(llvm::Attribute::ZExt);
+    }
+
+    auto overloads = symbols.find_functions(func.getName().str());
+    if (overloads.size() != 1 ||
+        overloads.front().param_types.size() != func.arg_size()) {
+      continue;
+    }
+    const FunctionSignature &sig = overloads.front();
+    for (unsigned i = 0; i < func.arg_size(); ++i) {
+      auto kind = narrow_int_extension(sig.param_types[i]);
+      if (kind != llvm::Attribute::None) {
+        func.addParamAttr(i, kind);
+      }
+    }
+    auto kind = narrow_int_extension(sig.return_type);
+    if (kind != llvm::Attribute::None) {
+      func.addRetAttr(kind);
+    }
+  }
+}
+
+} // namespace
+
+struct Engine::Impl {
+  struct Signature {
+    std::vector<std::string> param_types;
+    std::string return_type;
+  };
+
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+  std::string jit_error;
+
+  // Functions callable from later units without a declaration
+  std::map<std::string, Signature> host_functions;
+  std::map<std::string, Signature> exported;
+  // Operators defined by earlier units, by mangled name
+  std::map<std::string, OperatorInfo> operators;
+  unsigned next_unit = 0;
+};
+
+Engine::Engine() : impl_(std::make_unique<Impl>()) {
+  auto jit = create_runtime_jit(&engine_exit);
+  if (jit) {
+    impl_->jit = std::move(*jit);
+  } else {
+    impl_->jit_error = llvm::toString(jit.takeError());
+  }
+}
+
+Engine::~Engine() { __pecco_rt_flush(); }
+
+bool Engine::define_extern(const std::string &name, void *address,
+                           std::vector<std::string> param_types,
+                           std::string return_type) {
+  errors_.clear();
+  if (!impl_->jit) {
+    errors_.emplace_back("JIT unavailable: " + impl_->jit_error);
+    return false;
+  }
+  if (impl_->host_functions.count(name) || impl_->exported.count(name)) {
+    errors_.emplace_back("'" + name + "' is already defined");
+    return false;
+  }
+
+  llvm::orc::SymbolMap symbols;
+  symbols[impl_->jit->mangleAndIntern(name)] = llvm::orc::ExecutorSymbolDef(
+      llvm::orc::ExecutorAddr::fromPtr(address),
+      llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+  if (auto err = impl_->jit->getMainJITDylib().define(
+          llvm::orc::absoluteSymbols(std::move(symbols)))) {
+    errors_.emplace_back(llvm::toString(std::move(err)));
+    return false;
+  }
+
+  impl_->host_functions[name] = {std::move(param_types),
+                                 std::move(return_type)};
+  return true;
+}
+
+bool Engine::compile(std::string_view source) {
+  errors_.clear();
+  if (!impl_->jit) {
+    errors_.emplace_back("JIT unavailable: " + impl_->jit_error);
+    return false;
+  }
+
+  CompileOptions options;
+  options.module_name = "pecco_unit" + std::to_string(impl_->next_unit++);
+  // Every definition is exported, reachable from top-level code or not
+  options.eliminate_dead_functions = false;
+  CompilationSession session(options);
+  auto report = [&] {
+    for (const auto &diag : session.diagnostics()) {
+      errors_.emplace_back(diag.phase + " error: " + diag.message, diag.line,
+                           diag.column);
+    }
+    return false;
+  };
+
+  if (!session.parse(source)) {
+    return report();
+  }
+
+  // Host functions and earlier units' exports and operators are implicitly
+  // declared, unless this unit declares them itself
+  std::set<std::string> declared;
+  std::set<std::string> declared_operators;
+  for (const auto &stmt : session.stmts()) {
+    if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt.get());
+      std::string mangled = mangle_operator_declaration(*op);
+      if (op->body && impl_->operators.count(mangled)) {
+        errors_.emplace_back("semantic error: redefinition of operator '" +
+                                 op->op + "'",
+                             op->loc.line, op->loc.column);
+      }
+      declared_operators.insert(std::move(mangled));
+      continue;
+    }
+    if (stmt->kind != StmtKind::Func) {
+      continue;
+    }
+    auto *func = static_cast<const FuncStmt *>(stmt.get());
+    if (func->body && (impl_->host_functions.count(func->name) ||
+                       impl_->exported.count(func->name))) {
+      errors_.emplace_back("semantic error: redefinition of '" + func->name +
+                               "'",
+                           func->loc.line, func->loc.column);
+    }
+    declared.insert(func->name);
+  }
+  if (has_errors()) {
+    return false;
+  }
+  for (const auto *table : {&impl_->host_functions, &impl_->exported}) {
+    for (const auto &[name, sig] : *table) {
+      if (!declared.count(name)) {
+        session.declare(FunctionSignature(name, sig.param_types,
+                                          sig.return_type, true,
+                                          SymbolOrigin::Prelude));
+      }
+    }
+  }
+  for (const auto &[mangled, info] : impl_->operators) {
+    if (!declared_operators.count(mangled)) {
+      session.declare(info);
+    }
+  }
+
+  if (!session.analyze()) {
+    return report();
+  }
+  session.optimize_ast();
+  if (!session.generate()) {
+    return report();
+  }
+
+  CodeGen &codegen = *session.codegen();
+  llvm::Module &module = *codegen.get_module();
+  if (llvm::Function *entry = module.getFunction("__pecco_entry")) {
+    entry->eraseFromParent();
+  }
+  mark_c_abi_extensions(module, session.symbols().symbol_table());
+  module.setDataLayout(impl_->jit->getDataLayout());
+  module.setTargetTriple(impl_->jit->getTargetTriple().str());
+  optimize_jit_module(module, llvm::OptimizationLevel::O2);
+
+  auto context = codegen.take_context();
+  llvm::orc::ThreadSafeModule thread_safe_module(
+      codegen.take_module(), llvm::orc::ThreadSafeContext(std::move(context)));
+  if (auto err = impl_->jit->addIRModule(std::move(thread_safe_module))) {
+    errors_.emplace_back(llvm::toString(std::move(err)));
+    return false;
+  }
+
+  for (const auto &stmt : session.stmts()) {
+    if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt.get());
+      if (!op->body) {
+        continue;
+      }
+      std::vector<std::string> param_types;
+      for (const auto &param : op->params) {
+        param_types.push_back((*param.type)->name);
+      }
+      OperatorSignature sig(std::move(param_types),
+                            (*op->return_type)->name);
+      impl_->operators.emplace(
+          mangle_operator_declaration(*op),
+          OperatorInfo(op->op, op->position, op->precedence, op->assoc,
+                       std::move(sig), SymbolOrigin::Prelude));
+      continue;
+    }
+    if (stmt->kind != StmtKind::Func) {
+      continue;
+    }
+    auto *func = static_cast<const FuncStmt *>(stmt.get());
+    if (!func->body) {
+      continue;
+    }
+    const auto sig =
+        session.symbols().symbol_table().find_functions(func->name).front();
+    impl_->exported[func->name] = {sig.param_types,
+                                   normalize_return_type(sig.return_type)};
+  }
+  return true;
+}
+
+void *Engine::lookup_address(const std::string &name,
+                             const std::vector<std::string> &param_types,
+                             const std::string &return_type) {
+  errors_.clear();
+  auto it = impl_->exported.find(name);
+  if (it == impl_->exported.end()) {
+    errors_.emplace_back("no compiled function '" + name + "'");
+    return nullptr;
+  }
+  const Impl::Signature &sig = it->second;
+  if (sig.param_types != param_types || sig.return_type != return_type) {
+    errors_.emplace_back("'" + name + "' has signature " +
+                         describe(sig.param_types, sig.return_type) +
+                         ", requested " +
+                         describe(param_types, return_type));
+    return nullptr;
+  }
+
+  // The first lookup materializes the unit; later ones hit the symbol table
+  auto symbol = impl_->jit->lookup(name);
+  if (!symbol) {
+    errors_.emplace_back(llvm::toString(symbol.takeError()));
+    return nullptr;
+  }
+  return symbol->toPtr<void *>();
+}
+
+} // namespace pecco
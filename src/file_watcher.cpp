@@ -0,0 +1,104 @@
+#include "file_watcher.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace pecco {
+
+namespace {
+
+// Wait this long after a change for the rest of a save to arrive
+constexpr int settle_ms = 30;
+
+// Self-pipe: the signal handler wakes up wait() through it
+int signal_pipe[2] = {-1, -1};
+
+void on_stop(int) {
+  int saved = errno;
+  char byte = 's';
+  (void)!write(signal_pipe[1], &byte, 1);
+  errno = saved;
+}
+
+} // namespace
+
+FileWatcher::FileWatcher(std::string path) {
+  size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    directory_ = ".";
+    name_ = std::move(path);
+  } else {
+    directory_ = slash == 0 ? "/" : path.substr(0, slash);
+    name_ = path.substr(slash + 1);
+  }
+}
+
+FileWatcher::~FileWatcher() {
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+}
+
+bool FileWatcher::start(std::string &error) {
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0 ||
+      inotify_add_watch(inotify_fd_, directory_.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    error = "cannot watch '" + directory_ + "': " + std::strerror(errno);
+    return false;
+  }
+
+  if (signal_pipe[0] < 0 && pipe2(signal_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+    error = std::string("pipe: ") + std::strerror(errno);
+    return false;
+  }
+  struct sigaction action = {};
+  action.sa_handler = on_stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  return true;
+}
+
+bool FileWatcher::drain() {
+  alignas(inotify_event) char buffer[4096];
+  bool changed = false;
+  ssize_t n;
+  while ((n = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+    for (char *pos = buffer; pos < buffer + n;) {
+      auto *event = reinterpret_cast<inotify_event *>(pos);
+      if (event->len > 0 && name_ == event->name) {
+        changed = true;
+      }
+      pos += sizeof(inotify_event) + event->len;
+    }
+  }
+  return changed;
+}
+
+bool FileWatcher::wait() {
+  // Changes made while the caller was busy count as well
+  bool changed = drain();
+  pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {signal_pipe[0], POLLIN, 0}};
+  while (true) {
+    int ready = poll(fds, 2, changed ? settle_ms : -1);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (fds[1].revents & POLLIN) {
+      return false;
+    }
+    if (ready <= 0) {
+      // Quiet for settle_ms after a change (or poll failed)
+      return changed;
+    }
+    changed = drain() || changed;
+  }
+}
+
+} // namespace pecco
@@ -0,0 +1,752 @@
+#include "incremental_document.hpp"
+
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <utility>
+
+namespace pecco {
+
+// Editor results of one top-level statement, on top of its parse. Lines
+// are relative to the statement, like those of ParsedStatement.
+struct IncrementalDocument::Statement {
+  // Tokens and first AST; the AST is handed to the semantic queries
+  std::shared_ptr<ParsedStatement> parsed;
+  bool syntax_ok = false;
+  std::vector<Diagnostic> syntax_diagnostics;
+  std::vector<SemanticToken> semantic_tokens;
+
+  // Range of the identifier token `name` at or after loc
+  SourceLocation name_range(SourceLocation loc, const std::string &name) const {
+    for (const auto &tok : parsed->tokens) {
+      if (tok.kind == TokenKind::Identifier && tok.lexeme == name &&
+          (tok.line > loc.line ||
+           (tok.line == loc.line && tok.column >= loc.column))) {
+        return {tok.line, tok.column, tok.end_column};
+      }
+    }
+    return {loc.line, loc.column, loc.column + name.size()};
+  }
+
+  // Range of the token starting at loc
+  SourceLocation token_range(SourceLocation loc) const {
+    for (const auto &tok : parsed->tokens) {
+      if (tok.line == loc.line && tok.column == loc.column) {
+        return {tok.line, tok.column, tok.end_column};
+      }
+    }
+    return {loc.line, loc.column, loc.column + 1};
+  }
+};
+
+namespace {
+
+std::string type_name(const std::optional<TypePtr> &type) {
+  return type ? (*type)->name : "";
+}
+
+FunctionSignature signature(const FuncStmt &func) {
+  std::vector<std::string> param_types;
+  for (const auto &param : func.params) {
+    param_types.push_back(type_name(param.type));
+  }
+  return FunctionSignature(func.name, std::move(param_types),
+                           type_name(func.return_type), !func.body);
+}
+
+std::string describe(const FunctionSignature &sig) {
+  std::string text = "func " + sig.name + "(";
+  for (size_t i = 0; i < sig.param_types.size(); ++i) {
+    text += (i ? ", " : "") + sig.param_types[i];
+  }
+  text += ")";
+  if (!sig.return_type.empty()) {
+    text += " : " + sig.return_type;
+  }
+  return text;
+}
+
+bool contains(const SourceLocation &range, size_t line, size_t column) {
+  return range.line == line && column >= range.column &&
+         column < std::max(range.end_column, range.column + 1);
+}
+
+bool is_punctuation(const Token &tok, const char *lexeme) {
+  return tok.kind == TokenKind::Punctuation && tok.lexeme == lexeme;
+}
+
+// Function definitions of the prelude, for go-to-definition
+const std::map<std::string, SourceLocation> &prelude_functions() {
+  static const std::map<std::string, SourceLocation> functions = [] {
+    std::map<std::string, SourceLocation> result;
+    std::ifstream stream(STDLIB_DIR "/prelude.pec");
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    Lexer lexer(buffer.str());
+    auto tokens = lexer.tokenize_all();
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+      if (tokens[i].kind == TokenKind::Keyword && tokens[i].lexeme == "func" &&
+          tokens[i + 1].kind == TokenKind::Identifier) {
+        const Token &name = tokens[i + 1];
+        result.emplace(name.lexeme, SourceLocation(name.line, name.column,
+                                                   name.end_column));
+      }
+    }
+    return result;
+  }();
+  return functions;
+}
+
+// Finds the declaration of the identifier at a position by walking the
+// statement with a scope stack
+class DefinitionFinder {
+public:
+  DefinitionFinder(std::function<SourceLocation(SourceLocation,
+                                                const std::string &)>
+                       name_range,
+                   std::function<SourceLocation(SourceLocation)> token_range,
+                   size_t line, size_t column)
+      : name_range_(std::move(name_range)),
+        token_range_(std::move(token_range)), line_(line), column_(column) {
+    scopes_.emplace_back();
+  }
+
+  void visit(const Stmt *stmt) {
+    if (!stmt || done_) {
+      return;
+    }
+    switch (stmt->kind) {
+    case StmtKind::Func: {
+      auto *func = static_cast<const FuncStmt *>(stmt);
+      SourceLocation name = name_range_(func->loc, func->name);
+      if (contains(name, line_, column_)) {
+        found(func->name, true);
+        local_ = name;
+        return;
+      }
+      scopes_.emplace_back();
+      for (const auto &param : func->params) {
+        declare(param.name, param.loc);
+      }
+      if (func->body) {
+        visit(func->body->get());
+      }
+      scopes_.pop_back();
+      break;
+    }
+    case StmtKind::OperatorDecl: {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt);
+      scopes_.emplace_back();
+      for (const auto &param : op->params) {
+        declare(param.name, param.loc);
+      }
+      if (op->body) {
+        visit(op->body->get());
+      }
+      scopes_.pop_back();
+      break;
+    }
+    case StmtKind::Let: {
+      auto *let = static_cast<const LetStmt *>(stmt);
+      visit(let->init.get());
+      SourceLocation name = name_range_(let->loc, let->name);
+      if (contains(name, line_, column_)) {
+        found(let->name, false);
+        local_ = name;
+        return;
+      }
+      declare(let->name, name);
+      break;
+    }
+    case StmtKind::If: {
+      auto *if_stmt = static_cast<const IfStmt *>(stmt);
+      visit(if_stmt->condition.get());
+      visit(if_stmt->then_branch.get());
+      if (if_stmt->else_branch) {
+        visit(if_stmt->else_branch->get());
+      }
+      break;
+    }
+    case StmtKind::While: {
+      auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+      visit(while_stmt->condition.get());
+      visit(while_stmt->body.get());
+      break;
+    }
+    case StmtKind::Return: {
+      auto *ret = static_cast<const ReturnStmt *>(stmt);
+      if (ret->value) {
+        visit(ret->value->get());
+      }
+      break;
+    }
+    case StmtKind::Expr:
+      visit(static_cast<const ExprStmt *>(stmt)->expr.get());
+      break;
+    case StmtKind::Block: {
+      scopes_.emplace_back();
+      for (const auto &child : static_cast<const BlockStmt *>(stmt)->stmts) {
+        visit(child.get());
+      }
+      scopes_.pop_back();
+      break;
+    }
+    }
+  }
+
+  void visit(const Expr *expr) {
+    if (!expr || done_) {
+      return;
+    }
+    switch (expr->kind) {
+    case ExprKind::Identifier: {
+      auto *ident = static_cast<const IdentifierExpr *>(expr);
+      if (contains(token_range_(expr->loc), line_, column_)) {
+        found(ident->name, false);
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+          auto binding = it->find(ident->name);
+          if (binding != it->end()) {
+            local_ = binding->second;
+            break;
+          }
+        }
+      }
+      break;
+    }
+    case ExprKind::Call: {
+      auto *call = static_cast<const CallExpr *>(expr);
+      if (call->callee->kind == ExprKind::Identifier &&
+          contains(token_range_(call->callee->loc), line_, column_)) {
+        found(static_cast<const IdentifierExpr *>(call->callee.get())->name,
+              true);
+        return;
+      }
+      for (const auto &arg : call->args) {
+        visit(arg.get());
+      }
+      break;
+    }
+    case ExprKind::Binary: {
+      auto *binary = static_cast<const BinaryExpr *>(expr);
+      visit(binary->left.get());
+      visit(binary->right.get());
+      break;
+    }
+    case ExprKind::Unary:
+      visit(static_cast<const UnaryExpr *>(expr)->operand.get());
+      break;
+    case ExprKind::Index: {
+      auto *index = static_cast<const IndexExpr *>(expr);
+      visit(index->base.get());
+      visit(index->index.get());
+      break;
+    }
+    case ExprKind::OperatorSeq:
+      for (const auto &item : static_cast<const OperatorSeqExpr *>(expr)->items) {
+        visit(item.operand.get());
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  bool done() const { return done_; }
+  const std::string &name() const { return name_; }
+  bool is_function() const { return is_function_; }
+  // Declaration within the statement, if the name is bound there
+  const std::optional<SourceLocation> &local() const { return local_; }
+
+private:
+  std::function<SourceLocation(SourceLocation, const std::string &)>
+      name_range_;
+  std::function<SourceLocation(SourceLocation)> token_range_;
+  size_t line_;
+  size_t column_;
+  std::vector<std::map<std::string, SourceLocation>> scopes_;
+
+  bool done_ = false;
+  std::string name_;
+  bool is_function_ = false;
+  std::optional<SourceLocation> local_;
+
+  void declare(const std::string &name, SourceLocation loc) {
+    if (loc.end_column == 0) {
+      loc.end_column = loc.column + name.size();
+    }
+    scopes_.back()[name] = loc;
+  }
+
+  void found(const std::string &name, bool is_function) {
+    done_ = true;
+    name_ = name;
+    is_function_ = is_function;
+  }
+};
+
+} // namespace
+
+IncrementalDocument::IncrementalDocument(
+    std::shared_ptr<const SymbolTable> prelude)
+    : queries_(std::move(prelude)) {}
+
+IncrementalDocument::~IncrementalDocument() = default;
+
+std::shared_ptr<IncrementalDocument::Statement>
+IncrementalDocument::make_statement(std::shared_ptr<ParsedStatement> parsed) {
+  auto statement = std::make_shared<Statement>();
+  statement->parsed = std::move(parsed);
+  for (const auto &tok : statement->parsed->tokens) {
+    if (tok.kind == TokenKind::Error) {
+      statement->syntax_diagnostics.push_back({"lexer", tok.lexeme, tok.line,
+                                               tok.column, tok.end_column,
+                                               tok.error_offset});
+    }
+  }
+  for (const auto &err : statement->parsed->errors) {
+    statement->syntax_diagnostics.push_back(
+        {"parse", err.message, err.line, err.column, err.end_column});
+  }
+  statement->syntax_ok = statement->syntax_diagnostics.empty();
+
+  // Semantic tokens: lexical classes, with identifiers classified by context
+  std::vector<std::pair<size_t, size_t>> parameters;
+  for (const auto &stmt : statement->parsed->stmts) {
+    const std::vector<Parameter> *params = nullptr;
+    if (stmt->kind == StmtKind::Func) {
+      params = &static_cast<const FuncStmt *>(stmt.get())->params;
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      params = &static_cast<const OperatorDeclStmt *>(stmt.get())->params;
+    }
+    if (params) {
+      for (const auto &param : *params) {
+        parameters.emplace_back(param.loc.line, param.loc.column);
+      }
+    }
+  }
+  const Token *previous = nullptr;
+  const auto &toks = statement->parsed->tokens;
+  for (size_t i = 0; i + 1 < toks.size(); ++i) {
+    const Token &tok = toks[i];
+    std::optional<SemanticTokenKind> kind;
+    size_t length = tok.end_column > tok.column ? tok.end_column - tok.column
+                                                : tok.lexeme.size();
+    switch (tok.kind) {
+    case TokenKind::Keyword:
+      kind = SemanticTokenKind::Keyword;
+      break;
+    case TokenKind::Integer:
+    case TokenKind::Float:
+      kind = SemanticTokenKind::Number;
+      break;
+    case TokenKind::String:
+      kind = SemanticTokenKind::String;
+      break;
+    case TokenKind::Comment:
+      kind = SemanticTokenKind::Comment;
+      length = tok.lexeme.size() + 1; // '#' and the text
+      break;
+    case TokenKind::Operator:
+      kind = SemanticTokenKind::Operator;
+      break;
+    case TokenKind::Identifier: {
+      size_t next = i + 1;
+      while (toks[next].kind == TokenKind::Comment) {
+        ++next;
+      }
+      if (std::find(parameters.begin(), parameters.end(),
+                    std::make_pair(tok.line, tok.column)) != parameters.end()) {
+        kind = SemanticTokenKind::Parameter;
+      } else if ((previous && previous->kind == TokenKind::Keyword &&
+                  previous->lexeme == "func") ||
+                 is_punctuation(toks[next], "(")) {
+        kind = SemanticTokenKind::Function;
+      } else if (previous && is_punctuation(*previous, ":")) {
+        kind = SemanticTokenKind::Type;
+      } else {
+        kind = SemanticTokenKind::Variable;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    if (kind) {
+      statement->semantic_tokens.push_back(
+          {tok.line, tok.column, length, *kind});
+    }
+    if (tok.kind != TokenKind::Comment) {
+      previous = &tok;
+    }
+  }
+  return statement;
+}
+
+void IncrementalDocument::update(const std::string &text) {
+  stats_ = UpdateStats();
+
+  // Statements whose tokens are unchanged keep their results
+  std::unordered_map<const ParsedStatement *, std::shared_ptr<Statement>> cache;
+  std::vector<std::shared_ptr<Statement>> statements;
+  std::map<uint64_t, size_t> occurrences;
+  std::vector<std::pair<std::string, SemanticQueries::Parse>> queries;
+  for (const auto &parsed : parser_.update(text)) {
+    std::shared_ptr<Statement> statement;
+    auto cached = cache_.find(parsed.get());
+    if (cached != cache_.end()) {
+      statement = cached->second;
+    } else {
+      statement = make_statement(parsed);
+    }
+    cache[parsed.get()] = statement;
+
+    // Identical statements are analyzed separately. The queries analyze
+    // copies of the parser's AST, which stays with the parser for the
+    // next update; a statement with syntax errors is not analyzed, only
+    // its complete declarations are seen by the others.
+    std::string key = std::to_string(parsed->hash) + "#" +
+                      std::to_string(occurrences[parsed->hash]++);
+    queries.emplace_back(std::move(key), [parsed, first = true]() mutable {
+      if (!first && !parsed->errors.empty()) {
+        return std::vector<StmtPtr>();
+      }
+      first = false;
+      return clone(parsed->stmts);
+    });
+    statements.push_back(std::move(statement));
+  }
+  statements_ = std::move(statements);
+  cache_ = std::move(cache);
+  stats_.statements = statements_.size();
+  stats_.parsed = parser_.stats().parsed;
+  queries_.update(std::move(queries));
+  diagnostics_.reset();
+}
+
+const std::vector<Diagnostic> &IncrementalDocument::diagnostics() const {
+  if (diagnostics_) {
+    return *diagnostics_;
+  }
+  diagnostics_.emplace();
+  for (size_t i = 0; i < statements_.size(); ++i) {
+    const Statement &statement = *statements_[i];
+    std::vector<Diagnostic> list = statement.syntax_diagnostics;
+    if (statement.syntax_ok) {
+      list = queries_.diagnostics(i);
+    }
+    size_t offset = statement.parsed->first_line - 1;
+    for (Diagnostic &diag : list) {
+      if (diag.line == 0) {
+        diag.line = 1;
+        diag.column = statement.parsed->first_column;
+      }
+      diag.line += offset;
+      diagnostics_->push_back(std::move(diag));
+    }
+  }
+  return *diagnostics_;
+}
+
+UpdateStats IncrementalDocument::stats() const {
+  UpdateStats stats = stats_;
+  stats.checked = queries_.stats().checked;
+  return stats;
+}
+
+std::optional<size_t>
+IncrementalDocument::statement_at(size_t line, size_t column) const {
+  auto it = std::upper_bound(
+      statements_.begin(), statements_.end(), std::make_pair(line, column),
+      [](const std::pair<size_t, size_t> &pos,
+         const std::shared_ptr<Statement> &statement) {
+        return pos < std::make_pair(statement->parsed->first_line,
+                                    statement->parsed->first_column);
+      });
+  if (it == statements_.begin()) {
+    return std::nullopt;
+  }
+  return it - 1 - statements_.begin();
+}
+
+std::optional<HoverInfo> IncrementalDocument::hover(size_t line,
+                                                    size_t column) const {
+  auto index = statement_at(line, column);
+  if (!index || !statements_[*index]->syntax_ok) {
+    return std::nullopt;
+  }
+  const Statement *statement = statements_[*index].get();
+  const auto &stmts = queries_.checked(*index);
+  size_t offset = statement->parsed->first_line - 1;
+  size_t rel = line - offset;
+  std::optional<HoverInfo> result;
+  auto hit = [&](SourceLocation range, std::string text) {
+    if (!result && contains(range, rel, column)) {
+      range.line += offset;
+      result = HoverInfo{range, std::move(text)};
+    }
+  };
+  auto function_text = [&](const std::string &name,
+                           const std::vector<ExprPtr> *args) {
+    auto overloads = queries_.function_signatures(name);
+    if (overloads.empty()) {
+      return "func " + name;
+    }
+    for (const auto &sig : overloads) {
+      if (!args || sig.param_types.size() != args->size()) {
+        continue;
+      }
+      bool match = true;
+      for (size_t i = 0; i < args->size(); ++i) {
+        match = match && sig.param_types[i] == (*args)[i]->inferred_type;
+      }
+      if (match) {
+        return describe(sig);
+      }
+    }
+    return describe(overloads.front());
+  };
+
+  std::function<void(const Expr *)> visit_expr = [&](const Expr *expr) {
+    if (!expr || result) {
+      return;
+    }
+    switch (expr->kind) {
+    case ExprKind::Identifier:
+      hit(statement->token_range(expr->loc),
+          static_cast<const IdentifierExpr *>(expr)->name + ": " +
+              expr->inferred_type);
+      break;
+    case ExprKind::IntLiteral:
+    case ExprKind::FloatLiteral:
+    case ExprKind::StringLiteral:
+    case ExprKind::BoolLiteral:
+      hit(statement->token_range(expr->loc), expr->inferred_type);
+      break;
+    case ExprKind::Call: {
+      auto *call = static_cast<const CallExpr *>(expr);
+      if (call->callee->kind == ExprKind::Identifier) {
+        hit(statement->token_range(call->callee->loc),
+            function_text(
+                static_cast<const IdentifierExpr *>(call->callee.get())->name,
+                &call->args));
+      }
+      for (const auto &arg : call->args) {
+        visit_expr(arg.get());
+      }
+      break;
+    }
+    case ExprKind::Binary: {
+      auto *binary = static_cast<const BinaryExpr *>(expr);
+      hit({expr->loc.line, expr->loc.column,
+           expr->loc.column + binary->op.size()},
+          "(" + binary->left->inferred_type + " " + binary->op + " " +
+              binary->right->inferred_type + ") : " + expr->inferred_type);
+      visit_expr(binary->left.get());
+      visit_expr(binary->right.get());
+      break;
+    }
+    case ExprKind::Unary: {
+      auto *unary = static_cast<const UnaryExpr *>(expr);
+      if (unary->position == OpPosition::Prefix) {
+        hit({expr->loc.line, expr->loc.column,
+             expr->loc.column + unary->op.size()},
+            "(" + unary->op + unary->operand->inferred_type + ") : " +
+                expr->inferred_type);
+      }
+      visit_expr(unary->operand.get());
+      break;
+    }
+    case ExprKind::Index: {
+      auto *index = static_cast<const IndexExpr *>(expr);
+      visit_expr(index->base.get());
+      visit_expr(index->index.get());
+      break;
+    }
+    default:
+      break;
+    }
+  };
+
+  std::function<void(const Stmt *)> visit_stmt = [&](const Stmt *stmt) {
+    if (!stmt || result) {
+      return;
+    }
+    switch (stmt->kind) {
+    case StmtKind::Func: {
+      auto *func = static_cast<const FuncStmt *>(stmt);
+      hit(statement->name_range(func->loc, func->name),
+          describe(signature(*func)));
+      for (const auto &param : func->params) {
+        hit({param.loc.line, param.loc.column,
+             param.loc.column + param.name.size()},
+            param.name + ": " + type_name(param.type));
+      }
+      if (func->body) {
+        visit_stmt(func->body->get());
+      }
+      break;
+    }
+    case StmtKind::OperatorDecl: {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt);
+      for (const auto &param : op->params) {
+        hit({param.loc.line, param.loc.column,
+             param.loc.column + param.name.size()},
+            param.name + ": " + type_name(param.type));
+      }
+      if (op->body) {
+        visit_stmt(op->body->get());
+      }
+      break;
+    }
+    case StmtKind::Let: {
+      auto *let = static_cast<const LetStmt *>(stmt);
+      std::string type = let->type ? type_name(let->type)
+                         : let->init ? let->init->inferred_type
+                                     : "";
+      hit(statement->name_range(let->loc, let->name), let->name + ": " + type);
+      visit_expr(let->init.get());
+      break;
+    }
+    case StmtKind::If: {
+      auto *if_stmt = static_cast<const IfStmt *>(stmt);
+      visit_expr(if_stmt->condition.get());
+      visit_stmt(if_stmt->then_branch.get());
+      if (if_stmt->else_branch) {
+        visit_stmt(if_stmt->else_branch->get());
+      }
+      break;
+    }
+    case StmtKind::While: {
+      auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+      visit_expr(while_stmt->condition.get());
+      visit_stmt(while_stmt->body.get());
+      break;
+    }
+    case StmtKind::Return: {
+      auto *ret = static_cast<const ReturnStmt *>(stmt);
+      if (ret->value) {
+        visit_expr(ret->value->get());
+      }
+      break;
+    }
+    case StmtKind::Expr:
+      visit_expr(static_cast<const ExprStmt *>(stmt)->expr.get());
+      break;
+    case StmtKind::Block:
+      for (const auto &child : static_cast<const BlockStmt *>(stmt)->stmts) {
+        visit_stmt(child.get());
+      }
+      break;
+    }
+  };
+
+  for (const auto &stmt : stmts) {
+    visit_stmt(stmt.get());
+  }
+  return result;
+}
+
+std::optional<DefinitionLocation>
+IncrementalDocument::function_definition(const std::string &name) const {
+  // Prefer the definition over forward declarations
+  std::optional<DefinitionLocation> declaration;
+  for (size_t i = 0; i < statements_.size(); ++i) {
+    const Statement *statement = statements_[i].get();
+    for (const auto &stmt : queries_.syntax(i)) {
+      if (stmt->kind != StmtKind::Func) {
+        continue;
+      }
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      if (func->name != name) {
+        continue;
+      }
+      SourceLocation range = statement->name_range(func->loc, func->name);
+      range.line += statement->parsed->first_line - 1;
+      if (func->body) {
+        return DefinitionLocation{"", range};
+      }
+      if (!declaration) {
+        declaration = DefinitionLocation{"", range};
+      }
+    }
+  }
+  if (declaration) {
+    return declaration;
+  }
+  const auto &prelude = prelude_functions();
+  auto it = prelude.find(name);
+  if (it != prelude.end()) {
+    return DefinitionLocation{STDLIB_DIR "/prelude.pec", it->second};
+  }
+  return std::nullopt;
+}
+
+std::optional<DefinitionLocation>
+IncrementalDocument::definition(size_t line, size_t column) const {
+  auto index = statement_at(line, column);
+  if (!index) {
+    return std::nullopt;
+  }
+  const Statement *statement = statements_[*index].get();
+  size_t offset = statement->parsed->first_line - 1;
+  DefinitionFinder finder(
+      [statement](SourceLocation loc, const std::string &name) {
+        return statement->name_range(loc, name);
+      },
+      [statement](SourceLocation loc) { return statement->token_range(loc); },
+      line - offset, column);
+  for (const auto &stmt : queries_.syntax(*index)) {
+    finder.visit(stmt.get());
+  }
+  if (!finder.done()) {
+    return std::nullopt;
+  }
+  if (finder.is_function()) {
+    if (finder.local()) {
+      SourceLocation range = *finder.local();
+      range.line += offset;
+      return DefinitionLocation{"", range};
+    }
+    return function_definition(finder.name());
+  }
+  if (finder.local()) {
+    SourceLocation range = *finder.local();
+    range.line += offset;
+    return DefinitionLocation{"", range};
+  }
+
+  // Global variable of an earlier statement (the latest definition wins)
+  for (size_t i = *index; i-- > 0;) {
+    const Statement *other = statements_[i].get();
+    const auto &stmts = queries_.syntax(i);
+    for (auto stmt = stmts.rbegin(); stmt != stmts.rend(); ++stmt) {
+      if ((*stmt)->kind != StmtKind::Let) {
+        continue;
+      }
+      auto *let = static_cast<const LetStmt *>(stmt->get());
+      if (let->name == finder.name()) {
+        SourceLocation range = other->name_range(let->loc, let->name);
+        range.line += other->parsed->first_line - 1;
+        return DefinitionLocation{"", range};
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::vector<SemanticToken> IncrementalDocument::semantic_tokens() const {
+  std::vector<SemanticToken> tokens;
+  for (const auto &statement : statements_) {
+    for (SemanticToken tok : statement->semantic_tokens) {
+      tok.line += statement->parsed->first_line - 1;
+      tokens.push_back(tok);
+    }
+  }
+  return tokens;
+}
+
+} // namespace pecco
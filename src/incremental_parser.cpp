@@ -0,0 +1,309 @@
+#include "incremental_parser.hpp"
+
+#include "lexer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+namespace pecco {
+
+namespace {
+
+// FNV-1a over whole words rather than bytes: hashing runs over every token
+// of the program on each update, so it has to be much cheaper than parsing
+void mix(uint64_t &hash, uint64_t value) {
+  hash = (hash ^ value) * 1099511628211ull;
+}
+
+void mix(uint64_t &hash, const std::string &text) {
+  mix(hash, text.size());
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= text.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, text.data() + i, sizeof(word));
+    mix(hash, word);
+  }
+  for (; i < text.size(); ++i) {
+    mix(hash, static_cast<unsigned char>(text[i]));
+  }
+}
+
+uint64_t hash_range(const std::vector<Token> &tokens, size_t begin,
+                    size_t end) {
+  uint64_t hash = 14695981039346656037ull;
+  size_t offset = tokens[begin].line - 1;
+  for (size_t i = begin; i < end; ++i) {
+    const Token &tok = tokens[i];
+    mix(hash, static_cast<uint64_t>(tok.kind) << 32 | (tok.line - offset));
+    mix(hash, tok.column << 32 | tok.end_column);
+    mix(hash, tok.lexeme);
+  }
+  return hash;
+}
+
+// Same tokens at the same relative positions (guards against collisions)
+bool same_tokens(const ParsedStatement &statement,
+                 const std::vector<Token> &tokens, size_t begin, size_t end) {
+  if (statement.tokens.size() != end - begin + 1) {
+    return false;
+  }
+  size_t offset = tokens[begin].line - 1;
+  for (size_t i = begin; i < end; ++i) {
+    const Token &a = statement.tokens[i - begin];
+    const Token &b = tokens[i];
+    if (a.kind != b.kind || a.lexeme != b.lexeme ||
+        a.line != b.line - offset || a.column != b.column ||
+        a.end_column != b.end_column) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// First token that is not a comment is the keyword `else`
+bool starts_with_else(const std::vector<Token> &tokens) {
+  for (const auto &tok : tokens) {
+    if (tok.kind != TokenKind::Comment) {
+      return tok.kind == TokenKind::Keyword && tok.lexeme == "else";
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+std::vector<StmtPtr> ParsedStatement::reparse() const {
+  if (!lexer_ok) {
+    return {};
+  }
+  Parser parser(tokens);
+  return parser.parse_program();
+}
+
+std::shared_ptr<ParsedStatement>
+IncrementalParser::parse(const std::vector<Token> &tokens, size_t begin,
+                         size_t end) {
+  auto statement = std::make_shared<ParsedStatement>();
+  size_t offset = tokens[begin].line - 1;
+  statement->tokens.reserve(end - begin + 1);
+  for (size_t i = begin; i < end; ++i) {
+    Token tok = tokens[i];
+    tok.line -= offset;
+    statement->lexer_ok = statement->lexer_ok && tok.kind != TokenKind::Error;
+    statement->tokens.push_back(std::move(tok));
+  }
+  // Errors at the end of the statement point just past its last token
+  Token eof;
+  eof.line = statement->tokens.back().line;
+  eof.column = statement->tokens.back().end_column;
+  eof.end_column = eof.column;
+  statement->tokens.push_back(eof);
+
+  if (statement->lexer_ok) {
+    Parser parser(statement->tokens);
+    statement->stmts = parser.parse_program();
+    statement->errors = parser.errors();
+  }
+  return statement;
+}
+
+void IncrementalParser::collect(
+    const std::vector<Token> &tokens,
+    const std::vector<std::pair<size_t, size_t>> &ranges, Pool &pool,
+    const std::vector<size_t> &line_starts, size_t first_line,
+    std::vector<std::shared_ptr<ParsedStatement>> &statements,
+    std::vector<size_t> &offsets) {
+  for (const auto &[begin, end] : ranges) {
+    uint64_t hash = hash_range(tokens, begin, end);
+    std::shared_ptr<ParsedStatement> statement;
+    auto candidates = pool.find(hash);
+    if (candidates != pool.end()) {
+      // Identical statements are matched in order
+      for (auto &candidate : candidates->second) {
+        if (candidate && same_tokens(*candidate, tokens, begin, end)) {
+          statement = std::move(candidate);
+          break;
+        }
+      }
+    }
+    if (statement) {
+      ++stats_.reused;
+    } else {
+      statement = parse(tokens, begin, end);
+      statement->hash = hash;
+      ++stats_.parsed;
+    }
+    const Token &first = tokens[begin];
+    statement->first_line = first.line;
+    statement->first_column = first.column;
+    statements.push_back(std::move(statement));
+    offsets.push_back(line_starts[first.line - first_line] + first.column - 1);
+  }
+}
+
+void IncrementalParser::update_all(const std::string &text) {
+  stats_ = ReparseStats();
+  stats_.lexed = text.size();
+  Lexer lexer(text);
+  auto tokens = lexer.tokenize_all();
+  std::vector<size_t> line_starts = {0};
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') {
+      line_starts.push_back(i + 1);
+    }
+  }
+
+  Pool pool;
+  for (auto &statement : statements_) {
+    uint64_t hash = statement->hash;
+    pool[hash].push_back(std::move(statement));
+  }
+  std::vector<std::shared_ptr<ParsedStatement>> statements;
+  std::vector<size_t> offsets;
+  collect(tokens, Parser::split_top_level(tokens), pool, line_starts, 1,
+          statements, offsets);
+  statements_ = std::move(statements);
+  offsets_ = std::move(offsets);
+}
+
+bool IncrementalParser::update_range(const std::string &text) {
+  const std::string &old = text_;
+  size_t count = statements_.size();
+
+  // Changed bytes: [prefix, old.size() - suffix) of the old text
+  size_t limit = std::min(old.size(), text.size());
+  size_t prefix =
+      std::mismatch(old.begin(), old.begin() + limit, text.begin()).first -
+      old.begin();
+  size_t suffix = std::mismatch(old.rbegin(), old.rbegin() + (limit - prefix),
+                                text.rbegin())
+                      .first -
+                  old.rbegin();
+  size_t changed_end = old.size() - suffix;
+  ptrdiff_t delta = static_cast<ptrdiff_t>(text.size()) -
+                    static_cast<ptrdiff_t>(old.size());
+
+  // Lex again from the last statement starting before the change (its last
+  // tokens may run into it)...
+  size_t first = std::lower_bound(offsets_.begin(), offsets_.end(), prefix) -
+                 offsets_.begin();
+  size_t start = 0;
+  size_t start_line = 1;
+  size_t start_column = 1;
+  if (first > 0) {
+    --first;
+    start = offsets_[first];
+    start_line = statements_[first]->first_line;
+    start_column = statements_[first]->first_column;
+  }
+  // ...to the first statement after it starting on a later line (the
+  // columns of the statements on the changed lines may have moved)
+  size_t end_line =
+      start_line + std::count(old.begin() + start, old.begin() + changed_end,
+                              '\n');
+  size_t last = std::upper_bound(offsets_.begin() + first, offsets_.end(),
+                                 changed_end) -
+                offsets_.begin();
+  while (last < count && statements_[last]->first_line <= end_line) {
+    ++last;
+  }
+  // A statement starting with 'else' was split off only because of what
+  // came before it
+  if (last < count && starts_with_else(statements_[last]->tokens)) {
+    last = count;
+  }
+
+  std::vector<Token> tokens;
+  std::vector<std::pair<size_t, size_t>> ranges;
+  std::vector<size_t> line_starts;
+  size_t old_stop = 0;
+  size_t stop = 0;
+  for (;;) {
+    old_stop = last < count ? offsets_[last] : old.size();
+    stop = old_stop + delta;
+    stats_.lexed = stop - start;
+
+    Lexer lexer(std::string_view(text).substr(start, stop - start));
+    tokens = lexer.tokenize_all();
+    for (auto &tok : tokens) {
+      if (tok.line == 1) {
+        tok.column += start_column - 1;
+        tok.end_column += start_column - 1;
+      }
+      tok.line += start_line - 1;
+    }
+    line_starts = {start - (start_column - 1)};
+    for (size_t i = start; i < stop; ++i) {
+      if (text[i] == '\n') {
+        line_starts.push_back(i + 1);
+      }
+    }
+    bool open = false;
+    ranges = Parser::split_top_level(tokens, &open);
+    if (last == count) {
+      break;
+    }
+    // The rest of the text is lexed and split as before only if the edited
+    // part ends with a complete statement and a token boundary. Trailing
+    // comments would belong to the next statement; an Error token may be
+    // a string running on.
+    TokenKind last_kind = tokens.size() > 1 ? tokens[tokens.size() - 2].kind
+                                            : TokenKind::EndOfFile;
+    bool complete = !open && last_kind != TokenKind::Comment &&
+                    last_kind != TokenKind::Error;
+    bool boundary = stop == start || is_whitespace(text[stop - 1]);
+    if (complete && boundary) {
+      break;
+    }
+    last = count;
+  }
+  // The statement before the edit was split off because no 'else' followed
+  if (first > 0 && !ranges.empty() &&
+      starts_with_else(std::vector<Token>(tokens.begin() + ranges[0].first,
+                                          tokens.begin() + ranges[0].second))) {
+    return false;
+  }
+
+  Pool pool;
+  for (size_t i = first; i < last; ++i) {
+    uint64_t hash = statements_[i]->hash;
+    pool[hash].push_back(statements_[i]);
+  }
+  std::vector<std::shared_ptr<ParsedStatement>> statements(
+      statements_.begin(), statements_.begin() + first);
+  std::vector<size_t> offsets(offsets_.begin(), offsets_.begin() + first);
+  stats_.reused = first + (count - last);
+  collect(tokens, ranges, pool, line_starts, start_line, statements, offsets);
+
+  // The statements after the edit only move
+  ptrdiff_t line_delta =
+      static_cast<ptrdiff_t>(line_starts.size() - 1) -
+      std::count(old.begin() + start, old.begin() + old_stop, '\n');
+  for (size_t i = last; i < count; ++i) {
+    statements_[i]->first_line += line_delta;
+    statements.push_back(std::move(statements_[i]));
+    offsets.push_back(offsets_[i] + delta);
+  }
+  statements_ = std::move(statements);
+  offsets_ = std::move(offsets);
+  return true;
+}
+
+const std::vector<std::shared_ptr<ParsedStatement>> &
+IncrementalParser::update(const std::string &text) {
+  stats_ = ReparseStats();
+  if (statements_.empty() || !update_range(text)) {
+    update_all(text);
+  }
+  text_ = text;
+  stats_.statements = statements_.size();
+  return statements_;
+}
+
+} // namespace pecco
@@ -0,0 +1,80 @@
+#include "jit_runtime.hpp"
+
+#include "pecco_rt.h"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <mutex>
+
+namespace pecco {
+
+llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>>
+create_runtime_jit(void (*exit_function)(int32_t)) {
+  // Target registration mutates LLVM's global registry; do it once even
+  // when several JITs are created concurrently
+  static std::once_flag targets_initialized;
+  std::call_once(targets_initialized, [] {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+
+  auto jit = llvm::orc::LLJITBuilder().create();
+  if (!jit) {
+    return jit.takeError();
+  }
+  llvm::orc::JITDylib &dylib = (*jit)->getMainJITDylib();
+
+  // libm (pow for f64 **) and other libc symbols come from this process.
+  // DynamicLibrary's process-wide registry is lazily created, so opening
+  // it is serialized as well.
+  static std::mutex process_library_mutex;
+  std::unique_lock<std::mutex> lock(process_library_mutex);
+  auto process =
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          (*jit)->getDataLayout().getGlobalPrefix());
+  lock.unlock();
+  if (!process) {
+    return process.takeError();
+  }
+  dylib.addGenerator(std::move(*process));
+
+  llvm::orc::SymbolMap runtime;
+  auto define = [&](const char *name, auto *address) {
+    runtime[(*jit)->mangleAndIntern(name)] = llvm::orc::ExecutorSymbolDef(
+        llvm::orc::ExecutorAddr::fromPtr(address),
+        llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+  };
+  define("write", &__pecco_rt_write);
+  define("print", &__pecco_rt_print);
+  define("print_i32", &__pecco_rt_print_i32);
+  define("print_i64", &__pecco_rt_print_i64);
+  define("print_u64", &__pecco_rt_print_u64);
+  define("print_f64", &__pecco_rt_print_f64);
+  define("flush", &__pecco_rt_flush);
+  define("exit", exit_function);
+  if (auto err = dylib.define(llvm::orc::absoluteSymbols(std::move(runtime)))) {
+    return err;
+  }
+  return jit;
+}
+
+void optimize_jit_module(llvm::Module &module, llvm::OptimizationLevel level) {
+  llvm::LoopAnalysisManager LAM;
+  llvm::FunctionAnalysisManager FAM;
+  llvm::CGSCCAnalysisManager CGAM;
+  llvm::ModuleAnalysisManager MAM;
+
+  llvm::PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(level);
+  MPM.run(module, MAM);
+}
+
+} // namespace pecco
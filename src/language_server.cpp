@@ -0,0 +1,452 @@
+#include "language_server.hpp"
+
+#include <llvm/ADT/StringRef.h>
+
+namespace pecco {
+
+namespace {
+
+// JSON-RPC error codes
+constexpr int parse_error = -32700;
+constexpr int method_not_found = -32601;
+constexpr int invalid_params = -32602;
+
+// Names of SemanticTokenKind, in order
+const char *const token_types[] = {"keyword", "function", "parameter",
+                                   "variable", "type",     "number",
+                                   "string",  "comment",  "operator"};
+
+// Number of UTF-16 code units of the UTF-8 sequence starting with `lead`
+// (continuation bytes count 0)
+size_t utf16_units(unsigned char lead) {
+  if ((lead & 0xC0) == 0x80) {
+    return 0;
+  }
+  return lead >= 0xF0 ? 2 : 1;
+}
+
+int64_t integer(const llvm::json::Object &object, llvm::StringRef key) {
+  auto value = object.getInteger(key);
+  return value ? *value : 0;
+}
+
+// Offsets of the line starts of a text
+std::vector<size_t> line_index(const std::string &text) {
+  std::vector<size_t> line_starts = {0};
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') {
+      line_starts.push_back(i + 1);
+    }
+  }
+  return line_starts;
+}
+
+// Byte offset of an LSP position (0-based line, UTF-16 character)
+size_t byte_offset(const std::string &text,
+                   const std::vector<size_t> &line_starts, int64_t line,
+                   int64_t character) {
+  if (line < 0) {
+    return 0;
+  }
+  if (static_cast<size_t>(line) >= line_starts.size()) {
+    return text.size();
+  }
+  size_t pos = line_starts[line];
+  int64_t units = 0;
+  while (pos < text.size() && text[pos] != '\n') {
+    size_t width = utf16_units(static_cast<unsigned char>(text[pos]));
+    if (width > 0 && units + static_cast<int64_t>(width) > character) {
+      break;
+    }
+    units += static_cast<int64_t>(width);
+    ++pos;
+  }
+  return pos;
+}
+
+llvm::json::Value position(size_t line, size_t character) {
+  return llvm::json::Object{{"line", static_cast<int64_t>(line)},
+                            {"character", static_cast<int64_t>(character)}};
+}
+
+} // namespace
+
+// An open document: text, line index and incremental analysis
+struct LanguageServer::Document {
+  std::string text;
+  std::vector<size_t> line_starts;
+  IncrementalDocument analysis;
+
+  void set_text(std::string new_text) {
+    text = std::move(new_text);
+    line_starts = line_index(text);
+    analysis.update(text);
+  }
+
+  // 1-based byte column of an LSP position on a 1-based line
+  size_t column(size_t line, int64_t character) const {
+    return byte_offset(text, line_starts, static_cast<int64_t>(line) - 1,
+                       character) -
+           line_starts[std::min(line, line_starts.size()) - 1] + 1;
+  }
+
+  // UTF-16 character of a 1-based line and byte column
+  size_t character(size_t line, size_t column) const {
+    if (line == 0 || line > line_starts.size()) {
+      return 0;
+    }
+    size_t start = line_starts[line - 1];
+    size_t end = std::min(start + column - 1, text.size());
+    size_t units = 0;
+    for (size_t pos = start; pos < end; ++pos) {
+      units += utf16_units(static_cast<unsigned char>(text[pos]));
+    }
+    return units;
+  }
+
+  llvm::json::Value range(const SourceLocation &loc) const {
+    size_t end_column =
+        loc.end_column > loc.column ? loc.end_column : loc.column + 1;
+    return llvm::json::Object{
+        {"start", position(loc.line - 1, character(loc.line, loc.column))},
+        {"end", position(loc.line - 1, character(loc.line, end_column))}};
+  }
+};
+
+LanguageServer::LanguageServer(std::istream &in, llvm::raw_ostream &out)
+    : in_(in), out_(out) {}
+
+LanguageServer::~LanguageServer() = default;
+
+int LanguageServer::run() {
+  std::string content;
+  while (read_message(content)) {
+    auto message = llvm::json::parse(content);
+    if (!message) {
+      reply_error(nullptr, parse_error, llvm::toString(message.takeError()));
+      continue;
+    }
+    const llvm::json::Object *object = message->getAsObject();
+    if (!object) {
+      reply_error(nullptr, parse_error, "message is not an object");
+      continue;
+    }
+    if (!handle(*object)) {
+      return shutdown_requested_ ? 0 : 1;
+    }
+  }
+  // Input closed without 'exit'
+  return 1;
+}
+
+bool LanguageServer::read_message(std::string &content) {
+  size_t length = 0;
+  bool has_length = false;
+  std::string line;
+  while (std::getline(in_, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      if (!has_length) {
+        continue;
+      }
+      content.resize(length);
+      return static_cast<bool>(in_.read(content.data(), length));
+    }
+    llvm::StringRef header(line);
+    if (header.consume_front_insensitive("Content-Length:")) {
+      has_length = !header.trim().getAsInteger(10, length);
+    }
+  }
+  return false;
+}
+
+void LanguageServer::send(llvm::json::Value message) {
+  std::string body;
+  llvm::raw_string_ostream stream(body);
+  stream << message;
+  stream.flush();
+  out_ << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+  out_.flush();
+}
+
+void LanguageServer::reply(const llvm::json::Value &id,
+                           llvm::json::Value result) {
+  send(llvm::json::Object{
+      {"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void LanguageServer::reply_error(const llvm::json::Value &id, int code,
+                                 const std::string &message) {
+  send(llvm::json::Object{
+      {"jsonrpc", "2.0"},
+      {"id", id},
+      {"error", llvm::json::Object{{"code", code},
+                                   {"message", llvm::json::fixUTF8(message)}}}});
+}
+
+void LanguageServer::notify(const std::string &method,
+                            llvm::json::Value params) {
+  send(llvm::json::Object{
+      {"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+}
+
+bool LanguageServer::handle(const llvm::json::Object &message) {
+  auto method = message.getString("method");
+  if (!method) {
+    // Responses to server requests: none are sent
+    return true;
+  }
+  // Notifications have no id
+  const llvm::json::Value *request_id = message.get("id");
+  llvm::json::Value id = request_id ? *request_id : nullptr;
+  static const llvm::json::Object no_params;
+  const llvm::json::Object *params = message.getObject("params");
+  if (!params) {
+    params = &no_params;
+  }
+
+  if (*method == "initialize") {
+    reply(id, initialize_result());
+  } else if (*method == "shutdown") {
+    shutdown_requested_ = true;
+    reply(id, nullptr);
+  } else if (*method == "exit") {
+    return false;
+  } else if (*method == "textDocument/didOpen") {
+    did_open(*params);
+  } else if (*method == "textDocument/didChange") {
+    did_change(*params);
+  } else if (*method == "textDocument/didClose") {
+    did_close(*params);
+  } else if (!request_id) {
+    // Other notifications ('initialized', '$/...') need no action
+  } else if (*method == "textDocument/hover") {
+    reply(id, hover(*params));
+  } else if (*method == "textDocument/definition") {
+    reply(id, definition(*params));
+  } else if (*method == "textDocument/semanticTokens/full") {
+    if (!find_document(*params)) {
+      reply_error(id, invalid_params, "unknown document");
+    } else {
+      reply(id, semantic_tokens(*params));
+    }
+  } else {
+    reply_error(id, method_not_found, "method not found: " + method->str());
+  }
+  return true;
+}
+
+llvm::json::Value LanguageServer::initialize_result() const {
+  llvm::json::Array types;
+  for (const char *type : token_types) {
+    types.push_back(type);
+  }
+  return llvm::json::Object{
+      {"capabilities",
+       llvm::json::Object{
+           // Incremental text synchronization
+           {"textDocumentSync",
+            llvm::json::Object{{"openClose", true}, {"change", 2}}},
+           {"hoverProvider", true},
+           {"definitionProvider", true},
+           {"semanticTokensProvider",
+            llvm::json::Object{
+                {"legend", llvm::json::Object{{"tokenTypes", std::move(types)},
+                                              {"tokenModifiers",
+                                               llvm::json::Array()}}},
+                {"full", true}}},
+       }},
+      {"serverInfo", llvm::json::Object{{"name", "plc"}}}};
+}
+
+const LanguageServer::Document *
+LanguageServer::find_document(const llvm::json::Object &params) const {
+  const llvm::json::Object *text_document = params.getObject("textDocument");
+  if (!text_document) {
+    return nullptr;
+  }
+  auto uri = text_document->getString("uri");
+  if (!uri) {
+    return nullptr;
+  }
+  auto it = documents_.find(uri->str());
+  return it == documents_.end() ? nullptr : it->second.get();
+}
+
+void LanguageServer::did_open(const llvm::json::Object &params) {
+  const llvm::json::Object *text_document = params.getObject("textDocument");
+  if (!text_document) {
+    return;
+  }
+  auto uri = text_document->getString("uri");
+  auto text = text_document->getString("text");
+  if (!uri || !text) {
+    return;
+  }
+  auto &document = documents_[uri->str()];
+  document = std::make_unique<Document>();
+  document->set_text(text->str());
+  publish_diagnostics(uri->str(), *document);
+}
+
+void LanguageServer::did_change(const llvm::json::Object &params) {
+  const llvm::json::Object *text_document = params.getObject("textDocument");
+  const llvm::json::Array *changes = params.getArray("contentChanges");
+  if (!text_document || !changes) {
+    return;
+  }
+  auto uri = text_document->getString("uri");
+  if (!uri) {
+    return;
+  }
+  auto it = documents_.find(uri->str());
+  if (it == documents_.end()) {
+    return;
+  }
+  Document &document = *it->second;
+
+  // Apply all edits, then analyze once
+  std::string text = document.text;
+  for (const auto &change_value : *changes) {
+    const llvm::json::Object *change = change_value.getAsObject();
+    if (!change) {
+      continue;
+    }
+    auto new_text = change->getString("text");
+    if (!new_text) {
+      continue;
+    }
+    const llvm::json::Object *range = change->getObject("range");
+    if (!range) {
+      text = new_text->str();
+      continue;
+    }
+    // Positions refer to the text after the previous edits
+    std::vector<size_t> line_starts = line_index(text);
+    auto offset_of = [&](const char *key) -> size_t {
+      const llvm::json::Object *pos = range->getObject(key);
+      if (!pos) {
+        return 0;
+      }
+      return byte_offset(text, line_starts, integer(*pos, "line"),
+                         integer(*pos, "character"));
+    };
+    size_t start = offset_of("start");
+    size_t end = std::max(start, offset_of("end"));
+    text.replace(start, end - start, new_text->str());
+  }
+  document.set_text(std::move(text));
+  publish_diagnostics(uri->str(), document);
+}
+
+void LanguageServer::did_close(const llvm::json::Object &params) {
+  const llvm::json::Object *text_document = params.getObject("textDocument");
+  if (!text_document) {
+    return;
+  }
+  if (auto uri = text_document->getString("uri")) {
+    documents_.erase(uri->str());
+    // Clear the document's diagnostics in the client
+    notify("textDocument/publishDiagnostics",
+           llvm::json::Object{{"uri", uri->str()},
+                              {"diagnostics", llvm::json::Array()}});
+  }
+}
+
+void LanguageServer::publish_diagnostics(const std::string &uri,
+                                         const Document &document) {
+  llvm::json::Array diagnostics;
+  for (const auto &diag : document.analysis.diagnostics()) {
+    diagnostics.push_back(llvm::json::Object{
+        {"range", document.range({diag.line, diag.column, diag.end_column})},
+        {"severity", 1},
+        {"source", "pecco"},
+        // Lexer messages may quote a partial UTF-8 sequence
+        {"message",
+         llvm::json::fixUTF8(diag.phase + " error: " + diag.message)}});
+  }
+  notify("textDocument/publishDiagnostics",
+         llvm::json::Object{{"uri", uri},
+                            {"diagnostics", std::move(diagnostics)}});
+}
+
+llvm::json::Value
+LanguageServer::hover(const llvm::json::Object &params) const {
+  const Document *document = find_document(params);
+  const llvm::json::Object *pos = params.getObject("position");
+  if (!document || !pos) {
+    return nullptr;
+  }
+  size_t line = integer(*pos, "line") + 1;
+  size_t column =
+      document->column(line, integer(*pos, "character"));
+  auto info = document->analysis.hover(line, column);
+  if (!info) {
+    return nullptr;
+  }
+  return llvm::json::Object{
+      {"contents",
+       llvm::json::Object{{"kind", "markdown"},
+                          {"value", llvm::json::fixUTF8("```pecco\n" +
+                                                        info->text +
+                                                        "\n```")}}},
+      {"range", document->range(info->range)}};
+}
+
+llvm::json::Value
+LanguageServer::definition(const llvm::json::Object &params) const {
+  const Document *document = find_document(params);
+  const llvm::json::Object *pos = params.getObject("position");
+  if (!document || !pos) {
+    return nullptr;
+  }
+  size_t line = integer(*pos, "line") + 1;
+  size_t column =
+      document->column(line, integer(*pos, "character"));
+  auto target = document->analysis.definition(line, column);
+  if (!target) {
+    return nullptr;
+  }
+  if (target->path.empty()) {
+    return llvm::json::Object{
+        {"uri", *params.getObject("textDocument")->getString("uri")},
+        {"range", document->range(target->range)}};
+  }
+  // Other files (the prelude) are ASCII: byte columns are characters
+  const SourceLocation &loc = target->range;
+  return llvm::json::Object{
+      {"uri", "file://" + target->path},
+      {"range",
+       llvm::json::Object{{"start", position(loc.line - 1, loc.column - 1)},
+                          {"end", position(loc.line - 1,
+                                           loc.end_column - 1)}}}};
+}
+
+llvm::json::Value
+LanguageServer::semantic_tokens(const llvm::json::Object &params) const {
+  const Document *document = find_document(params);
+  // Relative encoding: line delta, start delta (same line), length, type,
+  // modifiers
+  llvm::json::Array data;
+  size_t previous_line = 0;
+  size_t previous_start = 0;
+  for (const auto &tok : document->analysis.semantic_tokens()) {
+    size_t line = tok.line - 1;
+    size_t start = document->character(tok.line, tok.column);
+    size_t length =
+        document->character(tok.line, tok.column + tok.length) - start;
+    data.push_back(static_cast<int64_t>(line - previous_line));
+    data.push_back(static_cast<int64_t>(
+        line == previous_line ? start - previous_start : start));
+    data.push_back(static_cast<int64_t>(length));
+    data.push_back(static_cast<int64_t>(tok.kind));
+    data.push_back(0);
+    previous_line = line;
+    previous_start = start;
+  }
+  return llvm::json::Object{{"data", std::move(data)}};
+}
+
+} // namespace pecco
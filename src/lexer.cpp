@@ -237,11 +237,45 @@ Token Lexer::lex_number() {
     break;
   }
 
+  // Integer type suffix: 255u8, 1i64
+  if (!saw_dot && !saw_exponent && (peek() == 'i' || peek() == 'u') &&
+      index_ + 1 < source_.size() &&
+      std::isdigit(static_cast<unsigned char>(source_[index_ + 1]))) {
+    std::size_t suffix_start = index_;
+    while (!at_end() && is_identifier_part(peek())) {
+      advance();
+    }
+    std::string suffix = source_.substr(suffix_start, index_ - suffix_start);
+    if (suffix != "i8" && suffix != "i16" && suffix != "i32" &&
+        suffix != "i64" && suffix != "u8" && suffix != "u16" &&
+        suffix != "u32" && suffix != "u64") {
+      return make_error("Invalid integer suffix: " + suffix, start_line,
+                        start_column, column_, suffix_start - start_index);
+    }
+  }
+
+  // Float type suffix: 1.5f32, 2f32
+  bool float_suffix = false;
+  if (peek() == 'f' && index_ + 1 < source_.size() &&
+      std::isdigit(static_cast<unsigned char>(source_[index_ + 1]))) {
+    std::size_t suffix_start = index_;
+    while (!at_end() && is_identifier_part(peek())) {
+      advance();
+    }
+    std::string suffix = source_.substr(suffix_start, index_ - suffix_start);
+    if (suffix != "f32" && suffix != "f64") {
+      return make_error("Invalid float suffix: " + suffix, start_line,
+                        start_column, column_, suffix_start - start_index);
+    }
+    float_suffix = true;
+  }
+
   std::string_view number_view =
       std::string_view(source_).substr(start_index, index_ - start_index);
 
   Token tok;
-  tok.kind = (saw_dot || saw_exponent) ? TokenKind::Float : TokenKind::Integer;
+  tok.kind = (saw_dot || saw_exponent || float_suffix) ? TokenKind::Float
+                                                       : TokenKind::Integer;
   tok.lexeme = std::string(number_view);
   tok.line = start_line;
   tok.column = start_column;
@@ -0,0 +1,232 @@
+#include "object_cache.hpp"
+
+#include "runtime_symbols.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <set>
+
+namespace pecco {
+
+namespace {
+
+// Globals used by a constant operand, looking through constant expressions
+void collect_globals(llvm::Constant *constant,
+                     std::vector<llvm::GlobalValue *> &globals,
+                     std::set<llvm::Constant *> &seen) {
+  if (!seen.insert(constant).second) {
+    return;
+  }
+  if (auto *global = llvm::dyn_cast<llvm::GlobalValue>(constant)) {
+    globals.push_back(global);
+    return;
+  }
+  for (llvm::Value *operand : constant->operands()) {
+    if (auto *nested = llvm::dyn_cast<llvm::Constant>(operand)) {
+      collect_globals(nested, globals, seen);
+    }
+  }
+}
+
+// Functions and variables referenced by a function, in order of first use
+std::vector<llvm::GlobalValue *> referenced_globals(llvm::Function &function) {
+  std::vector<llvm::GlobalValue *> globals;
+  std::set<llvm::Constant *> seen;
+  for (llvm::Instruction &inst : llvm::instructions(function)) {
+    for (llvm::Value *operand : inst.operands()) {
+      if (auto *constant = llvm::dyn_cast<llvm::Constant>(operand)) {
+        collect_globals(constant, globals, seen);
+      }
+    }
+  }
+  return globals;
+}
+
+// Module with a copy of one function. Referenced functions are declared;
+// local constants (string literals) are copied under names that do not
+// depend on the rest of the program, so the printed module only changes
+// when the function or the signatures it uses change.
+std::unique_ptr<llvm::Module> extract(llvm::Function &function) {
+  const llvm::Module &source = *function.getParent();
+  auto module = std::make_unique<llvm::Module>(function.getName(),
+                                               function.getContext());
+  module->setDataLayout(source.getDataLayout());
+  module->setTargetTriple(source.getTargetTriple());
+
+  llvm::ValueToValueMapTy values;
+  size_t constants = 0;
+  for (llvm::GlobalValue *global : referenced_globals(function)) {
+    if (global == &function) {
+      continue;
+    }
+    if (auto *callee = llvm::dyn_cast<llvm::Function>(global)) {
+      auto *declaration = llvm::Function::Create(
+          callee->getFunctionType(), llvm::GlobalValue::ExternalLinkage,
+          callee->getName(), *module);
+      declaration->copyAttributesFrom(callee);
+      values[callee] = declaration;
+    } else if (auto *variable = llvm::dyn_cast<llvm::GlobalVariable>(global)) {
+      bool local = variable->hasLocalLinkage();
+      auto *copy = new llvm::GlobalVariable(
+          *module, variable->getValueType(), variable->isConstant(),
+          local ? variable->getLinkage() : llvm::GlobalValue::ExternalLinkage,
+          local ? variable->getInitializer() : nullptr,
+          local ? "const." + std::to_string(constants++)
+                : variable->getName().str());
+      copy->copyAttributesFrom(variable);
+      values[variable] = copy;
+    }
+  }
+
+  auto *copy =
+      llvm::Function::Create(function.getFunctionType(), function.getLinkage(),
+                             function.getName(), *module);
+  copy->copyAttributesFrom(&function);
+  values[&function] = copy;
+  auto arg = copy->arg_begin();
+  for (llvm::Argument &param : function.args()) {
+    arg->setName(param.getName());
+    values[&param] = &*arg++;
+  }
+  llvm::SmallVector<llvm::ReturnInst *, 4> returns;
+  llvm::CloneFunctionInto(copy, &function, values,
+                          llvm::CloneFunctionChangeType::DifferentModule,
+                          returns);
+  return module;
+}
+
+// Module defining the mutable global variables (top-level arrays), which
+// the per-function modules only declare
+std::unique_ptr<llvm::Module>
+extract_variables(const llvm::Module &source,
+                  const std::vector<llvm::GlobalVariable *> &variables) {
+  auto module =
+      std::make_unique<llvm::Module>("variables", source.getContext());
+  module->setDataLayout(source.getDataLayout());
+  module->setTargetTriple(source.getTargetTriple());
+  for (llvm::GlobalVariable *variable : variables) {
+    auto *copy = new llvm::GlobalVariable(
+        *module, variable->getValueType(), false,
+        llvm::GlobalValue::ExternalLinkage, variable->getInitializer(),
+        variable->getName());
+    copy->copyAttributesFrom(variable);
+  }
+  return module;
+}
+
+} // namespace
+
+ObjectCache::ObjectCache(llvm::TargetMachine &target_machine,
+                         std::string directory)
+    : target_machine_(target_machine), directory_(std::move(directory)) {}
+
+ObjectCache::~ObjectCache() {
+  for (const auto &[key, path] : objects_) {
+    llvm::sys::fs::remove(path);
+  }
+}
+
+bool ObjectCache::update(llvm::Module &module,
+                         std::vector<std::string> &objects,
+                         std::string &error) {
+  stats_ = {};
+  objects.clear();
+  module.setTargetTriple(target_machine_.getTargetTriple().str());
+  module.setDataLayout(target_machine_.createDataLayout());
+
+  // Every definition lands in another object file: local functions must be
+  // visible to the linker
+  for (llvm::Function &function : module) {
+    if (!function.isDeclaration() && function.hasLocalLinkage()) {
+      function.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    }
+  }
+  // So must the mutable variables: they get one object file for all of them
+  std::vector<llvm::GlobalVariable *> variables;
+  for (llvm::GlobalVariable &variable : module.globals()) {
+    if (!variable.isConstant() && !variable.isDeclaration()) {
+      variable.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      variables.push_back(&variable);
+    }
+  }
+
+  std::vector<std::unique_ptr<llvm::Module>> parts;
+  for (llvm::Function &function : module) {
+    if (!function.isDeclaration()) {
+      ++stats_.definitions;
+      parts.push_back(extract(function));
+    }
+  }
+  if (!variables.empty()) {
+    parts.push_back(extract_variables(module, variables));
+  }
+
+  std::unordered_map<std::string, std::string> current;
+  bool ok = true;
+  for (auto &part : parts) {
+    std::string key;
+    llvm::raw_string_ostream stream(key);
+    part->print(stream, nullptr);
+    stream.flush();
+
+    std::string path;
+    auto cached = objects_.find(key);
+    if (cached != objects_.end()) {
+      path = cached->second;
+    } else {
+      path = directory_ + "/" + std::to_string(next_object_++) + ".o";
+      if (!emit(*part, path, error)) {
+        ok = false;
+        break;
+      }
+      ++stats_.compiled;
+    }
+    objects.push_back(path);
+    current.emplace(std::move(key), std::move(path));
+  }
+
+  if (!ok) {
+    // Keep track of what was built so far, for reuse and cleanup
+    objects_.insert(current.begin(), current.end());
+    objects.clear();
+    return false;
+  }
+
+  // Drop the objects of functions that changed or disappeared
+  for (const auto &[key, path] : objects_) {
+    if (!current.count(key)) {
+      llvm::sys::fs::remove(path);
+    }
+  }
+  objects_ = std::move(current);
+  return true;
+}
+
+bool ObjectCache::emit(llvm::Module &module, const std::string &path,
+                       std::string &error) {
+  std::error_code ec;
+  llvm::raw_fd_ostream dest(path, ec, llvm::sys::fs::OF_None);
+  if (ec) {
+    error = "cannot write '" + path + "': " + ec.message();
+    return false;
+  }
+
+  bind_runtime_symbols(module);
+  llvm::legacy::PassManager pass;
+  if (target_machine_.addPassesToEmitFile(pass, dest, nullptr,
+                                          llvm::CodeGenFileType::ObjectFile)) {
+    error = "target machine cannot emit object files";
+    return false;
+  }
+  pass.run(module);
+  dest.flush();
+  return true;
+}
+
+} // namespace pecco
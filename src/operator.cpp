@@ -45,4 +45,20 @@ bool OperatorTable::has_operator(const std::string &op,
   return operators_.find(key) != operators_.end();
 }
 
+std::string mangle_operator_name(const std::string &op, OpPosition position,
+                                 const std::vector<std::string> &param_types) {
+  std::string mangled = op;
+  if (param_types.size() == 1) {
+    if (position == OpPosition::Prefix) {
+      mangled += "$prefix";
+    } else if (position == OpPosition::Postfix) {
+      mangled += "$postfix";
+    }
+  }
+  for (const auto &type : param_types) {
+    mangled += "$" + type;
+  }
+  return mangled;
+}
+
 } // namespace pecco
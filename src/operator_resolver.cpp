@@ -25,6 +25,13 @@ ExprPtr OperatorResolver::resolve_expr(ExprPtr expr,
     return expr;
   }
 
+  case ExprKind::Index: {
+    auto *index = static_cast<IndexExpr *>(expr.get());
+    index->base = resolve_expr(std::move(index->base), symbol_table, errors);
+    index->index = resolve_expr(std::move(index->index), symbol_table, errors);
+    return expr;
+  }
+
   // Literals and identifiers don't need resolution
   default:
     return expr;
@@ -120,10 +127,12 @@ OperatorResolver::resolve_operator_seq(const OperatorSeqExpr *seq,
     switch (operand->kind) {
     case ExprKind::IntLiteral:
       return std::make_unique<IntLiteralExpr>(
-          static_cast<const IntLiteralExpr *>(operand)->value, operand->loc);
+          static_cast<const IntLiteralExpr *>(operand)->value, operand->loc,
+          static_cast<const IntLiteralExpr *>(operand)->type);
     case ExprKind::FloatLiteral:
       return std::make_unique<FloatLiteralExpr>(
-          static_cast<const FloatLiteralExpr *>(operand)->value, operand->loc);
+          static_cast<const FloatLiteralExpr *>(operand)->value, operand->loc,
+          static_cast<const FloatLiteralExpr *>(operand)->type);
     case ExprKind::StringLiteral:
       return std::make_unique<StringLiteralExpr>(
           static_cast<const StringLiteralExpr *>(operand)->value, operand->loc);
@@ -148,6 +157,12 @@ OperatorResolver::resolve_operator_seq(const OperatorSeqExpr *seq,
       return std::make_unique<CallExpr>(std::move(cloned_callee),
                                         std::move(cloned_args), operand->loc);
     }
+    case ExprKind::Index: {
+      auto *index = static_cast<const IndexExpr *>(operand);
+      return std::make_unique<IndexExpr>(clone_operand(index->base.get()),
+                                         clone_operand(index->index.get()),
+                                         operand->loc);
+    }
     default:
       error("Cannot clone expression of type " +
                 std::to_string(static_cast<int>(operand->kind)),
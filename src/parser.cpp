@@ -1,11 +1,17 @@
 #include "parser.hpp"
+#include <algorithm>
+#include <atomic>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
 namespace pecco {
 
 Parser::Parser(std::vector<Token> tokens)
     : tokens_(std::move(tokens)), current_(0) {}
 
+Parser::Parser(TokenStream &stream) : current_(0), stream_(&stream) {}
+
 std::vector<StmtPtr> Parser::parse_program() {
   std::vector<StmtPtr> stmts;
   const size_t MAX_ERRORS = 10; // Prevent infinite error loops
@@ -20,10 +26,119 @@ std::vector<StmtPtr> Parser::parse_program() {
     } else {
       synchronize();
     }
+    discard_consumed();
   }
   return stmts;
 }
 
+std::vector<StmtPtr> Parser::parse_program_parallel(unsigned jobs) {
+  bool open = false;
+  auto ranges = split_top_level(tokens_, &open);
+  // A few chunks per job, so that uneven statements balance out
+  size_t chunk_count = std::min<size_t>(ranges.size(), size_t(jobs) * 4);
+  if (jobs <= 1 || chunk_count < 2 || open || current_ != 0 || stream_) {
+    return parse_program();
+  }
+
+  // Consecutive statements of about the same number of tokens per chunk
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t total = ranges.back().second;
+  size_t begin = 0;
+  for (const auto &range : ranges) {
+    if (range.second * chunk_count >= (chunks.size() + 1) * total) {
+      chunks.emplace_back(begin, range.second);
+      begin = range.second;
+    }
+  }
+  if (begin < total) {
+    chunks.emplace_back(begin, total);
+  }
+
+  std::vector<std::vector<StmtPtr>> results(chunks.size());
+  std::vector<char> failed(chunks.size(), 0);
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t i; (i = next++) < chunks.size();) {
+      auto [from, to] = chunks[i];
+      std::vector<Token> tokens(tokens_.begin() + from, tokens_.begin() + to);
+      Token eof;
+      eof.line = to < tokens_.size() ? tokens_[to].line : tokens.back().line;
+      eof.column = to < tokens_.size() ? tokens_[to].column : 1;
+      tokens.push_back(eof);
+      Parser parser(std::move(tokens));
+      results[i] = parser.parse_program();
+      failed[i] = parser.has_errors();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min<size_t>(jobs, chunks.size()); ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+    return parse_program();
+  }
+  std::vector<StmtPtr> stmts;
+  for (auto &result : results) {
+    std::move(result.begin(), result.end(), std::back_inserter(stmts));
+  }
+  current_ = total;
+  return stmts;
+}
+
+std::vector<std::pair<size_t, size_t>>
+Parser::split_top_level(const std::vector<Token> &tokens, bool *open) {
+  std::vector<std::pair<size_t, size_t>> ranges;
+  size_t begin = 0;
+  int depth = 0;
+  size_t count = tokens.size();
+  if (count > 0 && tokens.back().kind == TokenKind::EndOfFile) {
+    --count;
+  }
+  auto next_significant = [&](size_t i) {
+    while (i < count && tokens[i].kind == TokenKind::Comment) {
+      ++i;
+    }
+    return i;
+  };
+
+  for (size_t i = 0; i < count; ++i) {
+    const Token &tok = tokens[i];
+    bool end = false;
+    if (tok.kind == TokenKind::Punctuation) {
+      if (tok.lexeme == "(" || tok.lexeme == "[" || tok.lexeme == "{") {
+        ++depth;
+      } else if (tok.lexeme == ")" || tok.lexeme == "]") {
+        depth = std::max(depth - 1, 0);
+      } else if (tok.lexeme == "}") {
+        depth = std::max(depth - 1, 0);
+        if (depth == 0) {
+          size_t next = next_significant(i + 1);
+          end = next >= count || tokens[next].kind != TokenKind::Keyword ||
+                tokens[next].lexeme != "else";
+        }
+      } else if (tok.lexeme == ";") {
+        end = depth == 0;
+      }
+    }
+    if (end) {
+      ranges.emplace_back(begin, i + 1);
+      begin = i + 1;
+    }
+  }
+  if (open) {
+    *open = next_significant(begin) < count;
+  }
+  if (begin < count) {
+    ranges.emplace_back(begin, count);
+  }
+  return ranges;
+}
+
 // ===== Statement Parsing =====
 
 StmtPtr Parser::parse_stmt() {
@@ -80,17 +195,21 @@ StmtPtr Parser::parse_let_stmt() {
     }
   }
 
-  // Expect '='
-  if (!check(TokenKind::Operator) || peek().lexeme != "=") {
-    error("Expected '=' in let statement");
-    return nullptr;
-  }
-  advance(); // consume '='
+  // A declaration with a type may omit the initializer (arrays start zeroed)
+  ExprPtr init;
+  if (!type || !check(TokenKind::Punctuation) || peek().lexeme != ";") {
+    // Expect '='
+    if (!check(TokenKind::Operator) || peek().lexeme != "=") {
+      error("Expected '=' in let statement");
+      return nullptr;
+    }
+    advance(); // consume '='
 
-  auto init = parse_expr();
-  if (!init) {
-    error("Expected expression after '='");
-    return nullptr;
+    init = parse_expr();
+    if (!init) {
+      error("Expected expression after '='");
+      return nullptr;
+    }
   }
 
   // Expect ';' - but still return the statement even if missing
@@ -550,12 +669,26 @@ ExprPtr Parser::parse_primary_expr() {
   // Literals
   if (tok.kind == TokenKind::Integer) {
     advance();
-    return std::make_unique<IntLiteralExpr>(tok.lexeme, token_loc(tok));
+    // The lexer only accepts valid type suffixes (255u8)
+    size_t digits = tok.lexeme.find_first_not_of("0123456789");
+    if (digits == std::string::npos) {
+      return std::make_unique<IntLiteralExpr>(tok.lexeme, token_loc(tok));
+    }
+    return std::make_unique<IntLiteralExpr>(tok.lexeme.substr(0, digits),
+                                            token_loc(tok),
+                                            tok.lexeme.substr(digits));
   }
 
   if (tok.kind == TokenKind::Float) {
     advance();
-    return std::make_unique<FloatLiteralExpr>(tok.lexeme, token_loc(tok));
+    // Exponents use 'e', so an 'f' always starts the type suffix (1.5f32)
+    size_t suffix = tok.lexeme.find('f');
+    if (suffix == std::string::npos) {
+      return std::make_unique<FloatLiteralExpr>(tok.lexeme, token_loc(tok));
+    }
+    return std::make_unique<FloatLiteralExpr>(tok.lexeme.substr(0, suffix),
+                                              token_loc(tok),
+                                              tok.lexeme.substr(suffix));
   }
 
   if (tok.kind == TokenKind::String) {
@@ -577,13 +710,18 @@ ExprPtr Parser::parse_primary_expr() {
   // Identifier
   if (tok.kind == TokenKind::Identifier) {
     advance();
-    auto expr = std::make_unique<IdentifierExpr>(tok.lexeme, token_loc(tok));
+    ExprPtr expr = std::make_unique<IdentifierExpr>(tok.lexeme, token_loc(tok));
 
     // Check for function call
     if (check(TokenKind::Punctuation) && peek().lexeme == "(") {
       return parse_call_expr(std::move(expr));
     }
 
+    // Array indexing, possibly repeated: m[i][j]
+    while (expr && check(TokenKind::Punctuation) && peek().lexeme == "[") {
+      expr = parse_index_expr(std::move(expr));
+    }
+
     return expr;
   }
 
@@ -639,9 +777,62 @@ ExprPtr Parser::parse_call_expr(ExprPtr callee) {
                                     token_loc(start_tok));
 }
 
+ExprPtr Parser::parse_index_expr(ExprPtr base) {
+  Token start_tok = peek();
+  advance(); // consume '['
+
+  auto index = parse_expr();
+  if (!index) {
+    error("Expected index expression after '['");
+    return nullptr;
+  }
+
+  if (!check(TokenKind::Punctuation) || peek().lexeme != "]") {
+    error("Expected ']' after index");
+    return nullptr;
+  }
+  advance(); // consume ']'
+
+  return std::make_unique<IndexExpr>(std::move(base), std::move(index),
+                                     token_loc(start_tok));
+}
+
 // ===== Type Parsing =====
 
 std::optional<TypePtr> Parser::parse_type_annotation() {
+  // Array type: [N]T
+  if (check(TokenKind::Punctuation) && peek().lexeme == "[") {
+    Token tok = advance(); // consume '['
+    if (!check(TokenKind::Integer)) {
+      error("Expected array length after '['");
+      return std::nullopt;
+    }
+    Token size_tok = advance();
+    size_t size = 0;
+    try {
+      // A length has no type suffix
+      if (size_tok.lexeme.find_first_not_of("0123456789") ==
+          std::string::npos) {
+        size = std::stoull(size_tok.lexeme);
+      }
+    } catch (const std::out_of_range &) {
+    }
+    if (size == 0 || size > kMaxArrayLength) {
+      error("Invalid array length: " + size_tok.lexeme);
+      return std::nullopt;
+    }
+    if (!check(TokenKind::Punctuation) || peek().lexeme != "]") {
+      error("Expected ']' after array length");
+      return std::nullopt;
+    }
+    advance(); // consume ']'
+    auto element = parse_type_annotation();
+    if (!element) {
+      return std::nullopt;
+    }
+    return std::make_unique<Type>(std::move(*element), size, token_loc(tok));
+  }
+
   if (!check(TokenKind::Identifier)) {
     error("Expected type name");
     return std::nullopt;
@@ -656,7 +847,7 @@ std::optional<TypePtr> Parser::parse_type_annotation() {
 Token Parser::peek() const {
   // Skip comments
   size_t idx = current_;
-  while (idx < tokens_.size() && tokens_[idx].kind == TokenKind::Comment) {
+  while (has_token(idx) && tokens_[idx].kind == TokenKind::Comment) {
     ++idx;
   }
 
@@ -668,12 +859,11 @@ Token Parser::peek() const {
 
 Token Parser::advance() {
   // Skip comments before advancing
-  while (current_ < tokens_.size() &&
-         tokens_[current_].kind == TokenKind::Comment) {
+  while (has_token(current_) && tokens_[current_].kind == TokenKind::Comment) {
     ++current_;
   }
 
-  if (current_ < tokens_.size()) {
+  if (has_token(current_)) {
     ++current_;
   }
 
@@ -729,7 +919,7 @@ bool Parser::expect_keyword(const std::string &keyword,
 bool Parser::at_end() const {
   // Skip comments to check if we're at end
   size_t idx = current_;
-  while (idx < tokens_.size() && tokens_[idx].kind == TokenKind::Comment) {
+  while (has_token(idx) && tokens_[idx].kind == TokenKind::Comment) {
     ++idx;
   }
 
@@ -737,6 +927,23 @@ bool Parser::at_end() const {
          (idx < tokens_.size() && tokens_[idx].kind == TokenKind::EndOfFile);
 }
 
+bool Parser::has_token(size_t idx) const {
+  while (idx >= tokens_.size() && stream_ && stream_->next_batch(tokens_)) {
+  }
+  return idx < tokens_.size();
+}
+
+void Parser::discard_consumed() {
+  // Keep the previous token for error_at_previous_end(); erase only once
+  // the consumed part outweighs the rest, so that moving the remaining
+  // tokens stays amortized constant per token
+  if (!stream_ || current_ < 2 || current_ * 2 < tokens_.size()) {
+    return;
+  }
+  tokens_.erase(tokens_.begin(), tokens_.begin() + (current_ - 1));
+  current_ = 1;
+}
+
 bool Parser::can_start_primary() const {
   if (at_end())
     return false;
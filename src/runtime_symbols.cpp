@@ -0,0 +1,39 @@
+#include "runtime_symbols.hpp"
+
+namespace pecco {
+
+namespace {
+
+struct RuntimeSymbol {
+  const char *prelude_name;
+  const char *symbol;
+};
+
+constexpr RuntimeSymbol kRuntimeSymbols[] = {
+    {"print", "__pecco_rt_print"},
+    {"print_i32", "__pecco_rt_print_i32"},
+    {"print_i64", "__pecco_rt_print_i64"},
+    {"print_u64", "__pecco_rt_print_u64"},
+    {"print_f64", "__pecco_rt_print_f64"},
+    {"flush", "__pecco_rt_flush"},
+};
+
+} // namespace
+
+void bind_runtime_symbols(llvm::Module &module) {
+  for (const RuntimeSymbol &entry : kRuntimeSymbols) {
+    llvm::Function *function = module.getFunction(entry.prelude_name);
+    if (!function || !function->isDeclaration()) {
+      continue;
+    }
+    // The driver's main wrapper already declares __pecco_rt_flush
+    if (llvm::Function *existing = module.getFunction(entry.symbol)) {
+      function->replaceAllUsesWith(existing);
+      function->eraseFromParent();
+    } else {
+      function->setName(entry.symbol);
+    }
+  }
+}
+
+} // namespace pecco
@@ -80,10 +80,9 @@ void ScopeChecker::check_func(const FuncStmt *func,
   for (const auto &param : func->params) {
     std::string type_name;
     if (param.type) {
-      // Type is a unique_ptr<Type>, access through get()
-      if (param.type->get()->kind == TypeKind::Named) {
-        type_name = param.type->get()->name;
-      }
+      // Type is a unique_ptr<Type>, access through get(); array types are
+      // named by their "[N]T" spelling
+      type_name = param.type->get()->name;
     }
     symbols.add_variable(VariableBinding(param.name, type_name, func->loc.line,
                                          func->loc.column));
@@ -129,9 +128,7 @@ void ScopeChecker::check_let(const LetStmt *let, ScopedSymbolTable &symbols) {
   // Add variable to current scope
   std::string type_name;
   if (let->type) {
-    if (let->type->get()->kind == TypeKind::Named) {
-      type_name = let->type->get()->name;
-    }
+    type_name = let->type->get()->name;
   }
   symbols.add_variable(
       VariableBinding(let->name, type_name, let->loc.line, let->loc.column));
@@ -164,6 +161,10 @@ void ScopeChecker::check_expr(const Expr *expr, ScopedSymbolTable &symbols) {
   } else if (expr->kind == ExprKind::Unary) {
     auto *unary = static_cast<const UnaryExpr *>(expr);
     check_expr(unary->operand.get(), symbols);
+  } else if (expr->kind == ExprKind::Index) {
+    auto *index = static_cast<const IndexExpr *>(expr);
+    check_expr(index->base.get(), symbols);
+    check_expr(index->index.get(), symbols);
   } else if (expr->kind == ExprKind::OperatorSeq) {
     auto *seq = static_cast<const OperatorSeqExpr *>(expr);
     for (const auto &item : seq->items) {
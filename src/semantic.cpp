@@ -146,6 +146,7 @@ std::string SemanticAnalyzer::get_type_name(const Type *type) const {
 
   switch (type->kind) {
   case TypeKind::Named:
+  case TypeKind::Array: // Canonical "[N]T" spelling
     return type->name;
   default:
     return "";
@@ -177,6 +178,13 @@ ExprPtr SemanticAnalyzer::resolve_operators(ExprPtr expr) {
     return expr;
   }
 
+  case ExprKind::Index: {
+    auto *index = static_cast<IndexExpr *>(expr.get());
+    index->base = resolve_operators(std::move(index->base));
+    index->index = resolve_operators(std::move(index->index));
+    return expr;
+  }
+
   // Literals and identifiers don't need resolution
   default:
     return expr;
@@ -190,10 +198,12 @@ ExprPtr SemanticAnalyzer::resolve_operator_seq(const OperatorSeqExpr *seq) {
     switch (operand->kind) {
     case ExprKind::IntLiteral:
       return std::make_unique<IntLiteralExpr>(
-          static_cast<const IntLiteralExpr *>(operand)->value, operand->loc);
+          static_cast<const IntLiteralExpr *>(operand)->value, operand->loc,
+          static_cast<const IntLiteralExpr *>(operand)->type);
     case ExprKind::FloatLiteral:
       return std::make_unique<FloatLiteralExpr>(
-          static_cast<const FloatLiteralExpr *>(operand)->value, operand->loc);
+          static_cast<const FloatLiteralExpr *>(operand)->value, operand->loc,
+          static_cast<const FloatLiteralExpr *>(operand)->type);
     case ExprKind::StringLiteral:
       return std::make_unique<StringLiteralExpr>(
           static_cast<const StringLiteralExpr *>(operand)->value, operand->loc);
@@ -218,6 +228,12 @@ ExprPtr SemanticAnalyzer::resolve_operator_seq(const OperatorSeqExpr *seq) {
       return std::make_unique<CallExpr>(std::move(cloned_callee),
                                         std::move(cloned_args), operand->loc);
     }
+    case ExprKind::Index: {
+      auto *index = static_cast<const IndexExpr *>(operand);
+      return std::make_unique<IndexExpr>(clone_operand(index->base.get()),
+                                         clone_operand(index->index.get()),
+                                         operand->loc);
+    }
     default:
       error("Cannot clone expression of type " +
                 std::to_string(static_cast<int>(operand->kind)),
@@ -0,0 +1,456 @@
+#include "semantic_queries.hpp"
+
+#include "operator_resolver.hpp"
+#include "symbol_table_builder.hpp"
+#include "type_checker.hpp"
+
+#include <set>
+#include <unordered_map>
+
+namespace pecco {
+
+namespace {
+
+enum class Phase { None, Syntax, Resolved, Checked };
+
+std::string type_name(const std::optional<TypePtr> &type) {
+  return type ? (*type)->name : "";
+}
+
+std::string signature_text(const std::vector<std::string> &param_types,
+                           const std::string &return_type) {
+  std::string text = "(";
+  for (size_t i = 0; i < param_types.size(); ++i) {
+    text += (i ? ", " : "") + param_types[i];
+  }
+  return text + ") : " + return_type;
+}
+
+std::vector<std::string> param_types(const std::vector<Parameter> &params) {
+  std::vector<std::string> types;
+  for (const auto &param : params) {
+    types.push_back(type_name(param.type));
+  }
+  return types;
+}
+
+// Names a statement refers to: called functions and other identifiers
+struct References {
+  std::set<std::string> calls;
+  std::set<std::string> identifiers;
+
+  void visit(const Stmt *stmt) {
+    if (!stmt) {
+      return;
+    }
+    switch (stmt->kind) {
+    case StmtKind::Let:
+      visit(static_cast<const LetStmt *>(stmt)->init.get());
+      break;
+    case StmtKind::Func: {
+      auto *func = static_cast<const FuncStmt *>(stmt);
+      if (func->body) {
+        visit(func->body->get());
+      }
+      break;
+    }
+    case StmtKind::OperatorDecl: {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt);
+      if (op->body) {
+        visit(op->body->get());
+      }
+      break;
+    }
+    case StmtKind::If: {
+      auto *if_stmt = static_cast<const IfStmt *>(stmt);
+      visit(if_stmt->condition.get());
+      visit(if_stmt->then_branch.get());
+      if (if_stmt->else_branch) {
+        visit(if_stmt->else_branch->get());
+      }
+      break;
+    }
+    case StmtKind::While: {
+      auto *while_stmt = static_cast<const WhileStmt *>(stmt);
+      visit(while_stmt->condition.get());
+      visit(while_stmt->body.get());
+      break;
+    }
+    case StmtKind::Return: {
+      auto *ret = static_cast<const ReturnStmt *>(stmt);
+      if (ret->value) {
+        visit(ret->value->get());
+      }
+      break;
+    }
+    case StmtKind::Expr:
+      visit(static_cast<const ExprStmt *>(stmt)->expr.get());
+      break;
+    case StmtKind::Block:
+      for (const auto &child : static_cast<const BlockStmt *>(stmt)->stmts) {
+        visit(child.get());
+      }
+      break;
+    }
+  }
+
+  void visit(const Expr *expr) {
+    if (!expr) {
+      return;
+    }
+    switch (expr->kind) {
+    case ExprKind::Identifier:
+      identifiers.insert(static_cast<const IdentifierExpr *>(expr)->name);
+      break;
+    case ExprKind::Call: {
+      auto *call = static_cast<const CallExpr *>(expr);
+      if (call->callee->kind == ExprKind::Identifier) {
+        calls.insert(static_cast<const IdentifierExpr *>(call->callee.get())->name);
+      } else {
+        visit(call->callee.get());
+      }
+      for (const auto &arg : call->args) {
+        visit(arg.get());
+      }
+      break;
+    }
+    case ExprKind::Binary: {
+      auto *binary = static_cast<const BinaryExpr *>(expr);
+      visit(binary->left.get());
+      visit(binary->right.get());
+      break;
+    }
+    case ExprKind::Unary:
+      visit(static_cast<const UnaryExpr *>(expr)->operand.get());
+      break;
+    case ExprKind::Index: {
+      auto *index = static_cast<const IndexExpr *>(expr);
+      visit(index->base.get());
+      visit(index->index.get());
+      break;
+    }
+    case ExprKind::OperatorSeq:
+      for (const auto &item : static_cast<const OperatorSeqExpr *>(expr)->items) {
+        visit(item.operand.get());
+      }
+      break;
+    default:
+      break;
+    }
+  }
+};
+
+} // namespace
+
+struct SemanticQueries::Statement {
+  std::string key;
+  Parse parse;
+
+  // The AST and how far it has been analyzed
+  std::vector<StmtPtr> stmts;
+  Phase phase = Phase::None;
+
+  // From the first parse: declarations and top-level variables
+  bool scanned = false;
+  std::vector<FunctionSignature> functions;
+  std::vector<OperatorInfo> operators;
+  std::string function_text; // Canonical text of the above, for
+  std::string operator_text; // detecting declaration changes
+  std::vector<std::pair<std::string, std::string>> lets; // Name, declared type
+
+  // Resolution: the operator table it used and the scopes it collected
+  std::string operators_used;
+  std::unique_ptr<ScopedSymbolTable> symbols;
+  bool resolve_ok = false;
+  std::vector<Diagnostic> resolve_diagnostics;
+
+  // Checking: dependency -> its value when the statement was checked
+  std::map<std::string, std::string> dependencies;
+  size_t verified = 0;
+  std::vector<Diagnostic> diagnostics; // Resolution and type diagnostics
+};
+
+SemanticQueries::SemanticQueries(std::shared_ptr<const SymbolTable> prelude)
+    : prelude_(std::move(prelude)) {}
+
+SemanticQueries::~SemanticQueries() = default;
+
+void SemanticQueries::update(
+    std::vector<std::pair<std::string, Parse>> statements) {
+  ++revision_;
+  stats_ = {};
+
+  std::unordered_map<std::string, std::unique_ptr<Statement>> previous;
+  for (auto &statement : statements_) {
+    std::string key = statement->key;
+    previous.emplace(std::move(key), std::move(statement));
+  }
+  statements_.clear();
+  for (auto &[key, parse] : statements) {
+    std::unique_ptr<Statement> statement;
+    auto found = previous.find(key);
+    if (found != previous.end()) {
+      statement = std::move(found->second);
+    } else {
+      statement = std::make_unique<Statement>();
+      statement->key = key;
+    }
+    statement->parse = std::move(parse);
+    statements_.push_back(std::move(statement));
+  }
+}
+
+void SemanticQueries::parse(Statement &statement) {
+  ++stats_.parsed;
+  statement.stmts = statement.parse();
+  statement.phase = Phase::Syntax;
+  if (statement.scanned) {
+    return;
+  }
+
+  statement.scanned = true;
+  for (const auto &stmt : statement.stmts) {
+    if (stmt->kind == StmtKind::Func) {
+      auto *func = static_cast<const FuncStmt *>(stmt.get());
+      FunctionSignature sig(func->name, param_types(func->params),
+                            type_name(func->return_type), !func->body);
+      statement.function_text += "func " + sig.name +
+                                 signature_text(sig.param_types,
+                                                sig.return_type) +
+                                 (func->body ? "{}" : ";");
+      statement.functions.push_back(std::move(sig));
+    } else if (stmt->kind == StmtKind::OperatorDecl) {
+      auto *op = static_cast<const OperatorDeclStmt *>(stmt.get());
+      OperatorSignature sig(param_types(op->params),
+                            type_name(op->return_type));
+      statement.operator_text +=
+          "operator " + std::to_string(static_cast<int>(op->position)) +
+          op->op + " " + std::to_string(op->precedence) + " " +
+          std::to_string(static_cast<int>(op->assoc)) +
+          signature_text(sig.param_types, sig.return_type) + ";";
+      statement.operators.emplace_back(op->op, op->position, op->precedence,
+                                       op->assoc, sig);
+    } else if (stmt->kind == StmtKind::Let) {
+      auto *let = static_cast<const LetStmt *>(stmt.get());
+      statement.lets.emplace_back(let->name, type_name(let->type));
+    }
+  }
+}
+
+std::shared_ptr<const SymbolTable> SemanticQueries::declarations() {
+  if (declaration_table_ && declarations_revision_ == revision_) {
+    return declaration_table_;
+  }
+  declarations_revision_ = revision_;
+
+  std::string functions;
+  std::string operators;
+  for (auto &statement : statements_) {
+    if (!statement->scanned) {
+      parse(*statement);
+    }
+    functions += statement->function_text;
+    operators += statement->operator_text;
+  }
+  std::string key = functions + operators;
+  if (declaration_table_ && key == declarations_key_) {
+    return declaration_table_;
+  }
+
+  ++stats_.declarations;
+  auto table = std::make_shared<SymbolTable>(prelude_);
+  for (const auto &statement : statements_) {
+    for (const auto &sig : statement->functions) {
+      table->add_function(sig);
+    }
+    for (const auto &info : statement->operators) {
+      table->add_operator(info);
+    }
+  }
+  declaration_table_ = std::move(table);
+  declarations_key_ = std::move(key);
+  operators_key_ = std::move(operators);
+  return declaration_table_;
+}
+
+std::vector<FunctionSignature>
+SemanticQueries::function_signatures(const std::string &name) {
+  return declarations()->find_functions(name);
+}
+
+const std::vector<StmtPtr> &SemanticQueries::syntax(size_t index) {
+  Statement &statement = *statements_[index];
+  if (statement.phase == Phase::None) {
+    parse(statement);
+  }
+  return statement.stmts;
+}
+
+const std::vector<StmtPtr> &SemanticQueries::resolved(size_t index) {
+  auto table = declarations();
+  Statement &statement = *statements_[index];
+  if (statement.phase >= Phase::Resolved &&
+      statement.operators_used == operators_key_) {
+    return statement.stmts;
+  }
+  // Resolution rewrites the AST: start again from a fresh one
+  if (statement.phase != Phase::Syntax) {
+    parse(statement);
+  }
+
+  ++stats_.resolved;
+  statement.phase = Phase::Resolved;
+  statement.operators_used = operators_key_;
+  statement.resolve_ok = false;
+  statement.resolve_diagnostics.clear();
+
+  statement.symbols = std::make_unique<ScopedSymbolTable>(table);
+  ScopedSymbolTable &symbols = *statement.symbols;
+  SymbolTableBuilder builder;
+  if (!builder.collect(statement.stmts, symbols)) {
+    for (const auto &err : builder.errors()) {
+      statement.resolve_diagnostics.push_back(
+          {"semantic", err.message, err.line, err.column});
+    }
+    return statement.stmts;
+  }
+
+  std::vector<std::string> errors;
+  for (auto &stmt : statement.stmts) {
+    OperatorResolver::resolve_stmt(stmt.get(), symbols.symbol_table(), errors);
+  }
+  for (const auto &err : errors) {
+    statement.resolve_diagnostics.push_back(resolver_diagnostic(err));
+  }
+  statement.resolve_ok = errors.empty();
+  return statement.stmts;
+}
+
+const Scope &SemanticQueries::scopes(size_t index) {
+  resolved(index);
+  return *statements_[index]->symbols->root_scope();
+}
+
+const std::vector<Diagnostic> &
+SemanticQueries::resolution_diagnostics(size_t index) {
+  resolved(index);
+  return statements_[index]->resolve_diagnostics;
+}
+
+std::string SemanticQueries::dependency(const std::string &key,
+                                        size_t index) {
+  if (key == "operators") {
+    declarations();
+    return operators_key_;
+  }
+  if (key.rfind("func:", 0) == 0) {
+    std::string text;
+    for (const auto &sig : function_signatures(key.substr(5))) {
+      text += signature_text(sig.param_types, sig.return_type) + ";";
+    }
+    return text;
+  }
+  if (key.rfind("global:", 0) == 0) {
+    return global_type(key.substr(7), index);
+  }
+  return "";
+}
+
+const std::vector<StmtPtr> &SemanticQueries::checked(size_t index) {
+  resolved(index);
+  Statement &statement = *statements_[index];
+  if (statement.phase == Phase::Checked) {
+    if (statement.verified == revision_) {
+      return statement.stmts;
+    }
+    bool valid = true;
+    for (const auto &[key, value] : statement.dependencies) {
+      if (dependency(key, index) != value) {
+        valid = false;
+        break;
+      }
+    }
+    if (valid) {
+      statement.verified = revision_;
+      return statement.stmts;
+    }
+    // Inferred types are stored in the AST: start again from a fresh one
+    statement.phase = Phase::None;
+    resolved(index);
+  }
+
+  statement.phase = Phase::Checked;
+  statement.verified = revision_;
+  statement.dependencies.clear();
+  statement.diagnostics = statement.resolve_diagnostics;
+  if (!statement.resolve_ok) {
+    return statement.stmts;
+  }
+
+  ++stats_.checked;
+  statement.dependencies["operators"] = operators_key_;
+  References references;
+  for (const auto &stmt : statement.stmts) {
+    references.visit(stmt.get());
+  }
+  for (const auto &name : references.calls) {
+    std::string key = "func:" + name;
+    statement.dependencies[key] = dependency(key, index);
+  }
+  std::map<std::string, std::string> globals;
+  for (const auto &name : references.identifiers) {
+    std::string type = global_type(name, index);
+    statement.dependencies["global:" + name] = type;
+    if (!type.empty()) {
+      globals[name] = type;
+    }
+  }
+
+  ScopedSymbolTable symbols(declarations());
+  TypeChecker checker;
+  if (!checker.check(statement.stmts, symbols, globals)) {
+    for (const auto &err : checker.errors()) {
+      statement.diagnostics.push_back(
+          {"type", err.message, err.line, err.column});
+    }
+  }
+  return statement.stmts;
+}
+
+std::string SemanticQueries::global_type(const std::string &name,
+                                         size_t index) {
+  for (size_t i = std::min(index, statements_.size()); i-- > 0;) {
+    Statement &statement = *statements_[i];
+    if (!statement.scanned) {
+      parse(statement);
+    }
+    for (auto let = statement.lets.rbegin(); let != statement.lets.rend();
+         ++let) {
+      if (let->first != name) {
+        continue;
+      }
+      if (!let->second.empty()) {
+        return let->second;
+      }
+      // Inferred: the type of the initializer
+      const auto &stmts = checked(i);
+      for (auto stmt = stmts.rbegin(); stmt != stmts.rend(); ++stmt) {
+        if ((*stmt)->kind == StmtKind::Let) {
+          auto *decl = static_cast<const LetStmt *>(stmt->get());
+          if (decl->name == name && decl->init) {
+            return decl->init->inferred_type;
+          }
+        }
+      }
+      return "";
+    }
+  }
+  return "";
+}
+
+const std::vector<Diagnostic> &SemanticQueries::diagnostics(size_t index) {
+  checked(index);
+  return statements_[index]->diagnostics;
+}
+
+} // namespace pecco
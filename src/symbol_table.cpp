@@ -1,5 +1,7 @@
 #include "symbol_table.hpp"
 
+#include <set>
+
 namespace pecco {
 
 void SymbolTable::add_function(const FunctionSignature &sig) {
@@ -12,52 +14,89 @@ void SymbolTable::add_operator(const OperatorInfo &info) {
 
 std::vector<FunctionSignature>
 SymbolTable::find_functions(const std::string &name) const {
+  std::vector<FunctionSignature> result;
+  if (base_) {
+    result = base_->find_functions(name);
+  }
   auto it = functions_.find(name);
   if (it != functions_.end()) {
-    return it->second;
+    result.insert(result.end(), it->second.begin(), it->second.end());
   }
-  return {};
+  return result;
 }
 
 std::optional<OperatorInfo>
 SymbolTable::find_operator(const std::string &op, OpPosition position) const {
+  if (base_) {
+    if (auto info = base_->find_operator(op, position)) {
+      return info;
+    }
+  }
   return operators_.find_operator(op, position);
 }
 
 std::vector<OperatorInfo>
 SymbolTable::find_operators(const std::string &op, OpPosition position) const {
-  return operators_.find_operators(op, position);
+  std::vector<OperatorInfo> result;
+  if (base_) {
+    result = base_->find_operators(op, position);
+  }
+  auto own = operators_.find_operators(op, position);
+  result.insert(result.end(), own.begin(), own.end());
+  return result;
 }
 
 std::vector<OperatorInfo>
 SymbolTable::find_all_operators(const std::string &op) const {
-  return operators_.find_all_operators(op);
+  // Keep the per-position grouping of a single table
+  std::vector<OperatorInfo> result;
+  for (OpPosition position :
+       {OpPosition::Prefix, OpPosition::Infix, OpPosition::Postfix}) {
+    auto overloads = find_operators(op, position);
+    result.insert(result.end(), overloads.begin(), overloads.end());
+  }
+  return result;
 }
 
 bool SymbolTable::has_function(const std::string &name) const {
-  return functions_.find(name) != functions_.end();
+  return functions_.find(name) != functions_.end() ||
+         (base_ && base_->has_function(name));
 }
 
 bool SymbolTable::has_operator(const std::string &op,
                                OpPosition position) const {
-  return operators_.has_operator(op, position);
+  return operators_.has_operator(op, position) ||
+         (base_ && base_->has_operator(op, position));
 }
 
 std::vector<std::string> SymbolTable::get_all_function_names() const {
-  std::vector<std::string> names;
+  std::set<std::string> names;
+  if (base_) {
+    auto base_names = base_->get_all_function_names();
+    names.insert(base_names.begin(), base_names.end());
+  }
   for (const auto &[name, _] : functions_) {
-    names.push_back(name);
+    names.insert(name);
   }
-  return names;
+  return {names.begin(), names.end()};
 }
 
 std::vector<OperatorInfo> SymbolTable::get_all_operators() const {
-  std::vector<OperatorInfo> result;
-  for (const auto &[key, overloads] : operators_.get_operators()) {
-    for (const auto &op : overloads) {
-      result.push_back(op);
+  std::set<std::pair<std::string, OpPosition>> keys;
+  if (base_) {
+    for (const auto &info : base_->get_all_operators()) {
+      keys.insert({info.op, info.position});
     }
   }
+  for (const auto &[key, _] : operators_.get_operators()) {
+    keys.insert(key);
+  }
+
+  std::vector<OperatorInfo> result;
+  for (const auto &[op, position] : keys) {
+    auto overloads = find_operators(op, position);
+    result.insert(result.end(), overloads.begin(), overloads.end());
+  }
   return result;
 }
 
@@ -8,8 +8,10 @@ namespace pecco {
 
 bool SymbolTableBuilder::collect(const std::vector<StmtPtr> &stmts,
                                  ScopedSymbolTable &symbols) {
-  next_block_num_ = 0;
   for (const auto &stmt : stmts) {
+    // Blocks are numbered within their top-level statement, so a statement
+    // collected on its own (see SemanticQueries) gets the same scopes
+    next_block_num_ = 0;
     process_stmt(stmt.get(), symbols);
   }
   return !has_errors();
@@ -246,6 +248,7 @@ std::string SymbolTableBuilder::get_type_name(const Type *type) const {
 
   switch (type->kind) {
   case TypeKind::Named:
+  case TypeKind::Array: // Canonical "[N]T" spelling
     return type->name;
   default:
     return "";
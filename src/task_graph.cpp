@@ -0,0 +1,100 @@
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace pecco {
+
+TaskGraph::Id TaskGraph::add(std::string name, std::function<bool()> work,
+                             std::vector<Id> dependencies) {
+  Id id = tasks_.size();
+  Task task;
+  task.work = std::move(work);
+  task.waiting_for = dependencies.size();
+  task.timing.name = std::move(name);
+  tasks_.push_back(std::move(task));
+  for (Id dependency : dependencies) {
+    tasks_[dependency].dependents.push_back(id);
+  }
+  return id;
+}
+
+bool TaskGraph::run(unsigned threads) {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<Id> ready;
+  size_t unfinished = tasks_.size();
+  for (Id id = 0; id < tasks_.size(); ++id) {
+    if (tasks_[id].waiting_for == 0) {
+      ready.push_back(id);
+    }
+  }
+
+  // Called with the lock held once a task ran or was skipped
+  std::function<void(Id, bool)> finish = [&](Id id, bool ok) {
+    --unfinished;
+    for (Id dependent : tasks_[id].dependents) {
+      Task &task = tasks_[dependent];
+      task.skipped |= !ok;
+      if (--task.waiting_for > 0) {
+        continue;
+      }
+      if (task.skipped) {
+        finish(dependent, false);
+      } else {
+        ready.push_back(dependent);
+      }
+    }
+  };
+
+  auto work = [&](unsigned thread) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      changed.wait(lock, [&] { return !ready.empty() || unfinished == 0; });
+      if (unfinished == 0) {
+        return;
+      }
+      Id id = ready.front();
+      ready.pop_front();
+      Task &task = tasks_[id];
+      lock.unlock();
+
+      task.timing.thread = thread;
+      task.timing.ran = true;
+      task.timing.start = Clock::now();
+      bool ok = task.work();
+      task.timing.end = Clock::now();
+      task.timing.succeeded = ok;
+
+      lock.lock();
+      finish(id, ok);
+      changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  threads = std::max<unsigned>(1, std::min<size_t>(threads, tasks_.size()));
+  for (unsigned i = 1; i < threads; ++i) {
+    pool.emplace_back(work, i);
+  }
+  work(0);
+  for (auto &thread : pool) {
+    thread.join();
+  }
+
+  return std::all_of(tasks_.begin(), tasks_.end(),
+                     [](const Task &task) { return task.timing.succeeded; });
+}
+
+std::vector<TaskGraph::Timing> TaskGraph::timings() const {
+  std::vector<Timing> timings;
+  for (const auto &task : tasks_) {
+    timings.push_back(task.timing);
+  }
+  return timings;
+}
+
+} // namespace pecco
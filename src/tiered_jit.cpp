@@ -0,0 +1,240 @@
+#include "tiered_jit.hpp"
+
+#include "codegen.hpp"
+#include "jit_runtime.hpp"
+#include "pecco_rt.h"
+
+#include <llvm/IR/IRBuilder.h>
+
+#include <chrono>
+#include <cstdlib>
+
+namespace pecco {
+
+namespace {
+
+// Suffix of the adapter that lets the VM call a compiled function
+constexpr const char *kAdapterSuffix = "$tier";
+
+// exit() from native code: flush the runtime buffer like the interpreter's
+// Exit instruction, then leave without running plc's static destructors
+// (the JIT worker thread may still be alive)
+void tiered_exit(int32_t code) {
+  __pecco_rt_flush();
+  std::_Exit(code);
+}
+
+// void name$tier(ptr args, ptr result): load each parameter from its 8-byte
+// VM register, call the function and store the result as a VM value
+// (bool is widened to the i32 0/1 the interpreter uses)
+void add_adapter(llvm::Module &module, llvm::Function &target) {
+  llvm::LLVMContext &context = module.getContext();
+  llvm::Type *ptr = llvm::PointerType::getUnqual(context);
+  auto *type = llvm::FunctionType::get(llvm::Type::getVoidTy(context),
+                                       {ptr, ptr}, false);
+  auto *adapter =
+      llvm::Function::Create(type, llvm::Function::ExternalLinkage,
+                             target.getName() + kAdapterSuffix, module);
+
+  llvm::IRBuilder<> builder(
+      llvm::BasicBlock::Create(context, "entry", adapter));
+  std::vector<llvm::Value *> args;
+  for (llvm::Argument &param : target.args()) {
+    llvm::Value *slot = builder.CreateConstGEP1_64(
+        builder.getInt8Ty(), adapter->getArg(0),
+        param.getArgNo() * sizeof(VMValue));
+    llvm::Type *param_type = param.getType();
+    if (param_type->isIntegerTy(1)) {
+      args.push_back(builder.CreateTrunc(
+          builder.CreateLoad(builder.getInt32Ty(), slot), param_type));
+    } else {
+      args.push_back(builder.CreateLoad(param_type, slot));
+    }
+  }
+
+  llvm::Value *result = builder.CreateCall(&target, args);
+  llvm::Type *return_type = target.getReturnType();
+  if (!return_type->isVoidTy()) {
+    if (return_type->isIntegerTy(1)) {
+      result = builder.CreateZExt(result, builder.getInt32Ty());
+    }
+    builder.CreateStore(result, adapter->getArg(1));
+  }
+  builder.CreateRetVoid();
+}
+
+} // namespace
+
+TieredJit::TieredJit(std::vector<StmtPtr> &stmts,
+                     const ScopedSymbolTable &symbols,
+                     const BytecodeModule &module, VM &vm)
+    : stmts_(stmts), symbols_(symbols), module_(module), vm_(vm) {
+  call_graph_.build(stmts);
+  for (size_t index = 0; index < module.functions.size(); ++index) {
+    if (index != module.entry) {
+      function_indices_[module.functions[index].name] = index;
+    }
+  }
+}
+
+TieredJit::~TieredJit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    queue_.clear();
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void TieredJit::request(size_t function) {
+  // Top-level statements run once; there is nothing to call natively
+  if (function == module_.entry) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || !requested_.insert(function).second) {
+      return;
+    }
+    queue_.push_back(function);
+    // Programs that never get hot don't pay for the thread
+    if (!worker_.joinable()) {
+      worker_ = std::thread(&TieredJit::run_worker, this);
+    }
+  }
+  wake_.notify_one();
+}
+
+void TieredJit::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+std::vector<TieredJit::TierUp> TieredJit::tier_ups() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tier_ups_;
+}
+
+void TieredJit::run_worker() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      break;
+    }
+
+    size_t function = queue_.front();
+    queue_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    TierUp tier_up = compile(function);
+
+    lock.lock();
+    busy_ = false;
+    // Already compiled as a callee of an earlier tier-up
+    if (!tier_up.compiled.empty() || !tier_up.error.empty()) {
+      tier_ups_.push_back(std::move(tier_up));
+    }
+    if (queue_.empty()) {
+      idle_.notify_all();
+    }
+  }
+  busy_ = false;
+  idle_.notify_all();
+}
+
+TieredJit::TierUp TieredJit::compile(size_t function) {
+  auto start = std::chrono::steady_clock::now();
+  TierUp tier_up;
+  tier_up.function = module_.functions[function].name;
+
+  // The hot function plus everything it can reach that is still bytecode;
+  // functions from earlier tier-ups are only declared and link against the
+  // existing definitions
+  std::set<std::string> names;
+  std::vector<std::string> pending{tier_up.function};
+  while (!pending.empty()) {
+    std::string name = pending.back();
+    pending.pop_back();
+    if (!function_indices_.count(name) || compiled_.count(name) ||
+        !names.insert(name).second) {
+      continue;
+    }
+    for (const auto &callee : call_graph_.callees(name)) {
+      pending.push_back(callee);
+    }
+  }
+  if (names.empty()) {
+    return tier_up;
+  }
+
+  auto fail = [&](std::string message) {
+    tier_up.error = std::move(message);
+    tier_up.milliseconds = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    return tier_up;
+  };
+
+  if (!jit_) {
+    auto jit = create_runtime_jit(&tiered_exit);
+    if (!jit) {
+      return fail(llvm::toString(jit.takeError()));
+    }
+    jit_ = std::move(*jit);
+  }
+
+  CodeGen codegen("pecco_tier" + std::to_string(next_module_++));
+  if (!codegen.generate_definitions(stmts_, symbols_, names)) {
+    return fail(codegen.errors().empty() ? "code generation failed"
+                                         : codegen.errors()[0].message);
+  }
+
+  llvm::Module &module = *codegen.get_module();
+  for (const auto &name : names) {
+    llvm::Function *target = module.getFunction(name);
+    if (!target || target->isDeclaration()) {
+      return fail("no definition generated for " + name);
+    }
+    add_adapter(module, *target);
+  }
+  module.setDataLayout(jit_->getDataLayout());
+  module.setTargetTriple(jit_->getTargetTriple().str());
+  optimize_jit_module(module, llvm::OptimizationLevel::O2);
+
+  auto context = codegen.take_context();
+  llvm::orc::ThreadSafeModule thread_safe_module(
+      codegen.take_module(), llvm::orc::ThreadSafeContext(std::move(context)));
+  if (auto err = jit_->addIRModule(std::move(thread_safe_module))) {
+    return fail(llvm::toString(std::move(err)));
+  }
+
+  // Resolve every adapter before installing any, so a failed lookup leaves
+  // the whole group interpreted
+  std::vector<std::pair<size_t, VM::NativeEntry>> entries;
+  for (const auto &name : names) {
+    auto symbol = jit_->lookup(name + kAdapterSuffix);
+    if (!symbol) {
+      return fail(llvm::toString(symbol.takeError()));
+    }
+    entries.emplace_back(function_indices_.at(name),
+                         symbol->toPtr<VM::NativeEntry>());
+  }
+  for (const auto &[index, entry] : entries) {
+    vm_.install_native(index, entry);
+  }
+
+  compiled_.insert(names.begin(), names.end());
+  tier_up.compiled.assign(names.begin(), names.end());
+  tier_up.milliseconds = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return tier_up;
+}
+
+} // namespace pecco
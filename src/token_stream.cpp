@@ -0,0 +1,78 @@
+#include "token_stream.hpp"
+
+#include <utility>
+
+namespace pecco {
+
+TokenStream::TokenStream(std::string_view source, size_t batch_size)
+    : lexer_(source), batch_size_(batch_size == 0 ? 1 : batch_size),
+      lexer_thread_([this] { produce(); }) {}
+
+TokenStream::~TokenStream() {
+  // Wake the lexer thread if it waits for a free slot
+  stop_.store(true, std::memory_order_release);
+  head_.fetch_add(1, std::memory_order_release);
+  head_.notify_one();
+  lexer_thread_.join();
+}
+
+void TokenStream::produce() {
+  for (size_t tail = 0;; ++tail) {
+    std::vector<Token> batch;
+    batch.reserve(batch_size_);
+    bool done = false;
+    while (batch.size() < batch_size_ && !done) {
+      Token tok = lexer_.next_token();
+      if (tok.kind == TokenKind::Error) {
+        errors_.push_back(tok);
+      }
+      done = tok.kind == TokenKind::EndOfFile;
+      batch.push_back(std::move(tok));
+    }
+
+    // Wait for the consumer to free the slot
+    for (;;) {
+      size_t head = head_.load(std::memory_order_acquire);
+      if (stop_.load(std::memory_order_acquire)) {
+        return;
+      }
+      if (tail - head < kSlots) {
+        break;
+      }
+      head_.wait(head, std::memory_order_acquire);
+    }
+    slots_[tail % kSlots] = std::move(batch);
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+    if (done) {
+      return;
+    }
+  }
+}
+
+bool TokenStream::next_batch(std::vector<Token> &tokens) {
+  if (finished_) {
+    return false;
+  }
+  size_t head = head_.load(std::memory_order_relaxed);
+  tail_.wait(head, std::memory_order_acquire);
+
+  auto &batch = slots_[head % kSlots];
+  finished_ = batch.back().kind == TokenKind::EndOfFile;
+  tokens.insert(tokens.end(), std::make_move_iterator(batch.begin()),
+                std::make_move_iterator(batch.end()));
+  batch = {};
+  head_.store(head + 1, std::memory_order_release);
+  head_.notify_one();
+  return true;
+}
+
+const std::vector<Token> &TokenStream::lexer_errors() {
+  std::vector<Token> rest;
+  while (next_batch(rest)) {
+    rest.clear();
+  }
+  return errors_;
+}
+
+} // namespace pecco
@@ -1,12 +1,101 @@
 #include "type_checker.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <set>
 #include <sstream>
+#include <stdexcept>
 
 namespace pecco {
 
+namespace {
+
+// Prelude builtins that codegen lowers to LLVM intrinsics; a call matching
+// none of their overloads has nothing to fall back to
+bool is_bit_builtin(const std::string &name) {
+  static const std::set<std::string> names = {
+      "popcount", "clz", "ctz", "rotl", "rotr", "bswap", "bitreverse"};
+  return names.count(name) > 0;
+}
+
+} // namespace
+
 void TypeChecker::error(const std::string &msg, size_t line, size_t column) {
   errors_.emplace_back(msg, line, column);
 }
 
+std::string TypeChecker::check_int_literal(IntLiteralExpr *lit, bool negated) {
+  auto integer = parse_integer_type_name(lit->type);
+  // Folded constants may be negative ("-5"); they were checked already
+  if (!integer || lit->value.empty() || lit->value[0] == '-') {
+    return lit->type;
+  }
+  uint64_t max = integer->is_signed ? (uint64_t(1) << (integer->bits - 1)) - 1
+                 : integer->bits == 64 ? UINT64_MAX
+                                       : (uint64_t(1) << integer->bits) - 1;
+  // -128i8 is in range although 128i8 is not
+  if (integer->is_signed && negated) {
+    ++max;
+  }
+  bool fits = lit->value.size() <= 20;
+  try {
+    fits = fits && std::stoull(lit->value) <= max;
+  } catch (const std::out_of_range &) {
+    fits = false;
+  }
+  if (!fits) {
+    error("Integer literal " + lit->value + " is out of range for '" +
+              lit->type + "'",
+          lit->loc.line, lit->loc.column);
+  }
+  return lit->type;
+}
+
+bool TypeChecker::is_numeric_mix(const std::string &left,
+                                 const std::string &right) const {
+  auto is_float = [](const std::string &type) {
+    return type == "f32" || type == "f64";
+  };
+  bool integers =
+      parse_integer_type_name(left) && parse_integer_type_name(right);
+  return (integers || (is_float(left) && is_float(right))) && left != right;
+}
+
+void TypeChecker::check_lane_arguments(
+    CallExpr *call, const std::string &func_name,
+    const std::vector<std::string> &arg_types) {
+  auto vector =
+      arg_types.empty() ? std::nullopt : parse_vector_type_name(arg_types[0]);
+  bool shuffle = func_name == "shuffle";
+  if (!vector ||
+      (!shuffle && func_name != "extract" && func_name != "insert")) {
+    return;
+  }
+  // shuffle(a, b, lanes...) indexes the lanes of a followed by those of b;
+  // extract(v, lane) and insert(v, lane, x) index v
+  size_t first = shuffle ? 2 : 1;
+  size_t end = shuffle ? call->args.size() : 2;
+  size_t limit = shuffle ? 2 * vector->lanes : vector->lanes;
+
+  for (size_t i = first; i < end && i < call->args.size(); ++i) {
+    Expr *lane = call->args[i].get();
+    if (lane->kind != ExprKind::IntLiteral) {
+      // Variable lanes are fine except in a shuffle mask
+      if (shuffle) {
+        error("Shuffle lanes must be integer literals", lane->loc.line,
+              lane->loc.column);
+      }
+      continue;
+    }
+    const std::string &value = static_cast<IntLiteralExpr *>(lane)->value;
+    if (value.size() > 10 || std::stoull(value) >= limit) {
+      error("Lane " + value + " is out of range for " +
+                (shuffle ? "two '" + arg_types[0] + "' vectors"
+                         : "'" + arg_types[0] + "'"),
+            lane->loc.line, lane->loc.column);
+    }
+  }
+}
+
 std::string TypeChecker::get_type_name(const Type *type) const {
   if (!type)
     return "";
@@ -15,12 +104,21 @@ std::string TypeChecker::get_type_name(const Type *type) const {
 
 bool TypeChecker::check(std::vector<StmtPtr> &stmts,
                         const ScopedSymbolTable &symbols) {
+  return check(stmts, symbols, {});
+}
+
+bool TypeChecker::check(std::vector<StmtPtr> &stmts,
+                        const ScopedSymbolTable &symbols,
+                        const std::map<std::string, std::string> &globals) {
   symbols_ = &symbols;
   errors_.clear();
   scope_stack_.clear();
 
   // Push global scope
   push_scope();
+  for (const auto &[name, type] : globals) {
+    add_variable_type(name, type);
+  }
 
   for (auto &stmt : stmts) {
     check_stmt(stmt.get());
@@ -64,8 +162,27 @@ void TypeChecker::check_stmt(Stmt *stmt) {
   switch (stmt->kind) {
   case StmtKind::Let: {
     auto *let = static_cast<LetStmt *>(stmt);
-    if (let->init) {
+    bool is_array = let->type && let->type.value()->kind == TypeKind::Array;
+    if (is_array && let->init) {
+      check_expr(let->init.get());
+      error("Array '" + let->name +
+                "' cannot have an initializer (arrays start zeroed)",
+            let->init->loc.line, let->init->loc.column);
+      add_variable_type(let->name, get_type_name(let->type.value().get()));
+    } else if (!let->init) {
+      if (!is_array) {
+        error("Variable '" + let->name + "' must be initialized",
+              let->loc.line, let->loc.column);
+      }
+      if (let->type) {
+        add_variable_type(let->name, get_type_name(let->type.value().get()));
+      }
+    } else {
       std::string init_type = check_expr(let->init.get());
+      if (parse_array_type_name(init_type)) {
+        error("Arrays cannot be copied", let->init->loc.line,
+              let->init->loc.column);
+      }
 
       // If variable has explicit type annotation, check compatibility
       if (let->type) {
@@ -91,6 +208,11 @@ void TypeChecker::check_stmt(Stmt *stmt) {
 
   case StmtKind::Func: {
     auto *func = static_cast<FuncStmt *>(stmt);
+    if (func->return_type &&
+        func->return_type.value()->kind == TypeKind::Array) {
+      error("Function '" + func->name + "' cannot return an array",
+            func->loc.line, func->loc.column);
+    }
     if (func->body) {
       push_scope();
 
@@ -183,11 +305,11 @@ std::string TypeChecker::check_expr(Expr *expr) {
 
   switch (expr->kind) {
   case ExprKind::IntLiteral:
-    type = "i32";
+    type = check_int_literal(static_cast<IntLiteralExpr *>(expr), false);
     break;
 
   case ExprKind::FloatLiteral:
-    type = "f64";
+    type = static_cast<FloatLiteralExpr *>(expr)->type;
     break;
 
   case ExprKind::StringLiteral:
@@ -216,6 +338,13 @@ std::string TypeChecker::check_expr(Expr *expr) {
     std::string left_type = check_expr(binary->left.get());
     std::string right_type = check_expr(binary->right.get());
 
+    // Arrays are only indexed and passed to functions, never operated on
+    if (parse_array_type_name(left_type) || parse_array_type_name(right_type)) {
+      error("Operator '" + binary->op + "' cannot be applied to arrays",
+            expr->loc.line, expr->loc.column);
+      break;
+    }
+
     // Look up operator in symbol table
     auto ops = symbols_->find_operators(binary->op, OpPosition::Infix);
 
@@ -241,6 +370,12 @@ std::string TypeChecker::check_expr(Expr *expr) {
       }
 
       if (!found) {
+        // Integers of different widths or signedness never mix implicitly
+        if (is_numeric_mix(left_type, right_type)) {
+          error("No operator '" + binary->op + "' for '" + left_type +
+                    "' and '" + right_type + "' (convert explicitly)",
+                expr->loc.line, expr->loc.column);
+        }
         // Just use the first operator's return type
         type = ops[0].signature.return_type;
       }
@@ -250,7 +385,22 @@ std::string TypeChecker::check_expr(Expr *expr) {
 
   case ExprKind::Unary: {
     auto *unary = static_cast<UnaryExpr *>(expr);
-    std::string operand_type = check_expr(unary->operand.get());
+    std::string operand_type;
+    if (unary->op == "-" && unary->position == OpPosition::Prefix &&
+        unary->operand->kind == ExprKind::IntLiteral &&
+        unary->operand->inferred_type.empty()) {
+      operand_type = check_int_literal(
+          static_cast<IntLiteralExpr *>(unary->operand.get()), true);
+      unary->operand->inferred_type = operand_type;
+    } else {
+      operand_type = check_expr(unary->operand.get());
+    }
+
+    if (parse_array_type_name(operand_type)) {
+      error("Operator '" + unary->op + "' cannot be applied to arrays",
+            expr->loc.line, expr->loc.column);
+      break;
+    }
 
     // Look up operator in symbol table
     auto ops = symbols_->find_operators(unary->op, unary->position);
@@ -277,6 +427,14 @@ std::string TypeChecker::check_expr(Expr *expr) {
       }
 
       if (!found) {
+        if (parse_integer_type_name(operand_type)) {
+          error("No " +
+                    std::string(unary->position == OpPosition::Prefix
+                                    ? "prefix"
+                                    : "postfix") +
+                    " operator '" + unary->op + "' for '" + operand_type + "'",
+                expr->loc.line, expr->loc.column);
+        }
         // Just use the first operator's return type
         type = ops[0].signature.return_type;
       }
@@ -334,8 +492,59 @@ std::string TypeChecker::check_expr(Expr *expr) {
       if (!found) {
         // Just use the first overload's return type
         type = funcs[0].return_type;
+        bool conversion = parse_integer_type_name(func_name) ||
+                          func_name == "f32" || func_name == "f64";
+        if (conversion && arg_types.size() == 1 && !arg_types[0].empty() &&
+            arg_types[0] != func_name) {
+          error("Cannot convert '" + arg_types[0] + "' to '" + func_name + "'",
+                expr->loc.line, expr->loc.column);
+        }
+        bool known_args =
+            std::none_of(arg_types.begin(), arg_types.end(),
+                         [](const std::string &t) { return t.empty(); });
+        if (is_bit_builtin(func_name) && known_args) {
+          std::ostringstream msg;
+          msg << "No overload of '" << func_name << "' for (";
+          for (size_t i = 0; i < arg_types.size(); ++i) {
+            msg << (i ? ", " : "") << "'" << arg_types[i] << "'";
+          }
+          msg << ")";
+          error(msg.str(), expr->loc.line, expr->loc.column);
+        }
+      }
+      check_lane_arguments(call, func_name, arg_types);
+    }
+    break;
+  }
+
+  case ExprKind::Index: {
+    auto *index = static_cast<IndexExpr *>(expr);
+    std::string base_type = check_expr(index->base.get());
+    std::string index_type = check_expr(index->index.get());
+    auto array = parse_array_type_name(base_type);
+    if (!array) {
+      if (!base_type.empty()) {
+        error("Cannot index a value of type '" + base_type + "'",
+              expr->loc.line, expr->loc.column);
+      }
+      break;
+    }
+    if (!index_type.empty() && index_type != "i32") {
+      error("Array index must be 'i32', got '" + index_type + "'",
+            index->index->loc.line, index->index->loc.column);
+    }
+    // Constant indices are checked here; others are not checked at runtime
+    if (index->index->kind == ExprKind::IntLiteral) {
+      const std::string &value =
+          static_cast<IntLiteralExpr *>(index->index.get())->value;
+      // Too many digits for an i32 is out of bounds too
+      if (value.size() > 10 || std::stoull(value) >= array->size) {
+        error("Array index " + value + " is out of bounds for '" + base_type +
+                  "'",
+              index->index->loc.line, index->index->loc.column);
       }
     }
+    type = array->element;
     break;
   }
 
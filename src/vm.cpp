@@ -0,0 +1,407 @@
+#include "vm.hpp"
+
+#include "pecco_rt.h"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PECCO_VM_THREADED 1
+#else
+#define PECCO_VM_THREADED 0
+#endif
+
+namespace pecco {
+
+namespace {
+
+int32_t wrap(uint32_t value) { return static_cast<int32_t>(value); }
+
+} // namespace
+
+VM::VM(const BytecodeModule &module)
+    : module_(module), stack_(new VMValue[kStackSlots]),
+      hotness_(module.functions.size(), 0),
+      natives_(new std::atomic<NativeEntry>[module.functions.size()]) {
+  for (size_t i = 0; i < module.functions.size(); ++i) {
+    natives_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+void VM::set_tier_up(uint32_t threshold, std::function<void(size_t)> on_hot) {
+  tier_threshold_ = threshold;
+  on_hot_ = std::move(on_hot);
+}
+
+void VM::install_native(size_t function, NativeEntry entry) {
+  natives_[function].store(entry, std::memory_order_release);
+}
+
+void VM::count_hotness(size_t function) {
+  // Fires exactly once per function; the counter keeps saturating above
+  if (hotness_[function] < tier_threshold_ &&
+      ++hotness_[function] == tier_threshold_ && on_hot_) {
+    on_hot_(function);
+  }
+}
+
+int32_t VM::run() {
+  error_.clear();
+  frames_.clear();
+  return execute();
+}
+
+void VM::thread_code(const void *const *handlers) {
+  code_.clear();
+  code_.reserve(module_.functions.size());
+  for (const auto &func : module_.functions) {
+    std::vector<ThreadedInstr> threaded;
+    threaded.reserve(func.code.size());
+    for (const Instr &ins : func.code) {
+      const void *handler =
+          handlers ? handlers[static_cast<size_t>(ins.op)] : nullptr;
+      threaded.push_back({handler, ins.op, ins.a, ins.b, ins.c});
+    }
+    code_.push_back(std::move(threaded));
+  }
+}
+
+int32_t VM::runtime_error(const std::string &msg) {
+  __pecco_rt_flush();
+  error_ = msg;
+  return 1;
+}
+
+int32_t VM::execute() {
+#if PECCO_VM_THREADED
+  static const void *const kHandlers[] = {
+#define PECCO_OPCODE_LABEL(name) &&op_##name,
+      PECCO_OPCODES(PECCO_OPCODE_LABEL)
+#undef PECCO_OPCODE_LABEL
+  };
+  if (code_.empty()) {
+    thread_code(kHandlers);
+  }
+#define VM_DISPATCH() goto *pc->handler
+#define VM_NEXT()                                                              \
+  do {                                                                         \
+    ++pc;                                                                      \
+    goto *pc->handler;                                                         \
+  } while (0)
+#define VM_CASE(name) op_##name:
+#define VM_LOOP_BEGIN VM_DISPATCH();
+#define VM_LOOP_END
+#else
+  if (code_.empty()) {
+    thread_code(nullptr);
+  }
+#define VM_DISPATCH() continue
+#define VM_NEXT()                                                              \
+  {                                                                            \
+    ++pc;                                                                      \
+    continue;                                                                  \
+  }
+#define VM_CASE(name) case Opcode::name:
+#define VM_LOOP_BEGIN                                                          \
+  for (;;) {                                                                   \
+    switch (pc->op) {
+#define VM_LOOP_END                                                            \
+  }                                                                            \
+  }
+#endif
+#define R(index) base[index]
+#define IMM(ins)                                                               \
+  static_cast<int32_t>(static_cast<uint32_t>((ins)->b) |                       \
+                       (static_cast<uint32_t>((ins)->c) << 16))
+
+  const double *f64_constants = module_.f64_constants.data();
+  std::vector<const char *> strings;
+  strings.reserve(module_.strings.size());
+  for (const auto &str : module_.strings) {
+    strings.push_back(str.c_str());
+  }
+
+  VMValue *const stack_end = stack_.get() + kStackSlots;
+  VMValue *base = stack_.get();
+  auto function = static_cast<uint32_t>(module_.entry);
+  const ThreadedInstr *code = code_[function].data();
+  const ThreadedInstr *pc = code;
+  const bool tiering = tier_threshold_ != 0;
+  if (module_.functions[module_.entry].num_regs > kStackSlots) {
+    return runtime_error("stack overflow");
+  }
+
+  VM_LOOP_BEGIN
+
+  VM_CASE(Mov) {
+    R(pc->a) = R(pc->b);
+    VM_NEXT();
+  }
+  VM_CASE(LoadInt) {
+    R(pc->a).i = IMM(pc);
+    VM_NEXT();
+  }
+  VM_CASE(LoadF64) {
+    R(pc->a).f = f64_constants[pc->b];
+    VM_NEXT();
+  }
+  VM_CASE(LoadStr) {
+    R(pc->a).s = strings[pc->b];
+    VM_NEXT();
+  }
+
+  // i32 arithmetic wraps around like the generated add/sub/mul
+  VM_CASE(AddI32) {
+    R(pc->a).i = wrap(static_cast<uint32_t>(R(pc->b).i) +
+                      static_cast<uint32_t>(R(pc->c).i));
+    VM_NEXT();
+  }
+  VM_CASE(SubI32) {
+    R(pc->a).i = wrap(static_cast<uint32_t>(R(pc->b).i) -
+                      static_cast<uint32_t>(R(pc->c).i));
+    VM_NEXT();
+  }
+  VM_CASE(MulI32) {
+    R(pc->a).i = wrap(static_cast<uint32_t>(R(pc->b).i) *
+                      static_cast<uint32_t>(R(pc->c).i));
+    VM_NEXT();
+  }
+  VM_CASE(DivI32) {
+    int32_t lhs = R(pc->b).i;
+    int32_t rhs = R(pc->c).i;
+    if (rhs == 0 ||
+        (lhs == std::numeric_limits<int32_t>::min() && rhs == -1)) {
+      return runtime_error("integer division overflow or division by zero");
+    }
+    R(pc->a).i = lhs / rhs;
+    VM_NEXT();
+  }
+  VM_CASE(RemI32) {
+    int32_t lhs = R(pc->b).i;
+    int32_t rhs = R(pc->c).i;
+    if (rhs == 0 ||
+        (lhs == std::numeric_limits<int32_t>::min() && rhs == -1)) {
+      return runtime_error("integer division overflow or division by zero");
+    }
+    R(pc->a).i = lhs % rhs;
+    VM_NEXT();
+  }
+  VM_CASE(AndI32) {
+    R(pc->a).i = R(pc->b).i & R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(OrI32) {
+    R(pc->a).i = R(pc->b).i | R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(XorI32) {
+    R(pc->a).i = R(pc->b).i ^ R(pc->c).i;
+    VM_NEXT();
+  }
+  // Out-of-range shift amounts are poison in LLVM; mask like x86 does
+  VM_CASE(ShlI32) {
+    R(pc->a).i = wrap(static_cast<uint32_t>(R(pc->b).i) << (R(pc->c).i & 31));
+    VM_NEXT();
+  }
+  VM_CASE(ShrI32) {
+    R(pc->a).i = R(pc->b).i >> (R(pc->c).i & 31);
+    VM_NEXT();
+  }
+  VM_CASE(NegI32) {
+    R(pc->a).i = wrap(0u - static_cast<uint32_t>(R(pc->b).i));
+    VM_NEXT();
+  }
+  VM_CASE(NotI32) {
+    R(pc->a).i = ~R(pc->b).i;
+    VM_NEXT();
+  }
+  VM_CASE(NotBool) {
+    R(pc->a).i = R(pc->b).i ^ 1;
+    VM_NEXT();
+  }
+
+  VM_CASE(EqI32) {
+    R(pc->a).i = R(pc->b).i == R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(NeI32) {
+    R(pc->a).i = R(pc->b).i != R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(LtI32) {
+    R(pc->a).i = R(pc->b).i < R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(LeI32) {
+    R(pc->a).i = R(pc->b).i <= R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(GtI32) {
+    R(pc->a).i = R(pc->b).i > R(pc->c).i;
+    VM_NEXT();
+  }
+  VM_CASE(GeI32) {
+    R(pc->a).i = R(pc->b).i >= R(pc->c).i;
+    VM_NEXT();
+  }
+
+  VM_CASE(AddF64) {
+    R(pc->a).f = R(pc->b).f + R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(SubF64) {
+    R(pc->a).f = R(pc->b).f - R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(MulF64) {
+    R(pc->a).f = R(pc->b).f * R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(DivF64) {
+    R(pc->a).f = R(pc->b).f / R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(PowF64) {
+    R(pc->a).f = std::pow(R(pc->b).f, R(pc->c).f);
+    VM_NEXT();
+  }
+  VM_CASE(NegF64) {
+    R(pc->a).f = -R(pc->b).f;
+    VM_NEXT();
+  }
+
+  // Ordered comparisons: false when either operand is NaN
+  VM_CASE(EqF64) {
+    R(pc->a).i = R(pc->b).f == R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(NeF64) {
+    R(pc->a).i = R(pc->b).f < R(pc->c).f || R(pc->b).f > R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(LtF64) {
+    R(pc->a).i = R(pc->b).f < R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(LeF64) {
+    R(pc->a).i = R(pc->b).f <= R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(GtF64) {
+    R(pc->a).i = R(pc->b).f > R(pc->c).f;
+    VM_NEXT();
+  }
+  VM_CASE(GeF64) {
+    R(pc->a).i = R(pc->b).f >= R(pc->c).f;
+    VM_NEXT();
+  }
+
+  VM_CASE(Jump) {
+    pc = code + IMM(pc);
+    VM_DISPATCH();
+  }
+  VM_CASE(Loop) {
+    if (tiering) {
+      count_hotness(function);
+    }
+    pc = code + IMM(pc);
+    VM_DISPATCH();
+  }
+  VM_CASE(JumpIfFalse) {
+    if (R(pc->a).i) {
+      ++pc;
+    } else {
+      pc = code + IMM(pc);
+    }
+    VM_DISPATCH();
+  }
+
+  VM_CASE(Call) {
+    VMValue *callee_base = base + pc->b;
+    if (NativeEntry native = natives_[pc->c].load(std::memory_order_acquire)) {
+      native(callee_base, &R(pc->a));
+      VM_NEXT();
+    }
+    if (tiering) {
+      count_hotness(pc->c);
+    }
+    if (frames_.size() >= kMaxCallDepth ||
+        module_.functions[pc->c].num_regs >
+            static_cast<size_t>(stack_end - callee_base)) {
+      return runtime_error("stack overflow");
+    }
+    frames_.push_back({code, pc + 1, base, function, pc->a});
+    base = callee_base;
+    function = pc->c;
+    code = code_[function].data();
+    pc = code;
+    VM_DISPATCH();
+  }
+  VM_CASE(Return) {
+    VMValue result = R(pc->a);
+    if (frames_.empty()) {
+      __pecco_rt_flush();
+      return result.i;
+    }
+    const Frame &frame = frames_.back();
+    code = frame.code;
+    pc = frame.return_pc;
+    base = frame.base;
+    function = frame.function;
+    R(frame.dest) = result;
+    frames_.pop_back();
+    VM_DISPATCH();
+  }
+  VM_CASE(ReturnVoid) {
+    if (frames_.empty()) {
+      __pecco_rt_flush();
+      return 0;
+    }
+    const Frame &frame = frames_.back();
+    code = frame.code;
+    pc = frame.return_pc;
+    base = frame.base;
+    function = frame.function;
+    frames_.pop_back();
+    VM_DISPATCH();
+  }
+
+  VM_CASE(Write) {
+    R(pc->a).i =
+        __pecco_rt_write(R(pc->b).i, R(pc->b + 1).s, R(pc->b + 2).i);
+    VM_NEXT();
+  }
+  VM_CASE(Print) {
+    __pecco_rt_print(R(pc->b).s);
+    VM_NEXT();
+  }
+  VM_CASE(PrintI32) {
+    __pecco_rt_print_i32(R(pc->b).i);
+    VM_NEXT();
+  }
+  VM_CASE(PrintF64) {
+    __pecco_rt_print_f64(R(pc->b).f);
+    VM_NEXT();
+  }
+  VM_CASE(Flush) {
+    __pecco_rt_flush();
+    VM_NEXT();
+  }
+  VM_CASE(Exit) {
+    __pecco_rt_flush();
+    return R(pc->b).i;
+  }
+
+  VM_LOOP_END
+
+#undef VM_DISPATCH
+#undef VM_CASE
+#undef VM_LOOP_BEGIN
+#undef VM_LOOP_END
+#undef VM_NEXT
+#undef R
+#undef IMM
+  return runtime_error("invalid instruction");
+}
+
+} // namespace pecco
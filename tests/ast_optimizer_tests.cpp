@@ -0,0 +1,182 @@
+#include "ast_optimizer.hpp"
+#include "lexer.hpp"
+#include "operator_resolver.hpp"
+#include "parser.hpp"
+#include "scope.hpp"
+#include "symbol_table_builder.hpp"
+#include "type_checker.hpp"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace pecco;
+
+class AstOptimizerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    builder.load_prelude(STDLIB_DIR "/prelude.pec", symbols);
+  }
+
+  ScopedSymbolTable symbols;
+  SymbolTableBuilder builder;
+
+  // Parse, resolve, type check and optimize, returning the printed AST
+  std::string optimize(const std::string &code) {
+    Lexer lexer(code);
+    auto tokens = lexer.tokenize_all();
+    Parser parser(std::move(tokens));
+    stmts = parser.parse_program();
+    if (parser.has_errors() || !builder.collect(stmts, symbols)) {
+      return "<error>";
+    }
+
+    std::vector<std::string> resolve_errors;
+    for (auto &stmt : stmts) {
+      OperatorResolver::resolve_stmt(stmt.get(), symbols.symbol_table(),
+                                     resolve_errors);
+    }
+    TypeChecker checker;
+    if (!resolve_errors.empty() || !checker.check(stmts, symbols)) {
+      return "<error>";
+    }
+
+    AstPassManager::create_default().run(stmts);
+
+    std::ostringstream os;
+    for (const auto &stmt : stmts) {
+      stmt->print(os);
+      os << "\n";
+    }
+    return os.str();
+  }
+
+  // Print a single expression for comparison
+  static std::string print_expr(const Expr *expr) {
+    std::ostringstream os;
+    expr->print(os);
+    return os.str();
+  }
+
+  const Expr *let_init(size_t index) const {
+    return static_cast<const LetStmt *>(stmts[index].get())->init.get();
+  }
+
+  std::vector<StmtPtr> stmts;
+};
+
+TEST_F(AstOptimizerTest, FoldsIntegerArithmetic) {
+  optimize("let x = 2 + 3 * 4; let y = 7 / 2 - 7 % 2; let z = 1 << 4 | 3;");
+
+  ASSERT_EQ(let_init(0)->kind, ExprKind::IntLiteral);
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(0))->value, "14");
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(1))->value, "2");
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(2))->value, "19");
+}
+
+TEST_F(AstOptimizerTest, FoldingWrapsAroundI32) {
+  optimize("let a = 2147483647 + 1; let b = 65536 * 65536; "
+           "let c = -2147483648;");
+
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(0))->value,
+            "-2147483648");
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(1))->value, "0");
+  EXPECT_EQ(static_cast<const IntLiteralExpr *>(let_init(2))->value,
+            "-2147483648");
+}
+
+TEST_F(AstOptimizerTest, KeepsUndefinedOperations) {
+  optimize("let a = 1 / 0; let b = 5 % 0; let c = 1 << 32; "
+           "let d = -2147483648 / -1;");
+
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(let_init(i)->kind, ExprKind::Binary) << i;
+  }
+}
+
+TEST_F(AstOptimizerTest, FoldsFloatAndComparisons) {
+  optimize("let a = 2.0 ** 10.0; let b = 1.5 * 2.0 < 3.5; let c = !(1 == 2);"
+           "let d = 1.0 / 0.0;");
+
+  ASSERT_EQ(let_init(0)->kind, ExprKind::FloatLiteral);
+  EXPECT_EQ(static_cast<const FloatLiteralExpr *>(let_init(0))->value, "1024");
+  ASSERT_EQ(let_init(1)->kind, ExprKind::BoolLiteral);
+  EXPECT_TRUE(static_cast<const BoolLiteralExpr *>(let_init(1))->value);
+  ASSERT_EQ(let_init(2)->kind, ExprKind::BoolLiteral);
+  EXPECT_TRUE(static_cast<const BoolLiteralExpr *>(let_init(2))->value);
+  // Infinity has no literal spelling
+  EXPECT_EQ(let_init(3)->kind, ExprKind::Binary);
+}
+
+TEST_F(AstOptimizerTest, UserDefinedOperatorsNotFolded) {
+  optimize(R"(
+    operator infix ** (a: i32, b: i32) : i32 prec 90 assoc_right {
+      print("side effect");
+      return a * b;
+    }
+    let x = 3 ** 4;
+  )");
+
+  // The overload has side effects, so the call must stay
+  EXPECT_EQ(let_init(1)->kind, ExprKind::Binary);
+}
+
+TEST_F(AstOptimizerTest, AlgebraicIdentities) {
+  optimize(R"(
+    func f(x: i32, y: f64, b: bool) : i32 {
+      let a = x + 0;
+      let c = 1 * x;
+      let d = y * 1.0;
+      let e = b && true;
+      let g = x * 0;
+      let h = -(-x);
+      let k = f(x, y, b) * 0;
+      return 0;
+    }
+  )");
+
+  auto *func = static_cast<const FuncStmt *>(stmts[0].get());
+  auto *body = static_cast<const BlockStmt *>(func->body.value().get());
+  auto init = [&](size_t i) {
+    return print_expr(
+        static_cast<const LetStmt *>(body->stmts[i].get())->init.get());
+  };
+  EXPECT_EQ(init(0), "Identifier(x)");
+  EXPECT_EQ(init(1), "Identifier(x)");
+  EXPECT_EQ(init(2), "Identifier(y)");
+  EXPECT_EQ(init(3), "Identifier(b)");
+  EXPECT_EQ(init(4), "IntLiteral(0)");
+  EXPECT_EQ(init(5), "Identifier(x)");
+  // The call has side effects and must still be evaluated
+  EXPECT_EQ(static_cast<const LetStmt *>(body->stmts[6].get())->init->kind,
+            ExprKind::Binary);
+}
+
+TEST_F(AstOptimizerTest, DeadBranchElimination) {
+  optimize(R"(
+    if 1 < 2 { print("yes"); } else { print("no"); }
+    if false { print("never"); }
+    while 1 > 2 { print("loop"); }
+  )");
+
+  ASSERT_EQ(stmts.size(), 1u);
+  EXPECT_EQ(stmts[0]->kind, StmtKind::Block);
+}
+
+TEST_F(AstOptimizerTest, UnreachableCodeAfterReturn) {
+  optimize(R"(
+    func f(x: i32) : i32 {
+      if x > 0 {
+        return 1;
+      } else {
+        return 2;
+      }
+      print("dead");
+      return 3;
+    }
+  )");
+
+  auto *func = static_cast<const FuncStmt *>(stmts[0].get());
+  auto *body = static_cast<const BlockStmt *>(func->body.value().get());
+  ASSERT_EQ(body->stmts.size(), 1u);
+  EXPECT_EQ(body->stmts[0]->kind, StmtKind::If);
+}
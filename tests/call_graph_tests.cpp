@@ -0,0 +1,132 @@
+#include "call_graph.hpp"
+#include "lexer.hpp"
+#include "operator_resolver.hpp"
+#include "parser.hpp"
+#include "scope.hpp"
+#include "symbol_table_builder.hpp"
+#include "type_checker.hpp"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace pecco;
+
+class CallGraphTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    builder.load_prelude(STDLIB_DIR "/prelude.pec", symbols);
+  }
+
+  ScopedSymbolTable symbols;
+  SymbolTableBuilder builder;
+  CallGraph graph;
+
+  bool build(const std::string &code) {
+    Lexer lexer(code);
+    auto tokens = lexer.tokenize_all();
+    Parser parser(std::move(tokens));
+    stmts = parser.parse_program();
+    if (parser.has_errors() || !builder.collect(stmts, symbols)) {
+      return false;
+    }
+
+    std::vector<std::string> resolve_errors;
+    for (auto &stmt : stmts) {
+      OperatorResolver::resolve_stmt(stmt.get(), symbols.symbol_table(),
+                                     resolve_errors);
+    }
+    if (!resolve_errors.empty()) {
+      return false;
+    }
+
+    TypeChecker checker;
+    if (!checker.check(stmts, symbols)) {
+      return false;
+    }
+
+    graph.build(stmts);
+    return true;
+  }
+
+  std::vector<StmtPtr> stmts;
+};
+
+TEST_F(CallGraphTest, DirectAndTransitiveCalls) {
+  std::string code = R"(
+    func leaf(x: i32) : i32 { return x + 1; }
+    func middle(x: i32) : i32 { return leaf(x) * 2; }
+    func unused(x: i32) : i32 { return leaf(x); }
+    let y = middle(3);
+  )";
+  ASSERT_TRUE(build(code));
+
+  EXPECT_TRUE(graph.is_reachable(CallGraph::kEntryName));
+  EXPECT_TRUE(graph.is_reachable("middle"));
+  EXPECT_TRUE(graph.is_reachable("leaf"));
+  EXPECT_FALSE(graph.is_reachable("unused"));
+  EXPECT_TRUE(graph.is_reachable(stmts[0].get()));
+  EXPECT_FALSE(graph.is_reachable(stmts[2].get()));
+
+  EXPECT_EQ(graph.callees("unused").count("leaf"), 1u);
+  EXPECT_EQ(graph.callees(CallGraph::kEntryName).count("middle"), 1u);
+}
+
+TEST_F(CallGraphTest, RecursionAndForwardReference) {
+  std::string code = R"(
+    let r = even(4);
+    func even(n: i32) : bool {
+      if n == 0 { return true; }
+      return odd(n - 1);
+    }
+    func odd(n: i32) : bool {
+      if n == 0 { return false; }
+      return even(n - 1);
+    }
+  )";
+  ASSERT_TRUE(build(code));
+
+  EXPECT_TRUE(graph.is_reachable("even"));
+  EXPECT_TRUE(graph.is_reachable("odd"));
+}
+
+TEST_F(CallGraphTest, OperatorUsesResolveToOverloads) {
+  std::string code = R"(
+    operator infix *** (a: i32, b: i32) : i32 prec 80 assoc_left { return a * b; }
+    operator infix *** (a: f64, b: f64) : f64 prec 80 assoc_left { return a * b; }
+    operator prefix !! (a: i32) : i32 { return 0 - a; }
+    let x = 2 *** 3;
+  )";
+  ASSERT_TRUE(build(code));
+
+  EXPECT_TRUE(graph.is_reachable("***$i32$i32"));
+  EXPECT_FALSE(graph.is_reachable("***$f64$f64"));
+  EXPECT_FALSE(graph.is_reachable("!!$prefix$i32"));
+}
+
+TEST_F(CallGraphTest, OperatorBodyCallsFunction) {
+  std::string code = R"(
+    func helper(a: i32) : i32 { return a + 1; }
+    operator prefix !! (a: i32) : i32 { return helper(a); }
+    let x = !!5;
+  )";
+  ASSERT_TRUE(build(code));
+
+  EXPECT_TRUE(graph.is_reachable("!!$prefix$i32"));
+  EXPECT_TRUE(graph.is_reachable("helper"));
+}
+
+TEST_F(CallGraphTest, PrintMarksUnreachableAndExtern) {
+  std::string code = R"(
+    func used() : void { print_i32(1); }
+    func dead() : void { }
+    used();
+  )";
+  ASSERT_TRUE(build(code));
+
+  std::ostringstream os;
+  graph.print(os);
+  std::string text = os.str();
+  EXPECT_NE(text.find("__pecco_entry -> used"), std::string::npos);
+  EXPECT_NE(text.find("used -> print_i32 [extern]"), std::string::npos);
+  EXPECT_NE(text.find("dead [unreachable] -> (none)"), std::string::npos);
+}
@@ -1,18 +1,30 @@
 #include <gtest/gtest.h>
 
 #include "codegen.hpp"
+#include "compilation_session.hpp"
 #include "lexer.hpp"
 #include "operator_resolver.hpp"
 #include "parser.hpp"
 #include "symbol_table_builder.hpp"
 
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/TargetParser/Host.h>
+
+#include <algorithm>
 #include <fstream>
 #include <regex>
 
 namespace {
 
 // Helper to compile source code to IR
-std::string compileToIR(const std::string &source) {
+std::string compileToIR(const std::string &source,
+                        bool eliminate_dead_functions = false) {
   pecco::Lexer lexer(source);
   auto tokens = lexer.tokenize_all();
 
@@ -55,6 +67,7 @@ std::string compileToIR(const std::string &source) {
   }
 
   pecco::CodeGen codegen("test_module");
+  codegen.set_eliminate_dead_functions(eliminate_dead_functions);
   if (!codegen.generate(stmts, symbols)) {
     return "";
   }
@@ -62,6 +75,21 @@ std::string compileToIR(const std::string &source) {
   return codegen.get_ir();
 }
 
+// Helper to compile through the full pipeline, including the type checker
+// (signedness of integer operations comes from the checked types)
+std::string compileCheckedToIR(const std::string &source,
+                               llvm::FastMathFlags fast_math_flags = {}) {
+  pecco::CompileOptions options;
+  options.eliminate_dead_functions = false;
+  options.fast_math_flags = fast_math_flags;
+  pecco::CompilationSession session(options);
+  if (!session.compile(source)) {
+    ADD_FAILURE() << session.diagnostics().front().message;
+    return "";
+  }
+  return session.codegen()->get_ir();
+}
+
 // Helper to check if IR contains a pattern
 bool irContains(const std::string &ir, const std::string &pattern) {
   return ir.find(pattern) != std::string::npos;
@@ -681,6 +709,22 @@ TEST(CodeGenTest, WriteFunction) {
   EXPECT_TRUE(irContains(ir, "Hello"));
 }
 
+TEST(CodeGenTest, RuntimePrintFunctions) {
+  std::string source = R"(
+    print("Hello");
+    print_i32(42);
+    print_f64(1.5);
+    flush();
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "declare void @print(ptr)"));
+  EXPECT_TRUE(irContains(ir, "call void @print_i32(i32 42)"));
+  EXPECT_TRUE(irContains(ir, "call void @print_f64(double 1.500000e+00)"));
+  EXPECT_TRUE(irContains(ir, "call void @flush()"));
+}
+
 // ===== Entry Point =====
 
 TEST(CodeGenTest, EntryPointGeneration) {
@@ -1189,6 +1233,566 @@ TEST(CodeGenTest, BuiltinOperatorsPrioritized) {
   EXPECT_FALSE(irContains(ir, "call i32 @\"*$i32$i32\""));
 }
 
+// ===== Dead Function Elimination =====
+
+TEST(CodeGenTest, DeadFunctionsKeptByDefault) {
+  std::string source = R"(
+    func unused(x: i32) : i32 { return x; }
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "define i32 @unused"));
+}
+
+TEST(CodeGenTest, DeadFunctionsSkipped) {
+  std::string source = R"(
+    func helper(x: i32) : i32 { return x + 1; }
+    func used(x: i32) : i32 { return helper(x); }
+    func unused(x: i32) : i32 { return helper(x) * 2; }
+    operator infix %%(a: i32, b: i32) : i32 prec 80 assoc_left {
+      return a - b;
+    }
+    operator infix ^^(a: i32, b: i32) : i32 prec 80 assoc_left {
+      return a * b;
+    }
+    let r = used(1) %% 2;
+  )";
+  std::string ir = compileToIR(source, true);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "define i32 @used"));
+  EXPECT_TRUE(irContains(ir, "define i32 @helper"));
+  EXPECT_TRUE(irContains(ir, "define i32 @\"%%$i32$i32\""));
+  EXPECT_FALSE(irContains(ir, "define i32 @unused"));
+  EXPECT_FALSE(irContains(ir, "define i32 @\"^^$i32$i32\""));
+}
+
+// ===== Arrays =====
+
+TEST(CodeGenTest, LocalArray) {
+  std::string source = R"(
+    func f(n: i32) : f64 {
+      let xs: [8]f64;
+      xs[n] = 1.5;
+      return xs[n + 1];
+    }
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "alloca [8 x double]"));
+  // Zeroed where it is declared
+  EXPECT_TRUE(irContains(ir, "call void @llvm.memset"));
+  EXPECT_TRUE(irMatches(
+      ir, R"(getelementptr inbounds \[8 x double\], ptr %xs, i64 0, i64 %)"));
+  EXPECT_TRUE(irMatches(ir, R"(store double 1\.5.*, ptr %elemptr)"));
+  EXPECT_TRUE(irMatches(ir, R"(load double, ptr %elemptr)"));
+}
+
+TEST(CodeGenTest, GlobalArray) {
+  std::string source = R"(
+    let table: [16]i32;
+    func get(i: i32) : i32 { return table[i]; }
+    table[3] = get(2) + 1;
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(
+      irContains(ir, "@table = internal global [16 x i32] zeroinitializer"));
+  EXPECT_TRUE(irContains(ir, "getelementptr inbounds [16 x i32], ptr @table"));
+}
+
+TEST(CodeGenTest, ArrayParametersByReference) {
+  std::string source = R"(
+    func first(xs: [8]f64, m: [2][4]i32) : f64 {
+      m[1][3] = 7;
+      return xs[0];
+    }
+    let data: [8]f64;
+    let grid: [2][4]i32;
+    let x = first(data, grid);
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  // A pointer to the whole array, which the callee does not keep
+  EXPECT_TRUE(irMatches(ir, R"(define double @first\(ptr [^,]*nocapture[^,]*)"
+                            R"(dereferenceable\(64\) %0, ptr [^,]*)"
+                            R"(nocapture[^,]*dereferenceable\(32\) %1\))"));
+  EXPECT_TRUE(irContains(ir, "call double @first(ptr @data, ptr @grid)"));
+  EXPECT_TRUE(irMatches(
+      ir, R"(getelementptr inbounds \[2 x \[4 x i32\]\], ptr %1, i64 0)"));
+  EXPECT_TRUE(
+      irMatches(ir, R"(getelementptr inbounds \[4 x i32\], ptr %elemptr)"));
+}
+
+// Loop vectorizer remarks ("Vectorized") per function, after optimizing the
+// program for the host at the given level
+std::vector<std::string>
+vectorizedFunctions(const std::string &source, llvm::OptimizationLevel level,
+                    llvm::FastMathFlags fast_math_flags = {}) {
+  struct RemarkCollector : llvm::DiagnosticHandler {
+    std::vector<std::string> functions;
+
+    bool isAnyRemarkEnabled() const override { return true; }
+    bool isPassedOptRemarkEnabled(llvm::StringRef pass) const override {
+      return pass == "loop-vectorize";
+    }
+    bool handleDiagnostics(const llvm::DiagnosticInfo &info) override {
+      if (auto *remark = llvm::dyn_cast<llvm::OptimizationRemark>(&info)) {
+        if (remark->getPassName() == "loop-vectorize" &&
+            remark->getRemarkName() == "Vectorized") {
+          functions.push_back(remark->getFunction().getName().str());
+        }
+      }
+      return true;
+    }
+  };
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  std::string triple = llvm::sys::getProcessTriple();
+  std::string error;
+  const llvm::Target *target =
+      llvm::TargetRegistry::lookupTarget(triple, error);
+  if (!target) {
+    ADD_FAILURE() << error;
+    return {};
+  }
+  std::unique_ptr<llvm::TargetMachine> target_machine(
+      target->createTargetMachine(triple, "generic", "", {}, std::nullopt));
+
+  llvm::LLVMContext context;
+  auto collector = std::make_unique<RemarkCollector>();
+  RemarkCollector *remarks = collector.get();
+  context.setDiagnosticHandler(std::move(collector));
+
+  pecco::CompileOptions options;
+  options.eliminate_dead_functions = false;
+  options.fast_math_flags = fast_math_flags;
+  pecco::CompilationSession session(
+      options, pecco::CompilationSession::default_prelude());
+  if (!session.parse(source) || !session.analyze() ||
+      !session.generate(context)) {
+    ADD_FAILURE() << session.diagnostics().front().message;
+    return {};
+  }
+  llvm::Module &module = *session.codegen()->get_module();
+  module.setTargetTriple(triple);
+  module.setDataLayout(target_machine->createDataLayout());
+
+  llvm::LoopAnalysisManager loop_analyses;
+  llvm::FunctionAnalysisManager function_analyses;
+  llvm::CGSCCAnalysisManager cgscc_analyses;
+  llvm::ModuleAnalysisManager module_analyses;
+  llvm::PassBuilder pass_builder(target_machine.get());
+  pass_builder.registerModuleAnalyses(module_analyses);
+  pass_builder.registerCGSCCAnalyses(cgscc_analyses);
+  pass_builder.registerFunctionAnalyses(function_analyses);
+  pass_builder.registerLoopAnalyses(loop_analyses);
+  pass_builder.crossRegisterProxies(loop_analyses, function_analyses,
+                                    cgscc_analyses, module_analyses);
+  pass_builder.buildPerModuleDefaultPipeline(level).run(module,
+                                                        module_analyses);
+
+  return remarks->functions;
+}
+
+const char *kArrayLoops = R"(
+  func axpy(a: f64, x: [1024]f64, y: [1024]f64) : void {
+    let i = 0;
+    while i < 1024 {
+      let ax = a * x[i];
+      y[i] = ax + y[i];
+      i += 1;
+    }
+  }
+
+  func sum(xs: [1024]i32) : i32 {
+    let total = 0;
+    let i = 0;
+    while i < 1024 {
+      total += xs[i];
+      i += 1;
+    }
+    return total;
+  }
+
+  let data: [1024]i32;
+  let i = 0;
+  while i < 1024 {
+    data[i] = i * 3;
+    i += 1;
+  }
+  print_i32(sum(data));
+)";
+
+bool vectorized(const std::vector<std::string> &functions,
+                const std::string &name) {
+  return std::find(functions.begin(), functions.end(), name) !=
+         functions.end();
+}
+
+TEST(CodeGenTest, ArrayLoopsVectorizeAtO2) {
+  auto functions =
+      vectorizedFunctions(kArrayLoops, llvm::OptimizationLevel::O2);
+  EXPECT_TRUE(vectorized(functions, "axpy"));
+  EXPECT_TRUE(vectorized(functions, "sum"));
+  // The top-level loop over the global array
+  EXPECT_TRUE(vectorized(functions, "__pecco_entry"));
+}
+
+TEST(CodeGenTest, ArrayLoopsVectorizeAtO3) {
+  auto functions =
+      vectorizedFunctions(kArrayLoops, llvm::OptimizationLevel::O3);
+  EXPECT_TRUE(vectorized(functions, "axpy"));
+  EXPECT_TRUE(vectorized(functions, "sum"));
+  EXPECT_TRUE(vectorized(functions, "__pecco_entry"));
+}
+
+// Reassociating the sum is what lets the vectorizer split it into lanes
+const char *kFloatSum = R"(
+  func total(xs: [1024]f32) : f32 {
+    let sum = 0.0f32;
+    let i = 0;
+    while i < 1024 {
+      sum += xs[i];
+      i += 1;
+    }
+    return sum;
+  }
+)";
+
+TEST(CodeGenTest, FloatReductionsVectorizeOnlyWithFastMath) {
+  auto strict = vectorizedFunctions(kFloatSum, llvm::OptimizationLevel::O2);
+  EXPECT_FALSE(vectorized(strict, "total"));
+
+  llvm::FastMathFlags fast;
+  fast.setFast();
+  auto relaxed =
+      vectorizedFunctions(kFloatSum, llvm::OptimizationLevel::O2, fast);
+  EXPECT_TRUE(vectorized(relaxed, "total"));
+}
+
+// ===== SIMD vectors =====
+
+TEST(CodeGenTest, VectorArithmetic) {
+  std::string source = R"(
+    func blend(a: f64x4, b: f64x4) : f64x4 {
+      let m = a < b;
+      return select(m, a * b, -a);
+    }
+    func mix(v: i32x8, s: i32) : i32x8 {
+      return (v + i32x8(s)) >> i32x8(1);
+    }
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(
+      ir, "define <4 x double> @blend(<4 x double> %0, <4 x double> %1)"));
+  EXPECT_TRUE(irContains(ir, "fcmp olt <4 x double>"));
+  EXPECT_TRUE(irContains(ir, "fmul <4 x double>"));
+  EXPECT_TRUE(irContains(ir, "fneg <4 x double>"));
+  EXPECT_TRUE(irMatches(ir, R"(select <4 x i1> %m\d*, <4 x double>)"));
+  EXPECT_TRUE(irContains(ir, "add <8 x i32>"));
+  EXPECT_TRUE(irContains(ir, "ashr <8 x i32>"));
+  // Splat of a runtime value
+  EXPECT_TRUE(irContains(ir, "shufflevector <8 x i32> %splat.splatinsert"));
+  // Builtins are lowered in place, not declared as functions
+  EXPECT_FALSE(irContains(ir, "@select"));
+  EXPECT_FALSE(irContains(ir, "@i32x8"));
+}
+
+TEST(CodeGenTest, VectorBuiltins) {
+  std::string source = R"(
+    func lanes(a: f64x4, b: f64x4) : f64 {
+      let s = shuffle(a, b, 3, 2, 5, 4);
+      let t = insert(s, 1, 0.5);
+      return extract(t, 0) + reduce_add(t) + reduce_max(t);
+    }
+    func ints(v: i32x4) : bool {
+      return reduce_min(v) < reduce_mul(v) && all(v != i32x4(0, 1, 2, 3));
+    }
+  )";
+  std::string ir = compileToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irMatches(
+      ir, R"(shufflevector <4 x double> %a\d*, <4 x double> %b\d*, )"
+          R"(<4 x i32> <i32 3, i32 2, i32 5, i32 4>)"));
+  EXPECT_TRUE(irContains(ir, "insertelement <4 x double> %s"));
+  EXPECT_TRUE(irContains(ir, "extractelement <4 x double> %t"));
+  // Lane-order sum starting from -0.0
+  EXPECT_TRUE(irContains(
+      ir, "@llvm.vector.reduce.fadd.v4f64(double -0.000000e+00"));
+  EXPECT_TRUE(irContains(ir, "@llvm.vector.reduce.fmax.v4f64"));
+  EXPECT_TRUE(irContains(ir, "@llvm.vector.reduce.smin.v4i32"));
+  EXPECT_TRUE(irContains(ir, "@llvm.vector.reduce.mul.v4i32"));
+  EXPECT_TRUE(irContains(ir, "@llvm.vector.reduce.and.v4i1"));
+}
+
+// ===== Integer widths =====
+
+TEST(CodeGenTest, UnsignedIntegerOperations) {
+  std::string source = R"(
+    func ops(a: u32, b: u32) : u32 {
+      if (a < b) {
+        return a / b;
+      }
+      return (a % b) >> 2;
+    }
+    func signed_ops(a: i64, b: i64) : i64 {
+      if (a < b) {
+        return a / b;
+      }
+      return (a % b) >> 2;
+    }
+  )";
+  std::string ir = compileCheckedToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "define i32 @ops(i32 %0, i32 %1)"));
+  EXPECT_TRUE(irContains(ir, "icmp ult i32"));
+  EXPECT_TRUE(irContains(ir, "udiv i32"));
+  EXPECT_TRUE(irContains(ir, "urem i32"));
+  EXPECT_TRUE(irContains(ir, "lshr i32"));
+  EXPECT_TRUE(irContains(ir, "define i64 @signed_ops(i64 %0, i64 %1)"));
+  EXPECT_TRUE(irContains(ir, "icmp slt i64"));
+  EXPECT_TRUE(irContains(ir, "sdiv i64"));
+  EXPECT_TRUE(irContains(ir, "srem i64"));
+  // The i32 shift amount is widened to the shifted type
+  EXPECT_TRUE(irContains(ir, "ashr i64 %modtmp, 2"));
+}
+
+TEST(CodeGenTest, IntegerLiteralsAndConversions) {
+  std::string source = R"(
+    func widen(a: i8, b: u8) : i64 {
+      return i64(a) + i64(b) + 4294967296i64;
+    }
+    func narrow(a: i64) : u8 {
+      return u8(a) + 200u8;
+    }
+    func floats(x: f64, n: u32) : f64 {
+      return f64(i32(x)) + f64(n) + f64(u64(x));
+    }
+  )";
+  std::string ir = compileCheckedToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irMatches(ir, R"(sext i8 %a\d* to i64)"));
+  EXPECT_TRUE(irMatches(ir, R"(zext i8 %b\d* to i64)"));
+  EXPECT_TRUE(irContains(ir, "4294967296"));
+  EXPECT_TRUE(irMatches(ir, R"(trunc i64 %a\d* to i8)"));
+  // 200u8 is printed as a signed i8
+  EXPECT_TRUE(irContains(ir, "add i8 %conv, -56"));
+  EXPECT_TRUE(irContains(ir, "@llvm.fptosi.sat.i32.f64"));
+  EXPECT_TRUE(irContains(ir, "@llvm.fptoui.sat.i64.f64"));
+  EXPECT_TRUE(irContains(ir, "sitofp i32"));
+  EXPECT_TRUE(irContains(ir, "uitofp i32"));
+  // Conversions are lowered in place, not declared as functions
+  EXPECT_FALSE(irContains(ir, "@i64("));
+  EXPECT_FALSE(irContains(ir, "@f64("));
+}
+
+// ===== f32 and fast-math =====
+
+TEST(CodeGenTest, Float32Operations) {
+  std::string source = R"(
+    func scale(x: f32, y: f32) : f32 {
+      return x * 1.5f32 + y ** 2f32;
+    }
+    func widen(x: f32, d: f64) : f64 {
+      return f64(x) + f64(f32(d)) + f64(i32(x));
+    }
+  )";
+  std::string ir = compileCheckedToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "define float @scale(float %0, float %1)"));
+  EXPECT_TRUE(irMatches(ir, R"(fmul float %x\d*, 1\.500000e\+00)"));
+  EXPECT_TRUE(irContains(ir, "@llvm.pow.f32"));
+  EXPECT_TRUE(irContains(ir, "fadd float"));
+  EXPECT_TRUE(irMatches(ir, R"(fpext float %x\d* to double)"));
+  EXPECT_TRUE(irMatches(ir, R"(fptrunc double %d\d* to float)"));
+  EXPECT_TRUE(irContains(ir, "@llvm.fptosi.sat.i32.f32"));
+  // Strict IEEE semantics by default
+  EXPECT_FALSE(irContains(ir, "fast"));
+}
+
+TEST(CodeGenTest, FastMathFlags) {
+  std::string source = R"(
+    func muladd(a: f64, b: f64, c: f64) : f64 {
+      if (a < b) {
+        return a * b + c;
+      }
+      return c;
+    }
+  )";
+
+  llvm::FastMathFlags fast;
+  fast.setFast();
+  std::string ir = compileCheckedToIR(source, fast);
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "fcmp fast olt double"));
+  EXPECT_TRUE(irContains(ir, "fmul fast double"));
+  EXPECT_TRUE(irContains(ir, "fadd fast double"));
+  EXPECT_TRUE(irContains(ir, "\"unsafe-fp-math\"=\"true\""));
+  EXPECT_TRUE(irContains(ir, "\"no-nans-fp-math\"=\"true\""));
+
+  llvm::FastMathFlags contract;
+  contract.setAllowContract();
+  ir = compileCheckedToIR(source, contract);
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "fmul contract double"));
+  EXPECT_TRUE(irContains(ir, "fadd contract double"));
+  EXPECT_FALSE(irContains(ir, "fp-math"));
+
+  llvm::FastMathFlags no_nans;
+  no_nans.setNoNaNs();
+  ir = compileCheckedToIR(source, no_nans);
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irContains(ir, "fcmp nnan olt double"));
+  EXPECT_TRUE(irContains(ir, "\"no-nans-fp-math\"=\"true\""));
+  EXPECT_FALSE(irContains(ir, "unsafe-fp-math"));
+}
+
+// Assembly of the program optimized at O2 for x86-64 with AVX2
+std::string compileToAVX2Assembly(const std::string &source) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  std::string triple = "x86_64-unknown-linux-gnu";
+  std::string error;
+  const llvm::Target *target =
+      llvm::TargetRegistry::lookupTarget(triple, error);
+  if (!target) {
+    return "";
+  }
+  std::unique_ptr<llvm::TargetMachine> target_machine(
+      target->createTargetMachine(triple, "haswell", "", {}, std::nullopt));
+
+  pecco::CompileOptions options;
+  options.eliminate_dead_functions = false;
+  pecco::CompilationSession session(options);
+  if (!session.compile(source)) {
+    ADD_FAILURE() << session.diagnostics().front().message;
+    return "";
+  }
+  llvm::Module &module = *session.codegen()->get_module();
+  module.setTargetTriple(triple);
+  module.setDataLayout(target_machine->createDataLayout());
+
+  llvm::LoopAnalysisManager loop_analyses;
+  llvm::FunctionAnalysisManager function_analyses;
+  llvm::CGSCCAnalysisManager cgscc_analyses;
+  llvm::ModuleAnalysisManager module_analyses;
+  llvm::PassBuilder pass_builder(target_machine.get());
+  pass_builder.registerModuleAnalyses(module_analyses);
+  pass_builder.registerCGSCCAnalyses(cgscc_analyses);
+  pass_builder.registerFunctionAnalyses(function_analyses);
+  pass_builder.registerLoopAnalyses(loop_analyses);
+  pass_builder.crossRegisterProxies(loop_analyses, function_analyses,
+                                    cgscc_analyses, module_analyses);
+  pass_builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2)
+      .run(module, module_analyses);
+
+  llvm::SmallVector<char, 0> assembly;
+  llvm::raw_svector_ostream stream(assembly);
+  llvm::legacy::PassManager emitter;
+  if (target_machine->addPassesToEmitFile(
+          emitter, stream, nullptr, llvm::CodeGenFileType::AssemblyFile)) {
+    ADD_FAILURE() << "cannot emit assembly";
+    return "";
+  }
+  emitter.run(module);
+  return std::string(assembly.begin(), assembly.end());
+}
+
+TEST(CodeGenTest, VectorArithmeticIsOneAVX2Instruction) {
+  std::string source = R"(
+    func add4(a: f64x4, b: f64x4) : f64x4 { return a + b; }
+    func mul8(a: i32x8, b: i32x8) : i32x8 { return a * b; }
+  )";
+  std::string assembly = compileToAVX2Assembly(source);
+  if (assembly.empty()) {
+    GTEST_SKIP() << "x86-64 target not available";
+  }
+
+  // The whole function body: the instruction and the return
+  auto single = [](const std::string &func, const std::string &instruction) {
+    return std::regex(func + R"(:[^\n]*\n(#[^\n]*\n)?\s*)" + instruction +
+                      R"(\s+%ymm[01], %ymm[01], %ymm0\n\s*retq)");
+  };
+  EXPECT_TRUE(std::regex_search(assembly, single("add4", "vaddpd")))
+      << assembly;
+  EXPECT_TRUE(std::regex_search(assembly, single("mul8", "vpmulld")))
+      << assembly;
+}
+
+// ===== Bit manipulation =====
+
+TEST(CodeGenTest, BitBuiltins) {
+  std::string source = R"(
+    func bits(x: u64, y: i16, b: u8) : i32 {
+      return popcount(x) + clz(y) + ctz(b);
+    }
+    func mix(x: u32, n: i32) : u32 {
+      return rotl(x, n) ^ rotr(x, 7) ^ bswap(x) ^ bitreverse(x);
+    }
+    func byte(b: u8) : u8 { return bswap(b); }
+  )";
+  std::string ir = compileCheckedToIR(source);
+
+  ASSERT_FALSE(ir.empty());
+  EXPECT_TRUE(irMatches(ir, R"(call i64 @llvm.ctpop.i64\(i64 %x\d*\))"));
+  EXPECT_TRUE(
+      irMatches(ir, R"(call i16 @llvm.ctlz.i16\(i16 %y\d*, i1 false\))"));
+  EXPECT_TRUE(irMatches(ir, R"(call i8 @llvm.cttz.i8\(i8 %b\d*, i1 false\))"));
+  // Counts are i32
+  EXPECT_TRUE(irContains(ir, "trunc i64"));
+  EXPECT_TRUE(irContains(ir, "zext i16"));
+  EXPECT_TRUE(irMatches(
+      ir, R"(call i32 @llvm.fshl.i32\(i32 %x\d*, i32 %x\d*, i32 %n\d*\))"));
+  EXPECT_TRUE(irMatches(
+      ir, R"(call i32 @llvm.fshr.i32\(i32 %x\d*, i32 %x\d*, i32 7\))"));
+  EXPECT_TRUE(irContains(ir, "@llvm.bswap.i32"));
+  EXPECT_TRUE(irContains(ir, "@llvm.bitreverse.i32"));
+  // A single byte has nothing to swap
+  EXPECT_FALSE(irContains(ir, "@llvm.bswap.i8"));
+  EXPECT_FALSE(irContains(ir, "@popcount"));
+}
+
+TEST(CodeGenTest, BitBuiltinsAreSingleInstructions) {
+  std::string source = R"(
+    func pc(x: u64) : i32 { return popcount(x); }
+    func lz(x: u64) : i32 { return clz(x); }
+    func tz(x: u64) : i32 { return ctz(x); }
+    func rot(x: u64, n: i32) : u64 { return rotl(x, n); }
+    func swap(x: u64) : u64 { return bswap(x); }
+  )";
+  // Haswell has POPCNT, LZCNT and BMI1 (TZCNT)
+  std::string assembly = compileToAVX2Assembly(source);
+  if (assembly.empty()) {
+    GTEST_SKIP() << "x86-64 target not available";
+  }
+
+  // The function body: register moves, the instruction and the return
+  auto single = [](const std::string &func, const std::string &instruction) {
+    return std::regex(func + R"(:[^\n]*\n(#[^\n]*\n)?)" +
+                      R"((\s*mov[lq]\s[^\n]*\n)*\s*)" + instruction +
+                      R"(\s[^\n]*\n\s*retq)");
+  };
+  EXPECT_TRUE(std::regex_search(assembly, single("pc", "popcntq")))
+      << assembly;
+  EXPECT_TRUE(std::regex_search(assembly, single("lz", "lzcntq"))) << assembly;
+  EXPECT_TRUE(std::regex_search(assembly, single("tz", "tzcntq"))) << assembly;
+  EXPECT_TRUE(std::regex_search(assembly, single("rot", "rolq"))) << assembly;
+  EXPECT_TRUE(std::regex_search(assembly, single("swap", "bswapq")))
+      << assembly;
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
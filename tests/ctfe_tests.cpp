@@ -0,0 +1,187 @@
+#include "ctfe.hpp"
+#include "lexer.hpp"
+#include "operator_resolver.hpp"
+#include "parser.hpp"
+#include "scope.hpp"
+#include "symbol_table_builder.hpp"
+#include "type_checker.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace pecco;
+
+class CtfeTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    builder.load_prelude(STDLIB_DIR "/prelude.pec", symbols);
+  }
+
+  ScopedSymbolTable symbols;
+  SymbolTableBuilder builder;
+  std::vector<StmtPtr> stmts;
+
+  // Parse, resolve, type check and run only the compile-time evaluation pass
+  bool evaluate(const std::string &code,
+                uint64_t step_budget = ConstEvaluator::kDefaultStepBudget) {
+    Lexer lexer(code);
+    auto tokens = lexer.tokenize_all();
+    Parser parser(std::move(tokens));
+    stmts = parser.parse_program();
+    if (parser.has_errors() || !builder.collect(stmts, symbols)) {
+      return false;
+    }
+
+    std::vector<std::string> resolve_errors;
+    for (auto &stmt : stmts) {
+      OperatorResolver::resolve_stmt(stmt.get(), symbols.symbol_table(),
+                                     resolve_errors);
+    }
+    TypeChecker checker;
+    if (!resolve_errors.empty() || !checker.check(stmts, symbols)) {
+      return false;
+    }
+
+    CompileTimeEvaluationPass(step_budget).run(stmts);
+    return true;
+  }
+
+  const Expr *let_init(size_t index) const {
+    return static_cast<const LetStmt *>(stmts[index].get())->init.get();
+  }
+
+  const Expr *expr_at(size_t index) const {
+    return static_cast<const ExprStmt *>(stmts[index].get())->expr.get();
+  }
+
+  static std::string int_value(const Expr *expr) {
+    if (expr->kind != ExprKind::IntLiteral)
+      return "<not folded>";
+    return static_cast<const IntLiteralExpr *>(expr)->value;
+  }
+};
+
+TEST_F(CtfeTest, EvaluatesUserDefinedOperator) {
+  ASSERT_TRUE(evaluate(R"(
+    operator infix ** (base: i32, exp: i32) : i32 prec 90 assoc_right {
+      let result = 1;
+      let i = 0;
+      while i < exp {
+        result = result * base;
+        i = i + 1;
+      }
+      return result;
+    }
+    exit(3 ** 4);
+  )"));
+
+  auto *call = static_cast<const CallExpr *>(expr_at(1));
+  EXPECT_EQ(int_value(call->args[0].get()), "81");
+}
+
+TEST_F(CtfeTest, EvaluatesRecursion) {
+  ASSERT_TRUE(evaluate(R"(
+    func fib(n: i32) : i32 {
+      if n < 2 { return n; }
+      return fib(n - 1) + fib(n - 2);
+    }
+    let x = fib(30);
+  )"));
+
+  // Memoization keeps the naive recursion cheap
+  EXPECT_EQ(int_value(let_init(1)), "832040");
+}
+
+TEST_F(CtfeTest, EvaluatesFloatAndBool) {
+  ASSERT_TRUE(evaluate(R"(
+    func half(x: f64) : f64 { return x / 2.0; }
+    func is_even(n: i32) : bool { return n % 2 == 0; }
+    let a = half(5.0);
+    let b = is_even(10);
+  )"));
+
+  ASSERT_EQ(let_init(2)->kind, ExprKind::FloatLiteral);
+  ASSERT_EQ(let_init(3)->kind, ExprKind::BoolLiteral);
+  EXPECT_TRUE(static_cast<const BoolLiteralExpr *>(let_init(3))->value);
+}
+
+TEST_F(CtfeTest, BudgetExhaustionKeepsCall) {
+  ASSERT_TRUE(evaluate(R"(
+    func spin(n: i32) : i32 {
+      let i = 0;
+      while i < n { i = i + 1; }
+      return i;
+    }
+    let x = spin(1000);
+    let y = spin(3);
+  )",
+                       200));
+
+  EXPECT_EQ(let_init(1)->kind, ExprKind::Call);
+  EXPECT_EQ(int_value(let_init(2)), "3");
+}
+
+TEST_F(CtfeTest, InfiniteRecursionKeepsCall) {
+  ASSERT_TRUE(evaluate(R"(
+    func forever(n: i32) : i32 { return forever(n + 1); }
+    let x = forever(0);
+  )"));
+
+  EXPECT_EQ(let_init(1)->kind, ExprKind::Call);
+}
+
+TEST_F(CtfeTest, ImpureFunctionsNotEvaluated) {
+  ASSERT_TRUE(evaluate(R"(
+    func noisy(x: i32) : i32 {
+      print("called\n");
+      return x;
+    }
+    func wrapper(x: i32) : i32 { return noisy(x) + 1; }
+    let a = noisy(1);
+    let b = wrapper(2);
+  )"));
+
+  EXPECT_EQ(let_init(2)->kind, ExprKind::Call);
+  EXPECT_EQ(let_init(3)->kind, ExprKind::Call);
+}
+
+TEST_F(CtfeTest, UndefinedBehaviorNotEvaluated) {
+  ASSERT_TRUE(evaluate(R"(
+    func div(a: i32, b: i32) : i32 { return a / b; }
+    let x = div(1, 0);
+    let y = div(7, 2);
+  )"));
+
+  EXPECT_EQ(let_init(1)->kind, ExprKind::Call);
+  EXPECT_EQ(int_value(let_init(2)), "3");
+}
+
+TEST_F(CtfeTest, PropagatesTopLevelConstants) {
+  ASSERT_TRUE(evaluate(R"(
+    func square(x: i32) : i32 { return x * x; }
+    let n = 4;
+    let sq = square(n);
+    let counter = 0;
+    counter = counter + 1;
+    let next = counter + sq;
+  )"));
+
+  EXPECT_EQ(int_value(let_init(2)), "16");
+  // counter is reassigned, so only sq is substituted
+  auto *next = static_cast<const BinaryExpr *>(let_init(5));
+  ASSERT_EQ(next->kind, ExprKind::Binary);
+  EXPECT_EQ(next->left->kind, ExprKind::Identifier);
+  EXPECT_EQ(int_value(next->right.get()), "16");
+}
+
+TEST_F(CtfeTest, BuiltinOperatorsTakePrecedence) {
+  // Codegen always lowers i32 + to an add instruction, so the user overload
+  // must not be evaluated either
+  ASSERT_TRUE(evaluate(R"(
+    operator infix + (a: i32, b: i32) : i32 prec 70 assoc_left {
+      return 0;
+    }
+    let x = 2 + 3;
+  )"));
+
+  EXPECT_EQ(int_value(let_init(1)), "5");
+}
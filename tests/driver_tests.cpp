@@ -1,11 +1,19 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <csignal>
 #include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
 #ifndef PLC_BINARY
 #define PLC_BINARY "./build/src/plc"
@@ -31,6 +39,29 @@ std::string runCommand(const std::string &cmd) {
   return result;
 }
 
+// 独立的工作目录：plc 以输入文件名命名中间目标文件和默认的可执行文件，
+// 共用同一测试输入的用例在 ctest -j 下并行运行时不能共用当前目录
+class ScratchDir {
+public:
+  ScratchDir() {
+    char path[] = "/tmp/plc-driver-test-XXXXXX";
+    if (!mkdtemp(path)) {
+      throw std::runtime_error("mkdtemp() failed!");
+    }
+    path_ = path;
+  }
+  ~ScratchDir() { std::system(("rm -rf " + path_).c_str()); }
+
+  // 加在命令前，使 plc 在该目录中运行
+  std::string cd() const { return "cd " + path_ + " && "; }
+  std::string file(const std::string &name) const {
+    return path_ + "/" + name;
+  }
+
+private:
+  std::string path_;
+};
+
 TEST(PlcDriverTest, LexSampleFile) {
   std::string cmd =
       std::string(PLC_BINARY) + " --lex " + TEST_FIXTURES_DIR + "/sample.pec";
@@ -153,6 +184,70 @@ TEST(PlcDriverTest, DumpSymbolTable) {
   EXPECT_TRUE(output.find("infix *") != std::string::npos);
 }
 
+TEST(PlcDriverTest, DumpSymbolsWithoutTypeChecking) {
+  ScratchDir dir;
+  std::string source = dir.file("untyped.pec");
+  std::ofstream(source) << "func f(x: i32) : i32 {\n"
+                           "  if x > 0 { let y = x; }\n"
+                           "  return missing(x);\n"
+                           "}\n";
+  std::string plc = std::string(PLC_BINARY) + " " + source;
+
+  // 单独的 --dump-symbols 只收集声明和作用域，不检查函数体的类型
+  std::string symbols = runCommand(plc + " --dump-symbols --hide-prelude");
+  EXPECT_TRUE(symbols.find("f(i32) : i32") != std::string::npos) << symbols;
+  EXPECT_TRUE(symbols.find("Scope [block #1 at line 2]:") !=
+              std::string::npos)
+      << symbols;
+  EXPECT_TRUE(symbols.find("error") == std::string::npos) << symbols;
+  std::string ir = runCommand(plc + " --emit-llvm");
+  EXPECT_TRUE(ir.find("Unknown function 'missing'") != std::string::npos);
+
+  // 作用域和操作符解析的错误照常报告
+  std::string resolve_error =
+      runCommand(std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                 "/semantic_error.pec --dump-symbols");
+  EXPECT_TRUE(resolve_error.find("Mixed associativity") != std::string::npos);
+}
+
+TEST(PlcDriverTest, DumpCallGraph) {
+  std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                    "/size_test.pec --dump-callgraph";
+  std::string output = runCommand(cmd);
+
+  EXPECT_TRUE(output.find("Call Graph:") != std::string::npos);
+  EXPECT_TRUE(output.find("__pecco_entry -> print [extern], print_i32 "
+                          "[extern], square") != std::string::npos);
+  EXPECT_TRUE(output.find("unused_helper [unreachable]") != std::string::npos);
+  // 只输出调用图，不生成可执行文件
+  EXPECT_TRUE(output.find("Executable generated:") == std::string::npos);
+}
+
+TEST(PlcDriverTest, DeadFunctionsNotEmitted) {
+  std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                    "/size_test.pec --emit-llvm --no-ast-opt";
+  std::string output = runCommand(cmd);
+
+  // 关闭 AST 优化，否则 square(6) 会在编译期求值
+  EXPECT_TRUE(output.find("define i32 @square") != std::string::npos);
+  EXPECT_TRUE(output.find("define i32 @unused_helper") == std::string::npos);
+}
+
+TEST(PlcDriverTest, AstOptimizationRemovesDeadBranch) {
+  std::string base = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                     "/ast_opt_test.pec ";
+
+  std::string ir = runCommand(base + "--emit-llvm");
+  EXPECT_TRUE(ir.find("never printed") == std::string::npos);
+
+  // --no-ast-opt 保留原始 AST
+  std::string raw_ir = runCommand(base + "--emit-llvm --no-ast-opt");
+  EXPECT_TRUE(raw_ir.find("never printed") != std::string::npos);
+
+  std::string run_cmd = base + "--run";
+  EXPECT_EQ(WEXITSTATUS(system(run_cmd.c_str())), 14);
+}
+
 TEST(PlcDriverTest, SemanticErrorReporting) {
   std::string cmd =
       std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR + "/semantic_error.pec";
@@ -187,7 +282,7 @@ TEST(PlcDriverTest, DumpResolvedAST) {
 
 TEST(PlcDriverTest, EmitLLVM) {
   std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
-                    "/simple_ir_test.pec --emit-llvm";
+                    "/simple_ir_test.pec --emit-llvm --no-ast-opt";
   std::string output = runCommand(cmd);
 
   // Should contain LLVM IR module definition
@@ -247,7 +342,7 @@ TEST(PlcDriverTest, CompileOnlyMode) {
 TEST(PlcDriverTest, OptimizationFlag) {
   // Test --opt with --emit-llvm
   std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
-                    "/opt_test.pec --opt --emit-llvm";
+                    "/opt_test.pec --opt --emit-llvm --no-ast-opt";
   std::string output = runCommand(cmd);
 
   // Optimized version should simplify add_constant to a single add
@@ -276,6 +371,38 @@ TEST(PlcDriverTest, OptimizationFlag) {
   EXPECT_LE(alloca_count, 1);
 }
 
+TEST(PlcDriverTest, FloatingPointOptions) {
+  std::string base = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                     "/fast_math_test.pec --emit-llvm --no-ast-opt ";
+
+  // 默认严格 IEEE 语义
+  std::string strict = runCommand(base);
+  EXPECT_TRUE(strict.find("fmul double") != std::string::npos);
+  EXPECT_TRUE(strict.find("fadd float") != std::string::npos);
+
+  std::string fast = runCommand(base + "--ffast-math");
+  EXPECT_TRUE(fast.find("fmul fast double") != std::string::npos);
+  EXPECT_TRUE(fast.find("fadd fast float") != std::string::npos);
+
+  std::string contract = runCommand(base + "--fp-contract=fast");
+  EXPECT_TRUE(contract.find("fmul contract double") != std::string::npos);
+
+  // --fp-contract=off 去掉 --ffast-math 中的 contract
+  std::string no_contract =
+      runCommand(base + "--ffast-math --fp-contract=off");
+  EXPECT_TRUE(no_contract.find(
+                  "fmul reassoc nnan ninf nsz arcp afn double") !=
+              std::string::npos);
+
+  std::string no_nans = runCommand(base + "--fno-honor-nans");
+  EXPECT_TRUE(no_nans.find("fmul nnan double") != std::string::npos);
+
+  std::string run = runCommand(std::string(PLC_BINARY) + " " +
+                               TEST_FIXTURES_DIR +
+                               "/fast_math_test.pec --opt --ffast-math --run");
+  EXPECT_EQ(run, "9\n");
+}
+
 TEST(PlcDriverTest, OptimizationWithRun) {
   // Test that --opt with --run produces correct result
   std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
@@ -303,6 +430,402 @@ TEST(PlcDriverTest, OptimizationConsistency) {
   EXPECT_EQ(exit_unopt, 8);
 }
 
+TEST(PlcDriverTest, RuntimeBufferedOutput) {
+  // print/write 经过运行时缓冲区，main 正常返回时刷新
+  ScratchDir dir;
+  std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                    "/print_test.pec --run";
+  std::string output = runCommand(cmd);
+
+  EXPECT_EQ(output, "0 1 2 \n-2147483648\n3.25\n-0.1\n1e+20\n");
+}
+
+TEST(PlcDriverTest, RuntimeFlushOnExit) {
+  // exit 之前缓冲的输出不能丢失
+  ScratchDir dir;
+  std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                    "/print_exit_test.pec --run; echo \"status=$?\"";
+  std::string output = runCommand(cmd);
+
+  EXPECT_EQ(output, "before exit\nstatus=7\n");
+}
+
+TEST(PlcDriverTest, FreestandingRun) {
+  // --freestanding 不依赖 libc，输出与默认模式一致
+  ScratchDir dir;
+  std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                    "/print_test.pec --freestanding --run";
+  std::string output = runCommand(cmd);
+
+  EXPECT_EQ(output, "0 1 2 \n-2147483648\n3.25\n-0.1\n1e+20\n");
+
+  std::string exit_cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                         "/exit_test.pec --freestanding --run";
+  EXPECT_EQ(WEXITSTATUS(system(exit_cmd.c_str())), 42);
+}
+
+TEST(PlcDriverTest, FreestandingStaticExecutable) {
+  ScratchDir dir;
+  std::string exe_file = dir.file("freestanding_test");
+
+  std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                    "/exit_test.pec --freestanding -o " + exe_file;
+  std::string output = runCommand(cmd);
+  EXPECT_TRUE(output.find("Executable generated:") != std::string::npos);
+
+  // 静态程序不应引用动态加载器
+  std::ifstream file(exe_file, std::ios::binary);
+  ASSERT_TRUE(file.good());
+  std::stringstream contents;
+  contents << file.rdbuf();
+  file.close();
+  EXPECT_TRUE(contents.str().find("ld-linux") == std::string::npos);
+}
+
+TEST(PlcDriverTest, SizeOptimizedRun) {
+  // -Os/-Oz 不改变程序行为
+  ScratchDir dir;
+  for (const char *level : {"-Os", "-Oz"}) {
+    std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                      "/size_test.pec " + level + " --run";
+    EXPECT_EQ(runCommand(cmd), "36\n") << level;
+  }
+
+  std::string exit_cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                         "/print_exit_test.pec -Oz --run; echo \"status=$?\"";
+  EXPECT_EQ(runCommand(exit_cmd), "before exit\nstatus=7\n");
+}
+
+TEST(PlcDriverTest, SizeReport) {
+  ScratchDir dir;
+  std::string exe_file = dir.file("size_report_test");
+
+  std::string cmd = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                    "/size_test.pec -Os --size-report -o " + exe_file;
+  std::string output = runCommand(cmd);
+
+  EXPECT_TRUE(output.find("Size report (.text):") != std::string::npos);
+  EXPECT_TRUE(output.find(" main\n") != std::string::npos);
+  EXPECT_TRUE(output.find(" total\n") != std::string::npos);
+  // 未被引用的函数与运行时函数应被回收
+  EXPECT_TRUE(output.find("unused_helper") == std::string::npos);
+  EXPECT_TRUE(output.find("print_f64") == std::string::npos);
+  EXPECT_TRUE(output.find("Executable generated:") != std::string::npos);
+
+  // 报告之后重新链接：输出的可执行文件没有符号表
+  std::ifstream exe(exe_file, std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(exe)),
+                       std::istreambuf_iterator<char>());
+  ASSERT_FALSE(contents.empty());
+  EXPECT_EQ(contents.find(".symtab"), std::string::npos);
+}
+
+TEST(PlcDriverTest, SizeOptimizedExecutableIsSmaller) {
+  ScratchDir dir;
+  std::string default_exe = dir.file("size_default_test");
+  std::string small_exe = dir.file("size_small_test");
+
+  std::string base = dir.cd() + PLC_BINARY + " " + TEST_FIXTURES_DIR +
+                     "/print_test.pec ";
+  runCommand(base + "-o " + default_exe);
+  runCommand(base + "-Oz -o " + small_exe);
+
+  std::ifstream default_file(default_exe, std::ios::binary | std::ios::ate);
+  std::ifstream small_file(small_exe, std::ios::binary | std::ios::ate);
+  ASSERT_TRUE(default_file.good());
+  ASSERT_TRUE(small_file.good());
+  EXPECT_LT(small_file.tellg(), default_file.tellg());
+}
+
+TEST(PlcDriverTest, TimePhases) {
+  std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                    "/exit_test.pec --compile -o time_phases.o --time-phases";
+  std::string output = runCommand(cmd);
+  std::remove("time_phases.o");
+
+  EXPECT_NE(output.find("Phases (ms):"), std::string::npos) << output;
+  for (const char *phase :
+       {"read", "parse", "prelude", "target", "analyze", "codegen", "emit",
+        "total"}) {
+    EXPECT_NE(output.find(std::string("  ") + phase + " "), std::string::npos)
+        << phase << "\n"
+        << output;
+  }
+}
+
+TEST(PlcDriverTest, BatchCompilesListedFiles) {
+  std::string list = "batch_list.txt";
+  {
+    std::ofstream out(list);
+    out << "# fixtures\n"
+        << TEST_FIXTURES_DIR << "/exit_test.pec\n\n"
+        << TEST_FIXTURES_DIR << "/print_test.pec\n";
+  }
+  std::string cmd = std::string(PLC_BINARY) + " --batch " + list +
+                    " -o batch_out 2>&1; echo \"status=$?\"";
+  std::string output = runCommand(cmd);
+
+  EXPECT_NE(output.find("compiled 2/2 files"), std::string::npos) << output;
+  EXPECT_NE(output.find("files/s"), std::string::npos) << output;
+  EXPECT_NE(output.find("status=0"), std::string::npos) << output;
+  EXPECT_TRUE(std::ifstream("batch_out/exit_test.o").good());
+  EXPECT_TRUE(std::ifstream("batch_out/print_test.o").good());
+
+  std::remove("batch_out/exit_test.o");
+  std::remove("batch_out/print_test.o");
+  std::remove("batch_out");
+  std::remove(list.c_str());
+}
+
+TEST(PlcDriverTest, InterpreterMatchesNative) {
+  // --interp 的输出与退出码必须与编译后的程序一致
+  for (const char *fixture :
+       {"exit_test", "print_test", "print_exit_test", "opt_test", "size_test",
+        "ast_opt_test"}) {
+    std::string base = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                       "/" + fixture + ".pec ";
+    std::string native = runCommand(base + "--run; echo \"status=$?\"");
+    std::string interp = runCommand(base + "--interp; echo \"status=$?\"");
+    EXPECT_EQ(native, interp) << fixture;
+  }
+}
+
+TEST(PlcDriverTest, TieredMatchesNative) {
+  // 阈值为 1 时几乎所有函数都在运行中途切换到 JIT 编译的机器码
+  for (const char *fixture :
+       {"exit_test", "print_test", "print_exit_test", "opt_test",
+        "tiered_test"}) {
+    std::string base = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                       "/" + fixture + ".pec --no-ast-opt ";
+    std::string native = runCommand(base + "--run; echo \"status=$?\"");
+    std::string tiered = runCommand(
+        base + "--tiered --jit-threshold=1; echo \"status=$?\"");
+    EXPECT_EQ(native, tiered) << fixture;
+  }
+}
+
+TEST(PlcDriverTest, TierReport) {
+  std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                    "/tiered_test.pec --no-ast-opt --tiered --tier-report";
+  std::string output = runCommand(cmd);
+
+  EXPECT_TRUE(output.find("Tier-ups:") != std::string::npos) << output;
+  EXPECT_TRUE(output.find("is_even") != std::string::npos) << output;
+  EXPECT_TRUE(output.find("failed") == std::string::npos) << output;
+}
+
+TEST(PlcDriverTest, DumpBytecode) {
+  std::string cmd = std::string(PLC_BINARY) + " " + TEST_FIXTURES_DIR +
+                    "/opt_test.pec --dump-bytecode --no-ast-opt";
+  std::string output = runCommand(cmd);
+
+  EXPECT_TRUE(output.find("Bytecode:") != std::string::npos);
+  EXPECT_TRUE(output.find("add_constant (params 1") != std::string::npos);
+  EXPECT_TRUE(output.find("AddI32") != std::string::npos);
+  EXPECT_TRUE(output.find("Exit") != std::string::npos);
+}
+
+// 在后台启动编译服务器，等到它开始监听
+pid_t startServer(const std::string &socket) {
+  std::string socket_arg = "--socket=" + socket;
+  pid_t server = fork();
+  if (server == 0) {
+    execl(PLC_BINARY, PLC_BINARY, "--server", socket_arg.c_str(),
+          static_cast<char *>(nullptr));
+    _exit(127);
+  }
+  for (int i = 0; i < 500 && access(socket.c_str(), F_OK) != 0; ++i) {
+    usleep(10000);
+  }
+  return server;
+}
+
+TEST(PlcDriverTest, CompileServerMatchesLocal) {
+  std::string socket =
+      "/tmp/plc-driver-test-" + std::to_string(getpid()) + ".sock";
+  pid_t server = startServer(socket);
+  ASSERT_EQ(access(socket.c_str(), F_OK), 0);
+
+  // 通过服务器执行的请求，输出与退出码和本地执行一致
+  std::string client = std::string(PLC_BINARY) + " --use-server --socket=" +
+                       socket + " ";
+  for (const char *fixture : {"exit_test", "print_test", "print_exit_test"}) {
+    std::string file = std::string(TEST_FIXTURES_DIR) + "/" + fixture + ".pec";
+    for (const char *mode : {"--run", "--interp", "--emit-llvm"}) {
+      std::string local = runCommand(std::string(PLC_BINARY) + " " + file +
+                                     " " + mode + "; echo \"status=$?\"");
+      std::string remote =
+          runCommand(client + file + " " + mode + "; echo \"status=$?\"");
+      EXPECT_EQ(local, remote) << fixture << " " << mode;
+    }
+  }
+
+  // 相对路径按客户端的工作目录解析
+  std::string output = runCommand(std::string("cd ") + TEST_FIXTURES_DIR +
+                                  " && " + client + "exit_test.pec --parse");
+  EXPECT_TRUE(output.find("Identifier(exit)") != std::string::npos) << output;
+
+  // 错误信息写到客户端的 stderr
+  output = runCommand(client + TEST_FIXTURES_DIR + "/parse_error.pec");
+  EXPECT_TRUE(output.find("parse error") != std::string::npos) << output;
+
+  // 并发请求
+  std::string file = std::string(TEST_FIXTURES_DIR) + "/print_test.pec";
+  std::string expected = runCommand(std::string(PLC_BINARY) + " " + file +
+                                    " --interp");
+  std::string concurrent;
+  for (int i = 0; i < 8; ++i) {
+    concurrent += client + file + " --interp > " + socket + ".out" +
+                  std::to_string(i) + " & ";
+  }
+  concurrent += "wait";
+  for (int i = 0; i < 8; ++i) {
+    concurrent += "; cat " + socket + ".out" + std::to_string(i) + "; rm " +
+                  socket + ".out" + std::to_string(i);
+  }
+  std::string repeated;
+  for (int i = 0; i < 8; ++i) {
+    repeated += expected;
+  }
+  EXPECT_EQ(runCommand(concurrent), repeated);
+
+  // SIGTERM 后服务器退出并删除套接字
+  kill(server, SIGTERM);
+  int status = 0;
+  waitpid(server, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_NE(access(socket.c_str(), F_OK), 0);
+}
+
+TEST(PlcDriverTest, IdleClientDoesNotBlockServer) {
+  std::string socket =
+      "/tmp/plc-driver-idle-test-" + std::to_string(getpid()) + ".sock";
+  pid_t server = startServer(socket);
+  ASSERT_EQ(access(socket.c_str(), F_OK), 0);
+
+  // 连接后不发送请求的客户端
+  int idle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  std::snprintf(address.sun_path, sizeof(address.sun_path), "%s",
+                socket.c_str());
+  ASSERT_EQ(connect(idle, reinterpret_cast<sockaddr *>(&address),
+                    sizeof(address)),
+            0);
+
+  std::string file = std::string(TEST_FIXTURES_DIR) + "/exit_test.pec";
+  auto start = std::chrono::steady_clock::now();
+  std::string output =
+      runCommand(std::string(PLC_BINARY) + " --use-server --socket=" + socket +
+                 " " + file + " --interp; echo \"status=$?\"");
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(output, "status=42\n");
+  EXPECT_LT(elapsed, std::chrono::seconds(3));
+
+  close(idle);
+  kill(server, SIGTERM);
+  waitpid(server, nullptr, 0);
+}
+
+TEST(PlcDriverTest, DefaultSocketDirectoryIsPrivate) {
+  std::string file = std::string(TEST_FIXTURES_DIR) + "/exit_test.pec";
+  std::string output =
+      runCommand("env -u XDG_RUNTIME_DIR " + std::string(PLC_BINARY) +
+                 " --use-server " + file + " --interp; echo \"status=$?\"");
+  EXPECT_TRUE(output.find("status=42") != std::string::npos) << output;
+
+  std::string directory = "/tmp/plc-" + std::to_string(getuid());
+  struct stat info;
+  ASSERT_EQ(lstat(directory.c_str(), &info), 0);
+  EXPECT_TRUE(S_ISDIR(info.st_mode));
+  EXPECT_EQ(info.st_uid, getuid());
+  EXPECT_EQ(info.st_mode & 077, 0u);
+}
+
+TEST(PlcDriverTest, UseServerFallsBackToLocal) {
+  std::string file = std::string(TEST_FIXTURES_DIR) + "/print_test.pec";
+  std::string expected =
+      runCommand(std::string(PLC_BINARY) + " " + file + " --interp");
+  std::string output = runCommand(
+      std::string(PLC_BINARY) + " --use-server " +
+      "--socket=/nonexistent/plc.sock " + file + " --interp");
+
+  EXPECT_TRUE(output.find("compiling locally") != std::string::npos)
+      << output;
+  EXPECT_TRUE(output.find(expected) != std::string::npos) << output;
+}
+
+// 等待日志文件中出现 count 次 text，返回日志内容
+std::string waitForLog(const std::string &log, const std::string &text,
+                       size_t count) {
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    std::ifstream in(log);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    content = buffer.str();
+    size_t found = 0;
+    for (size_t pos = content.find(text); pos != std::string::npos;
+         pos = content.find(text, pos + 1)) {
+      ++found;
+    }
+    if (found >= count) {
+      break;
+    }
+    usleep(10000);
+  }
+  return content;
+}
+
+TEST(PlcDriverTest, WatchRebuildsChangedFunctions) {
+  std::string base = "/tmp/plc-watch-test-" + std::to_string(getpid());
+  std::string source = base + ".pec";
+  std::string log = base + ".log";
+  const char *sum = "func sum(n: i32) : i32 {\n"
+                    "  let s = 0;\n"
+                    "  let i = 0;\n"
+                    "  while i < n {\n"
+                    "    s = s + sq(i);\n"
+                    "    i = i + 1;\n"
+                    "  }\n"
+                    "  return s;\n"
+                    "}\n"
+                    "print_i32(sum(4));\n"
+                    "print(\"\\n\");\n";
+  std::ofstream(source) << "func sq(x: i32) : i32 { return x * x; }\n" << sum;
+
+  pid_t watcher = fork();
+  if (watcher == 0) {
+    FILE *out = std::freopen(log.c_str(), "w", stdout);
+    dup2(fileno(out), STDERR_FILENO);
+    // 关闭 AST 优化，避免编译期求值把整个程序折叠进入口函数
+    execl(PLC_BINARY, PLC_BINARY, "--watch", source.c_str(), "--run",
+          "--no-ast-opt", static_cast<char *>(nullptr));
+    _exit(127);
+  }
+
+  // 首次构建编译所有函数：sq、sum、入口与 main
+  std::string output = waitForLog(log, "exited with status", 1);
+  EXPECT_TRUE(output.find("for 4/4 functions") != std::string::npos)
+      << output;
+  EXPECT_TRUE(output.find("14\n") != std::string::npos) << output;
+
+  // 只修改 sq 的函数体：只重新编译 sq，重新链接并运行
+  std::ofstream(source) << "func sq(x: i32) : i32 { return x * x * x; }\n"
+                        << sum;
+  output = waitForLog(log, "exited with status", 2);
+  EXPECT_TRUE(output.find("for 1/4 functions") != std::string::npos)
+      << output;
+  EXPECT_TRUE(output.find("36\n") != std::string::npos) << output;
+
+  kill(watcher, SIGINT);
+  int status = 0;
+  waitpid(watcher, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  std::remove(source.c_str());
+  std::remove(log.c_str());
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,238 @@
+#include "engine.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace pecco;
+
+namespace {
+
+int32_t host_calls = 0;
+
+f64 host_scale(f64 x) {
+  ++host_calls;
+  return x * 2.5;
+}
+
+bool host_is_small(i32 x) { return x < 10; }
+
+int32_t host_print_calls = 0;
+
+} // namespace
+
+// Host functions named like prelude builtins: the runtime library linked into
+// pecco_lib must not define these symbols, and JIT code must not call them
+extern "C" void print(const char *) { ++host_print_calls; }
+extern "C" void flush() { ++host_print_calls; }
+
+TEST(EngineTest, CompileAndCallFunction) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    func add(a: i32, b: i32) : i32 { return a + b; }
+    func hypot2(x: f64, y: f64) : f64 { return x * x + y * y; }
+  )")) << engine.errors()[0].message;
+
+  auto add = engine.lookup<i32(i32, i32)>("add");
+  ASSERT_NE(add, nullptr);
+  EXPECT_EQ(add(2, 40), 42);
+  EXPECT_EQ(add(2147483647, 1), -2147483647 - 1);
+
+  auto hypot2 = engine.lookup<f64(f64, f64)>("hypot2");
+  ASSERT_NE(hypot2, nullptr);
+  EXPECT_DOUBLE_EQ(hypot2(3.0, 4.0), 25.0);
+}
+
+TEST(EngineTest, UnreachableDefinitionsAreExported) {
+  // Top-level statements are ignored; every definition is compiled
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    func negate(x: i32) : i32 { return -x; }
+    exit(1);
+  )"));
+  auto negate = engine.lookup<i32(i32)>("negate");
+  ASSERT_NE(negate, nullptr);
+  EXPECT_EQ(negate(5), -5);
+}
+
+TEST(EngineTest, UserDefinedOperators) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    operator infix ** (base: i32, exp: i32) : i32 prec 90 assoc_right {
+      let result = 1;
+      let i = 0;
+      while i < exp { result *= base; i += 1; }
+      return result;
+    }
+    func pow_tower(a: i32) : i32 { return a ** 2 ** 2; }
+  )"));
+  auto pow_tower = engine.lookup<i32(i32)>("pow_tower");
+  ASSERT_NE(pow_tower, nullptr);
+  EXPECT_EQ(pow_tower(3), 81);
+}
+
+TEST(EngineTest, HostFunctionsCallableWithoutDeclaration) {
+  Engine engine;
+  ASSERT_TRUE(engine.define_extern("host_scale", &host_scale));
+  ASSERT_TRUE(engine.define_extern("host_is_small", &host_is_small));
+  ASSERT_TRUE(engine.compile(R"(
+    func scaled_sum(n: i32) : f64 {
+      let total = 0.0;
+      let i = 0;
+      while host_is_small(i) && i < n {
+        total += host_scale(1.0);
+        i += 1;
+      }
+      return total;
+    }
+  )")) << engine.errors()[0].message;
+
+  auto scaled_sum = engine.lookup<f64(i32)>("scaled_sum");
+  ASSERT_NE(scaled_sum, nullptr);
+  host_calls = 0;
+  EXPECT_DOUBLE_EQ(scaled_sum(4), 10.0);
+  EXPECT_EQ(host_calls, 4);
+  EXPECT_DOUBLE_EQ(scaled_sum(100), 25.0);
+}
+
+TEST(EngineTest, BoolFunctionsUseCAbi) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    func both(a: bool, b: bool) : bool { return a && b; }
+    func is_odd(x: i32) : bool { return x % 2 != 0; }
+  )"));
+  auto both = engine.lookup<bool(bool, bool)>("both");
+  auto is_odd = engine.lookup<bool(i32)>("is_odd");
+  ASSERT_NE(both, nullptr);
+  ASSERT_NE(is_odd, nullptr);
+  EXPECT_TRUE(both(true, true));
+  EXPECT_FALSE(both(true, false));
+  EXPECT_TRUE(is_odd(7));
+  EXPECT_FALSE(is_odd(8));
+}
+
+TEST(EngineTest, HostSymbolsDoNotClashWithRuntime) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    func say() : void { print(""); flush(); }
+  )")) << engine.errors()[0].message;
+  auto say = engine.lookup<void()>("say");
+  ASSERT_NE(say, nullptr);
+  host_print_calls = 0;
+  say();
+  EXPECT_EQ(host_print_calls, 0);
+}
+
+TEST(EngineTest, EveryNumericWidthRoundTrips) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile(R"(
+    func neg_i8(x: i8) : i8 { return -x; }
+    func add_i16(a: i16, b: i16) : i16 { return a + b; }
+    func mul_i64(a: i64, b: i64) : i64 { return a * b; }
+    func add_u8(a: u8, b: u8) : u8 { return a + b; }
+    func add_u16(a: u16, b: u16) : u16 { return a + b; }
+    func half_u32(x: u32) : u32 { return x / 2u32; }
+    func add_u64(a: u64, b: u64) : u64 { return a + b; }
+    func scale_f32(x: f32) : f32 { return x * 0.5f32; }
+    func widen(a: i8, b: u16) : i64 { return i64(a) + i64(b); }
+  )")) << engine.errors()[0].message;
+
+  auto neg_i8 = engine.lookup<i8(i8)>("neg_i8");
+  auto add_i16 = engine.lookup<i16(i16, i16)>("add_i16");
+  auto mul_i64 = engine.lookup<i64(i64, i64)>("mul_i64");
+  auto add_u8 = engine.lookup<u8(u8, u8)>("add_u8");
+  auto add_u16 = engine.lookup<u16(u16, u16)>("add_u16");
+  auto half_u32 = engine.lookup<u32(u32)>("half_u32");
+  auto add_u64 = engine.lookup<u64(u64, u64)>("add_u64");
+  auto scale_f32 = engine.lookup<f32(f32)>("scale_f32");
+  auto widen = engine.lookup<i64(i8, u16)>("widen");
+  ASSERT_NE(neg_i8, nullptr);
+  ASSERT_NE(add_i16, nullptr);
+  ASSERT_NE(mul_i64, nullptr);
+  ASSERT_NE(add_u8, nullptr);
+  ASSERT_NE(add_u16, nullptr);
+  ASSERT_NE(half_u32, nullptr);
+  ASSERT_NE(add_u64, nullptr);
+  ASSERT_NE(scale_f32, nullptr);
+  ASSERT_NE(widen, nullptr);
+
+  // Results wrap at each type's width
+  EXPECT_EQ(neg_i8(5), -5);
+  EXPECT_EQ(neg_i8(-128), -128);
+  EXPECT_EQ(add_i16(30000, 10000), -25536);
+  EXPECT_EQ(mul_i64(int64_t(1) << 32, 3), int64_t(3) << 32);
+  EXPECT_EQ(add_u8(200, 100), 44);
+  EXPECT_EQ(add_u16(65535, 2), 1);
+  EXPECT_EQ(half_u32(4000000000u), 2000000000u);
+  EXPECT_EQ(add_u64(UINT64_MAX, 2), 1u);
+  EXPECT_FLOAT_EQ(scale_f32(3.0f), 1.5f);
+  // Narrow arguments keep their sign or zero extension across the call
+  EXPECT_EQ(widen(-1, 65535), 65534);
+
+  EXPECT_EQ(engine.lookup<i32(i32)>("neg_i8"), nullptr);
+  EXPECT_EQ(engine.lookup<u64(i64, i64)>("mul_i64"), nullptr);
+}
+
+TEST(EngineTest, LaterUnitsSeeEarlierExports) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile("func square(x: i32) : i32 { return x * x; }"));
+  ASSERT_TRUE(engine.compile(
+      "func quad(x: i32) : i32 { return square(square(x)); }"))
+      << engine.errors()[0].message;
+
+  auto quad = engine.lookup<i32(i32)>("quad");
+  ASSERT_NE(quad, nullptr);
+  EXPECT_EQ(quad(3), 81);
+
+  EXPECT_FALSE(engine.compile("func square(x: i32) : i32 { return x; }"));
+  ASSERT_TRUE(engine.has_errors());
+  EXPECT_NE(engine.errors()[0].message.find("redefinition"),
+            std::string::npos);
+}
+
+TEST(EngineTest, LaterUnitsSeeEarlierOperators) {
+  const char *power = R"(
+    operator infix ** (base: i32, exp: i32) : i32 prec 90 assoc_right {
+      let result = 1;
+      let i = 0;
+      while i < exp { result *= base; i += 1; }
+      return result;
+    }
+  )";
+  Engine engine;
+  ASSERT_TRUE(engine.compile(power));
+  ASSERT_TRUE(engine.compile("func cube(x: i32) : i32 { return x ** 3; }"))
+      << engine.errors()[0].message;
+  auto cube = engine.lookup<i32(i32)>("cube");
+  ASSERT_NE(cube, nullptr);
+  EXPECT_EQ(cube(2), 8);
+
+  EXPECT_FALSE(engine.compile(power));
+  ASSERT_TRUE(engine.has_errors());
+  EXPECT_NE(engine.errors()[0].message.find("redefinition of operator '**'"),
+            std::string::npos)
+      << engine.errors()[0].message;
+  EXPECT_EQ(engine.errors()[0].line, 2u);
+}
+
+TEST(EngineTest, LookupChecksSignature) {
+  Engine engine;
+  ASSERT_TRUE(engine.compile("func add(a: i32, b: i32) : i32 { return a + b; }"));
+
+  EXPECT_EQ(engine.lookup<f64(f64, f64)>("add"), nullptr);
+  ASSERT_TRUE(engine.has_errors());
+  EXPECT_NE(engine.errors()[0].message.find("(i32, i32) : i32"),
+            std::string::npos);
+
+  EXPECT_EQ(engine.lookup<i32(i32, i32)>("missing"), nullptr);
+  EXPECT_TRUE(engine.has_errors());
+}
+
+TEST(EngineTest, CompileErrorsReported) {
+  Engine engine;
+  EXPECT_FALSE(engine.compile("func f(x: i32) : i32 { return missing(x); }"));
+  ASSERT_TRUE(engine.has_errors());
+  EXPECT_EQ(engine.errors()[0].line, 1u);
+  EXPECT_NE(engine.errors()[0].message.find("missing"), std::string::npos);
+
+  EXPECT_FALSE(engine.compile("func f(x: i32) : i32 { return x +; }"));
+  EXPECT_TRUE(engine.has_errors());
+}
@@ -0,0 +1,330 @@
+#include "incremental_document.hpp"
+#include "language_server.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace pecco;
+
+namespace {
+
+const std::string kSource = R"(func add(a: i32, b: i32) : i32 {
+  return a + b;
+}
+let scale = 2.5;
+func twice(x: f64) : f64 {
+  let y = x * scale;
+  return y;
+}
+print_i32(add(1, 2));
+)";
+
+// Many independent functions followed by code using them
+std::string generated_source(size_t functions) {
+  std::string source;
+  for (size_t i = 0; i < functions; ++i) {
+    std::string n = std::to_string(i);
+    source += "func f" + n + "(x: i32) : i32 {\n  let y = x * " + n +
+              ";\n  return y + 1;\n}\n";
+  }
+  source += "exit(f0(1) + f1(2));\n";
+  return source;
+}
+
+TEST(IncrementalDocumentTest, ReportsDiagnosticsWithLocations) {
+  IncrementalDocument doc;
+  doc.update(kSource);
+  EXPECT_TRUE(doc.diagnostics().empty());
+
+  doc.update(kSource + "let z = missing(1);\nlet w = (1;\n");
+  // Same diagnostics as the compiler: one type error, two parse errors
+  ASSERT_EQ(doc.diagnostics().size(), 3u);
+  EXPECT_EQ(doc.diagnostics()[0].phase, "type");
+  EXPECT_EQ(doc.diagnostics()[0].line, 10u);
+  EXPECT_EQ(doc.diagnostics()[1].phase, "parse");
+  EXPECT_EQ(doc.diagnostics()[1].line, 11u);
+  EXPECT_EQ(doc.diagnostics()[1].column, 11u);
+}
+
+TEST(IncrementalDocumentTest, EditingABodyRechecksOnlyThatStatement) {
+  std::string source = generated_source(200);
+  IncrementalDocument doc;
+  doc.update(source);
+  EXPECT_TRUE(doc.diagnostics().empty());
+  EXPECT_EQ(doc.stats().statements, 201u);
+  EXPECT_EQ(doc.stats().parsed, 201u);
+  EXPECT_EQ(doc.stats().checked, 201u);
+
+  // Break one body: only that function is parsed and checked again
+  size_t pos = source.find("x * 7;");
+  std::string edited = source;
+  edited.replace(pos, 6, "x * z7;");
+  doc.update(edited);
+  ASSERT_EQ(doc.diagnostics().size(), 1u);
+  EXPECT_EQ(doc.stats().parsed, 1u);
+  EXPECT_EQ(doc.stats().checked, 1u);
+  EXPECT_EQ(doc.diagnostics()[0].line, 7u * 4 + 2);
+
+  // Lines inserted above move the statements without re-analysis
+  doc.update("\n\n" + edited);
+  ASSERT_EQ(doc.diagnostics().size(), 1u);
+  EXPECT_EQ(doc.stats().parsed, 0u);
+  EXPECT_EQ(doc.stats().checked, 0u);
+  EXPECT_EQ(doc.diagnostics()[0].line, 7u * 4 + 4);
+
+  doc.update(source);
+  EXPECT_TRUE(doc.diagnostics().empty());
+}
+
+TEST(IncrementalDocumentTest, SignatureChangesRecheckDependents) {
+  IncrementalDocument doc;
+  doc.update(kSource);
+  EXPECT_TRUE(doc.diagnostics().empty());
+
+  // add() now returns f64: only the call site is rechecked with the new type
+  std::string edited = kSource;
+  edited.replace(edited.find(") : i32 {"), 9, ") : f64 {");
+  doc.update(edited);
+  EXPECT_TRUE(doc.diagnostics().empty());
+  EXPECT_EQ(doc.stats().parsed, 1u);
+  EXPECT_EQ(doc.stats().checked, 2u); // add, the call
+  auto hover = doc.hover(9, 12);
+  ASSERT_TRUE(hover);
+  EXPECT_EQ(hover->text, "func add(i32, i32) : f64");
+
+  // A global's type flows into later statements only
+  doc.update(kSource);
+  EXPECT_TRUE(doc.diagnostics().empty());
+  edited = kSource;
+  edited.replace(edited.find("2.5"), 3, "2");
+  doc.update(edited);
+  EXPECT_TRUE(doc.diagnostics().empty());
+  EXPECT_EQ(doc.stats().checked, 2u); // let scale, twice
+  auto use = doc.hover(6, 15);
+  ASSERT_TRUE(use);
+  EXPECT_EQ(use->text, "scale: i32");
+}
+
+TEST(IncrementalDocumentTest, HoverShowsInferredTypes) {
+  IncrementalDocument doc;
+  doc.update(kSource);
+
+  auto variable = doc.hover(6, 7); // y
+  ASSERT_TRUE(variable);
+  EXPECT_EQ(variable->text, "y: f64");
+  EXPECT_EQ(variable->range.line, 6u);
+  EXPECT_EQ(variable->range.column, 7u);
+  EXPECT_EQ(variable->range.end_column, 8u);
+
+  auto use = doc.hover(6, 15); // scale
+  ASSERT_TRUE(use);
+  EXPECT_EQ(use->text, "scale: f64");
+
+  auto op = doc.hover(2, 12); // +
+  ASSERT_TRUE(op);
+  EXPECT_EQ(op->text, "(i32 + i32) : i32");
+
+  auto call = doc.hover(9, 1); // print_i32
+  ASSERT_TRUE(call);
+  EXPECT_EQ(call->text, "func print_i32(i32) : void");
+
+  auto function = doc.hover(1, 6); // add
+  ASSERT_TRUE(function);
+  EXPECT_EQ(function->text, "func add(i32, i32) : i32");
+
+  auto parameter = doc.hover(5, 12); // x
+  ASSERT_TRUE(parameter);
+  EXPECT_EQ(parameter->text, "x: f64");
+
+  EXPECT_FALSE(doc.hover(3, 1)); // '}'
+}
+
+TEST(IncrementalDocumentTest, HoverAnalyzesOnlyTheStatementUnderTheCursor) {
+  IncrementalDocument doc;
+  doc.update(generated_source(200));
+  EXPECT_EQ(doc.stats().checked, 0u);
+
+  auto local = doc.hover(7 * 4 + 2, 7); // y in f7
+  ASSERT_TRUE(local);
+  EXPECT_EQ(local->text, "y: i32");
+  EXPECT_EQ(doc.stats().checked, 1u);
+
+  auto call = doc.hover(200 * 4 + 1, 6); // f0
+  ASSERT_TRUE(call);
+  EXPECT_EQ(call->text, "func f0(i32) : i32");
+  EXPECT_EQ(doc.stats().checked, 2u);
+
+  // Checked statements are not checked again by diagnostics()
+  EXPECT_TRUE(doc.diagnostics().empty());
+  EXPECT_EQ(doc.stats().checked, 201u);
+}
+
+TEST(IncrementalDocumentTest, FindsDefinitions) {
+  IncrementalDocument doc;
+  doc.update(kSource);
+
+  auto parameter = doc.definition(2, 10); // a in a + b
+  ASSERT_TRUE(parameter);
+  EXPECT_TRUE(parameter->path.empty());
+  EXPECT_EQ(parameter->range.line, 1u);
+  EXPECT_EQ(parameter->range.column, 10u);
+
+  auto local = doc.definition(7, 10); // y
+  ASSERT_TRUE(local);
+  EXPECT_EQ(local->range.line, 6u);
+  EXPECT_EQ(local->range.column, 7u);
+
+  auto global = doc.definition(6, 15); // scale
+  ASSERT_TRUE(global);
+  EXPECT_EQ(global->range.line, 4u);
+  EXPECT_EQ(global->range.column, 5u);
+
+  auto function = doc.definition(9, 11); // add
+  ASSERT_TRUE(function);
+  EXPECT_EQ(function->range.line, 1u);
+  EXPECT_EQ(function->range.column, 6u);
+  EXPECT_EQ(function->range.end_column, 9u);
+
+  auto builtin = doc.definition(9, 1); // print_i32
+  ASSERT_TRUE(builtin);
+  EXPECT_NE(builtin->path.find("prelude.pec"), std::string::npos);
+  EXPECT_GT(builtin->range.line, 0u);
+}
+
+TEST(IncrementalDocumentTest, ClassifiesSemanticTokens) {
+  IncrementalDocument doc;
+  doc.update("# comment\nfunc f(n: i32) : i32 { return n + 1; }\n");
+  auto tokens = doc.semantic_tokens();
+
+  std::vector<SemanticTokenKind> kinds;
+  for (const auto &tok : tokens) {
+    kinds.push_back(tok.kind);
+  }
+  std::vector<SemanticTokenKind> expected = {
+      SemanticTokenKind::Comment,   SemanticTokenKind::Keyword,
+      SemanticTokenKind::Function,  SemanticTokenKind::Parameter,
+      SemanticTokenKind::Type,      SemanticTokenKind::Type,
+      SemanticTokenKind::Keyword,   SemanticTokenKind::Variable,
+      SemanticTokenKind::Operator,  SemanticTokenKind::Number};
+  EXPECT_EQ(kinds, expected);
+  EXPECT_EQ(tokens[0].length, 9u);
+  EXPECT_EQ(tokens[2].line, 2u);
+  EXPECT_EQ(tokens[2].column, 6u);
+}
+
+// Frame JSON-RPC messages the way an editor sends them
+std::string frame(const std::string &body) {
+  return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::vector<llvm::json::Value> read_messages(const std::string &output) {
+  std::vector<llvm::json::Value> messages;
+  size_t pos = 0;
+  while ((pos = output.find("Content-Length: ", pos)) != std::string::npos) {
+    size_t header_end = output.find("\r\n\r\n", pos);
+    size_t length = std::stoul(output.substr(pos + 16, header_end - pos - 16));
+    auto message = llvm::json::parse(output.substr(header_end + 4, length));
+    EXPECT_TRUE(static_cast<bool>(message));
+    if (message) {
+      messages.push_back(std::move(*message));
+    }
+    pos = header_end + 4 + length;
+  }
+  return messages;
+}
+
+TEST(LanguageServerTest, ServesAnEditingSession) {
+  std::string uri = "file:///tmp/test.pec";
+  std::string input =
+      frame(R"({"jsonrpc":"2.0","id":1,"method":"initialize","params":{}})") +
+      frame(R"({"jsonrpc":"2.0","method":"initialized","params":{}})") +
+      frame(R"({"jsonrpc":"2.0","method":"textDocument/didOpen","params":)"
+            R"({"textDocument":{"uri":")" +
+            uri +
+            R"(","languageId":"pecco","version":1,)"
+            R"("text":"let x = 1.5;\nprint_f64(x);\n"}}})") +
+      frame(R"({"jsonrpc":"2.0","id":2,"method":"textDocument/hover",)"
+            R"("params":{"textDocument":{"uri":")" +
+            uri + R"("},"position":{"line":1,"character":10}}})") +
+      // Replace 1.5 with a call to an unknown function
+      frame(R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":)"
+            R"({"textDocument":{"uri":")" +
+            uri +
+            R"(","version":2},"contentChanges":[{"range":{"start":)"
+            R"({"line":0,"character":8},"end":{"line":0,"character":11}},)"
+            R"json("text":"missing()"}]}})json") +
+      frame(R"({"jsonrpc":"2.0","id":3,"method":"textDocument/definition",)"
+            R"("params":{"textDocument":{"uri":")" +
+            uri + R"("},"position":{"line":1,"character":10}}})") +
+      frame(R"({"jsonrpc":"2.0","id":4,"method":)"
+            R"("textDocument/semanticTokens/full","params":)"
+            R"({"textDocument":{"uri":")" +
+            uri + R"("}}})") +
+      frame(R"({"jsonrpc":"2.0","id":5,"method":"textDocument/unknown"})") +
+      frame(R"({"jsonrpc":"2.0","id":6,"method":"shutdown"})") +
+      frame(R"({"jsonrpc":"2.0","method":"exit"})");
+
+  std::istringstream in(input);
+  std::string output;
+  llvm::raw_string_ostream out(output);
+  LanguageServer server(in, out);
+  EXPECT_EQ(server.run(), 0);
+  out.flush();
+
+  auto messages = read_messages(output);
+  ASSERT_EQ(messages.size(), 8u);
+
+  // initialize
+  const auto *init = messages[0].getAsObject();
+  ASSERT_TRUE(init);
+  const auto *capabilities =
+      init->getObject("result")->getObject("capabilities");
+  ASSERT_TRUE(capabilities);
+  EXPECT_EQ(*capabilities->getBoolean("hoverProvider"), true);
+
+  // didOpen: no diagnostics
+  const auto *open = messages[1].getAsObject();
+  EXPECT_EQ(*open->getString("method"), "textDocument/publishDiagnostics");
+  EXPECT_TRUE(open->getObject("params")->getArray("diagnostics")->empty());
+
+  // hover
+  const auto *hover = messages[2].getAsObject()->getObject("result");
+  ASSERT_TRUE(hover);
+  EXPECT_EQ(*hover->getObject("contents")->getString("value"),
+            "```pecco\nx: f64\n```");
+
+  // didChange: the edit introduced an error on line 0, and x is no longer
+  // defined on line 1
+  const auto *diagnostics =
+      messages[3].getAsObject()->getObject("params")->getArray("diagnostics");
+  ASSERT_EQ(diagnostics->size(), 2u);
+  const auto *diag = (*diagnostics)[0].getAsObject();
+  EXPECT_TRUE(diag->getString("message")->contains("missing"));
+  EXPECT_EQ(*diag->getObject("range")->getObject("start")->getInteger("line"),
+            0);
+  EXPECT_EQ(
+      *diag->getObject("range")->getObject("start")->getInteger("character"),
+      15);
+
+  // definition of x
+  const auto *definition = messages[4].getAsObject()->getObject("result");
+  ASSERT_TRUE(definition);
+  EXPECT_EQ(*definition->getString("uri"), uri);
+  EXPECT_EQ(*definition->getObject("range")
+                 ->getObject("start")
+                 ->getInteger("character"),
+            4);
+
+  // semantic tokens: let x = missing ( ) ; print_f64 ( x ) ;
+  const auto *data =
+      messages[5].getAsObject()->getObject("result")->getArray("data");
+  ASSERT_TRUE(data);
+  EXPECT_EQ(data->size() % 5, 0u);
+  EXPECT_EQ(data->size(), 5u * 6);
+
+  // unknown method
+  EXPECT_TRUE(messages[6].getAsObject()->getObject("error"));
+}
+
+} // namespace
@@ -131,6 +131,46 @@ TEST(LexerTest, NumbersRichVariants) {
                           });
 }
 
+TEST(LexerTest, IntegerSuffixes) {
+  Lexer lexer("255u8 1i64 7u 3ix 0u32+1");
+  auto tokens = lexer.tokenize_all();
+  expect_sequence(tokens, {
+                              {TokenKind::Integer, "255u8"},
+                              {TokenKind::Integer, "1i64"},
+                              {TokenKind::Integer, "7"},
+                              {TokenKind::Identifier, "u"},
+                              {TokenKind::Integer, "3"},
+                              {TokenKind::Identifier, "ix"},
+                              {TokenKind::Integer, "0u32"},
+                              {TokenKind::Operator, "+"},
+                              {TokenKind::Integer, "1"},
+                          });
+}
+
+TEST(LexerTest, FloatSuffixes) {
+  Lexer lexer("1.5f32 2f32 1e3f64 3.0f");
+  auto tokens = lexer.tokenize_all();
+  expect_sequence(tokens, {
+                              {TokenKind::Float, "1.5f32"},
+                              {TokenKind::Float, "2f32"},
+                              {TokenKind::Float, "1e3f64"},
+                              {TokenKind::Float, "3.0"},
+                              {TokenKind::Identifier, "f"},
+                          });
+
+  Lexer invalid("1.0f16");
+  auto tok = invalid.next_token();
+  EXPECT_EQ(tok.kind, TokenKind::Error);
+  EXPECT_NE(tok.lexeme.find("Invalid float suffix: f16"), std::string::npos);
+}
+
+TEST(LexerTest, InvalidIntegerSuffix) {
+  Lexer lexer("1u7");
+  auto tok = lexer.next_token();
+  EXPECT_EQ(tok.kind, TokenKind::Error);
+  EXPECT_NE(tok.lexeme.find("Invalid integer suffix: u7"), std::string::npos);
+}
+
 TEST(LexerTest, OperatorCombinationsSeparatedBySpaces) {
   Lexer lexer("a == b != c <= d >= e && f || g + - * / % ^ & | << >> ");
   auto tokens = lexer.tokenize_all();
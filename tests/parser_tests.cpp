@@ -1,6 +1,9 @@
+#include "incremental_parser.hpp"
 #include "parser.hpp"
 #include <gtest/gtest.h>
 
+#include <sstream>
+
 using namespace pecco;
 
 namespace {
@@ -475,6 +478,391 @@ TEST(ParserTest, ParseChainedAssignment) {
   // Semantic analysis will handle the actual resolution
 }
 
+// ===== Arrays =====
+
+TEST(ParserTest, ParseArrayDeclaration) {
+  std::string source = "let m : [4][8]f64;";
+  auto [stmts, parser] = parse_source(source);
+
+  ASSERT_FALSE(parser.has_errors())
+      << "Parser errors: "
+      << (parser.errors().empty() ? "" : parser.errors()[0].message);
+  ASSERT_EQ(stmts.size(), 1);
+
+  auto *let = static_cast<LetStmt *>(stmts[0].get());
+  EXPECT_EQ(let->init, nullptr);
+  ASSERT_TRUE(let->type.has_value());
+  const Type &type = **let->type;
+  EXPECT_EQ(type.kind, TypeKind::Array);
+  EXPECT_EQ(type.name, "[4][8]f64");
+  EXPECT_EQ(type.size, 4u);
+  ASSERT_NE(type.element, nullptr);
+  EXPECT_EQ(type.element->name, "[8]f64");
+  EXPECT_EQ(type.element->element->name, "f64");
+
+  auto parts = parse_array_type_name(type.name);
+  ASSERT_TRUE(parts.has_value());
+  EXPECT_EQ(parts->element, "[8]f64");
+  EXPECT_EQ(parts->size, 4u);
+  EXPECT_FALSE(parse_array_type_name("f64").has_value());
+}
+
+TEST(ParserTest, ParseIndexExpression) {
+  std::string source = "m[i + 1][2] = x[0];";
+  auto [stmts, parser] = parse_source(source);
+
+  ASSERT_FALSE(parser.has_errors())
+      << "Parser errors: "
+      << (parser.errors().empty() ? "" : parser.errors()[0].message);
+  ASSERT_EQ(stmts.size(), 1);
+
+  auto *expr = static_cast<ExprStmt *>(stmts[0].get())->expr.get();
+  ASSERT_EQ(expr->kind, ExprKind::OperatorSeq);
+  auto *seq = static_cast<OperatorSeqExpr *>(expr);
+  ASSERT_EQ(seq->items.size(), 3);
+
+  ASSERT_EQ(seq->items[0].operand->kind, ExprKind::Index);
+  auto *outer = static_cast<IndexExpr *>(seq->items[0].operand.get());
+  EXPECT_EQ(outer->index->kind, ExprKind::IntLiteral);
+  ASSERT_EQ(outer->base->kind, ExprKind::Index);
+  auto *inner = static_cast<IndexExpr *>(outer->base.get());
+  EXPECT_EQ(inner->base->kind, ExprKind::Identifier);
+  EXPECT_EQ(inner->index->kind, ExprKind::OperatorSeq);
+
+  EXPECT_EQ(seq->items[2].operand->kind, ExprKind::Index);
+}
+
+TEST(ParserTest, ArrayTypeErrors) {
+  EXPECT_TRUE(parse_source("let a : [0]i32;").second.has_errors());
+  EXPECT_TRUE(parse_source("let a : [n]i32;").second.has_errors());
+  EXPECT_TRUE(parse_source("let a : [4 i32;").second.has_errors());
+  // Only declarations with a type may leave out the initializer
+  EXPECT_TRUE(parse_source("let a;").second.has_errors());
+}
+
+// ===== Parallel parsing =====
+
+// Statements with their locations, for comparing two parses
+std::string dump(const std::vector<StmtPtr> &stmts) {
+  std::ostringstream os;
+  for (const auto &stmt : stmts) {
+    os << stmt->loc.line << ":" << stmt->loc.column << " ";
+    stmt->print(os);
+    os << "\n";
+  }
+  return os.str();
+}
+
+std::string many_functions(size_t count) {
+  std::string source;
+  for (size_t i = 0; i < count; ++i) {
+    std::string n = std::to_string(i);
+    source += "# f" + n + "\nfunc f" + n + "(x: i32) : i32 {\n  if x > " + n +
+              " {\n    return x;\n  }\n  else {\n    return x * " + n +
+              ";\n  }\n}\nlet g" + n + " = f" + n + "(" + n + ");\n";
+  }
+  return source + "print_i32(g1); # done\n";
+}
+
+TEST(ParserTest, ParallelParseMatchesSequential) {
+  std::string source = many_functions(200) + "if 1 < 2 {\n  print_i32(1);\n}\n"
+                                             "else {\n  print_i32(2);\n}\n";
+  auto [expected, sequential] = parse_source(source);
+  ASSERT_FALSE(sequential.has_errors());
+
+  for (unsigned jobs : {1u, 2u, 4u, 16u}) {
+    Lexer lexer(source);
+    Parser parser(lexer.tokenize_all());
+    auto stmts = parser.parse_program_parallel(jobs);
+    EXPECT_FALSE(parser.has_errors()) << jobs;
+    EXPECT_EQ(dump(stmts), dump(expected)) << jobs;
+  }
+}
+
+TEST(ParserTest, ParallelParseReportsTheSameErrors) {
+  std::string source = many_functions(100);
+  source.replace(source.find("return x * 50;"), 14, "return x * ;");
+  source.replace(source.find("let g80 ="), 9, "let g80");
+  auto [expected, sequential] = parse_source(source);
+  ASSERT_TRUE(sequential.has_errors());
+
+  Lexer lexer(source);
+  Parser parser(lexer.tokenize_all());
+  auto stmts = parser.parse_program_parallel(4);
+  ASSERT_EQ(parser.errors().size(), sequential.errors().size());
+  for (size_t i = 0; i < parser.errors().size(); ++i) {
+    EXPECT_EQ(parser.errors()[i].message, sequential.errors()[i].message);
+    EXPECT_EQ(parser.errors()[i].line, sequential.errors()[i].line);
+    EXPECT_EQ(parser.errors()[i].column, sequential.errors()[i].column);
+  }
+  EXPECT_EQ(dump(stmts), dump(expected));
+}
+
+TEST(ParserTest, SplitTopLevelFollowsStatementBoundaries) {
+  Lexer lexer("func f() {\n  return 1;\n}\nif x { f(); }\nelse { f(); }\n"
+              "let y = 2; # last\n");
+  auto tokens = lexer.tokenize_all();
+  bool open = true;
+  auto ranges = Parser::split_top_level(tokens, &open);
+  EXPECT_FALSE(open);
+  ASSERT_EQ(ranges.size(), 4u);
+  // 'else' stays with its 'if'; comments after the last statement are a
+  // range of their own
+  EXPECT_EQ(tokens[ranges[1].first].lexeme, "if");
+  EXPECT_EQ(tokens[ranges[2].first].lexeme, "let");
+  EXPECT_EQ(tokens[ranges[3].first].kind, TokenKind::Comment);
+  EXPECT_EQ(ranges[3].second, tokens.size() - 1);
+
+  Lexer unclosed("let a = 1;\nfunc f() {\n");
+  auto unclosed_tokens = unclosed.tokenize_all();
+  Parser::split_top_level(unclosed_tokens, &open);
+  EXPECT_TRUE(open);
+}
+
+// ===== Streaming (pipelined lexing) =====
+
+TEST(ParserTest, StreamingParseMatchesBatch) {
+  std::string source = many_functions(200) + "if 1 < 2 {\n  print_i32(1);\n}\n"
+                                             "else {\n  print_i32(2);\n}\n";
+  auto [expected, batch] = parse_source(source);
+  ASSERT_FALSE(batch.has_errors());
+
+  for (size_t batch_size : {1u, 7u, 1024u, 1u << 20}) {
+    TokenStream stream(source, batch_size);
+    Parser parser(stream);
+    auto stmts = parser.parse_program();
+    EXPECT_FALSE(parser.has_errors()) << batch_size;
+    EXPECT_EQ(dump(stmts), dump(expected)) << batch_size;
+    EXPECT_TRUE(stream.lexer_errors().empty());
+  }
+}
+
+TEST(ParserTest, StreamingParseReportsTheSameErrors) {
+  std::string source = many_functions(100);
+  source.replace(source.find("return x * 50;"), 14, "return x * ;");
+  source.replace(source.find("let g80 = f80(80);"), 18, "let g80 = f80(80)");
+  auto [expected, batch] = parse_source(source);
+  ASSERT_TRUE(batch.has_errors());
+
+  TokenStream stream(source, 16);
+  Parser parser(stream);
+  auto stmts = parser.parse_program();
+  ASSERT_EQ(parser.errors().size(), batch.errors().size());
+  for (size_t i = 0; i < parser.errors().size(); ++i) {
+    EXPECT_EQ(parser.errors()[i].message, batch.errors()[i].message);
+    EXPECT_EQ(parser.errors()[i].line, batch.errors()[i].line);
+    EXPECT_EQ(parser.errors()[i].column, batch.errors()[i].column);
+  }
+  EXPECT_EQ(dump(stmts), dump(expected));
+}
+
+TEST(ParserTest, TokenStreamCollectsLexerErrors) {
+  TokenStream stream("let a = 1;\nlet b = \"open\n", 2);
+  const auto &errors = stream.lexer_errors();
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors[0].line, 2u);
+
+  // Destroying a stream that was not consumed stops its lexer thread
+  TokenStream unread(many_functions(1000), 4);
+  std::vector<Token> tokens;
+  ASSERT_TRUE(unread.next_batch(tokens));
+  EXPECT_EQ(tokens.size(), 4u);
+}
+
+TEST(ParserTest, CloneCopiesTheWholeTree) {
+  auto [stmts, parser] = parse_source(
+      "operator infix +++ (a: i32, b: i32) : i32 prec 60 { return a + b; }\n"
+      "func f(xs: [4]f64, n: u8) : f64 {\n"
+      "  let i = 0;\n"
+      "  while i < 4 { if xs[i] > 1.5 { return -xs[i]; } else { i = i + 1; } }"
+      "\n  return 2.0f32;\n"
+      "}\n"
+      "let s = \"text\";\n"
+      "print_i32(1 +++ 2);\n");
+  ASSERT_FALSE(parser.has_errors());
+  ASSERT_EQ(stmts.size(), 4u);
+
+  auto copies = clone(stmts);
+  ASSERT_EQ(copies.size(), stmts.size());
+  for (size_t i = 0; i < stmts.size(); ++i) {
+    EXPECT_NE(copies[i].get(), stmts[i].get());
+    EXPECT_EQ(copies[i]->loc.line, stmts[i]->loc.line);
+    std::ostringstream original, copy;
+    stmts[i]->print(original);
+    copies[i]->print(copy);
+    EXPECT_EQ(copy.str(), original.str());
+  }
+
+  // The copy is independent of the original
+  auto *let = static_cast<LetStmt *>(stmts[2].get());
+  let->init->inferred_type = "str";
+  let->name = "t";
+  auto *copy = static_cast<LetStmt *>(copies[2].get());
+  EXPECT_EQ(copy->name, "s");
+  EXPECT_TRUE(copy->init->inferred_type.empty());
+  EXPECT_EQ(clone(*let->init)->inferred_type, "str");
+}
+
+// ===== Incremental reparsing =====
+
+const std::string kProgram = R"(func f(x: i32) : i32 {
+  return x + 1;
+}
+func g(x: i32) : i32 {
+  return x * 2;
+}
+print_i32(f(1));
+print_i32(f(1));
+)";
+
+TEST(IncrementalParserTest, SplitsTopLevelStatements) {
+  IncrementalParser parser;
+  const auto &statements = parser.update(kProgram);
+  ASSERT_EQ(statements.size(), 4u);
+  EXPECT_EQ(parser.stats().parsed, 4u);
+  EXPECT_EQ(statements[1]->first_line, 4u);
+  EXPECT_EQ(statements[3]->first_line, 8u);
+
+  // Lines are relative to the statement
+  ASSERT_EQ(statements[1]->stmts.size(), 1u);
+  EXPECT_EQ(statements[1]->stmts[0]->kind, StmtKind::Func);
+  EXPECT_EQ(statements[1]->stmts[0]->loc.line, 1u);
+  EXPECT_EQ(statements[1]->tokens.back().kind, TokenKind::EndOfFile);
+}
+
+TEST(IncrementalParserTest, ReparsesOnlyChangedStatements) {
+  IncrementalParser parser;
+  auto before = parser.update(kProgram);
+
+  std::string edited = kProgram;
+  edited.replace(edited.find("x * 2"), 5, "x * 3");
+  const auto &after = parser.update(edited);
+  ASSERT_EQ(after.size(), 4u);
+  EXPECT_EQ(parser.stats().parsed, 1u);
+  EXPECT_EQ(parser.stats().reused, 3u);
+  EXPECT_EQ(after[0], before[0]);
+  EXPECT_NE(after[1], before[1]);
+  EXPECT_EQ(after[2], before[2]);
+  EXPECT_EQ(after[3], before[3]);
+
+  // Whitespace inside a statement moves its tokens: it is parsed again
+  parser.update(kProgram);
+  edited = kProgram;
+  edited.replace(edited.find("x + 1"), 5, "x  + 1");
+  parser.update(edited);
+  EXPECT_EQ(parser.stats().parsed, 1u);
+}
+
+TEST(IncrementalParserTest, HandlesInsertedAndDeletedStatements) {
+  IncrementalParser parser;
+  auto before = parser.update(kProgram);
+
+  // New lines and a new statement above: everything else is reused
+  const auto &inserted =
+      parser.update("\n# comment\nlet a = 1;\n" + kProgram);
+  ASSERT_EQ(inserted.size(), 5u);
+  EXPECT_EQ(parser.stats().parsed, 1u);
+  EXPECT_EQ(inserted[1], before[0]);
+  EXPECT_EQ(inserted[1]->first_line, 4u);
+  EXPECT_EQ(inserted[1]->stmts[0]->loc.line, 1u);
+
+  // Deleting a statement parses nothing
+  std::string deleted = kProgram;
+  size_t g = deleted.find("func g");
+  deleted.erase(g, deleted.find("print_i32") - g);
+  const auto &after = parser.update(deleted);
+  ASSERT_EQ(after.size(), 3u);
+  EXPECT_EQ(parser.stats().parsed, 0u);
+  EXPECT_EQ(after[0], before[0]);
+  EXPECT_EQ(after[1]->first_line, 4u);
+
+  // Identical statements stay distinct
+  EXPECT_NE(after[1], after[2]);
+}
+
+// Statements of an incremental update equal those of a fresh parse
+void expect_same_as_fresh(IncrementalParser &parser, const std::string &text) {
+  const auto &statements = parser.update(text);
+  IncrementalParser fresh;
+  const auto &expected = fresh.update(text);
+  ASSERT_EQ(statements.size(), expected.size()) << text;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(statements[i]->hash, expected[i]->hash) << i << "\n" << text;
+    EXPECT_EQ(statements[i]->first_line, expected[i]->first_line) << i;
+    EXPECT_EQ(statements[i]->first_column, expected[i]->first_column) << i;
+  }
+}
+
+TEST(IncrementalParserTest, LexesOnlyTheEditedStatements) {
+  std::string source;
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string n = std::to_string(i);
+    source += "func f" + n + "(x: i32) : i32 {\n  return x * " + n + ";\n}\n";
+  }
+  IncrementalParser parser;
+  parser.update(source);
+  EXPECT_EQ(parser.stats().lexed, source.size());
+
+  std::string edited = source;
+  edited.replace(edited.find("x * 500;"), 8, "x * 5000;");
+  expect_same_as_fresh(parser, edited);
+  EXPECT_EQ(parser.stats().parsed, 1u);
+  EXPECT_EQ(parser.stats().reused, 999u);
+  EXPECT_LT(parser.stats().lexed, 100u);
+
+  // New lines shift the statements below without lexing them
+  edited.insert(edited.find("func f10("), "\n\n");
+  expect_same_as_fresh(parser, edited);
+  EXPECT_EQ(parser.stats().parsed, 0u);
+  EXPECT_LT(parser.stats().lexed, 100u);
+}
+
+TEST(IncrementalParserTest, EditsMatchAFreshParse) {
+  std::string source = kProgram + "if 1 < 2 {\n  print_i32(1);\n}\nelse {\n"
+                                  "  print_i32(2);\n}\nlet z = 3; # end\n";
+  IncrementalParser parser;
+  parser.update(source);
+
+  std::vector<std::pair<std::string, std::string>> edits = {
+      {"x + 1", "x + 10"},      // Inside a statement
+      {"func g", "{ func g"},   // Unclosed brace swallows the rest
+      {"{ func g", "func g"},   // Closed again
+      {"x * 2", "\"x * 2"},     // Unterminated string
+      {"\"x * 2", "x * 2"},     // Terminated again
+      {"}\nfunc g", "} func g"}, // Two statements on one line
+      {"} func g", "}\nfunc g"},
+      {"}\nelse", "}\n# c\nelse"}, // Comment before 'else'
+      {"else {", "els {"},      // 'else' no longer joins the statements
+      {"els {", "else {"},
+      {"print_i32(f(1));\nprint_i32(f(1));\n", ""}, // Deleted lines
+      {"let z = 3;", "let z = 3; let w = 4;"},
+  };
+  for (const auto &[from, to] : edits) {
+    size_t pos = source.find(from);
+    ASSERT_NE(pos, std::string::npos) << from;
+    source.replace(pos, from.size(), to);
+    expect_same_as_fresh(parser, source);
+  }
+  expect_same_as_fresh(parser, "");
+  expect_same_as_fresh(parser, kProgram);
+}
+
+TEST(IncrementalParserTest, KeepsErrorsOfTheStatement) {
+  IncrementalParser parser;
+  const auto &statements =
+      parser.update("let a = 1;\nlet b = ;\nlet c = 2;\n");
+  ASSERT_EQ(statements.size(), 3u);
+  EXPECT_TRUE(statements[0]->errors.empty());
+  ASSERT_FALSE(statements[1]->errors.empty());
+  EXPECT_EQ(statements[1]->errors[0].line, 1u);
+  EXPECT_TRUE(statements[2]->errors.empty());
+
+  // A fresh AST comes from the statement's tokens
+  auto stmts = statements[2]->reparse();
+  ASSERT_EQ(stmts.size(), 1u);
+  EXPECT_EQ(static_cast<LetStmt *>(stmts[0].get())->name, "c");
+}
+
 } // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,154 @@
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "semantic_queries.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace pecco;
+
+namespace {
+
+// Statements keyed by their text
+std::vector<std::pair<std::string, SemanticQueries::Parse>>
+program(const std::vector<std::string> &statements) {
+  std::vector<std::pair<std::string, SemanticQueries::Parse>> result;
+  for (const auto &text : statements) {
+    result.emplace_back(text, [text] {
+      Lexer lexer(text);
+      Parser parser(lexer.tokenize_all());
+      return parser.parse_program();
+    });
+  }
+  return result;
+}
+
+void check_all(SemanticQueries &queries) {
+  for (size_t i = 0; i < queries.size(); ++i) {
+    EXPECT_TRUE(queries.diagnostics(i).empty()) << "statement " << i;
+  }
+}
+
+const BinaryExpr *let_init(const std::vector<StmtPtr> &stmts) {
+  auto *let = static_cast<const LetStmt *>(stmts.at(0).get());
+  EXPECT_EQ(let->init->kind, ExprKind::Binary);
+  return static_cast<const BinaryExpr *>(let->init.get());
+}
+
+TEST(SemanticQueriesTest, ComputesOnlyWhatIsQueried) {
+  SemanticQueries queries;
+  queries.update(program({"func f(x: i32) : i32 { return x; }",
+                          "let a = f(1);", "print_i32(a);"}));
+  EXPECT_EQ(queries.stats().parsed, 0u);
+
+  queries.syntax(1);
+  EXPECT_EQ(queries.stats().parsed, 1u);
+  EXPECT_EQ(queries.stats().checked, 0u);
+
+  // Checking needs every declaration, and the statement defining `a`
+  EXPECT_TRUE(queries.diagnostics(2).empty());
+  EXPECT_EQ(queries.stats().parsed, 3u);
+  EXPECT_EQ(queries.stats().declarations, 1u);
+  EXPECT_EQ(queries.stats().checked, 2u);
+  EXPECT_EQ(queries.global_type("a", 2), "i32");
+  EXPECT_EQ(queries.global_type("a", 1), "");
+}
+
+TEST(SemanticQueriesTest, SignatureChangesRecheckCallersOnly) {
+  SemanticQueries queries;
+  std::string caller = "func g() : i32 { return f(1) + 1; }";
+  std::string other = "func h() : i32 { return 2; }";
+  queries.update(program({"func f(x: i32) : i32 { return x; }", caller, other}));
+  check_all(queries);
+  EXPECT_EQ(queries.stats().checked, 3u);
+
+  // New body, same signature: callers keep their results
+  queries.update(program({"func f(x: i32) : i32 { return x * 2; }", caller,
+                          other}));
+  check_all(queries);
+  EXPECT_EQ(queries.stats().declarations, 0u);
+  EXPECT_EQ(queries.stats().checked, 1u);
+
+  // New signature: the caller is checked again, h is not
+  queries.update(program({"func f(x: i32) : f64 { return 2.0; }", caller,
+                          other}));
+  check_all(queries);
+  EXPECT_EQ(queries.stats().declarations, 1u);
+  EXPECT_EQ(queries.stats().checked, 2u);
+  ASSERT_EQ(queries.function_signatures("f").size(), 1u);
+  EXPECT_EQ(queries.function_signatures("f")[0].return_type, "f64");
+}
+
+TEST(SemanticQueriesTest, GlobalTypesFlowToReaders) {
+  SemanticQueries queries;
+  queries.update(program({"let a = 2.5;", "let b = a;", "print_i32(1);"}));
+  check_all(queries);
+  EXPECT_EQ(queries.global_type("b", 3), "f64");
+
+  queries.update(program({"let a = 2;", "let b = a;", "print_i32(1);"}));
+  check_all(queries);
+  EXPECT_EQ(queries.stats().checked, 2u); // a, b
+  EXPECT_EQ(queries.global_type("b", 3), "i32");
+  auto *let = static_cast<const LetStmt *>(queries.checked(1).at(0).get());
+  EXPECT_EQ(let->init->inferred_type, "i32");
+}
+
+TEST(SemanticQueriesTest, OperatorChangesResolveAgain) {
+  std::string use = "let v = 2 *** 3 *** 2;";
+  SemanticQueries queries;
+  queries.update(program(
+      {"operator infix *** (a: i32, b: i32) : i32 prec 90 assoc_right "
+       "{ return a * b; }",
+       use}));
+  const BinaryExpr *root = let_init(queries.resolved(1));
+  EXPECT_EQ(root->right->kind, ExprKind::Binary);
+  EXPECT_TRUE(queries.diagnostics(1).empty());
+
+  queries.update(program(
+      {"operator infix *** (a: i32, b: i32) : i32 prec 90 assoc_left "
+       "{ return a * b; }",
+       use}));
+  root = let_init(queries.resolved(1));
+  EXPECT_EQ(root->left->kind, ExprKind::Binary);
+  EXPECT_EQ(queries.stats().resolved, 1u);
+  EXPECT_TRUE(queries.diagnostics(1).empty());
+  EXPECT_EQ(queries.checked(1).size(), 1u);
+}
+
+TEST(SemanticQueriesTest, ReportsErrorsOfTheQueriedStatement) {
+  SemanticQueries queries;
+  queries.update(program({"let a = missing(1);", "let b = 1;"}));
+  ASSERT_EQ(queries.diagnostics(0).size(), 1u);
+  EXPECT_EQ(queries.diagnostics(0)[0].phase, "type");
+  EXPECT_TRUE(queries.diagnostics(1).empty());
+
+  // Declaring the function fixes the caller
+  queries.update(program({"func missing(x: i32) : i32 { return x; }",
+                          "let a = missing(1);", "let b = 1;"}));
+  EXPECT_TRUE(queries.diagnostics(1).empty());
+  EXPECT_TRUE(queries.diagnostics(2).empty());
+  EXPECT_EQ(queries.stats().checked, 1u); // a; the new function is not queried
+}
+
+TEST(SemanticQueriesTest, ScopesNeedNoTypeChecking) {
+  SemanticQueries queries;
+  queries.update(program(
+      {"let a = missing(1);",
+       "func f(x: i32) : i32 { if x > 0 { let y = x; } return x; }"}));
+  EXPECT_TRUE(queries.resolution_diagnostics(0).empty());
+  auto globals = queries.scopes(0).get_local_variables();
+  ASSERT_EQ(globals.size(), 1u);
+  EXPECT_EQ(globals[0].name, "a");
+
+  // Blocks are numbered within the statement
+  const Scope &func = *queries.scopes(1).children().at(0);
+  EXPECT_EQ(func.description(), "function f");
+  EXPECT_TRUE(func.has_variable_local("x"));
+  const Scope &body = *func.children().at(0);
+  EXPECT_EQ(body.description(), "block #0 at line 1");
+  EXPECT_TRUE(body.children().at(0)->has_variable_local("y"));
+
+  EXPECT_EQ(queries.stats().resolved, 2u);
+  EXPECT_EQ(queries.stats().checked, 0u);
+}
+
+} // namespace
@@ -0,0 +1,293 @@
+#include "batch_compiler.hpp"
+#include "compilation_session.hpp"
+#include "engine.hpp"
+#include "task_graph.hpp"
+
+#include <gtest/gtest.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/TargetParser/Host.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace pecco;
+
+namespace {
+
+const std::vector<std::string> kPrograms = {
+    R"(
+      func fib(n: i32) : i32 {
+        if n < 2 { return n; }
+        return fib(n - 1) + fib(n - 2);
+      }
+      exit(fib(10));
+    )",
+    R"(
+      operator infix ** (base: i32, exp: i32) : i32 prec 90 assoc_right {
+        let result = 1;
+        let i = 0;
+        while i < exp { result *= base; i += 1; }
+        return result;
+      }
+      operator prefix !! (x: i32) : i32 { return x * 2; }
+      let base = 3;
+      exit(!!(base ** 2 ** 2));
+    )",
+    R"(
+      func area(r: f64) : f64 { return 3.14159 * r * r; }
+      let total = 0.0;
+      let i = 0;
+      while i < 10 {
+        total += area(1.5);
+        i += 1;
+      }
+      print_f64(total);
+    )",
+    R"(
+      func classify(x: i32) : i32 {
+        if x < 0 { return -1; } else { if x == 0 { return 0; } }
+        return 1;
+      }
+      let flags = classify(-5) + classify(0) * 2 + classify(7) * 4;
+      print_i32(flags);
+      exit(flags);
+    )",
+    // Type error: diagnostics must be deterministic too
+    R"(
+      func broken(x: i32) : i32 { return missing(x); }
+    )",
+};
+
+// IR text or the diagnostics of compiling a program
+std::string compile_to_text(const std::string &source,
+                            std::shared_ptr<const SymbolTable> prelude) {
+  CompileOptions options;
+  options.module_name = "stress";
+  CompilationSession session(options, std::move(prelude));
+  if (!session.compile(source)) {
+    std::string text;
+    for (const auto &diag : session.diagnostics()) {
+      text += diag.phase + ":" + std::to_string(diag.line) + ":" +
+              std::to_string(diag.column) + ": " + diag.message + "\n";
+    }
+    return text;
+  }
+  return session.codegen()->get_ir();
+}
+
+} // namespace
+
+TEST(CompilationSessionTest, CompilesToIR) {
+  CompileOptions options;
+  options.eliminate_dead_functions = false;
+  CompilationSession session(options);
+  ASSERT_TRUE(session.compile("func add(a: i32, b: i32) : i32 { return a + b; }"));
+  std::string ir = session.codegen()->get_ir();
+  EXPECT_NE(ir.find("define i32 @add"), std::string::npos) << ir;
+}
+
+TEST(CompilationSessionTest, DiagnosticsCarryPhaseAndLocation) {
+  CompilationSession session;
+  EXPECT_FALSE(session.compile("let x = 1;\nlet y = (x;"));
+  ASSERT_TRUE(session.has_errors());
+  EXPECT_EQ(session.diagnostics()[0].phase, "parse");
+  EXPECT_EQ(session.diagnostics()[0].line, 2u);
+}
+
+TEST(CompilationSessionTest, OptionsControlAstOptimization) {
+  CompileOptions options;
+  options.ast_opt = false;
+  const char *source = R"(if 1 > 2 { print("never printed"); })";
+
+  CompilationSession plain(options);
+  ASSERT_TRUE(plain.compile(source));
+  EXPECT_NE(plain.codegen()->get_ir().find("never printed"), std::string::npos);
+
+  CompilationSession optimized;
+  ASSERT_TRUE(optimized.compile(source));
+  EXPECT_EQ(optimized.codegen()->get_ir().find("never printed"),
+            std::string::npos);
+}
+
+TEST(CompilationSessionTest, SharedPreludeIsNotModified) {
+  auto prelude = CompilationSession::default_prelude();
+  ASSERT_NE(prelude, nullptr);
+
+  CompilationSession first(CompileOptions{}, prelude);
+  ASSERT_TRUE(first.compile(
+      "operator infix <> (a: i32, b: i32) : i32 prec 50 { return a - b; }"
+      "func helper() : i32 { return 1 <> 2; }"));
+  EXPECT_TRUE(first.symbols().has_function("helper"));
+  EXPECT_TRUE(first.symbols().has_function("print"));
+
+  EXPECT_FALSE(prelude->has_function("helper"));
+  EXPECT_FALSE(prelude->has_operator("<>", OpPosition::Infix));
+
+  // A later session on the same prelude doesn't see the first one's symbols
+  CompilationSession second(CompileOptions{}, prelude);
+  EXPECT_FALSE(second.compile("exit(1 <> 2);"));
+}
+
+TEST(CompilationSessionTest, ConcurrentCompilationsMatchSequential) {
+  auto prelude = CompilationSession::default_prelude();
+  ASSERT_NE(prelude, nullptr);
+
+  std::vector<std::string> expected;
+  for (const auto &program : kPrograms) {
+    expected.push_back(compile_to_text(program, prelude));
+  }
+
+  constexpr size_t kThreads = 32;
+  constexpr size_t kRounds = 6;
+  std::atomic<size_t> mismatches{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t round = 0; round < kRounds; ++round) {
+        size_t index = (t + round) % kPrograms.size();
+        if (compile_to_text(kPrograms[index], prelude) != expected[index]) {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(mismatches.load(), 0u);
+}
+
+TEST(CompilationSessionTest, ConcurrentEngines) {
+  constexpr int kThreads = 8;
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      Engine engine;
+      if (!engine.compile("func scale(x: i32, k: i32) : i32 { return x * k; }")) {
+        ++failures;
+        return;
+      }
+      auto scale = engine.lookup<i32(i32, i32)>("scale");
+      if (!scale || scale(t, 3) != t * 3) {
+        ++failures;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(failures.load(), 0);
+}
+
+TEST(CompilationSessionTest, PreludeCanBeSetAfterParsing) {
+  CompilationSession session(CompileOptions{}, nullptr);
+  ASSERT_TRUE(session.parse("func twice(x: i32) : i32 { return x * 2; }\n"
+                            "print_i32(twice(21));"));
+  session.set_prelude(CompilationSession::default_prelude());
+  ASSERT_TRUE(session.analyze());
+  EXPECT_TRUE(session.symbols().has_function("print_i32"));
+  EXPECT_TRUE(session.generate());
+}
+
+TEST(TaskGraphTest, RunsTasksAfterTheirDependencies) {
+  std::mutex mutex;
+  std::vector<std::string> order;
+  auto task = [&](const char *name) {
+    return [&, name] {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(name);
+      return true;
+    };
+  };
+
+  TaskGraph graph;
+  auto read = graph.add("read", task("read"));
+  auto parse = graph.add("parse", task("parse"), {read});
+  auto prelude = graph.add("prelude", task("prelude"));
+  graph.add("target", task("target"));
+  auto analyze = graph.add("analyze", task("analyze"), {parse, prelude});
+  ASSERT_TRUE(graph.run(3));
+
+  auto position = [&](const char *name) {
+    return std::find(order.begin(), order.end(), name) - order.begin();
+  };
+  ASSERT_EQ(order.size(), 5u);
+  EXPECT_LT(position("read"), position("parse"));
+  EXPECT_LT(position("parse"), position("analyze"));
+  EXPECT_LT(position("prelude"), position("analyze"));
+  EXPECT_TRUE(graph.succeeded(analyze));
+
+  auto timings = graph.timings();
+  EXPECT_LE(timings[read].end, timings[parse].start);
+  EXPECT_LE(timings[prelude].end, timings[analyze].start);
+}
+
+TEST(TaskGraphTest, SkipsTasksAfterAFailure) {
+  TaskGraph graph;
+  std::atomic<int> ran{0};
+  auto failing = graph.add("read", [] { return false; });
+  auto skipped = graph.add("parse", [&] { return ++ran, true; }, {failing});
+  graph.add("analyze", [&] { return ++ran, true; }, {skipped});
+  auto independent = graph.add("target", [&] { return ++ran, true; });
+  EXPECT_FALSE(graph.run(2));
+  EXPECT_EQ(ran.load(), 1);
+  EXPECT_FALSE(graph.succeeded(skipped));
+  EXPECT_TRUE(graph.succeeded(independent));
+  EXPECT_FALSE(graph.timings()[skipped].ran);
+}
+
+TEST(BatchCompilerTest, CompilesEachFileToAnObject) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  std::string triple = llvm::sys::getProcessTriple();
+  std::string error;
+  const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+  ASSERT_NE(target, nullptr) << error;
+  std::unique_ptr<llvm::TargetMachine> target_machine(
+      target->createTargetMachine(triple, "generic", "", {}, std::nullopt));
+
+  llvm::SmallString<128> directory;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("batch-test", directory));
+  BatchCompiler compiler(*target_machine, CompileOptions{},
+                         llvm::OptimizationLevel::O2);
+  std::vector<Diagnostic> diagnostics;
+  // The last program is the one with a type error
+  size_t valid = kPrograms.size() - 1;
+  for (size_t i = 0; i < valid; ++i) {
+    std::string object = (directory + "/" + std::to_string(i) + ".o").str();
+    EXPECT_TRUE(compiler.compile(kPrograms[i], "program" + std::to_string(i),
+                                 object, diagnostics))
+        << i;
+    uint64_t size = 0;
+    EXPECT_FALSE(llvm::sys::fs::file_size(object, size));
+    EXPECT_GT(size, 0u);
+  }
+  EXPECT_TRUE(diagnostics.empty());
+
+  std::string broken = (directory + "/broken.o").str();
+  EXPECT_FALSE(
+      compiler.compile(kPrograms[valid], "broken", broken, diagnostics));
+  ASSERT_FALSE(diagnostics.empty());
+  EXPECT_EQ(diagnostics[0].phase, "type");
+  EXPECT_FALSE(llvm::sys::fs::exists(broken));
+
+  diagnostics.clear();
+  std::string bad = (directory + "/bad.o").str();
+  EXPECT_FALSE(compiler.compile("let x = ;", "bad", bad, diagnostics));
+  ASSERT_FALSE(diagnostics.empty());
+  EXPECT_EQ(diagnostics[0].phase, "parse");
+  EXPECT_FALSE(llvm::sys::fs::exists(bad));
+
+  EXPECT_EQ(compiler.stats().files, kPrograms.size() + 1);
+  EXPECT_EQ(compiler.stats().failed, 2u);
+  EXPECT_GT(compiler.stats().files_per_second(), 0);
+  llvm::sys::fs::remove_directories(directory);
+}
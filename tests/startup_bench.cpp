@@ -0,0 +1,105 @@
+// Startup latency of plc: runs each command line repeatedly as a fresh
+// process and prints the minimum and median wall-clock time.
+//
+// Usage: pecco_startup_bench [runs]   (default 20)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef PLC_BINARY
+#define PLC_BINARY "./build/src/plc"
+#endif
+
+#ifndef TEST_FIXTURES_DIR
+#define TEST_FIXTURES_DIR "./tests/fixtures"
+#endif
+
+extern char **environ;
+
+namespace {
+
+struct Case {
+  const char *name;
+  std::vector<std::string> args;
+};
+
+// Wall-clock milliseconds of one run with stdout/stderr discarded; negative
+// if plc could not be started or failed
+double run_once(const std::vector<std::string> &args) {
+  std::vector<char *> argv;
+  for (const auto &arg : args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  int error =
+      posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) {
+    return -1;
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  auto end = std::chrono::steady_clock::now();
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return -1;
+  }
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int runs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+  std::string sample = std::string(TEST_FIXTURES_DIR) + "/sample.pec";
+  std::string object = "startup_bench.o";
+
+  std::vector<Case> cases = {
+      {"--help", {PLC_BINARY, "--help"}},
+      {"--parse", {PLC_BINARY, "--parse", sample}},
+      {"--emit-llvm", {PLC_BINARY, "--emit-llvm", sample}},
+      {"--compile", {PLC_BINARY, "--compile", sample, "-o", object}},
+  };
+
+  std::printf("%-12s %10s %10s  (%d runs)\n", "command", "min ms",
+              "median ms", runs);
+  int status = 0;
+  for (const auto &c : cases) {
+    // The first run warms the page cache and is not counted
+    if (run_once(c.args) < 0) {
+      std::printf("%-12s failed\n", c.name);
+      status = 1;
+      continue;
+    }
+    std::vector<double> times;
+    for (int i = 0; i < runs; ++i) {
+      times.push_back(run_once(c.args));
+    }
+    std::sort(times.begin(), times.end());
+    if (times.front() < 0) {
+      std::printf("%-12s failed\n", c.name);
+      status = 1;
+      continue;
+    }
+    std::printf("%-12s %10.2f %10.2f\n", c.name, times.front(),
+                times[times.size() / 2]);
+  }
+  std::remove(object.c_str());
+  return status;
+}
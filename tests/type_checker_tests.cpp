@@ -483,3 +483,261 @@ TEST_F(TypeCheckerTest, UndefinedVariableInNestedScope) {
   EXPECT_NE(checker.errors()[0].message.find("undefined_in_inner"),
             std::string::npos);
 }
+
+// ===== Arrays =====
+
+TEST_F(TypeCheckerTest, ArrayIndexing) {
+  std::string code = R"(
+    func sum(xs : [8]f64) : f64 {
+      let total = 0.0;
+      let i = 0;
+      while i < 8 {
+        total += xs[i];
+        i += 1;
+      }
+      return total;
+    }
+    let data : [8]f64;
+    data[7] = 2.5;
+    let grid : [2][3]i32;
+    grid[1][2] = grid[0][0] + 1;
+    let s = sum(data);
+  )";
+
+  ASSERT_TRUE(parse_and_check(code));
+  EXPECT_FALSE(checker.has_errors());
+}
+
+TEST_F(TypeCheckerTest, ArrayIndexErrors) {
+  std::string code = R"(
+    let xs : [4]i32;
+    let a = xs[true];
+    let b = xs[4];
+    let n = 3;
+    let c = n[0];
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find("index must be 'i32'"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("out of bounds for '[4]i32'"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("Cannot index"),
+            std::string::npos);
+}
+
+TEST_F(TypeCheckerTest, ArraysAreNotValues) {
+  std::string code = R"(
+    let xs : [4]i32;
+    let ys : [4]i32;
+    let copy = xs;
+    xs = ys;
+    let sum = xs + ys;
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find("cannot be copied"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("Operator '='"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("Operator '+'"),
+            std::string::npos);
+}
+
+TEST_F(TypeCheckerTest, ArrayDeclarationRules) {
+  std::string code = R"(
+    let n : i32;
+    let xs : [4]i32 = 0;
+    func make() : [4]i32;
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find("must be initialized"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("cannot have an initializer"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("cannot return an array"),
+            std::string::npos);
+}
+
+// ===== Integer widths =====
+
+TEST_F(TypeCheckerTest, IntegerWidths) {
+  std::string code = R"(
+    func mix(a: u8, b: i64) : u64 {
+      let c : u32 = u32(a) >> 3 | 255u32;
+      return u64(c) * u64(b) + 1u64;
+    }
+    let low : i8 = -128i8;
+    let wide : i64 = i64(low) << 40;
+    let x : f64 = f64(wide) / 2.0;
+    let back : u16 = u16(x);
+    let same : i32 = i32(7);
+  )";
+
+  ASSERT_TRUE(parse_and_check(code));
+  EXPECT_FALSE(checker.has_errors());
+}
+
+TEST_F(TypeCheckerTest, IntegerLiteralRanges) {
+  std::string code = R"(
+    let a = 256u8;
+    let b = 128i8;
+    let c = -2147483648;
+    let d = 2147483648;
+    let e = 18446744073709551615u64;
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find("256 is out of range for 'u8'"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("128 is out of range for 'i8'"),
+            std::string::npos);
+  EXPECT_NE(
+      checker.errors()[2].message.find("2147483648 is out of range for 'i32'"),
+      std::string::npos);
+}
+
+TEST_F(TypeCheckerTest, NoImplicitIntegerConversions) {
+  std::string code = R"(
+    func f(a: i32, b: i64, c: u32) : void {
+      let x = a + b;
+      let y = -c;
+      let z = i64(true);
+    }
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find(
+                "No operator '+' for 'i32' and 'i64' (convert explicitly)"),
+            std::string::npos);
+  EXPECT_NE(
+      checker.errors()[1].message.find("No prefix operator '-' for 'u32'"),
+      std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("Cannot convert 'bool' to 'i64'"),
+            std::string::npos);
+}
+
+TEST_F(TypeCheckerTest, Float32) {
+  std::string code = R"(
+    func norm(x: f32, y: f32) : f32 {
+      return x * x + y * y ** 0.5f32;
+    }
+    let n : f32 = norm(3.0f32, 4f32);
+    let d : f64 = f64(n) + 1.0;
+    let back : f32 = f32(d) - f32(7);
+    let small : bool = -back < 1.0f32;
+  )";
+
+  ASSERT_TRUE(parse_and_check(code));
+  EXPECT_FALSE(checker.has_errors());
+}
+
+TEST_F(TypeCheckerTest, NoImplicitFloatConversions) {
+  std::string code = R"(
+    let a = 1.0f32 + 2.0;
+    let b : f32 = 1.0;
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 2);
+  EXPECT_NE(checker.errors()[0].message.find(
+                "No operator '+' for 'f32' and 'f64' (convert explicitly)"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("initialized with 'f64'"),
+            std::string::npos);
+}
+
+// ===== Bit manipulation =====
+
+TEST_F(TypeCheckerTest, BitBuiltins) {
+  std::string code = R"(
+    func hash(x: u64) : u64 {
+      let count : i32 = popcount(x) + clz(x) + ctz(u8(x));
+      return rotl(x, count) ^ bswap(x) ^ bitreverse(rotr(x, 3));
+    }
+    let low : i8 = bswap(1i8);
+  )";
+
+  ASSERT_TRUE(parse_and_check(code));
+  EXPECT_FALSE(checker.has_errors());
+}
+
+TEST_F(TypeCheckerTest, BitBuiltinsNeedIntegers) {
+  std::string code = R"(
+    let a = popcount(true);
+    let b = rotl(1u32, 2u32);
+    let c = clz(1.0);
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find(
+                "No overload of 'popcount' for ('bool')"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find(
+                "No overload of 'rotl' for ('u32', 'u32')"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("for ('f64')"),
+            std::string::npos);
+}
+
+// ===== SIMD vectors =====
+
+TEST_F(TypeCheckerTest, VectorOperations) {
+  std::string code = R"(
+    func blend(a: f64x4, b: f64x4) : f64x4 {
+      let m : boolx4 = a < b;
+      let sum : f64 = reduce_add(a * b);
+      let lane : f64 = extract(a, 3);
+      return select(m & !(a == b), shuffle(a, b, 0, 4, 1, 5), f64x4(sum));
+    }
+    let v : i32x8 = i32x8(1) << i32x8(2);
+    let total : i32 = reduce_max(v ^ i32x8(0, 1, 2, 3, 4, 5, 6, 7));
+    let big : bool = any(v > i32x8(total));
+  )";
+
+  ASSERT_TRUE(parse_and_check(code));
+  EXPECT_FALSE(checker.has_errors());
+}
+
+TEST_F(TypeCheckerTest, VectorResultTypes) {
+  std::string code = R"(
+    let ints = i32x4(1, 2, 3, 4);
+    let x : f64 = reduce_add(ints);
+    let m : i32x4 = ints == ints;
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 2);
+  EXPECT_NE(checker.errors()[0].message.find("initialized with 'i32'"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("initialized with 'boolx4'"),
+            std::string::npos);
+}
+
+TEST_F(TypeCheckerTest, VectorLaneErrors) {
+  std::string code = R"(
+    let v = f64x2(1.0, 2.0);
+    let n = 1;
+    let a = extract(v, 2);
+    let b = insert(v, n, 3.0);
+    let c = shuffle(v, v, 0, 4);
+    let d = shuffle(v, v, n, 0);
+  )";
+
+  EXPECT_FALSE(parse_and_check(code));
+  ASSERT_EQ(checker.errors().size(), 3);
+  EXPECT_NE(checker.errors()[0].message.find("Lane 2 is out of range for "
+                                             "'f64x2'"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[1].message.find("two 'f64x2' vectors"),
+            std::string::npos);
+  EXPECT_NE(checker.errors()[2].message.find("must be integer literals"),
+            std::string::npos);
+}
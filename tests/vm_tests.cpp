@@ -0,0 +1,337 @@
+#include "bytecode.hpp"
+#include "lexer.hpp"
+#include "operator_resolver.hpp"
+#include "parser.hpp"
+#include "scope.hpp"
+#include "symbol_table_builder.hpp"
+#include "tiered_jit.hpp"
+#include "type_checker.hpp"
+#include "vm.hpp"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace pecco;
+
+class VMTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    builder.load_prelude(STDLIB_DIR "/prelude.pec", symbols);
+  }
+
+  ScopedSymbolTable symbols;
+  SymbolTableBuilder builder;
+  std::vector<StmtPtr> stmts;
+  BytecodeModule module;
+  BytecodeCompiler compiler;
+
+  bool compile(const std::string &code) {
+    Lexer lexer(code);
+    auto tokens = lexer.tokenize_all();
+    Parser parser(std::move(tokens));
+    stmts = parser.parse_program();
+    if (parser.has_errors() || !builder.collect(stmts, symbols)) {
+      return false;
+    }
+
+    std::vector<std::string> resolve_errors;
+    for (auto &stmt : stmts) {
+      OperatorResolver::resolve_stmt(stmt.get(), symbols.symbol_table(),
+                                     resolve_errors);
+    }
+    TypeChecker checker;
+    if (!resolve_errors.empty() || !checker.check(stmts, symbols)) {
+      return false;
+    }
+
+    return compiler.compile(stmts, module);
+  }
+
+  size_t function_index(const std::string &name) const {
+    for (size_t i = 0; i < module.functions.size(); ++i) {
+      if (module.functions[i].name == name) {
+        return i;
+      }
+    }
+    ADD_FAILURE() << "no function " << name;
+    return 0;
+  }
+
+  struct Result {
+    int32_t status;
+    std::string output;
+    std::string error;
+  };
+
+  // Compile and run, capturing what the program writes to stdout
+  Result run(const std::string &code) {
+    if (!compile(code)) {
+      return {-1, "", "<compile error>"};
+    }
+    VM vm(module);
+    testing::internal::CaptureStdout();
+    int32_t status = vm.run();
+    std::string output = testing::internal::GetCapturedStdout();
+    return {status, output, vm.error()};
+  }
+};
+
+TEST_F(VMTest, ExitStatus) {
+  EXPECT_EQ(run("exit(42);").status, 42);
+  EXPECT_EQ(run("let x = 1;").status, 0);
+}
+
+TEST_F(VMTest, ArithmeticAndControlFlow) {
+  auto result = run(R"(
+    let sum = 0;
+    let i = 1;
+    while i <= 10 {
+      if i % 2 == 0 {
+        sum += i;
+      } else {
+        sum = sum - 1;
+      }
+      i = i + 1;
+    }
+    print_i32(sum);
+    print("\n");
+  )");
+
+  EXPECT_EQ(result.output, "25\n");
+  EXPECT_EQ(result.status, 0);
+}
+
+TEST_F(VMTest, RecursiveFunctions) {
+  auto result = run(R"(
+    func fib(n: i32) : i32 {
+      if n < 2 { return n; }
+      return fib(n - 1) + fib(n - 2);
+    }
+    exit(fib(20) % 256);
+  )");
+
+  EXPECT_EQ(result.status, 6765 % 256);
+}
+
+TEST_F(VMTest, UserDefinedOperators) {
+  auto result = run(R"(
+    operator infix ** (base: i32, exp: i32) : i32 prec 90 assoc_right {
+      let result = 1;
+      let i = 0;
+      while i < exp {
+        result *= base;
+        i += 1;
+      }
+      return result;
+    }
+    operator prefix !! (x: i32) : i32 {
+      return x * 2;
+    }
+    let base = 3;
+    exit(!!(base ** 2 ** 2));
+  )");
+
+  EXPECT_EQ(result.status, 162);
+}
+
+TEST_F(VMTest, I32WrapsAround) {
+  auto result = run(R"(
+    let big = 2147483647;
+    print_i32(big + 1);
+    print(" ");
+    print_i32(65536 * 65536);
+    print(" ");
+    print_i32(-7 / 2);
+    print(" ");
+    print_i32(-7 % 2);
+  )");
+
+  EXPECT_EQ(result.output, "-2147483648 0 -3 -1");
+}
+
+TEST_F(VMTest, FloatOperations) {
+  auto result = run(R"(
+    let x = 2.0 ** 10.0;
+    print_f64(x / 4.0 - 0.5);
+    let nan = 0.0 / 0.0;
+    if nan != nan { print(" unordered"); }
+    if !(nan == nan) { print(" ordered"); }
+  )");
+
+  EXPECT_EQ(result.output, "255.5 ordered");
+}
+
+TEST_F(VMTest, LeftOperandReadBeforeAssignment) {
+  // Codegen loads a before evaluating the assignment on the right
+  auto result = run(R"(
+    let a = 1;
+    let b = a + (a = 5);
+    exit(b * 10 + a);
+  )");
+
+  EXPECT_EQ(result.status, 65);
+}
+
+TEST_F(VMTest, WriteIsBufferedWithPrint) {
+  auto result = run(R"(
+    print("a");
+    let n = write(1, "bc", 2);
+    print_i32(n);
+    flush();
+  )");
+
+  EXPECT_EQ(result.output, "abc2");
+}
+
+TEST_F(VMTest, ExitFlushesOutput) {
+  auto result = run(R"(
+    print("before");
+    exit(3);
+    print("after");
+  )");
+
+  EXPECT_EQ(result.output, "before");
+  EXPECT_EQ(result.status, 3);
+}
+
+TEST_F(VMTest, DivisionByZeroIsRuntimeError) {
+  auto result = run(R"(
+    func div(a: i32, b: i32) : i32 { return a / b; }
+    print("partial");
+    exit(div(1, 0));
+  )");
+
+  EXPECT_EQ(result.output, "partial");
+  EXPECT_FALSE(result.error.empty());
+  EXPECT_NE(result.status, 0);
+}
+
+TEST_F(VMTest, UnboundedRecursionIsRuntimeError) {
+  auto result = run(R"(
+    func down(n: i32) : i32 { return down(n + 1) + 1; }
+    exit(down(0));
+  )");
+
+  EXPECT_EQ(result.error, "stack overflow");
+}
+
+TEST_F(VMTest, ExternFunctionsRejected) {
+  EXPECT_FALSE(compile(R"(
+    func external(x: i32) : i32;
+    exit(external(1));
+  )"));
+  ASSERT_TRUE(compiler.has_errors());
+  EXPECT_NE(compiler.errors()[0].message.find("external"), std::string::npos);
+}
+
+TEST_F(VMTest, CallArgumentsUseCalleeWindow) {
+  ASSERT_TRUE(compile(R"(
+    func add(a: i32, b: i32) : i32 { return a + b; }
+    let x = add(1, 2);
+  )"));
+
+  // Arguments are evaluated straight into the callee's parameter registers
+  std::ostringstream os;
+  module.disassemble(os);
+  EXPECT_EQ(os.str().find("Mov"), std::string::npos) << os.str();
+}
+
+TEST_F(VMTest, InstalledNativeEntryReplacesBytecode) {
+  ASSERT_TRUE(compile(R"(
+    func add(a: i32, b: i32) : i32 { return a + b; }
+    exit(add(1, 2));
+  )"));
+
+  VM vm(module);
+  EXPECT_EQ(vm.run(), 3);
+
+  vm.install_native(function_index("add"), [](VMValue *args, VMValue *result) {
+    result->i = args[0].i * 10 + args[1].i;
+  });
+  EXPECT_EQ(vm.run(), 12);
+}
+
+TEST_F(VMTest, TierUpHookFiresOncePerHotFunction) {
+  ASSERT_TRUE(compile(R"(
+    func cold(x: i32) : i32 { return x; }
+    func hot(x: i32) : i32 { return x + 1; }
+    func spin() : void {
+      let i = 0;
+      while i < 10 { i += 1; }
+    }
+    let i = 0;
+    while i < 10 { i = hot(i); }
+    spin();
+    exit(cold(i));
+  )"));
+
+  std::vector<size_t> hot;
+  VM vm(module);
+  vm.set_tier_up(5, [&](size_t function) { hot.push_back(function); });
+  EXPECT_EQ(vm.run(), 10);
+
+  // Calls and loop back-edges both count; spin is called only once
+  std::vector<size_t> expected{function_index("hot"), module.entry,
+                               function_index("spin")};
+  EXPECT_EQ(hot, expected);
+}
+
+TEST_F(VMTest, TieredJitCompilesHotFunctionsWithCallees) {
+  ASSERT_TRUE(compile(R"(
+    func square(x: i32) : i32 { return x * x; }
+    func sum_squares(n: i32) : i32 {
+      let total = 0;
+      let i = 1;
+      while i <= n { total += square(i); i += 1; }
+      return total;
+    }
+    let i = 0;
+    let last = 0;
+    while i < 50 { last = sum_squares(i); i += 1; }
+    print_i32(last);
+    exit(last % 256);
+  )"));
+
+  VM vm(module);
+  TieredJit jit(stmts, symbols, module, vm);
+  vm.set_tier_up(1, [&](size_t function) { jit.request(function); });
+
+  testing::internal::CaptureStdout();
+  int32_t status = vm.run();
+  std::string output = testing::internal::GetCapturedStdout();
+  jit.wait_idle();
+
+  EXPECT_EQ(output, "40425");
+  EXPECT_EQ(status, 40425 % 256);
+
+  auto tier_ups = jit.tier_ups();
+  ASSERT_FALSE(tier_ups.empty());
+  EXPECT_EQ(tier_ups[0].function, "sum_squares");
+  EXPECT_TRUE(tier_ups[0].error.empty()) << tier_ups[0].error;
+  std::vector<std::string> expected{"square", "sum_squares"};
+  EXPECT_EQ(tier_ups[0].compiled, expected);
+}
+
+TEST_F(VMTest, TieredJitRunsCompiledCodeNatively) {
+  ASSERT_TRUE(compile(R"(
+    func depth(n: i32) : i32 {
+      if n == 0 { return 0; }
+      return depth(n - 1) + 1;
+    }
+    exit(depth(150000) % 256);
+  )"));
+
+  // Too deep for the interpreter's call stack
+  {
+    VM vm(module);
+    vm.run();
+    EXPECT_EQ(vm.error(), "stack overflow");
+  }
+
+  VM vm(module);
+  TieredJit jit(stmts, symbols, module, vm);
+  jit.request(function_index("depth"));
+  jit.wait_idle();
+  EXPECT_EQ(vm.run(), 150000 % 256);
+  EXPECT_FALSE(vm.has_error()) << vm.error();
+}